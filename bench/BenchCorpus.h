@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// xorshift32 with a fixed seed so every run (and every machine) gets the same corpus
+struct BenchRandom {
+	uint32_t seed = 0x50FA7111;
+
+	uint32_t operator()()
+	{
+		seed ^= seed << 13;
+		seed ^= seed >> 17;
+		seed ^= seed << 5;
+		return seed;
+	}
+};
+
+// 4bpp tile sheet: a small set of tiles reused over and over, a few flat runs and some noise,
+// roughly what graphics dumped out of a ROM look like
+inline std::vector<uint8_t> makeTileCorpus(size_t size)
+{
+	BenchRandom next;
+
+	std::vector<std::vector<uint8_t>> tiles(64, std::vector<uint8_t>(32));
+	for (auto& tile : tiles) {
+		uint8_t color = next() & 0xFF;
+		for (auto& b : tile) {
+			if ((next() & 3) == 0) color = next() & 0xFF;
+			b = color;
+		}
+	}
+
+	std::vector<uint8_t> corpus;
+	corpus.reserve(size + 32);
+	while (corpus.size() < size) {
+		uint32_t pick = next();
+		if ((pick & 15) == 0) {
+			for (int i = 0; i < 32; i++) corpus.push_back(next() & 0xFF);
+		} else {
+			const auto& tile = tiles[(pick >> 4) % tiles.size()];
+			corpus.insert(corpus.end(), tile.begin(), tile.end());
+		}
+	}
+	corpus.resize(size);
+	return corpus;
+}
+
+// cel source the way the decomp (and saveAnimationCels) writes it: `AnimationCel name[] = {`,
+// a /* Len */ line and one line of three hex halfwords per oam
+inline std::string makeCelSource(size_t size)
+{
+	BenchRandom next;
+
+	std::string text = "// Generated by Sofanthiel [https://github.com/shaffyswitcher/sofanthiel]\n\n";
+	text.reserve(size + 1024);
+	char line[96];
+	for (int cel = 0; text.size() < size; cel++) {
+		const int oamCount = 1 + next() % 24;
+		std::snprintf(line, sizeof(line), "AnimationCel bench_cel%d[] = {\n    /* Len */ %d,\n", cel, oamCount);
+		text += line;
+		for (int i = 0; i < oamCount; i++) {
+			std::snprintf(line, sizeof(line), "    /* %03d */ 0x%04X, 0x%04X, 0x%04X%s\n", i,
+				next() & 0xFFFF, next() & 0xFFFF, next() & 0xFFFF, i + 1 < oamCount ? "," : "");
+			text += line;
+		}
+		text += "};\n\n";
+	}
+	return text;
+}
+
+// animation source in saveAnimations' layout, entries point at bench_cel<N> names
+inline std::string makeAnimationSource(size_t size)
+{
+	BenchRandom next;
+
+	std::string text = "#include \"global.h\"\n#include \"graphics.h\"\n\n#include \"bench_cels.c\"\n\n";
+	text.reserve(size + 1024);
+	char line[96];
+	for (int anim = 0; text.size() < size; anim++) {
+		std::snprintf(line, sizeof(line), "struct Animation anim_bench%d[] = {\n", anim);
+		text += line;
+		const int entryCount = 1 + next() % 16;
+		for (int i = 0; i < entryCount; i++) {
+			std::snprintf(line, sizeof(line), "    /* %03d */ { bench_cel%u, %u },\n", i, next() % 4096, 1 + next() % 30);
+			text += line;
+		}
+		std::snprintf(line, sizeof(line), "    /* %03d */ END_ANIMATION,\n};\n\n", entryCount);
+		text += line;
+	}
+	return text;
+}
@@ -0,0 +1,58 @@
+// greedy vs optimal compressLZ77: output size and time on a small sheet and a big one.
+// every stream is decoded again and checked against the input
+#include "BenchCorpus.h"
+#include "Compression.h"
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+namespace {
+
+constexpr int kRuns = 3;
+
+struct Result {
+	size_t packedSize = 0;
+	double ms = 0.0;
+	bool ok = true;
+};
+
+Result run(const std::vector<uint8_t>& input, Compression::LZ77Mode mode)
+{
+	Result result;
+	for (int i = 0; i < kRuns; i++) {
+		auto start = std::chrono::steady_clock::now();
+		std::vector<uint8_t> packed = Compression::compressLZ77(input.data(), input.size(), mode);
+		double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		if (i == 0 || ms < result.ms) result.ms = ms;
+		result.packedSize = packed.size();
+
+		std::vector<uint8_t> unpacked;
+		if (!Compression::decompress(packed.data(), packed.size(), unpacked) || unpacked != input) result.ok = false;
+	}
+	return result;
+}
+
+}
+
+int main()
+{
+	const size_t sizes[] = { 32 * 1024, 1024 * 1024 };
+
+	std::printf("lz77 compress, best of %d\n", kRuns);
+	for (size_t size : sizes) {
+		std::vector<uint8_t> corpus = makeTileCorpus(size);
+		Result greedy = run(corpus, Compression::LZ77Mode::Greedy);
+		Result optimal = run(corpus, Compression::LZ77Mode::Optimal);
+
+		if (!greedy.ok || !optimal.ok) {
+			std::printf("lz77 compress: stream doesn't decode back to the input (%zu bytes)\n", size);
+			return 1;
+		}
+
+		double saved = 100.0 * (1.0 - static_cast<double>(optimal.packedSize) / greedy.packedSize);
+		std::printf("  %7zu bytes  greedy: %7zu bytes %8.2f ms   optimal: %7zu bytes %8.2f ms   (%.1f%% smaller)\n",
+			size, greedy.packedSize, greedy.ms, optimal.packedSize, optimal.ms, saved);
+	}
+	return 0;
+}
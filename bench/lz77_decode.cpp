@@ -0,0 +1,90 @@
+// times Compression::decompress against the plain byte-at-a-time LZ77 loop it replaced.
+// the corpus is generated from a fixed seed so the numbers are comparable between runs
+#include "BenchCorpus.h"
+#include "Compression.h"
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+namespace {
+
+constexpr size_t kCorpusSize = 8 * 1024 * 1024;
+constexpr int kRuns = 5;
+
+// the decoder as it was before the block copy rewrite
+bool referenceDecompressLZ77(const uint8_t* data, size_t size, std::vector<uint8_t>& out)
+{
+	out.clear();
+	if (size < 4 || data[0] != Compression::LZ77_TYPE) return false;
+
+	size_t outSize = data[1] | (data[2] << 8) | (data[3] << 16);
+	out.reserve(outSize);
+	size_t pos = 4;
+
+	while (out.size() < outSize) {
+		if (pos >= size) return false;
+		uint8_t flags = data[pos++];
+
+		for (int bit = 7; bit >= 0 && out.size() < outSize; bit--) {
+			if ((flags >> bit) & 1) {
+				if (pos + 1 >= size) return false;
+				size_t len = (data[pos] >> 4) + 3;
+				size_t disp = (((data[pos] & 0x0F) << 8) | data[pos + 1]) + 1;
+				pos += 2;
+				if (disp > out.size()) return false;
+
+				size_t start = out.size() - disp;
+				for (size_t k = 0; k < len && out.size() < outSize; k++) {
+					uint8_t v = out[start + k];
+					out.push_back(v);
+				}
+			} else {
+				if (pos >= size) return false;
+				out.push_back(data[pos++]);
+			}
+		}
+	}
+	return true;
+}
+
+template <typename Fn>
+double bestOf(Fn&& fn)
+{
+	double best = 0.0;
+	for (int i = 0; i < kRuns; i++) {
+		auto start = std::chrono::steady_clock::now();
+		fn();
+		double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		if (i == 0 || ms < best) best = ms;
+	}
+	return best;
+}
+
+}
+
+int main()
+{
+	std::vector<uint8_t> corpus = makeTileCorpus(kCorpusSize);
+	std::vector<uint8_t> packed = Compression::compressLZ77(corpus.data(), corpus.size());
+
+	std::vector<uint8_t> refOut;
+	std::vector<uint8_t> newOut;
+	bool refOk = true;
+	bool newOk = true;
+
+	double refMs = bestOf([&]() { refOk = referenceDecompressLZ77(packed.data(), packed.size(), refOut) && refOk; });
+	double newMs = bestOf([&]() { newOk = Compression::decompress(packed.data(), packed.size(), newOut) && newOk; });
+
+	if (!refOk || !newOk || refOut != corpus || newOut != corpus) {
+		std::printf("lz77 decode: output doesn't match the corpus\n");
+		return 1;
+	}
+
+	double mb = corpus.size() / (1024.0 * 1024.0);
+	std::printf("lz77 decode, %.1f MB from %zu bytes, best of %d\n", mb, packed.size(), kRuns);
+	std::printf("  reference loop: %8.2f ms  %8.1f MB/s\n", refMs, mb / (refMs / 1000.0));
+	std::printf("  decompress:     %8.2f ms  %8.1f MB/s\n", newMs, mb / (newMs / 1000.0));
+	std::printf("  speedup:        %8.2fx\n", refMs / newMs);
+	return 0;
+}
@@ -0,0 +1,58 @@
+// cel and animation source parsing throughput in MB/s, on fixed generated sources about
+// the size of the decomp's biggest cel files and of all of them together
+#include "BenchCorpus.h"
+#include "ResourceManager.h"
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+namespace {
+
+constexpr int kRuns = 5;
+
+template <typename Parse>
+double bestMs(Parse parse)
+{
+	double best = 0.0;
+	for (int i = 0; i < kRuns; i++) {
+		auto start = std::chrono::steady_clock::now();
+		parse();
+		double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		if (i == 0 || ms < best) best = ms;
+	}
+	return best;
+}
+
+double megabytesPerSecond(size_t bytes, double ms)
+{
+	return (bytes / (1024.0 * 1024.0)) / (ms / 1000.0);
+}
+
+}
+
+int main()
+{
+	const size_t sizes[] = { 256 * 1024, 8 * 1024 * 1024 };
+
+	std::printf("text parse, best of %d\n", kRuns);
+	for (size_t size : sizes) {
+		const std::string cels = makeCelSource(size);
+		const std::string animations = makeAnimationSource(size);
+
+		size_t celCount = 0;
+		size_t animationCount = 0;
+		double celMs = bestMs([&]() { celCount = ResourceManager::loadAnimationCelsFromText(cels, "bench_cels.c").size(); });
+		double animationMs = bestMs([&]() { animationCount = ResourceManager::loadAnimationsFromText(animations, "bench_anims.c").size(); });
+
+		if (celCount == 0 || animationCount == 0) {
+			std::printf("text parse: nothing came out of the %zu byte sources\n", size);
+			return 1;
+		}
+
+		std::printf("  %7zu bytes  cels: %6zu in %8.2f ms (%7.1f MB/s)   animations: %6zu in %8.2f ms (%7.1f MB/s)\n",
+			size, celCount, celMs, megabytesPerSecond(cels.size(), celMs),
+			animationCount, animationMs, megabytesPerSecond(animations.size(), animationMs));
+	}
+	return 0;
+}
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// little endian byte packing shared by the project file and the edit journal
+
+class ByteWriter {
+public:
+	std::vector<uint8_t> bytes;
+
+	void putU8(uint8_t value) { bytes.push_back(value); }
+
+	void putU16(uint16_t value)
+	{
+		bytes.push_back(static_cast<uint8_t>(value & 0xFF));
+		bytes.push_back(static_cast<uint8_t>(value >> 8));
+	}
+
+	void putU32(uint32_t value)
+	{
+		for (int i = 0; i < 4; i++) {
+			bytes.push_back(static_cast<uint8_t>((value >> (i * 8)) & 0xFF));
+		}
+	}
+
+	void putBytes(const void* data, size_t size)
+	{
+		const uint8_t* src = static_cast<const uint8_t*>(data);
+		bytes.insert(bytes.end(), src, src + size);
+	}
+
+	void putString(const std::string& str)
+	{
+		putU32(static_cast<uint32_t>(str.size()));
+		putBytes(str.data(), str.size());
+	}
+};
+
+class ByteCursor {
+public:
+	ByteCursor(const uint8_t* data, size_t size) : data(data), size(size) {}
+
+	bool ok() const { return !failed; }
+	size_t remaining() const { return size - pos; }
+
+	uint8_t getU8()
+	{
+		if (!require(1)) return 0;
+		return data[pos++];
+	}
+
+	uint16_t getU16()
+	{
+		if (!require(2)) return 0;
+		uint16_t value = static_cast<uint16_t>(data[pos] | (data[pos + 1] << 8));
+		pos += 2;
+		return value;
+	}
+
+	uint32_t getU32()
+	{
+		if (!require(4)) return 0;
+		uint32_t value = static_cast<uint32_t>(data[pos]) | (static_cast<uint32_t>(data[pos + 1]) << 8) |
+			(static_cast<uint32_t>(data[pos + 2]) << 16) | (static_cast<uint32_t>(data[pos + 3]) << 24);
+		pos += 4;
+		return value;
+	}
+
+	const uint8_t* getBytes(size_t count)
+	{
+		if (!require(count)) return nullptr;
+		const uint8_t* ptr = data + pos;
+		pos += count;
+		return ptr;
+	}
+
+	std::string getString()
+	{
+		uint32_t len = getU32();
+		const uint8_t* chars = getBytes(len);
+		return chars ? std::string(reinterpret_cast<const char*>(chars), len) : std::string();
+	}
+
+private:
+	bool require(size_t count)
+	{
+		if (failed || count > size - pos) {
+			failed = true;
+			return false;
+		}
+		return true;
+	}
+
+	const uint8_t* data;
+	size_t size;
+	size_t pos = 0;
+	bool failed = false;
+};
+
+// random access over a buffer someone else owns (a mapped ROM, say). every read checks
+// its range and fails instead of running off the end
+class ByteView {
+public:
+	ByteView() = default;
+	ByteView(const uint8_t* data, size_t size) : data(data), size(size) {}
+
+	const uint8_t* getData() const { return data; }
+	size_t getSize() const { return size; }
+	bool empty() const { return size == 0; }
+
+	bool contains(size_t offset, size_t count) const { return offset <= size && count <= size - offset; }
+
+	bool readU16(size_t offset, uint16_t& out) const
+	{
+		if (!contains(offset, 2)) return false;
+		out = static_cast<uint16_t>(data[offset] | (data[offset + 1] << 8));
+		return true;
+	}
+
+	bool readU32(size_t offset, uint32_t& out) const
+	{
+		if (!contains(offset, 4)) return false;
+		out = static_cast<uint32_t>(data[offset]) | (static_cast<uint32_t>(data[offset + 1]) << 8) |
+			(static_cast<uint32_t>(data[offset + 2]) << 16) | (static_cast<uint32_t>(data[offset + 3]) << 24);
+		return true;
+	}
+
+private:
+	const uint8_t* data = nullptr;
+	size_t size = 0;
+};
@@ -0,0 +1,471 @@
+#include "Compression.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+namespace {
+
+constexpr size_t kLZ77Window = 0x1000;
+constexpr size_t kLZ77MinMatch = 3;
+constexpr size_t kLZ77MaxMatch = 18;
+constexpr size_t kHashSize = 1 << 14;
+constexpr int kMaxChainLength = 128;
+
+constexpr int kOptimalChainLength = 1024;
+
+size_t hashAt(const uint8_t* data, size_t pos)
+{
+	return ((static_cast<size_t>(data[pos]) << 6) ^ (static_cast<size_t>(data[pos + 1]) << 3) ^ data[pos + 2]) & (kHashSize - 1);
+}
+
+// hash chains over 3 byte prefixes, way faster than scanning the whole 4k window
+class MatchFinder {
+public:
+	MatchFinder(const uint8_t* data, size_t size, size_t minDisp)
+		: data(data), size(size), minDisp(minDisp), head(kHashSize, -1), prev(size, -1) {}
+
+	void insert(size_t pos)
+	{
+		if (pos + 2 >= size) return;
+		size_t h = hashAt(data, pos);
+		prev[pos] = head[h];
+		head[h] = static_cast<int32_t>(pos);
+	}
+
+	// longest match for `pos` among positions already inserted, len 0 when there's none
+	void find(size_t pos, int maxChain, size_t& bestLen, size_t& bestDisp) const
+	{
+		bestLen = 0;
+		bestDisp = 0;
+		if (pos + 2 >= size) return;
+
+		const size_t maxLen = std::min(kLZ77MaxMatch, size - pos);
+		int chain = maxChain;
+		for (int32_t cand = head[hashAt(data, pos)]; cand >= 0 && chain-- > 0; cand = prev[cand]) {
+			size_t disp = pos - static_cast<size_t>(cand);
+			if (disp > kLZ77Window) break;
+			if (disp < minDisp) continue;
+
+			size_t len = 0;
+			while (len < maxLen && data[cand + len] == data[pos + len]) len++;
+
+			if (len > bestLen) {
+				bestLen = len;
+				bestDisp = disp;
+				if (len == maxLen) break;
+			}
+		}
+	}
+
+private:
+	const uint8_t* data;
+	size_t size;
+	size_t minDisp;
+	std::vector<int32_t> head;
+	std::vector<int32_t> prev;
+};
+
+// groups tokens 8 to a flag byte, msb first
+class TokenWriter {
+public:
+	explicit TokenWriter(std::vector<uint8_t>& out) : out(out) {}
+
+	void literal(uint8_t value)
+	{
+		nextToken(false);
+		out.push_back(value);
+	}
+
+	void match(size_t len, size_t disp)
+	{
+		nextToken(true);
+		out.push_back(static_cast<uint8_t>(((len - kLZ77MinMatch) << 4) | ((disp - 1) >> 8)));
+		out.push_back(static_cast<uint8_t>((disp - 1) & 0xFF));
+	}
+
+private:
+	void nextToken(bool isMatch)
+	{
+		if (bit < 0) {
+			flagPos = out.size();
+			out.push_back(0);
+			bit = 7;
+		}
+		if (isMatch) out[flagPos] |= static_cast<uint8_t>(1 << bit);
+		bit--;
+	}
+
+	std::vector<uint8_t>& out;
+	size_t flagPos = 0;
+	int bit = -1;
+};
+
+const std::array<uint32_t, 256>& getCrcTable()
+{
+	static const std::array<uint32_t, 256> table = []() {
+		std::array<uint32_t, 256> t = {};
+		for (uint32_t i = 0; i < 256; i++) {
+			uint32_t c = i;
+			for (int k = 0; k < 8; k++) {
+				c = (c & 1) ? (0xEDB88320u ^ (c >> 1)) : (c >> 1);
+			}
+			t[i] = c;
+		}
+		return t;
+	}();
+	return table;
+}
+
+}
+
+std::vector<uint8_t> Compression::compressLZ77(const uint8_t* data, size_t size, LZ77Mode mode, bool vramSafe)
+{
+	std::vector<uint8_t> out;
+	if (size > MAX_DECOMPRESSED_SIZE) {
+		return out;
+	}
+
+	out.reserve(4 + size + size / 8 + 4);
+	out.push_back(LZ77_TYPE);
+	out.push_back(static_cast<uint8_t>(size & 0xFF));
+	out.push_back(static_cast<uint8_t>((size >> 8) & 0xFF));
+	out.push_back(static_cast<uint8_t>((size >> 16) & 0xFF));
+
+	MatchFinder finder(data, size, vramSafe ? 2 : 1);
+	TokenWriter writer(out);
+
+	if (mode == LZ77Mode::Greedy) {
+		size_t pos = 0;
+		while (pos < size) {
+			size_t bestLen = 0;
+			size_t bestDisp = 0;
+			finder.find(pos, kMaxChainLength, bestLen, bestDisp);
+
+			if (bestLen >= kLZ77MinMatch) {
+				writer.match(bestLen, bestDisp);
+				for (size_t k = 0; k < bestLen; k++) {
+					finder.insert(pos + k);
+				}
+				pos += bestLen;
+			}
+			else {
+				writer.literal(data[pos]);
+				finder.insert(pos);
+				pos++;
+			}
+		}
+	}
+	else {
+		// every match costs 17 bits (flag + 2 bytes) and every literal 9 whatever the distance,
+		// so the longest match at each position is all the parse needs: any shorter length at
+		// the same distance matches too. walk back from the end picking the cheapest tail
+		std::vector<uint8_t> longest(size);
+		std::vector<uint16_t> longestDisp(size);
+		for (size_t pos = 0; pos < size; pos++) {
+			size_t len = 0;
+			size_t disp = 0;
+			finder.find(pos, kOptimalChainLength, len, disp);
+			longest[pos] = static_cast<uint8_t>(len);
+			longestDisp[pos] = static_cast<uint16_t>(disp);
+			finder.insert(pos);
+		}
+
+		std::vector<uint32_t> cost(size + 1, 0);
+		std::vector<uint8_t> choice(size, 0); // 0 for a literal, the match length otherwise
+		for (size_t pos = size; pos-- > 0;) {
+			cost[pos] = cost[pos + 1] + 9;
+			for (size_t len = kLZ77MinMatch; len <= longest[pos]; len++) {
+				uint32_t matchCost = cost[pos + len] + 17;
+				if (matchCost <= cost[pos]) {
+					cost[pos] = matchCost;
+					choice[pos] = static_cast<uint8_t>(len);
+				}
+			}
+		}
+
+		size_t pos = 0;
+		while (pos < size) {
+			if (choice[pos] == 0) {
+				writer.literal(data[pos]);
+				pos++;
+			}
+			else {
+				writer.match(choice[pos], longestDisp[pos]);
+				pos += choice[pos];
+			}
+		}
+	}
+
+	// bios wants it word aligned
+	while (out.size() % 4 != 0) {
+		out.push_back(0);
+	}
+
+	return out;
+}
+
+bool Compression::decompressLZ77(const uint8_t* data, size_t size, std::vector<uint8_t>& out, size_t* consumed)
+{
+	out.clear();
+	if (size < 4 || data[0] != LZ77_TYPE) {
+		return false;
+	}
+
+	const size_t outSize = static_cast<size_t>(data[1]) | (static_cast<size_t>(data[2]) << 8) | (static_cast<size_t>(data[3]) << 16);
+	out.resize(outSize);
+
+	auto fail = [&out]() {
+		out.clear();
+		return false;
+	};
+
+	// raw pointers instead of push_back, the size is known up front
+	uint8_t* const outStart = out.data();
+	uint8_t* const outEnd = outStart + outSize;
+	uint8_t* dst = outStart;
+	const uint8_t* src = data + 4;
+	const uint8_t* const srcEnd = data + size;
+
+	while (dst < outEnd) {
+		if (src >= srcEnd) return fail();
+		uint8_t flags = *src++;
+
+		// a whole block of literals is common in noisy graphics
+		if (flags == 0 && srcEnd - src >= 8 && outEnd - dst >= 8) {
+			memcpy(dst, src, 8);
+			dst += 8;
+			src += 8;
+			continue;
+		}
+
+		// far enough from both ends that no token of this block can overrun either buffer
+		// (8 tokens read at most 16 bytes and write at most 8 * 18 + 6 counting the over-copy)
+		if (srcEnd - src >= 16 && outEnd - dst >= 8 * 18 + 6) {
+			for (int bit = 0; bit < 8; bit++, flags <<= 1) {
+				if ((flags & 0x80) == 0) {
+					*dst++ = *src++;
+					continue;
+				}
+
+				const size_t len = (src[0] >> 4) + kLZ77MinMatch;
+				const size_t disp = ((static_cast<size_t>(src[0] & 0x0F) << 8) | src[1]) + 1;
+				src += 2;
+				if (disp > static_cast<size_t>(dst - outStart)) return fail();
+
+				const uint8_t* from = dst - disp;
+				if (disp >= 8) {
+					// matches are 18 bytes at most: three fixed 8 byte copies beat a variable
+					// memcpy, and with disp >= 8 every chunk only reads bytes already written
+					memcpy(dst, from, 8);
+					memcpy(dst + 8, from + 8, 8);
+					memcpy(dst + 16, from + 16, 8);
+				}
+				else {
+					for (size_t k = 0; k < len; k++) dst[k] = from[k];
+				}
+				dst += len;
+			}
+			continue;
+		}
+
+		for (int bit = 0; bit < 8 && dst < outEnd; bit++, flags <<= 1) {
+			if ((flags & 0x80) == 0) {
+				if (src >= srcEnd) return fail();
+				*dst++ = *src++;
+				continue;
+			}
+
+			if (srcEnd - src < 2) return fail();
+			size_t len = (src[0] >> 4) + kLZ77MinMatch;
+			const size_t disp = ((static_cast<size_t>(src[0] & 0x0F) << 8) | src[1]) + 1;
+			src += 2;
+
+			if (disp > static_cast<size_t>(dst - outStart)) return fail();
+
+			len = std::min(len, static_cast<size_t>(outEnd - dst));
+			const uint8_t* from = dst - disp;
+			if (disp >= len) {
+				memcpy(dst, from, len);
+			}
+			else if (disp == 1) {
+				memset(dst, *from, len);
+			}
+			else {
+				// overlapping copy repeats the last `disp` bytes, has to go front to back
+				for (size_t k = 0; k < len; k++) dst[k] = from[k];
+			}
+			dst += len;
+		}
+	}
+
+	if (consumed != nullptr) {
+		*consumed = static_cast<size_t>(src - data);
+	}
+	return true;
+}
+
+bool Compression::decompressRLE(const uint8_t* data, size_t size, std::vector<uint8_t>& out, size_t* consumed)
+{
+	out.clear();
+	if (size < 4 || data[0] != RLE_TYPE) {
+		return false;
+	}
+
+	const size_t outSize = static_cast<size_t>(data[1]) | (static_cast<size_t>(data[2]) << 8) | (static_cast<size_t>(data[3]) << 16);
+	out.resize(outSize);
+
+	auto fail = [&out]() {
+		out.clear();
+		return false;
+	};
+
+	size_t pos = 4;
+	size_t written = 0;
+	while (written < outSize) {
+		if (pos >= size) return fail();
+
+		const uint8_t flag = data[pos++];
+		if (flag & 0x80) {
+			// run of one byte, 3..130 long
+			if (pos >= size) return fail();
+			size_t len = std::min<size_t>((flag & 0x7F) + 3, outSize - written);
+			memset(out.data() + written, data[pos++], len);
+			written += len;
+		}
+		else {
+			// 1..128 bytes copied as is
+			size_t len = (flag & 0x7F) + 1;
+			if (len > size - pos) return fail();
+			size_t kept = std::min(len, outSize - written);
+			memcpy(out.data() + written, data + pos, kept);
+			pos += len;
+			written += kept;
+		}
+	}
+
+	if (consumed != nullptr) {
+		*consumed = pos;
+	}
+	return true;
+}
+
+bool Compression::decompressHuffman(const uint8_t* data, size_t size, std::vector<uint8_t>& out, size_t* consumed)
+{
+	out.clear();
+	if (size < 5 || (data[0] & 0xF0) != HUFFMAN_TYPE) {
+		return false;
+	}
+
+	const int symbolBits = data[0] & 0x0F;
+	if (symbolBits != 4 && symbolBits != 8) {
+		return false;
+	}
+
+	const size_t outSize = static_cast<size_t>(data[1]) | (static_cast<size_t>(data[2]) << 8) | (static_cast<size_t>(data[3]) << 16);
+
+	// tree table: a size byte, then nodes. each node holds a 6 bit offset to its pair of
+	// children plus two flags saying which of them are leaves. the root sits right after the size
+	const size_t treeEnd = 4 + (static_cast<size_t>(data[4]) + 1) * 2;
+	const size_t rootPos = 5;
+	if (treeEnd > size) {
+		return false;
+	}
+
+	out.assign(outSize, 0);
+	auto fail = [&out]() {
+		out.clear();
+		return false;
+	};
+
+	size_t pos = treeEnd;
+	size_t written = 0;
+	bool highNibble = false;
+	size_t nodePos = rootPos;
+
+	while (written < outSize) {
+		if (size - pos < 4) return fail();
+		uint32_t bits = static_cast<uint32_t>(data[pos]) | (static_cast<uint32_t>(data[pos + 1]) << 8) |
+			(static_cast<uint32_t>(data[pos + 2]) << 16) | (static_cast<uint32_t>(data[pos + 3]) << 24);
+		pos += 4;
+
+		for (int bit = 0; bit < 32 && written < outSize; bit++, bits <<= 1) {
+			const uint8_t node = data[nodePos];
+			const bool right = (bits & 0x80000000u) != 0;
+			const size_t childPos = (nodePos & ~static_cast<size_t>(1)) + static_cast<size_t>(node & 0x3F) * 2 + 2 + (right ? 1 : 0);
+			if (childPos >= treeEnd) return fail();
+
+			if ((node & (right ? 0x40 : 0x80)) == 0) {
+				nodePos = childPos;
+				continue;
+			}
+
+			const uint8_t symbol = data[childPos];
+			nodePos = rootPos;
+			if (symbolBits == 8) {
+				out[written++] = symbol;
+			}
+			else if (!highNibble) {
+				out[written] = symbol & 0x0F;
+				highNibble = true;
+			}
+			else {
+				out[written++] |= static_cast<uint8_t>((symbol & 0x0F) << 4);
+				highNibble = false;
+			}
+		}
+	}
+
+	if (consumed != nullptr) {
+		*consumed = pos;
+	}
+	return true;
+}
+
+bool Compression::decompress(const uint8_t* data, size_t size, std::vector<uint8_t>& out, size_t* consumed)
+{
+	out.clear();
+	if (size < 4) {
+		return false;
+	}
+
+	switch (data[0] & 0xF0) {
+	case LZ77_TYPE: return decompressLZ77(data, size, out, consumed);
+	case HUFFMAN_TYPE: return decompressHuffman(data, size, out, consumed);
+	case RLE_TYPE: return decompressRLE(data, size, out, consumed);
+	default: return false;
+	}
+}
+
+bool Compression::readHeader(const uint8_t* data, size_t size, uint8_t& type, size_t& decompressedSize)
+{
+	if (size < 4) {
+		return false;
+	}
+
+	type = data[0];
+	const bool known = type == LZ77_TYPE || type == RLE_TYPE || type == (HUFFMAN_TYPE | 4) || type == (HUFFMAN_TYPE | 8);
+	decompressedSize = static_cast<size_t>(data[1]) | (static_cast<size_t>(data[2]) << 8) | (static_cast<size_t>(data[3]) << 16);
+	return known;
+}
+
+const char* Compression::getTypeName(uint8_t type)
+{
+	switch (type) {
+	case LZ77_TYPE: return "LZ77";
+	case RLE_TYPE: return "RLE";
+	case HUFFMAN_TYPE | 4: return "Huffman (4 bit)";
+	case HUFFMAN_TYPE | 8: return "Huffman (8 bit)";
+	default: return "unknown";
+	}
+}
+
+uint32_t Compression::crc32(const uint8_t* data, size_t size, uint32_t crc)
+{
+	const auto& table = getCrcTable();
+	crc = ~crc;
+	for (size_t i = 0; i < size; i++) {
+		crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+	}
+	return ~crc;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// GBA BIOS style compression (the same streams LZ77UnCompWram, RLUnCompWram and HuffUnComp eat).
+// every stream starts with a type byte and a 24 bit decompressed size. the decoders never read
+// past `size` and report how many input bytes the stream used in `consumed`
+class Compression
+{
+public:
+	static constexpr uint8_t LZ77_TYPE = 0x10;
+	static constexpr uint8_t HUFFMAN_TYPE = 0x20; // low nibble is the symbol size, 4 or 8 bits
+	static constexpr uint8_t RLE_TYPE = 0x30;
+	static constexpr size_t MAX_DECOMPRESSED_SIZE = 0xFFFFFF;
+
+	enum class LZ77Mode {
+		Greedy,  // longest match at each step, fast
+		Optimal  // smallest possible output for the matches found, a few times slower
+	};
+
+	// vramSafe never emits a distance of 1: LZ77UnCompVram writes halfwords, so it can't
+	// copy from the byte it's still putting together
+	static std::vector<uint8_t> compressLZ77(const uint8_t* data, size_t size, LZ77Mode mode = LZ77Mode::Greedy, bool vramSafe = false);
+	static bool decompressLZ77(const uint8_t* data, size_t size, std::vector<uint8_t>& out, size_t* consumed = nullptr);
+	static bool decompressRLE(const uint8_t* data, size_t size, std::vector<uint8_t>& out, size_t* consumed = nullptr);
+	static bool decompressHuffman(const uint8_t* data, size_t size, std::vector<uint8_t>& out, size_t* consumed = nullptr);
+
+	// picks the decoder from the type byte
+	static bool decompress(const uint8_t* data, size_t size, std::vector<uint8_t>& out, size_t* consumed = nullptr);
+	// type (high nibble of the first byte, or the whole byte for huffman) and decompressed size, without decoding
+	static bool readHeader(const uint8_t* data, size_t size, uint8_t& type, size_t& decompressedSize);
+	static const char* getTypeName(uint8_t type);
+
+	static uint32_t crc32(const uint8_t* data, size_t size, uint32_t crc = 0);
+};
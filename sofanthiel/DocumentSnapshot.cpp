@@ -0,0 +1,166 @@
+#include "DocumentSnapshot.h"
+
+#include <cstring>
+#include <string>
+#include <unordered_map>
+
+namespace {
+
+// same index first (the usual case), then by name so inserting one cel near the top
+// doesn't make every cel after it look new
+template <typename T, typename Same>
+std::vector<std::shared_ptr<const T>> shareElements(const std::vector<T>& current,
+	const std::vector<std::shared_ptr<const T>>* previous, Same same)
+{
+	std::vector<std::shared_ptr<const T>> out;
+	out.reserve(current.size());
+
+	std::unordered_map<std::string, const std::shared_ptr<const T>*> byName;
+	bool byNameBuilt = false;
+
+	for (size_t i = 0; i < current.size(); i++) {
+		const T& element = current[i];
+		const std::shared_ptr<const T>* match = nullptr;
+
+		if (previous != nullptr) {
+			if (i < previous->size() && same(*(*previous)[i], element)) {
+				match = &(*previous)[i];
+			}
+			else {
+				if (!byNameBuilt) {
+					for (const auto& prev : *previous) {
+						byName.emplace(prev->name, &prev);
+					}
+					byNameBuilt = true;
+				}
+
+				auto it = byName.find(element.name);
+				if (it != byName.end() && same(**it->second, element)) {
+					match = it->second;
+				}
+			}
+		}
+
+		out.push_back(match != nullptr ? *match : std::make_shared<const T>(element));
+	}
+
+	return out;
+}
+
+}
+
+bool sameTiles(const Tiles& lhs, const Tiles& rhs)
+{
+	if (lhs.getSize() != rhs.getSize()) {
+		return false;
+	}
+
+	for (int i = 0; i < lhs.getSize(); i++) {
+		TileData a = lhs.getTile(i);
+		TileData b = rhs.getTile(i);
+		if (memcmp(&a, &b, sizeof(TileData)) != 0) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool sameCel(const AnimationCel& lhs, const AnimationCel& rhs)
+{
+	return lhs.name == rhs.name && lhs.oams.size() == rhs.oams.size() &&
+		(lhs.oams.empty() || memcmp(lhs.oams.data(), rhs.oams.data(), lhs.oams.size() * sizeof(TengokuOAM)) == 0);
+}
+
+bool sameAnimation(const Animation& lhs, const Animation& rhs)
+{
+	if (lhs.name != rhs.name || lhs.entries.size() != rhs.entries.size()) {
+		return false;
+	}
+
+	for (size_t i = 0; i < lhs.entries.size(); i++) {
+		if (lhs.entries[i].celName != rhs.entries[i].celName || lhs.entries[i].duration != rhs.entries[i].duration) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool sameMetadata(const ProjectMetadata& lhs, const ProjectMetadata& rhs)
+{
+	return lhs.celFilename == rhs.celFilename && lhs.currentPalette == rhs.currentPalette &&
+		lhs.currentAnimation == rhs.currentAnimation && lhs.frameRate == rhs.frameRate &&
+		lhs.loopAnimation == rhs.loopAnimation && lhs.useTilePalettes == rhs.useTilePalettes;
+}
+
+std::shared_ptr<const DocumentSnapshot> DocumentSnapshot::capture(const Tiles& tiles, const std::vector<Palette>& palettes,
+	const std::vector<uint8_t>& tilePalettes, const std::vector<AnimationCel>& cels, const std::vector<Animation>& animations,
+	const ProjectMetadata& metadata, const std::shared_ptr<const DocumentSnapshot>& previous)
+{
+	auto snapshot = std::make_shared<DocumentSnapshot>();
+
+	if (previous != nullptr && sameTiles(*previous->tiles, tiles)) {
+		snapshot->tiles = previous->tiles;
+	}
+	else {
+		snapshot->tiles = std::make_shared<const Tiles>(tiles);
+	}
+
+	bool samePalettes = previous != nullptr && previous->palettes->size() == palettes.size() &&
+		(palettes.empty() || memcmp(previous->palettes->data(), palettes.data(), palettes.size() * sizeof(Palette)) == 0);
+	snapshot->palettes = samePalettes ? previous->palettes : std::make_shared<const std::vector<Palette>>(palettes);
+
+	bool sameTilePalettes = previous != nullptr && *previous->tilePalettes == tilePalettes;
+	snapshot->tilePalettes = sameTilePalettes ? previous->tilePalettes : std::make_shared<const std::vector<uint8_t>>(tilePalettes);
+
+	snapshot->animationCels = shareElements(cels, previous ? &previous->animationCels : nullptr, sameCel);
+	snapshot->animations = shareElements(animations, previous ? &previous->animations : nullptr, sameAnimation);
+	snapshot->metadata = metadata;
+
+	// nothing changed at all, hand back the old one so callers can compare pointers
+	if (previous != nullptr && snapshot->tiles == previous->tiles && snapshot->palettes == previous->palettes &&
+		snapshot->tilePalettes == previous->tilePalettes && snapshot->animationCels == previous->animationCels &&
+		snapshot->animations == previous->animations && sameMetadata(snapshot->metadata, previous->metadata)) {
+		return previous;
+	}
+
+	return snapshot;
+}
+
+std::shared_ptr<const DocumentSnapshot> DocumentSnapshot::capture(const ProjectData& project,
+	const std::shared_ptr<const DocumentSnapshot>& previous)
+{
+	return capture(project.tiles, project.palettes, project.tilePalettes, project.animationCels, project.animations,
+		project.metadata, previous);
+}
+
+std::vector<AnimationCel> DocumentSnapshot::copyAnimationCels() const
+{
+	std::vector<AnimationCel> out;
+	out.reserve(animationCels.size());
+	for (const auto& cel : animationCels) {
+		out.push_back(*cel);
+	}
+	return out;
+}
+
+std::vector<Animation> DocumentSnapshot::copyAnimations() const
+{
+	std::vector<Animation> out;
+	out.reserve(animations.size());
+	for (const auto& anim : animations) {
+		out.push_back(*anim);
+	}
+	return out;
+}
+
+ProjectData DocumentSnapshot::materialize() const
+{
+	ProjectData project;
+	project.tiles = *tiles;
+	project.palettes = *palettes;
+	project.tilePalettes = *tilePalettes;
+	project.animationCels = copyAnimationCels();
+	project.animations = copyAnimations();
+	project.metadata = metadata;
+	return project;
+}
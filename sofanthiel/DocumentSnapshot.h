@@ -0,0 +1,35 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "ProjectFile.h"
+
+// immutable, structurally shared view of the document. every cel/animation is its own
+// shared element, so consecutive snapshots share whatever didn't change in between and
+// handing one to another thread is just a refcount bump. nothing in here ever gets mutated
+struct DocumentSnapshot {
+	std::shared_ptr<const Tiles> tiles;
+	std::shared_ptr<const std::vector<Palette>> palettes;
+	std::shared_ptr<const std::vector<uint8_t>> tilePalettes;
+	std::vector<std::shared_ptr<const AnimationCel>> animationCels;
+	std::vector<std::shared_ptr<const Animation>> animations;
+	ProjectMetadata metadata;
+
+	// reuses every part of `previous` that still matches, only the edited bits get copied
+	static std::shared_ptr<const DocumentSnapshot> capture(const Tiles& tiles, const std::vector<Palette>& palettes,
+		const std::vector<uint8_t>& tilePalettes, const std::vector<AnimationCel>& cels, const std::vector<Animation>& animations,
+		const ProjectMetadata& metadata, const std::shared_ptr<const DocumentSnapshot>& previous);
+	static std::shared_ptr<const DocumentSnapshot> capture(const ProjectData& project,
+		const std::shared_ptr<const DocumentSnapshot>& previous = nullptr);
+
+	// deep copies back into plain containers, for workers and undo
+	std::vector<AnimationCel> copyAnimationCels() const;
+	std::vector<Animation> copyAnimations() const;
+	ProjectData materialize() const;
+};
+
+bool sameTiles(const Tiles& lhs, const Tiles& rhs);
+bool sameCel(const AnimationCel& lhs, const AnimationCel& rhs);
+bool sameAnimation(const Animation& lhs, const Animation& rhs);
+bool sameMetadata(const ProjectMetadata& lhs, const ProjectMetadata& rhs);
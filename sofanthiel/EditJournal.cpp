@@ -0,0 +1,502 @@
+#include "EditJournal.h"
+
+#include <cstring>
+#include <fstream>
+
+#include "ByteStream.h"
+#include "Compression.h"
+#include "FileUtils.h"
+
+namespace {
+
+constexpr uint32_t kJournalVersion = 2; // 2 added the tile palette map and useTilePalettes
+constexpr size_t kRecordHeaderSize = 8;
+constexpr int kJournalSlots = 8;
+
+enum JournalOp : uint8_t {
+	OP_TILE_COUNT = 1,
+	OP_TILE = 2,
+	OP_PALETTE_COUNT = 3,
+	OP_PALETTE = 4,
+	OP_CEL_COUNT = 5,
+	OP_CEL = 6,
+	OP_ANIMATION_COUNT = 7,
+	OP_ANIMATION = 8,
+	OP_METADATA = 9,
+	OP_TILE_PALETTES = 10
+};
+
+void packTile(const TileData& tile, uint8_t out[32])
+{
+	for (int byteIndex = 0; byteIndex < 32; ++byteIndex) {
+		int py = byteIndex / 4;
+		int px = (byteIndex % 4) * 2;
+		out[byteIndex] = static_cast<uint8_t>((tile.data[py][px] & 0x0F) | ((tile.data[py][px + 1] & 0x0F) << 4));
+	}
+}
+
+TileData unpackTile(const uint8_t* packed)
+{
+	TileData tile = {};
+	for (int i = 0; i < 8; i++) {
+		for (int j = 0; j < 8; j++) {
+			tile.data[i][j] = (packed[i * 4 + j / 2] >> ((j % 2) * 4)) & 0x0F;
+		}
+	}
+	return tile;
+}
+
+void writeCel(ByteWriter& writer, const AnimationCel& cel)
+{
+	writer.putString(cel.name);
+	writer.putU32(static_cast<uint32_t>(cel.oams.size()));
+	for (const auto& oam : cel.oams) {
+		uint16_t raw[3];
+		memcpy(raw, &oam, sizeof(raw));
+		writer.putU16(raw[0]);
+		writer.putU16(raw[1]);
+		writer.putU16(raw[2]);
+	}
+}
+
+void writeAnimation(ByteWriter& writer, const Animation& anim)
+{
+	writer.putString(anim.name);
+	writer.putU32(static_cast<uint32_t>(anim.entries.size()));
+	for (const auto& entry : anim.entries) {
+		writer.putString(entry.celName);
+		writer.putU8(entry.duration);
+	}
+}
+
+void writeMetadata(ByteWriter& writer, const ProjectMetadata& metadata)
+{
+	uint32_t frameRateBits = 0;
+	memcpy(&frameRateBits, &metadata.frameRate, sizeof(frameRateBits));
+
+	writer.putString(metadata.celFilename);
+	writer.putU32(static_cast<uint32_t>(metadata.currentPalette));
+	writer.putU32(static_cast<uint32_t>(metadata.currentAnimation));
+	writer.putU32(frameRateBits);
+	writer.putU8(metadata.loopAnimation ? 1 : 0);
+	writer.putU8(metadata.useTilePalettes ? 1 : 0);
+}
+
+}
+
+EditJournal::~EditJournal()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	wakeWorker.notify_all();
+
+	if (worker.joinable()) {
+		worker.join();
+	}
+
+	if (journalFile != nullptr) {
+		fclose(journalFile);
+	}
+}
+
+bool EditJournal::claimSlot(const std::string& directory)
+{
+	auto slotPath = [&directory](int slot) {
+		// slot 0 keeps the old name so journals from before slots still get recovered
+		return directory + (slot == 0 ? "autosave.journal" : "autosave-" + std::to_string(slot) + ".journal");
+	};
+
+	// leftovers first, a free slot with a journal in it belongs to an instance that crashed
+	for (int pass = 0; pass < 2; pass++) {
+		for (int slot = 0; slot < kJournalSlots; slot++) {
+			const std::string journalPath = slotPath(slot);
+			if (pass == 0 && !std::ifstream(journalPath, std::ios::binary).is_open()) {
+				continue;
+			}
+			if (slotLock.tryLock(journalPath + ".lock")) {
+				path = journalPath;
+				return true;
+			}
+		}
+	}
+
+	SDL_Log("Every journal slot in %s is in use, not journaling this session", directory.c_str());
+	return false;
+}
+
+std::vector<uint8_t> EditJournal::buildHeader() const
+{
+	ByteWriter writer;
+	writer.putBytes("ENJR", 4);
+	writer.putU32(kJournalVersion);
+	writer.putString(basePath);
+	return writer.bytes;
+}
+
+bool EditJournal::readRecovery(std::string& outBasePath, std::vector<std::vector<uint8_t>>& outRecords) const
+{
+	outRecords.clear();
+	if (path.empty()) {
+		return false;
+	}
+
+	std::ifstream file(path, std::ios::binary);
+	if (!file.is_open()) {
+		return false;
+	}
+
+	std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	if (bytes.size() < 8 || memcmp(bytes.data(), "ENJR", 4) != 0) {
+		return false;
+	}
+
+	ByteCursor cursor(bytes.data() + 4, bytes.size() - 4);
+	if (cursor.getU32() != kJournalVersion) {
+		SDL_Log("Ignoring journal with unknown version: %s", path.c_str());
+		return false;
+	}
+	outBasePath = cursor.getString();
+
+	while (cursor.ok() && cursor.remaining() >= kRecordHeaderSize) {
+		uint32_t size = cursor.getU32();
+		uint32_t checksum = cursor.getU32();
+		const uint8_t* payload = cursor.getBytes(size);
+
+		// a torn write at the tail is exactly what a crash looks like, keep everything before it
+		if (payload == nullptr || Compression::crc32(payload, size) != checksum) {
+			SDL_Log("Journal %s ends in a damaged record, recovering %zu record(s) before it", path.c_str(), outRecords.size());
+			break;
+		}
+		outRecords.emplace_back(payload, payload + size);
+	}
+
+	return !outRecords.empty();
+}
+
+bool EditJournal::applyRecord(const std::vector<uint8_t>& record, ProjectData& project)
+{
+	ByteCursor cursor(record.data(), record.size());
+
+	while (cursor.ok() && cursor.remaining() > 0) {
+		uint8_t op = cursor.getU8();
+		switch (op) {
+		case OP_TILE_COUNT:
+			project.tiles.resize(static_cast<int>(cursor.getU32()));
+			break;
+		case OP_TILE: {
+			int index = static_cast<int>(cursor.getU32());
+			const uint8_t* packed = cursor.getBytes(32);
+			if (packed == nullptr) return false;
+			project.tiles.setTile(index, unpackTile(packed));
+			break;
+		}
+		case OP_PALETTE_COUNT:
+			project.palettes.resize(cursor.getU32());
+			break;
+		case OP_PALETTE: {
+			uint32_t index = cursor.getU32();
+			const uint8_t* colors = cursor.getBytes(sizeof(Palette));
+			if (colors == nullptr || index >= project.palettes.size()) return false;
+			memcpy(&project.palettes[index], colors, sizeof(Palette));
+			break;
+		}
+		case OP_CEL_COUNT:
+			project.animationCels.resize(cursor.getU32());
+			break;
+		case OP_CEL: {
+			uint32_t index = cursor.getU32();
+			if (index >= project.animationCels.size()) return false;
+
+			AnimationCel& cel = project.animationCels[index];
+			cel.name = cursor.getString();
+			uint32_t oamCount = cursor.getU32();
+			if (oamCount > cursor.remaining() / 6) return false;
+
+			cel.oams.resize(oamCount);
+			for (auto& oam : cel.oams) {
+				uint16_t raw[3] = { cursor.getU16(), cursor.getU16(), cursor.getU16() };
+				memcpy(&oam, raw, sizeof(raw));
+			}
+			break;
+		}
+		case OP_ANIMATION_COUNT:
+			project.animations.resize(cursor.getU32());
+			break;
+		case OP_ANIMATION: {
+			uint32_t index = cursor.getU32();
+			if (index >= project.animations.size()) return false;
+
+			Animation& anim = project.animations[index];
+			anim.name = cursor.getString();
+			uint32_t entryCount = cursor.getU32();
+			if (entryCount > cursor.remaining() / 5) return false;
+
+			anim.entries.resize(entryCount);
+			for (auto& entry : anim.entries) {
+				entry.celName = cursor.getString();
+				entry.duration = cursor.getU8();
+			}
+			break;
+		}
+		case OP_METADATA: {
+			project.metadata.celFilename = cursor.getString();
+			project.metadata.currentPalette = static_cast<int32_t>(cursor.getU32());
+			project.metadata.currentAnimation = static_cast<int32_t>(cursor.getU32());
+			uint32_t frameRateBits = cursor.getU32();
+			memcpy(&project.metadata.frameRate, &frameRateBits, sizeof(frameRateBits));
+			project.metadata.loopAnimation = cursor.getU8() != 0;
+			project.metadata.useTilePalettes = cursor.getU8() != 0;
+			break;
+		}
+		case OP_TILE_PALETTES: {
+			uint32_t count = cursor.getU32();
+			const uint8_t* indices = cursor.getBytes(count);
+			if (indices == nullptr) return false;
+			project.tilePalettes.assign(indices, indices + count);
+			break;
+		}
+		default:
+			SDL_Log("Unknown journal op %u", op);
+			return false;
+		}
+	}
+
+	return cursor.ok();
+}
+
+void EditJournal::reset(const std::string& newBasePath, std::shared_ptr<const DocumentSnapshot> base)
+{
+	if (path.empty() || base == nullptr) {
+		return;
+	}
+
+	basePath = newBasePath;
+	active = true;
+	shadow = std::move(base);
+
+	liveRecords.clear();
+	// bump so marks handed out before the reset can't compact the new document
+	firstLiveSequence = ++nextSequence;
+
+	queueJob(JobType::Rewrite, buildHeader());
+}
+
+bool EditJournal::record(std::shared_ptr<const DocumentSnapshot> snapshot)
+{
+	if (!active || snapshot == nullptr || snapshot == shadow) {
+		return false;
+	}
+
+	ByteWriter delta;
+
+	if (snapshot->tiles != shadow->tiles) {
+		const Tiles& tiles = *snapshot->tiles;
+		const Tiles& oldTiles = *shadow->tiles;
+		const int tileCount = tiles.getSize();
+		const int oldCount = oldTiles.getSize();
+
+		if (tileCount != oldCount) {
+			delta.putU8(OP_TILE_COUNT);
+			delta.putU32(static_cast<uint32_t>(tileCount));
+		}
+
+		// growing fills with blank tiles on replay, so only non-blank new ones need sending
+		const TileData blank = {};
+		for (int i = 0; i < tileCount; i++) {
+			TileData tile = tiles.getTile(i);
+			TileData old = i < oldCount ? oldTiles.getTile(i) : blank;
+			if (memcmp(&tile, &old, sizeof(TileData)) == 0) continue;
+
+			uint8_t packed[32];
+			packTile(tile, packed);
+			delta.putU8(OP_TILE);
+			delta.putU32(static_cast<uint32_t>(i));
+			delta.putBytes(packed, sizeof(packed));
+		}
+	}
+
+	if (snapshot->palettes != shadow->palettes) {
+		const auto& palettes = *snapshot->palettes;
+		const auto& oldPalettes = *shadow->palettes;
+
+		if (palettes.size() != oldPalettes.size()) {
+			delta.putU8(OP_PALETTE_COUNT);
+			delta.putU32(static_cast<uint32_t>(palettes.size()));
+		}
+
+		const Palette blank = {};
+		for (size_t i = 0; i < palettes.size(); i++) {
+			const Palette& old = i < oldPalettes.size() ? oldPalettes[i] : blank;
+			if (memcmp(&palettes[i], &old, sizeof(Palette)) == 0) continue;
+
+			delta.putU8(OP_PALETTE);
+			delta.putU32(static_cast<uint32_t>(i));
+			delta.putBytes(&palettes[i], sizeof(Palette));
+		}
+	}
+
+	// one byte per tile and it only changes when an image gets converted, so it goes whole
+	if (snapshot->tilePalettes != shadow->tilePalettes) {
+		const auto& tilePalettes = *snapshot->tilePalettes;
+		delta.putU8(OP_TILE_PALETTES);
+		delta.putU32(static_cast<uint32_t>(tilePalettes.size()));
+		delta.putBytes(tilePalettes.data(), tilePalettes.size());
+	}
+
+	const auto& cels = snapshot->animationCels;
+	if (cels.size() != shadow->animationCels.size()) {
+		delta.putU8(OP_CEL_COUNT);
+		delta.putU32(static_cast<uint32_t>(cels.size()));
+	}
+	for (size_t i = 0; i < cels.size(); i++) {
+		if (i < shadow->animationCels.size() && cels[i] == shadow->animationCels[i]) continue;
+
+		delta.putU8(OP_CEL);
+		delta.putU32(static_cast<uint32_t>(i));
+		writeCel(delta, *cels[i]);
+	}
+
+	const auto& animations = snapshot->animations;
+	if (animations.size() != shadow->animations.size()) {
+		delta.putU8(OP_ANIMATION_COUNT);
+		delta.putU32(static_cast<uint32_t>(animations.size()));
+	}
+	for (size_t i = 0; i < animations.size(); i++) {
+		if (i < shadow->animations.size() && animations[i] == shadow->animations[i]) continue;
+
+		delta.putU8(OP_ANIMATION);
+		delta.putU32(static_cast<uint32_t>(i));
+		writeAnimation(delta, *animations[i]);
+	}
+
+	if (!sameMetadata(snapshot->metadata, shadow->metadata)) {
+		delta.putU8(OP_METADATA);
+		writeMetadata(delta, snapshot->metadata);
+	}
+
+	shadow = std::move(snapshot);
+
+	if (delta.bytes.empty()) {
+		return false;
+	}
+
+	ByteWriter framed;
+	framed.bytes.reserve(kRecordHeaderSize + delta.bytes.size());
+	framed.putU32(static_cast<uint32_t>(delta.bytes.size()));
+	framed.putU32(Compression::crc32(delta.bytes.data(), delta.bytes.size()));
+	framed.putBytes(delta.bytes.data(), delta.bytes.size());
+
+	liveRecords.push_back(framed.bytes);
+	nextSequence++;
+	queueJob(JobType::Append, std::move(framed.bytes));
+	return true;
+}
+
+void EditJournal::compact(uint64_t savedMark, const std::string& savedPath)
+{
+	// a reset since that save started means the mark belongs to some other document
+	if (!active || savedMark < firstLiveSequence || savedMark > nextSequence) {
+		return;
+	}
+
+	while (firstLiveSequence < savedMark && !liveRecords.empty()) {
+		liveRecords.pop_front();
+		firstLiveSequence++;
+	}
+
+	basePath = savedPath;
+	std::vector<uint8_t> bytes = buildHeader();
+	for (const auto& record : liveRecords) {
+		bytes.insert(bytes.end(), record.begin(), record.end());
+	}
+
+	queueJob(JobType::Rewrite, std::move(bytes));
+}
+
+void EditJournal::discard()
+{
+	// never started (or still waiting on a recovery answer), leave the file for next time
+	if (path.empty() || !active) {
+		return;
+	}
+
+	active = false;
+	liveRecords.clear();
+	queueJob(JobType::Remove, {});
+}
+
+void EditJournal::queueJob(JobType type, std::vector<uint8_t> bytes)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		// anything still waiting is about to be overwritten anyway
+		if (type != JobType::Append) {
+			jobs.clear();
+		}
+
+		Job job;
+		job.type = type;
+		job.bytes = std::move(bytes);
+		jobs.push_back(std::move(job));
+
+		if (!worker.joinable()) {
+			worker = std::thread(&EditJournal::workerLoop, this);
+		}
+	}
+	wakeWorker.notify_one();
+}
+
+void EditJournal::workerLoop()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	while (true) {
+		wakeWorker.wait(lock, [this]() { return stopping || !jobs.empty(); });
+		if (jobs.empty()) {
+			return;
+		}
+
+		std::deque<Job> batch;
+		batch.swap(jobs);
+		lock.unlock();
+
+		bool needsFlush = false;
+		for (auto& job : batch) {
+			if (job.type == JobType::Append) {
+				if (journalFile == nullptr) {
+					journalFile = fopen(path.c_str(), "ab");
+				}
+				if (journalFile == nullptr || fwrite(job.bytes.data(), 1, job.bytes.size(), journalFile) != job.bytes.size()) {
+					SDL_Log("Failed to append to journal: %s", path.c_str());
+					continue;
+				}
+				needsFlush = true;
+				continue;
+			}
+
+			if (journalFile != nullptr) {
+				fclose(journalFile);
+				journalFile = nullptr;
+			}
+
+			if (job.type == JobType::Rewrite) {
+				std::string error;
+				if (!writeFileAtomically(path, job.bytes, error)) {
+					SDL_Log("Failed to rewrite journal: %s", error.c_str());
+				}
+			}
+			else {
+				remove(path.c_str());
+			}
+		}
+
+		// one fsync per batch rather than per record
+		if (needsFlush && journalFile != nullptr && !flushToDisk(journalFile)) {
+			SDL_Log("Failed to flush journal: %s", path.c_str());
+		}
+
+		lock.lock();
+	}
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "DocumentSnapshot.h"
+#include "FileUtils.h"
+
+// append-only crash journal. every record is the element level delta between the
+// document and what the journal saw last time (changed tiles/palettes/cels/anims only),
+// so replaying them in order on top of the base project rebuilds the lost session.
+// snapshots share unchanged elements, so finding the delta is mostly pointer compares.
+// disk writes happen on a worker thread, the ui thread only diffs + encodes
+class EditJournal
+{
+public:
+	EditJournal() = default;
+	~EditJournal();
+
+	EditJournal(const EditJournal&) = delete;
+	EditJournal& operator=(const EditJournal&) = delete;
+
+	// every running instance journals into its own slot under `directory`, held with a lock
+	// file, so a second window never takes the first one's live journal for a crash.
+	// slots somebody left behind unlocked get picked first so they can be recovered.
+	// false if every slot is taken, the journal just stays off then
+	bool claimSlot(const std::string& directory);
+	bool isActive() const { return active; }
+
+	// left over journal from a session that didn't shut down cleanly
+	bool readRecovery(std::string& outBasePath, std::vector<std::vector<uint8_t>>& outRecords) const;
+	static bool applyRecord(const std::vector<uint8_t>& record, ProjectData& project);
+
+	void reset(const std::string& basePath, std::shared_ptr<const DocumentSnapshot> base);
+	bool record(std::shared_ptr<const DocumentSnapshot> snapshot);
+
+	// sequence number to hand back to compact() once a save of the current state lands
+	uint64_t mark() const { return nextSequence; }
+	void compact(uint64_t savedMark, const std::string& savedPath);
+
+	// clean shutdown, nothing to recover next time
+	void discard();
+
+private:
+	enum class JobType { Append, Rewrite, Remove };
+
+	struct Job {
+		JobType type = JobType::Append;
+		std::vector<uint8_t> bytes;
+	};
+
+	std::vector<uint8_t> buildHeader() const;
+	void queueJob(JobType type, std::vector<uint8_t> bytes);
+	void workerLoop();
+
+	std::string path;
+	std::string basePath;
+	FileLock slotLock;
+	bool active = false;
+
+	// what the journal currently believes the document looks like
+	std::shared_ptr<const DocumentSnapshot> shadow;
+
+	// records since the last reset/compaction, kept around so compaction can rewrite the tail
+	std::deque<std::vector<uint8_t>> liveRecords;
+	uint64_t firstLiveSequence = 0;
+	uint64_t nextSequence = 0;
+
+	std::mutex mutex;
+	std::condition_variable wakeWorker;
+	std::thread worker;
+	std::deque<Job> jobs;
+	bool stopping = false;
+	FILE* journalFile = nullptr;
+};
@@ -0,0 +1,163 @@
+#include "FileImport.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+
+#include "FileUtils.h"
+#include "JobSystem.h"
+
+namespace {
+
+std::string lowercaseExtension(const std::string& path)
+{
+	const size_t dotPos = path.find_last_of('.');
+	const size_t slashPos = path.find_last_of("/\\");
+	if (dotPos == std::string::npos || (slashPos != std::string::npos && dotPos < slashPos)) {
+		return "";
+	}
+
+	std::string ext = path.substr(dotPos + 1);
+	std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+	return ext;
+}
+
+// same sniffing the single file drop always did: palettes win when there's a TO_RGB555 in
+// there (or nothing animation looking), then cels, then animation tables
+void decodeCFile(ImportedFile& file)
+{
+	std::string content;
+	if (!readTextFile(file.path, content)) {
+		file.errorMessage = "Couldn't read the file.";
+		return;
+	}
+
+	const bool hasAnimationData = content.find("AnimationCel") != std::string::npos ||
+		content.find("struct Animation") != std::string::npos;
+	const bool hasPaletteData = content.find("Palette") != std::string::npos &&
+		(content.find("TO_RGB555") != std::string::npos || !hasAnimationData);
+
+	if (hasPaletteData) {
+		file.kind = ImportFileKind::CPalettes;
+		file.paletteGroups = ResourceManager::parsePalettesFromCText(content, file.path);
+		file.success = !file.paletteGroups.empty();
+	}
+	else if (content.find("AnimationCel") != std::string::npos) {
+		file.kind = ImportFileKind::AnimationCels;
+		file.cels = ResourceManager::loadAnimationCelsFromText(content, file.path);
+		file.success = true;
+	}
+	else if (content.find("struct Animation") != std::string::npos || content.find("END_ANIMATION") != std::string::npos) {
+		file.kind = ImportFileKind::Animations;
+		file.animations = ResourceManager::loadAnimationsFromText(content, file.path);
+		file.success = true;
+	}
+	else {
+		file.kind = ImportFileKind::Unsupported;
+		file.errorMessage = "Unrecognized .c file format.";
+		return;
+	}
+
+	if (!file.success) {
+		file.errorMessage = "Nothing usable in the file.";
+	}
+}
+
+void decodeFile(ImportedFile& file, std::vector<Palette>& palettes, int currentPalette)
+{
+	auto fileStart = std::chrono::steady_clock::now();
+
+	switch (file.kind) {
+	case ImportFileKind::Tiles:
+		file.tiles = ResourceManager::loadTiles(file.path);
+		file.success = file.tiles.getSize() > 0;
+		break;
+	case ImportFileKind::ImageTiles:
+		file.tiles = ResourceManager::loadTilesFromImageAndPalette(file.path, palettes, currentPalette, &file.tilesPerRow);
+		file.success = file.tiles.getSize() > 0;
+		break;
+	case ImportFileKind::Palettes:
+		file.palettes = ResourceManager::loadPalettes(file.path);
+		file.success = !file.palettes.empty();
+		break;
+	case ImportFileKind::AnimationCels:
+		decodeCFile(file);
+		break;
+	case ImportFileKind::Project:
+		file.errorMessage = "Projects can't be imported alongside other files.";
+		break;
+	default:
+		file.errorMessage = "Unsupported file type.";
+		break;
+	}
+	if (!file.success && file.errorMessage.empty()) {
+		file.errorMessage = "Nothing usable in the file.";
+	}
+
+	file.durationMs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+		std::chrono::steady_clock::now() - fileStart).count());
+}
+
+}
+
+ImportFileKind classifyImportPath(const std::string& path)
+{
+	const std::string ext = lowercaseExtension(path);
+	if (ext == "inv") return ImportFileKind::Project;
+	if (ext == "4bpp" || ext == "bin" || ext == "lz") return ImportFileKind::Tiles;
+	if (ext == "png" || ext == "bmp" || ext == "jpg" || ext == "jpeg") return ImportFileKind::ImageTiles;
+	if (ext == "pal") return ImportFileKind::Palettes;
+	if (ext == "c") return ImportFileKind::AnimationCels;
+	return ImportFileKind::Unsupported;
+}
+
+ImportBatchResult decodeImportBatch(const std::vector<std::string>& paths, std::vector<Palette> palettes,
+	int currentPalette, JobToken& token)
+{
+	auto startTime = std::chrono::steady_clock::now();
+
+	ImportBatchResult result;
+	result.files.reserve(paths.size());
+	for (const std::string& path : paths) {
+		ImportedFile file;
+		file.path = path;
+		file.kind = classifyImportPath(path);
+		result.files.push_back(std::move(file));
+	}
+
+	std::atomic<size_t> filesDone{ 0 };
+	token.setProgress(0.0f);
+	auto decodeFiles = [&](const std::vector<size_t>& indices) {
+		WorkerPool::shared().parallelFor(indices.size(), [&](size_t i) {
+			if (token.isCancelled()) {
+				return;
+			}
+			decodeFile(result.files[indices[i]], palettes, currentPalette);
+			token.setProgress(static_cast<float>(++filesDone) / static_cast<float>(result.files.size()));
+		});
+	};
+
+	// images get quantized against palettes, so any .pal in the batch has to be in first
+	std::vector<size_t> firstPass;
+	std::vector<size_t> imagePass;
+	for (size_t i = 0; i < result.files.size(); i++) {
+		(result.files[i].kind == ImportFileKind::ImageTiles ? imagePass : firstPass).push_back(i);
+	}
+
+	decodeFiles(firstPass);
+	for (const ImportedFile& file : result.files) {
+		if (file.kind == ImportFileKind::Palettes && file.success) {
+			palettes = file.palettes;
+			currentPalette = std::clamp(currentPalette, 0, static_cast<int>(palettes.size()) - 1);
+		}
+	}
+	decodeFiles(imagePass);
+
+	result.durationMs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+		std::chrono::steady_clock::now() - startTime).count());
+	if (!token.isCancelled()) {
+		SDL_Log("Decoded %zu imported files in %llu ms", result.files.size(), static_cast<unsigned long long>(result.durationMs));
+	}
+	return result;
+}
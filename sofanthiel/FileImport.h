@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Graphics.h"
+#include "ResourceManager.h"
+
+class JobToken;
+
+// dropped or picked files decoded off the ui thread, several at once. the batch only reads
+// and parses, putting the results into the project is left to whoever gets them back so it
+// can happen in one go and in the right order
+
+enum class ImportFileKind {
+	Unsupported,
+	Project,
+	Tiles,
+	ImageTiles,
+	Palettes,
+	CPalettes,
+	AnimationCels,
+	Animations
+};
+
+struct ImportedFile {
+	std::string path;
+	ImportFileKind kind = ImportFileKind::Unsupported;
+	bool success = false;
+	std::string errorMessage;
+
+	Tiles tiles;
+	int tilesPerRow = 0; // images only
+	std::vector<Palette> palettes;
+	std::vector<ParsedCPaletteGroup> paletteGroups;
+	std::vector<AnimationCel> cels;
+	std::vector<Animation> animations;
+	uint64_t durationMs = 0;
+};
+
+// by extension. .c files come back as AnimationCels and get sorted out once they're read
+ImportFileKind classifyImportPath(const std::string& path);
+
+struct ImportBatchResult {
+	std::vector<ImportedFile> files; // in the order they were given
+	uint64_t durationMs = 0;
+};
+
+// decodes `paths` across every core. meant to run as a job: files stop being picked up once
+// `token` is cancelled, and progress goes through it. images are quantized against
+// `palettes`, or against the last .pal in the batch if it has one
+ImportBatchResult decodeImportBatch(const std::vector<std::string>& paths, std::vector<Palette> palettes,
+	int currentPalette, JobToken& token);
@@ -0,0 +1,225 @@
+#include "FileUtils.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+#ifdef _WIN32
+#include <io.h>
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+#endif
+
+bool flushToDisk(FILE* file)
+{
+	if (fflush(file) != 0) {
+		return false;
+	}
+#ifdef _WIN32
+	return _commit(_fileno(file)) == 0;
+#else
+	return fsync(fileno(file)) == 0;
+#endif
+}
+
+namespace {
+
+bool replaceFile(const std::string& from, const std::string& to)
+{
+#ifdef _WIN32
+	return MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+	return rename(from.c_str(), to.c_str()) == 0;
+#endif
+}
+
+void syncParentDirectory(const std::string& path)
+{
+#ifndef _WIN32
+	// the rename itself lives in the directory entry, flush that too
+	size_t slash = path.find_last_of('/');
+	std::string dir = (slash == std::string::npos) ? "." : path.substr(0, slash == 0 ? 1 : slash);
+	int fd = open(dir.c_str(), O_RDONLY);
+	if (fd >= 0) {
+		fsync(fd);
+		::close(fd);
+	}
+#else
+	(void)path;
+#endif
+}
+
+bool fileHasContents(const std::string& path, const uint8_t* data, size_t size)
+{
+	FILE* file = fopen(path.c_str(), "rb");
+	if (file == nullptr) {
+		return false;
+	}
+
+	// size first, most changed exports already differ there and we never read them
+	bool same = fseek(file, 0, SEEK_END) == 0 && ftell(file) == static_cast<long>(size) && fseek(file, 0, SEEK_SET) == 0;
+	if (same) {
+		uint64_t hash = hashBytes(nullptr, 0);
+		uint8_t chunk[64 * 1024];
+		size_t total = 0;
+		size_t got = 0;
+		while ((got = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+			hash = hashBytes(chunk, got, hash);
+			total += got;
+		}
+		same = ferror(file) == 0 && total == size && hash == hashBytes(data, size);
+	}
+
+	fclose(file);
+	return same;
+}
+
+}
+
+uint64_t hashBytes(const uint8_t* data, size_t size, uint64_t hash)
+{
+	for (size_t i = 0; i < size; i++) {
+		hash = (hash ^ data[i]) * 1099511628211ull;
+	}
+	return hash;
+}
+
+bool writeFileAtomically(const std::string& path, const uint8_t* data, size_t size, std::string& error)
+{
+	const std::string tempPath = path + ".tmp";
+
+	FILE* file = fopen(tempPath.c_str(), "wb");
+	if (file == nullptr) {
+		error = "Couldn't create " + tempPath + ": " + strerror(errno);
+		return false;
+	}
+
+	bool ok = size == 0 || fwrite(data, 1, size, file) == size;
+	if (!ok) {
+		error = "Couldn't write " + tempPath + ": " + strerror(errno);
+	}
+	else if (!flushToDisk(file)) {
+		error = "Couldn't flush " + tempPath + ": " + strerror(errno);
+		ok = false;
+	}
+
+	if (fclose(file) != 0 && ok) {
+		error = "Couldn't close " + tempPath + ": " + strerror(errno);
+		ok = false;
+	}
+
+	if (!ok) {
+		remove(tempPath.c_str());
+		return false;
+	}
+
+	if (!replaceFile(tempPath, path)) {
+		error = "Couldn't move " + tempPath + " over " + path + ": " + strerror(errno);
+		remove(tempPath.c_str());
+		return false;
+	}
+
+	syncParentDirectory(path);
+	return true;
+}
+
+bool readTextFile(const std::string& path, std::string& out)
+{
+	FILE* file = fopen(path.c_str(), "r");
+	if (file == nullptr) {
+		return false;
+	}
+
+	// size is only a hint, text mode on windows hands back fewer bytes than are on disk
+	long size = 0;
+	if (fseek(file, 0, SEEK_END) == 0) {
+		size = ftell(file);
+		fseek(file, 0, SEEK_SET);
+	}
+
+	out.clear();
+	out.resize(size > 0 ? static_cast<size_t>(size) : 0);
+
+	size_t total = 0;
+	for (;;) {
+		if (total == out.size()) {
+			out.resize(out.size() + 64 * 1024);
+		}
+		size_t got = fread(&out[total], 1, out.size() - total, file);
+		total += got;
+		if (got == 0) {
+			break;
+		}
+	}
+
+	bool ok = ferror(file) == 0;
+	fclose(file);
+	out.resize(total);
+	return ok;
+}
+
+FileWriteResult writeFileIfChanged(const std::string& path, const uint8_t* data, size_t size, std::string& error)
+{
+	if (fileHasContents(path, data, size)) {
+		return FileWriteResult::Unchanged;
+	}
+
+	return writeFileAtomically(path, data, size, error) ? FileWriteResult::Written : FileWriteResult::Failed;
+}
+
+std::string getFileName(const std::string& path)
+{
+	size_t slash = path.find_last_of("/\\");
+	return slash == std::string::npos ? path : path.substr(slash + 1);
+}
+
+bool FileLock::tryLock(const std::string& path)
+{
+	release();
+#ifdef _WIN32
+	// no sharing at all, a second CreateFile on it fails until this handle closes
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+	handle = file;
+#else
+	int file = open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+	if (file < 0) {
+		return false;
+	}
+	if (flock(file, LOCK_EX | LOCK_NB) != 0) {
+		::close(file);
+		return false;
+	}
+	fd = file;
+#endif
+	return true;
+}
+
+void FileLock::release()
+{
+#ifdef _WIN32
+	if (handle != nullptr) {
+		CloseHandle(static_cast<HANDLE>(handle));
+		handle = nullptr;
+	}
+#else
+	if (fd >= 0) {
+		::close(fd);
+		fd = -1;
+	}
+#endif
+}
+
+bool FileLock::isHeld() const
+{
+#ifdef _WIN32
+	return handle != nullptr;
+#else
+	return fd >= 0;
+#endif
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// fnv-1a, plenty for "did this change". pass the previous result back in to hash in chunks
+uint64_t hashBytes(const uint8_t* data, size_t size, uint64_t hash = 14695981039346656037ull);
+
+// fflush plus fsync (_commit on windows), true once the bytes are really on disk
+bool flushToDisk(FILE* file);
+
+// writes to <path>.tmp, flushes it all the way to disk, then renames it over
+// the target so a crash or a full disk never leaves a half written file behind
+bool writeFileAtomically(const std::string& path, const uint8_t* data, size_t size, std::string& error);
+
+inline bool writeFileAtomically(const std::string& path, const std::vector<uint8_t>& bytes, std::string& error)
+{
+	return writeFileAtomically(path, bytes.data(), bytes.size(), error);
+}
+
+// whole file in one go, opened in text mode so line endings come out the same way
+// std::getline on an ifstream would have seen them
+bool readTextFile(const std::string& path, std::string& out);
+
+// everything after the last slash (either kind)
+std::string getFileName(const std::string& path);
+
+enum class FileWriteResult {
+	Written,
+	Unchanged,
+	Failed
+};
+
+// for exports other tools watch: if <path> already has exactly these bytes (same size, same
+// hash) it's left alone so its mtime doesn't move, otherwise it goes through writeFileAtomically
+FileWriteResult writeFileIfChanged(const std::string& path, const uint8_t* data, size_t size, std::string& error);
+
+// exclusive lock on <path> (created if missing), held until release() or destruction. the os
+// drops it when the process dies, so a crashed instance never leaves anybody locked out
+class FileLock {
+public:
+	FileLock() = default;
+	~FileLock() { release(); }
+	FileLock(const FileLock&) = delete;
+	FileLock& operator=(const FileLock&) = delete;
+
+	// doesn't wait, false straight away if another process holds it
+	bool tryLock(const std::string& path);
+	void release();
+	bool isHeld() const;
+
+private:
+#ifdef _WIN32
+	void* handle = nullptr;
+#else
+	int fd = -1;
+#endif
+};
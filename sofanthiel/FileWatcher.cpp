@@ -0,0 +1,240 @@
+#include "FileWatcher.h"
+
+#include <cerrno>
+#include <cstring>
+#include <sys/stat.h>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+constexpr Uint64 kScanIntervalMs = 1000;
+
+void splitPath(const std::string& path, std::string& directory, std::string& name)
+{
+	size_t slash = path.find_last_of("/\\");
+	if (slash == std::string::npos) {
+		directory = ".";
+		name = path;
+		return;
+	}
+	directory = path.substr(0, slash == 0 ? 1 : slash);
+	name = path.substr(slash + 1);
+}
+
+bool statFile(const std::string& path, int64_t& size, int64_t& modifiedTime)
+{
+	struct stat info;
+	if (stat(path.c_str(), &info) != 0) {
+		return false;
+	}
+	size = static_cast<int64_t>(info.st_size);
+	modifiedTime = static_cast<int64_t>(info.st_mtime);
+	return true;
+}
+
+}
+
+FileWatcher::FileWatcher()
+{
+#ifdef __linux__
+	inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (inotifyFd < 0) {
+		SDL_Log("inotify unavailable (%s), watching files by polling instead", strerror(errno));
+	}
+#endif
+}
+
+FileWatcher::~FileWatcher()
+{
+	clear();
+#ifdef __linux__
+	if (inotifyFd >= 0) {
+		::close(inotifyFd);
+	}
+#endif
+}
+
+bool FileWatcher::watch(const std::string& path)
+{
+	if (files.count(path) != 0) {
+		return true;
+	}
+
+	WatchedFile file;
+	splitPath(path, file.directory, file.name);
+	statFile(path, file.size, file.modifiedTime);
+
+#ifdef __linux__
+	if (inotifyFd >= 0) {
+		auto found = watchByDirectory.find(file.directory);
+		if (found != watchByDirectory.end()) {
+			file.polled = false;
+		}
+		else {
+			// the directory, not the file: a save through rename swaps the inode under us
+			int wd = inotify_add_watch(inotifyFd, file.directory.c_str(),
+				IN_CLOSE_WRITE | IN_MODIFY | IN_CREATE | IN_MOVED_TO);
+			if (wd >= 0) {
+				watchByDirectory[file.directory] = wd;
+				directoryByWatch[wd] = file.directory;
+				file.polled = false;
+			}
+			else {
+				SDL_Log("Couldn't watch %s (%s), polling it instead", file.directory.c_str(), strerror(errno));
+			}
+		}
+	}
+#endif
+
+	files.emplace(path, std::move(file));
+	return true;
+}
+
+void FileWatcher::unwatch(const std::string& path)
+{
+	auto found = files.find(path);
+	if (found == files.end()) {
+		return;
+	}
+
+	const std::string directory = found->second.directory;
+	files.erase(found);
+
+#ifdef __linux__
+	for (const auto& [otherPath, other] : files) {
+		if (other.directory == directory) {
+			return;
+		}
+	}
+
+	auto watchIt = watchByDirectory.find(directory);
+	if (watchIt != watchByDirectory.end()) {
+		inotify_rm_watch(inotifyFd, watchIt->second);
+		directoryByWatch.erase(watchIt->second);
+		watchByDirectory.erase(watchIt);
+	}
+#endif
+}
+
+void FileWatcher::clear()
+{
+#ifdef __linux__
+	for (const auto& [directory, wd] : watchByDirectory) {
+		inotify_rm_watch(inotifyFd, wd);
+	}
+#endif
+	watchByDirectory.clear();
+	directoryByWatch.clear();
+	files.clear();
+}
+
+void FileWatcher::markChanged(WatchedFile& file, Uint64 now)
+{
+	// every new event pushes the deadline back, so a script writing in chunks reloads once
+	file.pending = true;
+	file.pendingSince = now;
+}
+
+void FileWatcher::readEvents(Uint64 now)
+{
+#ifdef __linux__
+	if (inotifyFd < 0) {
+		return;
+	}
+
+	alignas(struct inotify_event) char buffer[4096];
+	for (;;) {
+		ssize_t length = read(inotifyFd, buffer, sizeof(buffer));
+		if (length <= 0) {
+			break;
+		}
+
+		for (char* ptr = buffer; ptr < buffer + length;) {
+			const struct inotify_event* event = reinterpret_cast<const struct inotify_event*>(ptr);
+			ptr += sizeof(struct inotify_event) + event->len;
+
+			if (event->mask & IN_Q_OVERFLOW) {
+				// lost track, assume the worst
+				for (auto& [path, file] : files) {
+					markChanged(file, now);
+				}
+				continue;
+			}
+
+			if (event->mask & IN_IGNORED) {
+				auto dirIt = directoryByWatch.find(event->wd);
+				if (dirIt != directoryByWatch.end()) {
+					for (auto& [path, file] : files) {
+						if (file.directory == dirIt->second) file.polled = true;
+					}
+					watchByDirectory.erase(dirIt->second);
+					directoryByWatch.erase(dirIt);
+				}
+				continue;
+			}
+
+			auto dirIt = directoryByWatch.find(event->wd);
+			if (event->len == 0 || dirIt == directoryByWatch.end()) {
+				continue;
+			}
+
+			for (auto& [path, file] : files) {
+				if (file.directory == dirIt->second && file.name == event->name) {
+					markChanged(file, now);
+				}
+			}
+		}
+	}
+#else
+	(void)now;
+#endif
+}
+
+void FileWatcher::scanForChanges(Uint64 now)
+{
+	for (auto& [path, file] : files) {
+		if (!file.polled) {
+			continue;
+		}
+
+		int64_t size = -1;
+		int64_t modifiedTime = -1;
+		if (!statFile(path, size, modifiedTime)) {
+			continue;
+		}
+
+		if (size != file.size || modifiedTime != file.modifiedTime) {
+			file.size = size;
+			file.modifiedTime = modifiedTime;
+			markChanged(file, now);
+		}
+	}
+}
+
+std::vector<std::string> FileWatcher::poll()
+{
+	std::vector<std::string> changed;
+	if (files.empty()) {
+		return changed;
+	}
+
+	const Uint64 now = SDL_GetTicks();
+	readEvents(now);
+
+	if (now - lastScanTick >= kScanIntervalMs) {
+		lastScanTick = now;
+		scanForChanges(now);
+	}
+
+	for (auto& [path, file] : files) {
+		if (file.pending && now - file.pendingSince >= DEBOUNCE_MS) {
+			file.pending = false;
+			changed.push_back(path);
+		}
+	}
+	return changed;
+}
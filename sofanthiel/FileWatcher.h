@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <SDL3/SDL.h>
+
+// tells you when files someone else edits (scripts, git checkouts...) have settled down.
+// linux listens to inotify on the parent directories, so editors that save through a
+// rename still get caught. everywhere else it falls back to checking size/mtime every
+// second. nothing here runs on its own thread, poll() is meant to be called once a frame
+class FileWatcher {
+public:
+	// a burst of events has to go quiet for this long before the file counts as changed
+	static constexpr Uint64 DEBOUNCE_MS = 300;
+
+	FileWatcher();
+	~FileWatcher();
+	FileWatcher(const FileWatcher&) = delete;
+	FileWatcher& operator=(const FileWatcher&) = delete;
+
+	bool watch(const std::string& path);
+	void unwatch(const std::string& path);
+	void clear();
+	bool isWatching(const std::string& path) const { return files.count(path) != 0; }
+
+	// paths that changed and then stayed quiet for DEBOUNCE_MS, each reported once
+	std::vector<std::string> poll();
+
+private:
+	struct WatchedFile {
+		std::string directory;
+		std::string name;
+		bool polled = true;
+		bool pending = false;
+		Uint64 pendingSince = 0;
+		int64_t size = -1;
+		int64_t modifiedTime = -1;
+	};
+
+	void markChanged(WatchedFile& file, Uint64 now);
+	void readEvents(Uint64 now);
+	void scanForChanges(Uint64 now);
+
+	std::unordered_map<std::string, WatchedFile> files;
+
+	int inotifyFd = -1;
+	std::unordered_map<int, std::string> directoryByWatch;
+	std::unordered_map<std::string, int> watchByDirectory;
+	Uint64 lastScanTick = 0;
+};
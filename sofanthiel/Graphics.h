@@ -145,6 +145,13 @@ struct Palette {
 	SDL_Color colors[16];
 };
 
+// gba BGR555 -> 8 bit per channel, low bits copied down so 31 comes out as 255
+inline SDL_Color colorFromRGB555(uint16_t value)
+{
+	auto expand = [](int channel) { return static_cast<uint8_t>((channel << 3) | (channel >> 2)); };
+	return SDL_Color{ expand(value & 0x1F), expand((value >> 5) & 0x1F), expand((value >> 10) & 0x1F), 255 };
+}
+
 inline bool getOAMColor(const std::vector<Palette>& palettes, const TengokuOAM& oam, uint8_t colorIndex, SDL_Color& outColor)
 {
 	if (colorIndex == 0 || palettes.empty()) {
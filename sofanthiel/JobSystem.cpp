@@ -0,0 +1,173 @@
+#include "JobSystem.h"
+
+#include <algorithm>
+
+WorkerPool::WorkerPool(unsigned threadCount)
+{
+	threadCount = std::max(1u, threadCount);
+	threads.reserve(threadCount);
+	for (unsigned i = 0; i < threadCount; i++) {
+		threads.emplace_back(&WorkerPool::workerLoop, this);
+	}
+}
+
+WorkerPool::~WorkerPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+		tasks.clear();
+	}
+	wakeWorker.notify_all();
+	for (auto& thread : threads) {
+		thread.join();
+	}
+}
+
+WorkerPool& WorkerPool::shared()
+{
+	// the ui thread doesn't count, it mostly waits on vsync, and parallelFor callers pitch in
+	static WorkerPool pool(std::max(1u, std::thread::hardware_concurrency()));
+	return pool;
+}
+
+void WorkerPool::enqueue(std::function<void()> task)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		tasks.push_back(std::move(task));
+	}
+	wakeWorker.notify_one();
+}
+
+void WorkerPool::workerLoop()
+{
+	while (true) {
+		std::function<void()> task;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			wakeWorker.wait(lock, [this]() { return stopping || !tasks.empty(); });
+			if (stopping) {
+				return;
+			}
+			task = std::move(tasks.front());
+			tasks.pop_front();
+		}
+		task();
+	}
+}
+
+void WorkerPool::parallelFor(size_t count, const std::function<void(size_t)>& fn)
+{
+	if (count == 0) {
+		return;
+	}
+	if (count == 1) {
+		fn(0);
+		return;
+	}
+
+	// helpers can start long after the loop is over (they queue behind whatever else is
+	// running), so the shared part outlives this call. a late helper only ever sees
+	// next >= count and leaves without touching fn
+	struct Loop {
+		std::atomic<size_t> next{ 0 };
+		std::atomic<size_t> completed{ 0 };
+		const std::function<void(size_t)>* fn = nullptr;
+		std::mutex mutex;
+		std::condition_variable allDone;
+	};
+	auto loop = std::make_shared<Loop>();
+	loop->fn = &fn;
+
+	auto run = [loop, count]() {
+		size_t finished = 0;
+		for (size_t i = loop->next++; i < count; i = loop->next++) {
+			(*loop->fn)(i);
+			finished++;
+		}
+		if (finished != 0 && loop->completed.fetch_add(finished) + finished == count) {
+			std::lock_guard<std::mutex> lock(loop->mutex);
+			loop->allDone.notify_all();
+		}
+	};
+
+	const size_t helperCount = std::min<size_t>(getThreadCount(), count - 1);
+	for (size_t i = 0; i < helperCount; i++) {
+		enqueue(run);
+	}
+	run();
+
+	std::unique_lock<std::mutex> lock(loop->mutex);
+	loop->allDone.wait(lock, [&]() { return loop->completed.load() == count; });
+}
+
+JobSystem::~JobSystem()
+{
+	// work functions only hold what they were given, but they may still be writing files
+	cancelAll();
+	std::vector<std::shared_ptr<Job>> pending;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		pending = jobs;
+	}
+	for (const auto& job : pending) {
+		if (job->started) {
+			job->finished.wait();
+		}
+	}
+}
+
+void JobSystem::applyFinished()
+{
+	std::vector<std::shared_ptr<Job>> finished;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		auto split = std::stable_partition(jobs.begin(), jobs.end(),
+			[](const std::shared_ptr<Job>& job) { return !job->done; });
+		finished.assign(std::make_move_iterator(split), std::make_move_iterator(jobs.end()));
+		jobs.erase(split, jobs.end());
+	}
+
+	// outside the lock, an apply is free to submit the next job
+	for (const auto& job : finished) {
+		if (!job->token->isCancelled()) {
+			job->apply();
+		}
+	}
+}
+
+void JobSystem::cancel(uint64_t id)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	for (const auto& job : jobs) {
+		if (job->id == id) {
+			job->token->cancel();
+		}
+	}
+}
+
+void JobSystem::cancelAll()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	for (const auto& job : jobs) {
+		job->token->cancel();
+	}
+}
+
+bool JobSystem::isBusy() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return !jobs.empty();
+}
+
+std::vector<JobStatus> JobSystem::getJobs() const
+{
+	std::vector<JobStatus> statuses;
+	std::lock_guard<std::mutex> lock(mutex);
+	statuses.reserve(jobs.size());
+	for (const auto& job : jobs) {
+		statuses.push_back({ job->id, job->name, job->token->getProgress(), job->started, job->token->isCancelled() });
+	}
+	return statuses;
+}
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+// one fixed set of worker threads for the whole app. long jobs and the parallel loops inside
+// importers/quantizers all share it instead of each spinning up their own threads
+class WorkerPool {
+public:
+	explicit WorkerPool(unsigned threadCount);
+	~WorkerPool();
+	WorkerPool(const WorkerPool&) = delete;
+	WorkerPool& operator=(const WorkerPool&) = delete;
+
+	static WorkerPool& shared();
+
+	unsigned getThreadCount() const { return static_cast<unsigned>(threads.size()); }
+	void enqueue(std::function<void()> task);
+
+	// fn(i) for every i in [0, count), on the pool and the calling thread, returns once all are
+	// done. fine to call from inside a pool task: the caller keeps taking indices itself, so
+	// it never waits on workers that are busy with something else. at most
+	// getThreadCount() + 1 threads run fn at the same time
+	void parallelFor(size_t count, const std::function<void(size_t)>& fn);
+
+private:
+	void workerLoop();
+
+	std::vector<std::thread> threads;
+	std::mutex mutex;
+	std::condition_variable wakeWorker;
+	std::deque<std::function<void()>> tasks;
+	bool stopping = false;
+};
+
+// handed to a job's work function: check for cancellation every so often, report progress
+class JobToken {
+public:
+	bool isCancelled() const { return cancelled.load(std::memory_order_relaxed); }
+	void cancel() { cancelled = true; }
+
+	// 0-1, or negative while there's no telling
+	void setProgress(float value) { progress.store(value, std::memory_order_relaxed); }
+	float getProgress() const { return progress.load(std::memory_order_relaxed); }
+
+private:
+	std::atomic<bool> cancelled{ false };
+	std::atomic<float> progress{ -1.0f };
+};
+
+struct JobHandle {
+	uint64_t id = 0;
+	std::shared_ptr<JobToken> token;
+	std::shared_future<void> finished; // ready once the work function returns
+};
+
+struct JobStatus {
+	uint64_t id = 0;
+	std::string name;
+	float progress = -1.0f;
+	bool started = false;
+	bool cancelling = false;
+};
+
+// named background jobs on the shared pool. the work runs on a worker with only what it was
+// given, its result is handed to `apply` on the main thread from applyFinished(), which the
+// editor calls at a point where touching the document is safe. cancelled jobs are never applied
+class JobSystem {
+public:
+	JobSystem() = default;
+	~JobSystem();
+	JobSystem(const JobSystem&) = delete;
+	JobSystem& operator=(const JobSystem&) = delete;
+
+	template <typename T>
+	JobHandle submit(const std::string& name, std::function<T(JobToken&)> work, std::function<void(T&)> apply)
+	{
+		auto job = std::make_shared<Job>();
+		job->id = nextJobId++;
+		job->name = name;
+
+		auto result = std::make_shared<std::optional<T>>();
+		auto promise = std::make_shared<std::promise<void>>();
+		job->finished = promise->get_future().share();
+		job->apply = [result, apply = std::move(apply)]() {
+			if (apply && result->has_value()) apply(**result);
+		};
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			jobs.push_back(job);
+		}
+
+		WorkerPool::shared().enqueue([job, result, promise, work = std::move(work)]() {
+			job->started = true;
+			if (!job->token->isCancelled()) {
+				result->emplace(work(*job->token));
+			}
+			job->done = true;
+			promise->set_value();
+		});
+
+		return { job->id, job->token, job->finished };
+	}
+
+	// main thread only. runs `apply` for every job that finished since the last call
+	void applyFinished();
+
+	void cancel(uint64_t id);
+	void cancelAll();
+	bool isBusy() const;
+	std::vector<JobStatus> getJobs() const;
+
+private:
+	struct Job {
+		uint64_t id = 0;
+		std::string name;
+		std::shared_ptr<JobToken> token = std::make_shared<JobToken>();
+		std::shared_future<void> finished;
+		std::function<void()> apply;
+		std::atomic<bool> started{ false };
+		std::atomic<bool> done{ false };
+	};
+
+	mutable std::mutex mutex;
+	std::vector<std::shared_ptr<Job>> jobs;
+	std::atomic<uint64_t> nextJobId{ 1 };
+};
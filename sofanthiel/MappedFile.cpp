@@ -0,0 +1,121 @@
+#include "MappedFile.h"
+
+#include <cerrno>
+#include <cstring>
+#include <utility>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+	: bytes(std::exchange(other.bytes, nullptr))
+	, length(std::exchange(other.length, 0))
+{
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+	if (this != &other) {
+		close();
+		bytes = std::exchange(other.bytes, nullptr);
+		length = std::exchange(other.length, 0);
+	}
+	return *this;
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open(const std::string& path, std::string& error)
+{
+	close();
+
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		error = "couldn't open the file (error " + std::to_string(GetLastError()) + ")";
+		return false;
+	}
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart <= 0) {
+		error = "the file is empty";
+		CloseHandle(file);
+		return false;
+	}
+
+	// the view keeps the mapping (and the file) alive on its own, both handles can go
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	CloseHandle(file);
+	if (mapping == nullptr) {
+		error = "couldn't map the file (error " + std::to_string(GetLastError()) + ")";
+		return false;
+	}
+
+	void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	CloseHandle(mapping);
+	if (view == nullptr) {
+		error = "couldn't map the file (error " + std::to_string(GetLastError()) + ")";
+		return false;
+	}
+
+	bytes = static_cast<const uint8_t*>(view);
+	length = static_cast<size_t>(fileSize.QuadPart);
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (bytes != nullptr) {
+		UnmapViewOfFile(bytes);
+	}
+	bytes = nullptr;
+	length = 0;
+}
+
+#else
+
+bool MappedFile::open(const std::string& path, std::string& error)
+{
+	close();
+
+	int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd < 0) {
+		error = std::string("couldn't open the file: ") + strerror(errno);
+		return false;
+	}
+
+	struct stat info;
+	if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+		error = "the file is empty";
+		::close(fd);
+		return false;
+	}
+
+	// the mapping holds its own reference, the descriptor isn't needed past this
+	void* view = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);
+	if (view == MAP_FAILED) {
+		error = std::string("couldn't map the file: ") + strerror(errno);
+		return false;
+	}
+
+	bytes = static_cast<const uint8_t*>(view);
+	length = static_cast<size_t>(info.st_size);
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (bytes != nullptr) {
+		munmap(const_cast<uint8_t*>(bytes), length);
+	}
+	bytes = nullptr;
+	length = 0;
+}
+
+#endif
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "ByteStream.h"
+
+// read only mapping of a whole file. pages only come in once something touches them, so
+// opening a 32 MB ROM is instant and nothing gets copied onto the heap.
+// the file shouldn't shrink while it's mapped, reading past the new end would fault
+class MappedFile {
+public:
+	MappedFile() = default;
+	~MappedFile() { close(); }
+	MappedFile(MappedFile&& other) noexcept;
+	MappedFile& operator=(MappedFile&& other) noexcept;
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	bool open(const std::string& path, std::string& error);
+	void close();
+
+	bool isOpen() const { return bytes != nullptr; }
+	size_t size() const { return length; }
+	ByteView view() const { return ByteView(bytes, length); }
+
+private:
+	const uint8_t* bytes = nullptr;
+	size_t length = 0;
+};
@@ -0,0 +1,45 @@
+#include "PaletteQuantizer.h"
+
+#include <climits>
+#include <unordered_set>
+
+PaletteQuantizer::PaletteQuantizer(const std::vector<Palette>& palettes, const std::vector<int>& paletteOrder)
+	: table(32768, -1)
+{
+	std::unordered_set<uint32_t> seen;
+	for (int paletteIdx : paletteOrder) {
+		if (paletteIdx < 0 || paletteIdx >= static_cast<int>(palettes.size())) continue;
+
+		for (int i = 0; i < 16; i++) {
+			const SDL_Color& color = palettes[paletteIdx].colors[i];
+			uint32_t colorKey = (color.r << 16) | (color.g << 8) | color.b;
+			if (seen.insert(colorKey).second) {
+				matches.push_back({ color, static_cast<uint8_t>(paletteIdx), static_cast<uint8_t>(i) });
+			}
+		}
+	}
+}
+
+int16_t PaletteQuantizer::search(int key) const
+{
+	// measured from the middle of the cell, in half steps so it stays integer
+	const int r = (((key >> 10) & 0x1F) << 4) + 7;
+	const int g = (((key >> 5) & 0x1F) << 4) + 7;
+	const int b = ((key & 0x1F) << 4) + 7;
+
+	int bestIndex = 0;
+	int bestDistance = INT_MAX;
+	for (size_t i = 0; i < matches.size(); i++) {
+		const SDL_Color& color = matches[i].color;
+		int dr = r - color.r * 2;
+		int dg = g - color.g * 2;
+		int db = b - color.b * 2;
+		int distance = dr * dr + dg * dg + db * db;
+
+		if (distance < bestDistance) {
+			bestDistance = distance;
+			bestIndex = static_cast<int>(i);
+		}
+	}
+	return static_cast<int16_t>(bestIndex);
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <SDL3/SDL.h>
+
+#include "Graphics.h"
+
+// nearest palette color for image import. GBA color is 15 bit, so instead of searching every
+// palette color for every pixel the search runs once per RGB555 cell, the first time a pixel
+// lands in it, and the answer is kept in a 32768 entry table
+class PaletteQuantizer {
+public:
+	struct Match {
+		SDL_Color color;
+		uint8_t palette;
+		uint8_t index;
+	};
+
+	// candidates come from `paletteOrder`, in that order. a color several palettes share maps
+	// to where it first shows up, and on equal distance the earlier candidate wins
+	PaletteQuantizer(const std::vector<Palette>& palettes, const std::vector<int>& paletteOrder);
+
+	bool empty() const { return matches.empty(); }
+
+	// channels are 0-255
+	const Match& find(int r, int g, int b)
+	{
+		const int key = ((r >> 3) << 10) | ((g >> 3) << 5) | (b >> 3);
+		int16_t& slot = table[key];
+		if (slot < 0) {
+			slot = search(key);
+		}
+		return matches[slot];
+	}
+
+private:
+	int16_t search(int key) const;
+
+	std::vector<Match> matches;
+	std::vector<int16_t> table;
+};
@@ -0,0 +1,44 @@
+#include "PlaybackClock.h"
+
+namespace {
+constexpr uint64_t kMeasureWindowNS = 500000000;
+}
+
+void PlaybackClock::start(uint64_t nowNS)
+{
+	running = true;
+	lastNS = nowNS;
+	accumulatorNS = 0.0;
+	droppedFrames = 0;
+	windowStartNS = nowNS;
+	windowFrames = 0;
+	measuredRate = 0.0;
+}
+
+uint64_t PlaybackClock::advance(uint64_t nowNS, double frameRate)
+{
+	if (!running || frameRate <= 0.0 || nowNS < lastNS) {
+		return 0;
+	}
+
+	// only whole periods get paid out, the remainder carries over so nothing is lost to rounding
+	const double periodNS = 1000000000.0 / frameRate;
+	accumulatorNS += static_cast<double>(nowNS - lastNS);
+	lastNS = nowNS;
+	const uint64_t due = static_cast<uint64_t>(accumulatorNS / periodNS);
+	accumulatorNS -= static_cast<double>(due) * periodNS;
+
+	if (due > 0) {
+		// only the last of them gets drawn
+		droppedFrames += due - 1;
+		windowFrames++;
+	}
+
+	const uint64_t windowNS = nowNS - windowStartNS;
+	if (windowNS >= kMeasureWindowNS) {
+		measuredRate = static_cast<double>(windowFrames) * 1000000000.0 / static_cast<double>(windowNS);
+		windowStartNS = nowNS;
+		windowFrames = 0;
+	}
+	return due;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdint>
+
+// fixed timestep clock for animation playback. real time goes into an accumulator and comes
+// back out as whole frames, so when the ui hitches the animation catches up on the frames it
+// missed instead of drifting behind. times are SDL_GetTicksNS() nanoseconds
+class PlaybackClock {
+public:
+	// 280896 cycles per frame at 16.78 MHz, a hair under 60
+	static constexpr double GBA_REFRESH_RATE = 16777216.0 / 280896.0;
+
+	void start(uint64_t nowNS);
+	void stop() { running = false; }
+	bool isRunning() const { return running; }
+
+	// how many frames are due since the last call at `frameRate` frames per second
+	uint64_t advance(uint64_t nowNS, double frameRate);
+
+	// distinct frames that made it on screen per second, measured over the last half second
+	double getMeasuredRate() const { return measuredRate; }
+	// frames stepped over since start() because the ui couldn't draw them in time
+	uint64_t getDroppedFrames() const { return droppedFrames; }
+
+private:
+	bool running = false;
+	uint64_t lastNS = 0;
+	double accumulatorNS = 0.0;
+	uint64_t droppedFrames = 0;
+	uint64_t windowStartNS = 0;
+	uint64_t windowFrames = 0;
+	double measuredRate = 0.0;
+};
@@ -0,0 +1,569 @@
+#include "ProjectFile.h"
+
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <unordered_map>
+
+#include "ByteStream.h"
+#include "Compression.h"
+#include "ResourceManager.h"
+#include "TextWriter.h"
+
+namespace {
+
+constexpr size_t kHeaderSize = 12;
+constexpr size_t kSectionEntrySize = 24;
+constexpr size_t kMinCompressSize = 64;
+
+class StringInterner {
+public:
+	std::vector<std::string> strings;
+
+	uint32_t intern(const std::string& value)
+	{
+		auto found = ids.find(value);
+		if (found != ids.end()) {
+			return found->second;
+		}
+
+		uint32_t id = static_cast<uint32_t>(strings.size());
+		strings.push_back(value);
+		ids.emplace(value, id);
+		return id;
+	}
+
+private:
+	std::unordered_map<std::string, uint32_t> ids;
+};
+
+std::vector<uint8_t> encodeTiles(const Tiles& tiles)
+{
+	std::vector<uint8_t> bytes;
+	bytes.reserve(static_cast<size_t>(tiles.getSize()) * 32);
+	for (int i = 0; i < tiles.getSize(); ++i) {
+		TileData td = tiles.getTile(i);
+		for (int byteIndex = 0; byteIndex < 32; ++byteIndex) {
+			int py = byteIndex / 4;
+			int px = (byteIndex % 4) * 2;
+			bytes.push_back(static_cast<uint8_t>((td.data[py][px] & 0x0F) | ((td.data[py][px + 1] & 0x0F) << 4)));
+		}
+	}
+	return bytes;
+}
+
+std::vector<uint8_t> encodePalettes(const std::vector<Palette>& palettes)
+{
+	std::vector<uint8_t> bytes;
+	bytes.reserve(palettes.size() * 16 * 4);
+	for (const auto& pal : palettes) {
+		for (int i = 0; i < 16; ++i) {
+			bytes.push_back(pal.colors[i].r);
+			bytes.push_back(pal.colors[i].g);
+			bytes.push_back(pal.colors[i].b);
+			bytes.push_back(pal.colors[i].a);
+		}
+	}
+	return bytes;
+}
+
+std::vector<uint8_t> encodeMetadata(const ProjectMetadata& metadata)
+{
+	TextWriter out;
+	out.reserve(128 + metadata.celFilename.size());
+	out.put("celFilename=");
+	out.put(metadata.celFilename);
+	out.put("\ncurrentPalette=");
+	out.putDecimal(metadata.currentPalette);
+	out.put("\ncurrentAnimation=");
+	out.putDecimal(metadata.currentAnimation);
+	out.put("\nframeRate=");
+	out.putFloat(metadata.frameRate);
+	out.put("\nloopAnimation=");
+	out.put(metadata.loopAnimation ? '1' : '0');
+	out.put("\nuseTilePalettes=");
+	out.put(metadata.useTilePalettes ? '1' : '0');
+	out.put('\n');
+
+	return std::vector<uint8_t>(out.text.begin(), out.text.end());
+}
+
+std::vector<uint8_t> encodeCels(const std::vector<AnimationCel>& cels, StringInterner& names)
+{
+	ByteWriter writer;
+	writer.bytes.reserve(8 + cels.size() * 8);
+	writer.putU32(static_cast<uint32_t>(cels.size()));
+	for (const auto& cel : cels) {
+		writer.putU32(names.intern(cel.name));
+		writer.putU32(static_cast<uint32_t>(cel.oams.size()));
+		for (const auto& oam : cel.oams) {
+			uint16_t raw[3];
+			memcpy(raw, &oam, sizeof(raw));
+			writer.putU16(raw[0]);
+			writer.putU16(raw[1]);
+			writer.putU16(raw[2]);
+		}
+	}
+	return writer.bytes;
+}
+
+std::vector<uint8_t> encodeAnimations(const std::vector<Animation>& animations, StringInterner& names)
+{
+	ByteWriter writer;
+	writer.putU32(static_cast<uint32_t>(animations.size()));
+	for (const auto& anim : animations) {
+		writer.putU32(names.intern(anim.name));
+		writer.putU32(static_cast<uint32_t>(anim.entries.size()));
+		for (const auto& entry : anim.entries) {
+			writer.putU32(names.intern(entry.celName));
+			writer.putU8(entry.duration);
+		}
+	}
+	return writer.bytes;
+}
+
+std::vector<uint8_t> encodeStrings(const std::vector<std::string>& strings)
+{
+	ByteWriter writer;
+	writer.putU32(static_cast<uint32_t>(strings.size()));
+	for (const auto& str : strings) {
+		writer.putString(str);
+	}
+	return writer.bytes;
+}
+
+}
+
+std::vector<uint8_t> ProjectWriter::serialize(const ProjectData& project, bool compressSections)
+{
+	struct PendingSection {
+		uint32_t type;
+		std::vector<uint8_t> raw;
+	};
+
+	std::vector<PendingSection> pending;
+	StringInterner names;
+
+	if (project.tiles.getSize() > 0) {
+		pending.push_back({ SECTION_TILES, encodeTiles(project.tiles) });
+	}
+	if (!project.palettes.empty()) {
+		pending.push_back({ SECTION_PALETTES, encodePalettes(project.palettes) });
+	}
+	if (!project.tilePalettes.empty()) {
+		pending.push_back({ SECTION_TILE_PALETTES, project.tilePalettes });
+	}
+	if (!project.animationCels.empty()) {
+		pending.push_back({ SECTION_CELS, encodeCels(project.animationCels, names) });
+	}
+	if (!project.animations.empty()) {
+		pending.push_back({ SECTION_ANIMATIONS, encodeAnimations(project.animations, names) });
+	}
+	if (!names.strings.empty()) {
+		pending.push_back({ SECTION_STRINGS, encodeStrings(names.strings) });
+	}
+	pending.push_back({ SECTION_METADATA, encodeMetadata(project.metadata) });
+
+	ByteWriter header;
+	header.putBytes("ENOT", 4); // ENOT RAIN WORLDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDD (this is the only thing keeping me sane at this point)
+	header.putU32(PROJECT_FILE_VERSION);
+	header.putU32(static_cast<uint32_t>(pending.size()));
+
+	std::vector<std::vector<uint8_t>> stored(pending.size());
+	uint32_t offset = static_cast<uint32_t>(kHeaderSize + pending.size() * kSectionEntrySize);
+
+	for (size_t i = 0; i < pending.size(); i++) {
+		const auto& raw = pending[i].raw;
+		uint32_t flags = 0;
+
+		if (compressSections && raw.size() >= kMinCompressSize) {
+			std::vector<uint8_t> packed = Compression::compressLZ77(raw.data(), raw.size());
+			// only keep it if it actually bought us something
+			if (!packed.empty() && packed.size() < raw.size()) {
+				stored[i] = std::move(packed);
+				flags |= SECTION_FLAG_LZ77;
+			}
+		}
+		if (!(flags & SECTION_FLAG_LZ77)) {
+			stored[i] = raw;
+		}
+
+		header.putU32(pending[i].type);
+		header.putU32(flags);
+		header.putU32(offset);
+		header.putU32(static_cast<uint32_t>(stored[i].size()));
+		header.putU32(static_cast<uint32_t>(raw.size()));
+		header.putU32(Compression::crc32(raw.data(), raw.size()));
+
+		offset += static_cast<uint32_t>(stored[i].size());
+	}
+
+	std::vector<uint8_t> out = std::move(header.bytes);
+	out.reserve(offset);
+	for (const auto& data : stored) {
+		out.insert(out.end(), data.begin(), data.end());
+	}
+	return out;
+}
+
+bool ProjectReader::open(const std::string& path)
+{
+	std::ifstream file(path, std::ios::binary | std::ios::ate);
+	if (!file.is_open()) {
+		SDL_Log("Failed to open project: %s", path.c_str());
+		return false;
+	}
+
+	std::streamsize size = file.tellg();
+	file.seekg(0, std::ios::beg);
+
+	std::vector<uint8_t> bytes(static_cast<size_t>(SDL_max(static_cast<std::streamsize>(0), size)));
+	if (!bytes.empty() && !file.read(reinterpret_cast<char*>(bytes.data()), size)) {
+		SDL_Log("Failed to read project: %s", path.c_str());
+		return false;
+	}
+
+	return openFromMemory(std::move(bytes), path);
+}
+
+bool ProjectReader::openFromMemory(std::vector<uint8_t> bytes, const std::string& sourceLabel)
+{
+	fileData = std::move(bytes);
+	label = sourceLabel;
+	sections.clear();
+	strings.clear();
+	stringsLoaded = false;
+	version = 0;
+
+	if (fileData.size() < kHeaderSize || memcmp(fileData.data(), "ENOT", 4) != 0) {
+		SDL_Log("Invalid project file (bad magic): %s", label.c_str());
+		return false;
+	}
+
+	ByteCursor cursor(fileData.data() + 4, fileData.size() - 4);
+	version = cursor.getU32();
+
+	if (version == 1) return parseVersion1();
+	if (version == 2) return parseVersion2();
+
+	SDL_Log("Unsupported project version %u in: %s", version, label.c_str());
+	return false;
+}
+
+bool ProjectReader::parseVersion1()
+{
+	// v1 is just type/len/data back to back, no table and no checksums
+	ByteCursor cursor(fileData.data() + 8, fileData.size() - 8);
+	uint32_t sectionCount = cursor.getU32();
+
+	for (uint32_t s = 0; s < sectionCount && cursor.ok(); ++s) {
+		Section section;
+		section.type = cursor.getU32();
+		section.rawSize = cursor.getU32();
+		section.storedSize = section.rawSize;
+		section.offset = static_cast<uint32_t>(fileData.size() - cursor.remaining());
+		if (!cursor.ok() || cursor.getBytes(section.storedSize) == nullptr) {
+			SDL_Log("Truncated section %u in project file: %s", section.type, label.c_str());
+			break;
+		}
+		sections.push_back(std::move(section));
+	}
+
+	return true;
+}
+
+bool ProjectReader::parseVersion2()
+{
+	ByteCursor cursor(fileData.data() + 8, fileData.size() - 8);
+	uint32_t sectionCount = cursor.getU32();
+
+	for (uint32_t s = 0; s < sectionCount; ++s) {
+		Section section;
+		section.type = cursor.getU32();
+		section.flags = cursor.getU32();
+		section.offset = cursor.getU32();
+		section.storedSize = cursor.getU32();
+		section.rawSize = cursor.getU32();
+		section.checksum = cursor.getU32();
+
+		if (!cursor.ok()) {
+			SDL_Log("Truncated section table in project file: %s", label.c_str());
+			return false;
+		}
+
+		if (static_cast<uint64_t>(section.offset) + section.storedSize > fileData.size()) {
+			SDL_Log("Section %u points past the end of project file: %s", section.type, label.c_str());
+			continue;
+		}
+
+		sections.push_back(std::move(section));
+	}
+
+	return true;
+}
+
+bool ProjectReader::hasSection(uint32_t type) const
+{
+	for (const auto& section : sections) {
+		if (section.type == type) return true;
+	}
+	return false;
+}
+
+ProjectReader::Section* ProjectReader::findSection(uint32_t type)
+{
+	for (auto& section : sections) {
+		if (section.type == type) return &section;
+	}
+	return nullptr;
+}
+
+const std::vector<uint8_t>* ProjectReader::getSectionData(uint32_t type)
+{
+	Section* section = findSection(type);
+	if (section == nullptr) {
+		return nullptr;
+	}
+
+	if (section->decoded) {
+		return section->valid ? &section->data : nullptr;
+	}
+	section->decoded = true;
+
+	const uint8_t* stored = fileData.data() + section->offset;
+	if (section->flags & SECTION_FLAG_LZ77) {
+		if (!Compression::decompressLZ77(stored, section->storedSize, section->data) ||
+			section->data.size() != section->rawSize) {
+			SDL_Log("Failed to decompress section %u in project file: %s", type, label.c_str());
+			return nullptr;
+		}
+	}
+	else {
+		section->data.assign(stored, stored + section->storedSize);
+	}
+
+	if (version >= 2 && Compression::crc32(section->data.data(), section->data.size()) != section->checksum) {
+		SDL_Log("Checksum mismatch in section %u of project file: %s", type, label.c_str());
+		section->data.clear();
+		return nullptr;
+	}
+
+	section->valid = true;
+	return &section->data;
+}
+
+bool ProjectReader::loadStrings()
+{
+	if (stringsLoaded) {
+		return true;
+	}
+
+	const std::vector<uint8_t>* data = getSectionData(SECTION_STRINGS);
+	if (data == nullptr) {
+		return false;
+	}
+
+	ByteCursor cursor(data->data(), data->size());
+	uint32_t count = cursor.getU32();
+	strings.clear();
+	strings.reserve(SDL_min(static_cast<size_t>(count), cursor.remaining() / 4));
+	for (uint32_t i = 0; i < count && cursor.ok(); i++) {
+		uint32_t len = cursor.getU32();
+		const uint8_t* chars = cursor.getBytes(len);
+		if (chars == nullptr) break;
+		strings.emplace_back(reinterpret_cast<const char*>(chars), len);
+	}
+
+	if (!cursor.ok()) {
+		SDL_Log("Truncated string table in project file: %s", label.c_str());
+		return false;
+	}
+
+	stringsLoaded = true;
+	return true;
+}
+
+bool ProjectReader::readTiles(Tiles& out)
+{
+	const std::vector<uint8_t>* data = getSectionData(SECTION_TILES);
+	if (data == nullptr) {
+		return false;
+	}
+
+	out = Tiles();
+	for (size_t offset = 0; offset + 32 <= data->size(); offset += 32) {
+		std::array<uint8_t, 32> tile;
+		memcpy(tile.data(), data->data() + offset, 32);
+		out.addTile(tile);
+	}
+	return true;
+}
+
+bool ProjectReader::readPalettes(std::vector<Palette>& out)
+{
+	const std::vector<uint8_t>* data = getSectionData(SECTION_PALETTES);
+	if (data == nullptr) {
+		return false;
+	}
+
+	out.clear();
+	size_t offset = 0;
+	while (offset + (16 * 4) <= data->size()) {
+		Palette pal;
+		for (int i = 0; i < 16; ++i) {
+			pal.colors[i].r = (*data)[offset++];
+			pal.colors[i].g = (*data)[offset++];
+			pal.colors[i].b = (*data)[offset++];
+			pal.colors[i].a = (*data)[offset++];
+		}
+		out.push_back(pal);
+	}
+	return true;
+}
+
+bool ProjectReader::readTilePalettes(std::vector<uint8_t>& out)
+{
+	const std::vector<uint8_t>* data = getSectionData(SECTION_TILE_PALETTES);
+	if (data == nullptr) {
+		return false;
+	}
+
+	out = *data;
+	return true;
+}
+
+bool ProjectReader::readAnimationCels(std::vector<AnimationCel>& out)
+{
+	if (const std::vector<uint8_t>* text = getSectionData(SECTION_CELS_TEXT)) {
+		out = ResourceManager::loadAnimationCelsFromText(std::string(text->begin(), text->end()), label + " [section:cels]");
+		return true;
+	}
+
+	const std::vector<uint8_t>* data = getSectionData(SECTION_CELS);
+	if (data == nullptr || !loadStrings()) {
+		return false;
+	}
+
+	ByteCursor cursor(data->data(), data->size());
+	uint32_t count = cursor.getU32();
+	out.clear();
+	out.reserve(SDL_min(static_cast<size_t>(count), cursor.remaining() / 8));
+
+	for (uint32_t i = 0; i < count && cursor.ok(); i++) {
+		AnimationCel cel;
+		uint32_t nameId = cursor.getU32();
+		uint32_t oamCount = cursor.getU32();
+		if (!cursor.ok() || nameId >= strings.size() || oamCount > cursor.remaining() / 6) {
+			SDL_Log("Corrupt cel %u in project file: %s", i, label.c_str());
+			return false;
+		}
+
+		cel.name = strings[nameId];
+		cel.oams.resize(oamCount);
+		for (auto& oam : cel.oams) {
+			uint16_t raw[3] = { cursor.getU16(), cursor.getU16(), cursor.getU16() };
+			memcpy(&oam, raw, sizeof(raw));
+		}
+		out.push_back(std::move(cel));
+	}
+
+	return cursor.ok();
+}
+
+bool ProjectReader::readAnimations(std::vector<Animation>& out)
+{
+	if (const std::vector<uint8_t>* text = getSectionData(SECTION_ANIMATIONS_TEXT)) {
+		out = ResourceManager::loadAnimationsFromText(std::string(text->begin(), text->end()), label + " [section:anims]");
+		return true;
+	}
+
+	const std::vector<uint8_t>* data = getSectionData(SECTION_ANIMATIONS);
+	if (data == nullptr || !loadStrings()) {
+		return false;
+	}
+
+	ByteCursor cursor(data->data(), data->size());
+	uint32_t count = cursor.getU32();
+	out.clear();
+	out.reserve(SDL_min(static_cast<size_t>(count), cursor.remaining() / 8));
+
+	for (uint32_t i = 0; i < count && cursor.ok(); i++) {
+		Animation anim;
+		uint32_t nameId = cursor.getU32();
+		uint32_t entryCount = cursor.getU32();
+		if (!cursor.ok() || nameId >= strings.size() || entryCount > cursor.remaining() / 5) {
+			SDL_Log("Corrupt animation %u in project file: %s", i, label.c_str());
+			return false;
+		}
+
+		anim.name = strings[nameId];
+		anim.entries.resize(entryCount);
+		for (auto& entry : anim.entries) {
+			uint32_t celNameId = cursor.getU32();
+			entry.duration = cursor.getU8();
+			if (celNameId < strings.size()) {
+				entry.celName = strings[celNameId];
+			}
+		}
+		out.push_back(std::move(anim));
+	}
+
+	return cursor.ok();
+}
+
+bool ProjectReader::readMetadata(ProjectMetadata& out)
+{
+	const std::vector<uint8_t>* data = getSectionData(SECTION_METADATA);
+	if (data == nullptr) {
+		return false;
+	}
+
+	std::istringstream iss(std::string(data->begin(), data->end()));
+	std::string line;
+	while (std::getline(iss, line)) {
+		size_t eq = line.find('=');
+		if (eq == std::string::npos) continue;
+		std::string key = line.substr(0, eq);
+		std::string val = line.substr(eq + 1);
+
+		if (key == "celFilename") out.celFilename = val;
+		else if (key == "currentPalette") {
+			try { out.currentPalette = std::stoi(val); } catch (...) {}
+		}
+		else if (key == "currentAnimation") {
+			try { out.currentAnimation = std::stoi(val); } catch (...) {}
+		}
+		else if (key == "frameRate") {
+			try { out.frameRate = std::stof(val); } catch (...) {}
+		}
+		else if (key == "loopAnimation") {
+			out.loopAnimation = (val == "1");
+		}
+		else if (key == "useTilePalettes") {
+			out.useTilePalettes = (val == "1");
+		}
+	}
+	return true;
+}
+
+bool ProjectReader::readAll(ProjectData& out)
+{
+	out = ProjectData();
+
+	// missing sections are fine (empty project bits), only corrupt ones are worth complaining about
+	bool ok = true;
+	if (hasSection(SECTION_TILES)) ok &= readTiles(out.tiles);
+	if (hasSection(SECTION_PALETTES)) ok &= readPalettes(out.palettes);
+	if (hasSection(SECTION_TILE_PALETTES)) ok &= readTilePalettes(out.tilePalettes);
+	if (hasSection(SECTION_CELS) || hasSection(SECTION_CELS_TEXT)) ok &= readAnimationCels(out.animationCels);
+	if (hasSection(SECTION_ANIMATIONS) || hasSection(SECTION_ANIMATIONS_TEXT)) ok &= readAnimations(out.animations);
+	if (hasSection(SECTION_METADATA)) ok &= readMetadata(out.metadata);
+
+	for (const auto& section : sections) {
+		if (section.type < SECTION_TILES || section.type > SECTION_TILE_PALETTES) {
+			SDL_Log("unknown section????? type %u in project file: %s", section.type, label.c_str());
+		}
+	}
+
+	return ok;
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Graphics.h"
+
+#define PROJECT_FILE_VERSION 2
+
+// section ids, 1-5 have been around since v1, 6+ only show up in v2
+enum ProjectSectionType : uint32_t {
+	SECTION_TILES = 1,
+	SECTION_PALETTES = 2,
+	SECTION_CELS_TEXT = 3,
+	SECTION_ANIMATIONS_TEXT = 4,
+	SECTION_METADATA = 5,
+	SECTION_STRINGS = 6,
+	SECTION_CELS = 7,
+	SECTION_ANIMATIONS = 8,
+	SECTION_TILE_PALETTES = 9
+};
+
+enum ProjectSectionFlags : uint32_t {
+	SECTION_FLAG_LZ77 = 1 << 0
+};
+
+struct ProjectMetadata {
+	std::string celFilename;
+	int currentPalette = 0;
+	int currentAnimation = -1;
+	float frameRate = 60.0f;
+	bool loopAnimation = true;
+	bool useTilePalettes = false;
+};
+
+struct ProjectData {
+	Tiles tiles;
+	std::vector<Palette> palettes;
+	std::vector<uint8_t> tilePalettes; // palette of each tile from image conversion, usually empty
+	std::vector<AnimationCel> animationCels;
+	std::vector<Animation> animations;
+	ProjectMetadata metadata;
+};
+
+class ProjectWriter
+{
+public:
+	static std::vector<uint8_t> serialize(const ProjectData& project, bool compressSections);
+};
+
+// reads the header + section table up front, sections are only decompressed,
+// checksummed and decoded the first time somebody asks for them
+class ProjectReader
+{
+public:
+	bool open(const std::string& path);
+	bool openFromMemory(std::vector<uint8_t> bytes, const std::string& sourceLabel);
+
+	uint32_t getVersion() const { return version; }
+	bool hasSection(uint32_t type) const;
+
+	bool readTiles(Tiles& out);
+	bool readPalettes(std::vector<Palette>& out);
+	bool readTilePalettes(std::vector<uint8_t>& out);
+	bool readAnimationCels(std::vector<AnimationCel>& out);
+	bool readAnimations(std::vector<Animation>& out);
+	bool readMetadata(ProjectMetadata& out);
+	bool readAll(ProjectData& out);
+
+private:
+	struct Section {
+		uint32_t type = 0;
+		uint32_t flags = 0;
+		uint32_t offset = 0;
+		uint32_t storedSize = 0;
+		uint32_t rawSize = 0;
+		uint32_t checksum = 0;
+		bool decoded = false;
+		bool valid = false;
+		std::vector<uint8_t> data;
+	};
+
+	bool parseVersion1();
+	bool parseVersion2();
+	Section* findSection(uint32_t type);
+	const std::vector<uint8_t>* getSectionData(uint32_t type);
+	bool loadStrings();
+
+	std::vector<uint8_t> fileData;
+	std::vector<Section> sections;
+	std::vector<std::string> strings;
+	bool stringsLoaded = false;
+	uint32_t version = 0;
+	std::string label;
+};
@@ -0,0 +1,100 @@
+#include "ProjectSaver.h"
+
+#include "FileUtils.h"
+
+ProjectSaver::~ProjectSaver()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	wakeWorker.notify_all();
+
+	// worker drains whatever's queued before leaving, closing mid-save shouldn't eat the file
+	if (worker.joinable()) {
+		worker.join();
+	}
+}
+
+void ProjectSaver::requestSave(std::shared_ptr<const DocumentSnapshot> snapshot, const std::string& path, bool compress, uint64_t tag)
+{
+	auto job = std::make_unique<Job>();
+	job->snapshot = std::move(snapshot);
+	job->path = path;
+	job->compress = compress;
+	job->tag = tag;
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		pendingJob = std::move(job);
+		if (!worker.joinable()) {
+			worker = std::thread(&ProjectSaver::workerLoop, this);
+		}
+	}
+	wakeWorker.notify_one();
+}
+
+bool ProjectSaver::pollResult(ProjectSaveResult& out)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	if (!hasResult) {
+		return false;
+	}
+
+	out = lastResult;
+	hasResult = false;
+	return true;
+}
+
+bool ProjectSaver::isBusy() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return jobRunning || pendingJob != nullptr;
+}
+
+void ProjectSaver::workerLoop()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	while (true) {
+		wakeWorker.wait(lock, [this]() { return stopping || pendingJob != nullptr; });
+		if (pendingJob == nullptr) {
+			return;
+		}
+
+		std::unique_ptr<Job> job = std::move(pendingJob);
+		jobRunning = true;
+		lock.unlock();
+
+		ProjectSaveResult result = runJob(*job);
+		job.reset();
+
+		lock.lock();
+		jobRunning = false;
+		lastResult = std::move(result);
+		hasResult = true;
+	}
+}
+
+ProjectSaveResult ProjectSaver::runJob(const Job& job)
+{
+	ProjectSaveResult result;
+	result.path = job.path;
+	result.tag = job.tag;
+
+	Uint64 startTicks = SDL_GetTicks();
+	std::vector<uint8_t> bytes = ProjectWriter::serialize(job.snapshot->materialize(), job.compress);
+
+	result.success = writeFileAtomically(job.path, bytes, result.error);
+	result.bytesWritten = result.success ? bytes.size() : 0;
+	result.durationMs = SDL_GetTicks() - startTicks;
+
+	if (result.success) {
+		SDL_Log("Saved project to %s (%zu bytes, %llu ms)", job.path.c_str(), bytes.size(),
+			static_cast<unsigned long long>(result.durationMs));
+	}
+	else {
+		SDL_Log("Failed to save project to %s: %s", job.path.c_str(), result.error.c_str());
+	}
+
+	return result;
+}
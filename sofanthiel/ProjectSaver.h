@@ -0,0 +1,57 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "DocumentSnapshot.h"
+
+struct ProjectSaveResult {
+	std::string path;
+	bool success = false;
+	std::string error;
+	size_t bytesWritten = 0;
+	uint64_t durationMs = 0;
+	uint64_t tag = 0;
+};
+
+// serializes + writes project snapshots on its own thread so the ui never waits on disk.
+// snapshots are immutable so the editor can keep going while the worker reads one.
+// if a save is requested while one is running the newest snapshot replaces whatever was queued
+class ProjectSaver
+{
+public:
+	ProjectSaver() = default;
+	~ProjectSaver();
+
+	ProjectSaver(const ProjectSaver&) = delete;
+	ProjectSaver& operator=(const ProjectSaver&) = delete;
+
+	// tag comes back untouched in the result, handy for telling which snapshot actually landed
+	void requestSave(std::shared_ptr<const DocumentSnapshot> snapshot, const std::string& path, bool compress, uint64_t tag = 0);
+	bool pollResult(ProjectSaveResult& out);
+	bool isBusy() const;
+
+private:
+	struct Job {
+		std::shared_ptr<const DocumentSnapshot> snapshot;
+		std::string path;
+		bool compress = true;
+		uint64_t tag = 0;
+	};
+
+	void workerLoop();
+	static ProjectSaveResult runJob(const Job& job);
+
+	mutable std::mutex mutex;
+	std::condition_variable wakeWorker;
+	std::thread worker;
+	std::unique_ptr<Job> pendingJob;
+	bool jobRunning = false;
+	bool stopping = false;
+	bool hasResult = false;
+	ProjectSaveResult lastResult;
+};
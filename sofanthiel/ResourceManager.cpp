@@ -1,266 +1,558 @@
 ﻿#include "ResourceManager.h"
 #include "gif.h"
-#include <climits>
+#include "FileUtils.h"
+#include "TextScanner.h"
+#include "TextWriter.h"
+#include "ByteStream.h"
+#include "Compression.h"
+#include "MappedFile.h"
+#include "PaletteQuantizer.h"
+#include "TileQuantizer.h"
+#include "JobSystem.h"
+#include <atomic>
 #include <cctype>
 #include <cmath>
-#include <regex>
+#include <cstdio>
+#include <memory>
 #include <set>
+#include <thread>
 
 namespace {
-std::vector<AnimationCel> parseAnimationCelsStream(std::istream& input, const std::string& sourceLabel)
+constexpr size_t kMaxCompressedTilesSize = 1024 * 1024;
+
+// any line with the keyword and a '[' counts as a declaration, but only `AnimationCel name[]`
+// opens a new cel (and with it a new block). `name` is left empty otherwise
+bool matchCelDeclaration(std::string_view line, bool& opensCel, std::string_view& name)
 {
-    std::vector<AnimationCel> cels;
+    size_t celKeyword = line.find("AnimationCel");
+    if (celKeyword == std::string_view::npos || !containsText(line, "[")) {
+        return false;
+    }
+
+    size_t nameStart = celKeyword + 12;
+    while (nameStart < line.length() && isTextSpace(line[nameStart])) nameStart++;
 
-    std::string line;
+    size_t nameEnd = line.find("[]", nameStart);
+    opensCel = nameEnd != std::string_view::npos;
+    name = opensCel ? line.substr(nameStart, nameEnd - nameStart) : std::string_view();
+    return true;
+}
+
+// one pass over the buffer, lines and tokens are views into it. only cel names and finished
+// oams get copied out. `firstLine` is what the first line of `text` is in the whole file
+void parseAnimationCelLines(std::string_view text, const std::string& sourceLabel, int firstLine, std::vector<AnimationCel>& cels)
+{
+    LineScanner lines(text, firstLine);
+    std::string_view line;
     AnimationCel currentCel;
     bool readingCel = false;
     bool nextLineIsLength = false;
     int expectedOAMs = 0;
     int currentOAMs = 0;
+    int celLine = 0;
 
-    while (std::getline(input, line)) {
+    while (lines.next(line)) {
         if (line.empty()) {
             continue;
         }
 
-        if (line.find("AnimationCel") != std::string::npos && line.find("[") != std::string::npos) {
+        bool opensCel = false;
+        std::string_view celName;
+        if (matchCelDeclaration(line, opensCel, celName)) {
             if (readingCel && currentCel.oams.size() > 0) {
-                cels.push_back(currentCel);
+                // only safe to steal it when it's about to be replaced anyway
+                if (opensCel) cels.push_back(std::move(currentCel));
+                else cels.push_back(currentCel);
             }
 
-            size_t nameStart = line.find("AnimationCel") + 12;
-            while (nameStart < line.length() && std::isspace(static_cast<unsigned char>(line[nameStart]))) nameStart++;
-
-            size_t nameEnd = line.find("[]", nameStart);
-            if (nameEnd != std::string::npos) {
+            if (opensCel) {
                 currentCel = AnimationCel();
-                currentCel.name = line.substr(nameStart, nameEnd - nameStart);
-                currentCel.oams.clear();
+                currentCel.name.assign(celName);
                 readingCel = true;
                 nextLineIsLength = true;
                 expectedOAMs = 0;
                 currentOAMs = 0;
+                celLine = lines.getLineNumber();
             }
         }
         else if (readingCel && nextLineIsLength) {
             size_t lenPos = line.find_first_of("0123456789");
-            if (lenPos != std::string::npos) {
-                size_t lenEnd = line.find_first_not_of("0123456789", lenPos);
-                if (lenEnd == std::string::npos) lenEnd = line.length();
-
-                std::string lenStr = line.substr(lenPos, lenEnd - lenPos);
-                try {
-                    expectedOAMs = std::stoi(lenStr);
-                }
-                catch (...) {
+            if (lenPos != std::string_view::npos) {
+                if (!parseDecimalPrefix(line.substr(lenPos), expectedOAMs)) {
+                    SDL_Log("%s:%d:%zu: OAM count for cel %s is out of range",
+                        sourceLabel.c_str(), lines.getLineNumber(), lenPos + 1, currentCel.name.c_str());
                     expectedOAMs = 0;
                 }
             }
             nextLineIsLength = false;
         }
-        else if (readingCel && line.find("0x") != std::string::npos) {
-            std::istringstream iss(line);
-            std::string token;
-            std::vector<uint16_t> values;
-
-            while (iss >> token) {
-                if (token.substr(0, 2) == "0x") {
-                    try {
-                        uint16_t value = static_cast<uint16_t>(std::stoul(token, nullptr, 16));
-                        values.push_back(value);
-                    }
-                    catch (...) {
-                    }
+        else if (readingCel && containsText(line, "0x")) {
+            TokenScanner tokens(line);
+            std::string_view token;
+            uint16_t values[3] = {};
+            size_t valueCount = 0;
+            size_t firstValueOffset = 0;
+
+            while (tokens.next(token)) {
+                if (token.substr(0, 2) != "0x") {
+                    continue;
                 }
+
+                unsigned long value = 0;
+                if (!parseHexPrefix(token, value)) {
+                    SDL_Log("%s:%d:%zu: hex value out of range in cel %s",
+                        sourceLabel.c_str(), lines.getLineNumber(), tokens.getTokenOffset() + 1, currentCel.name.c_str());
+                    continue;
+                }
+
+                if (valueCount == 0) firstValueOffset = tokens.getTokenOffset();
+                if (valueCount < 3) values[valueCount] = static_cast<uint16_t>(value);
+                valueCount++;
             }
 
-            if (values.size() == 3) {
+            if (valueCount == 3) {
                 TengokuOAM tengokuOAM;
-                memcpy(&tengokuOAM, values.data(), sizeof(TengokuOAM));
+                memcpy(&tengokuOAM, values, sizeof(TengokuOAM));
 
                 currentCel.oams.push_back(tengokuOAM);
                 currentOAMs++;
             }
+            else if (valueCount > 0) {
+                SDL_Log("%s:%d:%zu: skipped OAM in cel %s, expected 3 values but got %zu",
+                    sourceLabel.c_str(), lines.getLineNumber(), firstValueOffset + 1, currentCel.name.c_str(), valueCount);
+            }
         }
-        else if (readingCel && line.find("};") != std::string::npos) {
+        else if (readingCel && containsText(line, "};")) {
             if (expectedOAMs > 0 && currentOAMs != expectedOAMs) {
-                SDL_Log("Warning: Cel %s expected %d OAMs but got %d",
-                    currentCel.name.c_str(), expectedOAMs, currentOAMs);
+                SDL_Log("%s:%d: Warning: Cel %s (line %d) expected %d OAMs but got %d",
+                    sourceLabel.c_str(), lines.getLineNumber(), currentCel.name.c_str(), celLine, expectedOAMs, currentOAMs);
             }
 
             if (currentCel.oams.size() > 0) {
-                cels.push_back(currentCel);
+                cels.push_back(std::move(currentCel));
             }
             readingCel = false;
         }
     }
 
     if (readingCel && currentCel.oams.size() > 0) {
-        cels.push_back(currentCel);
+        cels.push_back(std::move(currentCel));
     }
+}
+
+std::vector<AnimationCel> parseAnimationCelsText(std::string_view text, const std::string& sourceLabel)
+{
+    std::vector<AnimationCel> cels;
+    parseAnimationCelLines(text, sourceLabel, 1, cels);
 
     SDL_Log("Loaded %zu animation cels from %s", cels.size(), sourceLabel.c_str());
     return cels;
 }
 
-std::vector<Animation> parseAnimationsStream(std::istream& input, const std::string& sourceLabel)
+std::vector<Animation> parseAnimationsText(std::string_view text, const std::string& sourceLabel)
 {
     std::vector<Animation> animations;
 
-    std::string line;
+    LineScanner lines(text);
+    std::string_view line;
     Animation currentAnimation;
     bool readingAnim = false;
 
-    while (std::getline(input, line)) {
-        if (line.empty() || line.find("#include") != std::string::npos) {
+    while (lines.next(line)) {
+        if (line.empty() || containsText(line, "#include")) {
             continue;
         }
 
-        if (line.find("struct Animation") != std::string::npos && line.find("[") != std::string::npos) {
+        if (containsText(line, "struct Animation") && containsText(line, "[")) {
+            size_t nameStart = line.find("anim_");
+            if (nameStart == std::string_view::npos) nameStart = 0;
+            size_t nameEnd = line.find("[]", nameStart);
+
             if (readingAnim && !currentAnimation.entries.empty()) {
-                animations.push_back(currentAnimation);
+                if (nameEnd != std::string_view::npos) animations.push_back(std::move(currentAnimation));
+                else animations.push_back(currentAnimation);
             }
 
-            size_t nameStart = line.find("anim_") != std::string::npos ? line.find("anim_") : 0;
-            size_t nameEnd = line.find("[]", nameStart);
-            if (nameEnd != std::string::npos) {
+            if (nameEnd != std::string_view::npos) {
                 currentAnimation = Animation();
-                currentAnimation.name = line.substr(nameStart, nameEnd - nameStart);
-                currentAnimation.entries.clear();
+                currentAnimation.name.assign(line.substr(nameStart, nameEnd - nameStart));
                 readingAnim = true;
             }
         }
-        else if (readingAnim && line.find("{") != std::string::npos && line.find("}") != std::string::npos) {
-            if (line.find("END_ANIMATION") != std::string::npos) {
+        else if (readingAnim && containsText(line, "{") && containsText(line, "}")) {
+            if (containsText(line, "END_ANIMATION")) {
                 readingAnim = false;
                 continue;
             }
 
-            size_t celStart = line.find("{") + 1;
-            size_t celEnd = line.find(",", celStart);
-
-            if (celEnd != std::string::npos) {
-                std::string celName = line.substr(celStart, celEnd - celStart);
-
-                celName.erase(0, celName.find_first_not_of(" \t"));
-                celName.erase(celName.find_last_not_of(" \t") + 1);
-
-                size_t durationStart = celEnd + 1;
-                size_t durationEnd = line.find("}", durationStart);
-                if (durationEnd != std::string::npos) {
-                    std::string durationStr = line.substr(durationStart, durationEnd - durationStart);
-
-                    durationStr.erase(0, durationStr.find_first_not_of(" \t"));
-                    durationStr.erase(durationStr.find_last_not_of(" \t") + 1);
-
-                    try {
-                        int duration = std::stoi(durationStr);
+            size_t celStart = line.find('{') + 1;
+            size_t celEnd = line.find(',', celStart);
+            if (celEnd == std::string_view::npos) {
+                continue;
+            }
 
-                        AnimationEntry entry;
-                        entry.celName = celName;
-                        entry.duration = duration;
+            size_t durationStart = celEnd + 1;
+            size_t durationEnd = line.find('}', durationStart);
+            if (durationEnd == std::string_view::npos) {
+                continue;
+            }
 
-                        currentAnimation.entries.push_back(entry);
-                    }
-                    catch (...) {
-                        SDL_Log("Failed to parse duration in animation %s", currentAnimation.name.c_str());
-                    }
-                }
+            std::string_view durationText = trimText(line.substr(durationStart, durationEnd - durationStart));
+            int duration = 0;
+            if (!parseDecimalPrefix(durationText, duration)) {
+                SDL_Log("%s:%d:%zu: Failed to parse duration in animation %s", sourceLabel.c_str(),
+                    lines.getLineNumber(), durationStart + 1, currentAnimation.name.c_str());
+                continue;
             }
+
+            AnimationEntry entry;
+            entry.celName.assign(trimText(line.substr(celStart, celEnd - celStart)));
+            entry.duration = duration;
+            currentAnimation.entries.push_back(std::move(entry));
         }
-        else if (readingAnim && line.find("};") != std::string::npos) {
+        else if (readingAnim && containsText(line, "};")) {
             if (!currentAnimation.entries.empty()) {
-                animations.push_back(currentAnimation);
+                animations.push_back(std::move(currentAnimation));
             }
             readingAnim = false;
         }
     }
 
     if (readingAnim && !currentAnimation.entries.empty()) {
-        animations.push_back(currentAnimation);
+        animations.push_back(std::move(currentAnimation));
     }
 
     SDL_Log("Loaded %zu animations from %s", animations.size(), sourceLabel.c_str());
     return animations;
 }
+
+bool isWordChar(char c)
+{
+    return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
 }
 
-std::vector<ParsedCPaletteGroup> ResourceManager::parsePalettesFromCFile(const std::string& path)
+size_t skipTextSpace(std::string_view text, size_t pos)
 {
-    std::vector<ParsedCPaletteGroup> groups;
-    std::ifstream file(path);
+    while (pos < text.size() && isTextSpace(text[pos])) pos++;
+    return pos;
+}
 
-    if (!file.is_open()) {
-        SDL_Log("Failed to open palette C file: %s", path.c_str());
-        return groups;
+// `Palette <name> [ ] = {` starting at `at`, hands back the name and the opening brace
+bool matchPaletteDeclaration(std::string_view text, size_t at, std::string_view& name, size_t& braceStart)
+{
+    size_t pos = at + 7;
+    size_t nameStart = skipTextSpace(text, pos);
+    if (nameStart == pos) return false;
+
+    pos = nameStart;
+    while (pos < text.size() && isWordChar(text[pos])) pos++;
+    if (pos == nameStart) return false;
+    name = text.substr(nameStart, pos - nameStart);
+
+    for (char expected : { '[', ']', '=', '{' }) {
+        pos = skipTextSpace(text, pos);
+        if (pos >= text.size() || text[pos] != expected) return false;
+        pos++;
     }
 
-    std::string content((std::istreambuf_iterator<char>(file)),
-                         std::istreambuf_iterator<char>());
-    file.close();
+    braceStart = pos - 1;
+    return true;
+}
 
-    // i should have learned rust
-    std::regex declRegex(R"(Palette\s+(\w+)\s*\[\s*\]\s*=\s*\{)");
-    std::regex paletteBlockRegex(R"(\{([^{}]*)\})");
-    std::regex colorRegex(R"(TO_RGB555\s*\(\s*0x([0-9A-Fa-f]{4,6})\s*\))");
+// `TO_RGB555 ( 0x<4-6 hex digits> )` starting at `at`
+bool matchRGB555Macro(std::string_view text, size_t at, uint32_t& rgb24, size_t& matchEnd)
+{
+    size_t pos = skipTextSpace(text, at + 9);
+    if (pos >= text.size() || text[pos] != '(') return false;
 
-    auto declBegin = std::sregex_iterator(content.begin(), content.end(), declRegex); // looks to the moon
-    auto declEnd = std::sregex_iterator(); // five pebbles
+    pos = skipTextSpace(text, pos + 1);
+    if (text.substr(pos, 2) != "0x") return false;
+    pos += 2;
 
-    for (auto dit = declBegin; dit != declEnd; ++dit) {
-        ParsedCPaletteGroup group;
-        group.name = (*dit)[1].str();
+    size_t digitsStart = pos;
+    while (pos < text.size() && isHexDigit(text[pos])) pos++;
+    size_t digits = pos - digitsStart;
+    if (digits < 4 || digits > 6) return false;
+
+    size_t closePos = skipTextSpace(text, pos);
+    if (closePos >= text.size() || text[closePos] != ')') return false;
+
+    std::from_chars(text.data() + digitsStart, text.data() + pos, rgb24, 16);
+    matchEnd = closePos + 1;
+    return true;
+}
+
+int parsePaletteColors(std::string_view block, Palette& palette)
+{
+    int colorIdx = 0;
+
+    if (containsText(block, "TO_RGB555")) {
+        size_t pos = 0;
+        while (colorIdx < 16 && (pos = block.find("TO_RGB555", pos)) != std::string_view::npos) {
+            uint32_t rgb24 = 0;
+            size_t matchEnd = 0;
+            if (!matchRGB555Macro(block, pos, rgb24, matchEnd)) {
+                pos++;
+                continue;
+            }
+
+            palette.colors[colorIdx].r = static_cast<uint8_t>((rgb24 >> 16) & 0xFF);
+            palette.colors[colorIdx].g = static_cast<uint8_t>((rgb24 >> 8) & 0xFF);
+            palette.colors[colorIdx].b = static_cast<uint8_t>(rgb24 & 0xFF);
+            palette.colors[colorIdx].a = 255;
+            colorIdx++;
+            pos = matchEnd;
+        }
+        return colorIdx;
+    }
+
+    // no macro, so plain u16 gba colors like 0x7FFF. comments get skipped here since a
+    // stray hex number in one would shift every color after it
+    size_t pos = 0;
+    while (colorIdx < 16 && pos < block.size()) {
+        if (block.substr(pos, 2) == "/*") {
+            size_t end = block.find("*/", pos + 2);
+            pos = (end == std::string_view::npos) ? block.size() : end + 2;
+            continue;
+        }
+        if (block.substr(pos, 2) == "//") {
+            size_t end = block.find('\n', pos);
+            pos = (end == std::string_view::npos) ? block.size() : end + 1;
+            continue;
+        }
+
+        bool tokenStart = pos == 0 || !isWordChar(block[pos - 1]);
+        if (tokenStart && block[pos] == '0' && pos + 2 < block.size() && (block[pos + 1] == 'x' || block[pos + 1] == 'X')) {
+            size_t digitsStart = pos + 2;
+            size_t digitsEnd = digitsStart;
+            while (digitsEnd < block.size() && isHexDigit(block[digitsEnd])) digitsEnd++;
+
+            uint32_t value = 0;
+            size_t digits = digitsEnd - digitsStart;
+            bool standalone = digitsEnd >= block.size() || !isWordChar(block[digitsEnd]);
+            if (digits > 0 && digits <= 4 && standalone) {
+                std::from_chars(block.data() + digitsStart, block.data() + digitsEnd, value, 16);
+                palette.colors[colorIdx++] = colorFromRGB555(static_cast<uint16_t>(value));
+            }
+            pos = digitsEnd;
+            continue;
+        }
+
+        pos++;
+    }
+    return colorIdx;
+}
+
+// one linear walk: find each `Palette name[] = {`, then every innermost {...} inside
+// it is one palette
+std::vector<ParsedCPaletteGroup> parsePaletteGroupsText(std::string_view text, const std::string& sourceLabel)
+{
+    std::vector<ParsedCPaletteGroup> groups;
+
+    size_t searchPos = 0;
+    while ((searchPos = text.find("Palette", searchPos)) != std::string_view::npos) {
+        std::string_view name;
+        size_t braceStart = 0;
+        if (!matchPaletteDeclaration(text, searchPos, name, braceStart)) {
+            searchPos++;
+            continue;
+        }
+        searchPos = braceStart + 1;
 
-        size_t braceStart = dit->position() + dit->length() - 1;
         int depth = 1;
         size_t pos = braceStart + 1;
-        while (pos < content.size() && depth > 0) {
-            if (content[pos] == '{') depth++;
-            else if (content[pos] == '}') depth--;
+        while (pos < text.size() && depth > 0) {
+            if (text[pos] == '{') depth++;
+            else if (text[pos] == '}') depth--;
             pos++;
         }
-        std::string groupBody = content.substr(braceStart + 1, pos - braceStart - 2);
-
-        auto palBegin = std::sregex_iterator(groupBody.begin(), groupBody.end(), paletteBlockRegex);
-        auto palEnd = std::sregex_iterator();
-
-        for (auto pit = palBegin; pit != palEnd; ++pit) {
-            std::string palBody = (*pit)[1].str();
-
-            // extracts the RGB hex value from TO_RGB555
-            auto colBegin = std::sregex_iterator(palBody.begin(), palBody.end(), colorRegex);
-            auto colEnd = std::sregex_iterator();
-
-            Palette palette;
-            memset(&palette, 0, sizeof(Palette));
-            int colorIdx = 0;
-
-            // super parsing style
-            for (auto cit = colBegin; cit != colEnd && colorIdx < 16; ++cit, ++colorIdx) {
-                std::string hexStr = (*cit)[1].str();
-                uint32_t rgb24 = std::stoul(hexStr, nullptr, 16);
-                palette.colors[colorIdx].r = static_cast<uint8_t>((rgb24 >> 16) & 0xFF);
-                palette.colors[colorIdx].g = static_cast<uint8_t>((rgb24 >> 8) & 0xFF);
-                palette.colors[colorIdx].b = static_cast<uint8_t>(rgb24 & 0xFF);
-                palette.colors[colorIdx].a = 255;
-            }
+        size_t bodyEnd = std::max(braceStart + 1, pos - 1);
+        std::string_view groupBody = text.substr(braceStart + 1, bodyEnd - braceStart - 1);
 
-            if (colorIdx > 0) {
-                group.palettes.push_back(palette);
+        ParsedCPaletteGroup group;
+        size_t blockOpen = std::string_view::npos;
+        for (size_t i = 0; i < groupBody.size(); i++) {
+            if (groupBody[i] == '{') {
+                blockOpen = i;
+            }
+            else if (groupBody[i] == '}' && blockOpen != std::string_view::npos) {
+                Palette palette;
+                memset(&palette, 0, sizeof(Palette));
+                if (parsePaletteColors(groupBody.substr(blockOpen + 1, i - blockOpen - 1), palette) > 0) {
+                    group.palettes.push_back(palette);
+                }
+                blockOpen = std::string_view::npos;
             }
         }
 
         if (!group.palettes.empty()) {
-            groups.push_back(group);
+            group.name.assign(name);
             SDL_Log("Parsed palette group '%s' with %zu palettes from %s",
-                group.name.c_str(), group.palettes.size(), path.c_str());
+                group.name.c_str(), group.palettes.size(), sourceLabel.c_str());
+            groups.push_back(std::move(group));
         }
     }
 
-    SDL_Log("Parsed %zu palette groups from %s", groups.size(), path.c_str());
+    SDL_Log("Parsed %zu palette groups from %s", groups.size(), sourceLabel.c_str());
     return groups;
 }
 
+// exports get built in memory first and only hit the disk if they differ from what's already
+// there, so the decomp doesn't rebuild everything after every export. .c outputs get the
+// same line endings a text-mode ofstream always gave them
+bool writeOutputFile(const std::string& path, std::string_view data, bool textMode, const char* what)
+{
+#ifdef _WIN32
+    std::string crlf;
+    if (textMode) {
+        crlf.reserve(data.size() + data.size() / 16);
+        for (char c : data) {
+            if (c == '\n') crlf.push_back('\r');
+            crlf.push_back(c);
+        }
+        data = crlf;
+    }
+#else
+    (void)textMode;
+#endif
+
+    std::string error;
+    switch (writeFileIfChanged(path, reinterpret_cast<const uint8_t*>(data.data()), data.size(), error)) {
+    case FileWriteResult::Written:
+        return true;
+    case FileWriteResult::Unchanged:
+        SDL_Log("Skipped writing %s %s, it's already up to date", what, path.c_str());
+        return true;
+    default:
+        SDL_Log("Failed to write %s %s: %s", what, path.c_str(), error.c_str());
+        return false;
+    }
+}
+
+// decoded at its own size as RGBA32, nullptr (already logged) when it can't be
+SDL_Surface* loadImageRGBA(const std::string& path)
+{
+    SDL_Surface* loaded = IMG_Load(path.c_str());
+    if (!loaded) {
+        SDL_Log("Failed to load image %s! SDL_image Error: %s", path.c_str(), SDL_GetError());
+        return nullptr;
+    }
+    if (loaded->format == SDL_PIXELFORMAT_RGBA32) {
+        return loaded;
+    }
+
+    SDL_Surface* rgba = SDL_ConvertSurface(loaded, SDL_PIXELFORMAT_RGBA32);
+    SDL_DestroySurface(loaded);
+    if (!rgba) {
+        SDL_Log("Failed to convert %s to RGBA! SDL Error: %s", path.c_str(), SDL_GetError());
+    }
+    return rgba;
+}
+
+// Floyd-Steinberg straight into tiles, `tilesPerRow` tiles per tile row. error only ever goes
+// right or one row down, so the rows run as a wavefront: they're claimed in order and each
+// one stays two pixels behind the row above. the only float memory is a ring of error rows
+void ditherImageToTiles(const uint8_t* pixels, int width, int height, int pitch,
+    const PaletteQuantizer& quantizer, std::vector<TileData>& tileData, int tilesPerRow)
+{
+    WorkerPool& pool = WorkerPool::shared();
+    const size_t threadCount = std::min<size_t>(pool.getThreadCount() + 1, height);
+
+    // rows finish in order and at most threadCount are in flight, so by the time a ring slot
+    // comes around again every row that read it is done. each row has a spare pixel on both
+    // ends to soak up what would fall off the edges
+    const int ringSize = static_cast<int>(threadCount) + 2;
+    const size_t rowStride = static_cast<size_t>(width + 2) * 3;
+    std::vector<float> errorRows(rowStride * ringSize, 0.0f);
+    std::unique_ptr<std::atomic<int>[]> rowProgress(new std::atomic<int>[height]);
+    for (int y = 0; y < height; ++y) {
+        rowProgress[y].store(0, std::memory_order_relaxed);
+    }
+    std::atomic<int> nextRow{ 0 };
+
+    auto worker = [&]() {
+        PaletteQuantizer threadQuantizer = quantizer; // the lookup table fills in as it goes
+        for (int y = nextRow++; y < height; y = nextRow++) {
+            float* errorRow = errorRows.data() + (y % ringSize) * rowStride;
+            float* nextErrorRow = errorRows.data() + ((y + 1) % ringSize) * rowStride;
+            std::fill(nextErrorRow, nextErrorRow + rowStride, 0.0f);
+
+            const uint8_t* row = pixels + static_cast<size_t>(y) * pitch;
+            TileData* tileRow = tileData.data() + static_cast<size_t>(y / 8) * tilesPerRow;
+            int aboveDone = y > 0 ? 0 : width;
+            float right[3] = { 0.0f, 0.0f, 0.0f };
+
+            for (int x = 0; x < width; ++x) {
+                // the error under x is final once the row above is past x + 1
+                const int needed = std::min(x + 2, width);
+                while (aboveDone < needed) {
+                    aboveDone = rowProgress[y - 1].load(std::memory_order_acquire);
+                    if (aboveDone < needed) std::this_thread::yield();
+                }
+
+                const uint8_t* pixel = row + x * 4;
+                const float* error = errorRow + (x + 1) * 3;
+
+                float r = pixel[0] + (error[0] + right[0]);
+                float g = pixel[1] + (error[1] + right[1]);
+                float b = pixel[2] + (error[2] + right[2]);
+
+                r = std::max(0.0f, std::min(255.0f, r));
+                g = std::max(0.0f, std::min(255.0f, g));
+                b = std::max(0.0f, std::min(255.0f, b));
+
+                const PaletteQuantizer::Match& closest = threadQuantizer.find(static_cast<uint8_t>(r),
+                    static_cast<uint8_t>(g),
+                    static_cast<uint8_t>(b));
+                tileRow[x / 8].data[y % 8][x % 8] = closest.index;
+
+                float errR = r - closest.color.r;
+                float errG = g - closest.color.g;
+                float errB = b - closest.color.b;
+
+                // thank you chatgpt, apparently that's called a Floyd-Steinberg dithering, the more you know
+                float* below = nextErrorRow + (x + 1) * 3;
+                right[0] = errR * 7.0f / 16.0f;
+                right[1] = errG * 7.0f / 16.0f;
+                right[2] = errB * 7.0f / 16.0f;
+                below[-3] += errR * 3.0f / 16.0f;
+                below[-2] += errG * 3.0f / 16.0f;
+                below[-1] += errB * 3.0f / 16.0f;
+                below[0] += errR * 5.0f / 16.0f;
+                below[1] += errG * 5.0f / 16.0f;
+                below[2] += errB * 5.0f / 16.0f;
+                below[3] += errR * 1.0f / 16.0f;
+                below[4] += errG * 1.0f / 16.0f;
+                below[5] += errB * 1.0f / 16.0f;
+
+                if ((x & 15) == 15) {
+                    rowProgress[y].store(x + 1, std::memory_order_release);
+                }
+            }
+            rowProgress[y].store(width, std::memory_order_release);
+        }
+    };
+
+    pool.parallelFor(threadCount, [&](size_t) { worker(); });
+}
+}
+
+std::vector<ParsedCPaletteGroup> ResourceManager::parsePalettesFromCFile(const std::string& path)
+{
+    std::string text;
+    if (!readTextFile(path, text)) {
+        SDL_Log("Failed to open palette C file: %s", path.c_str());
+        return {};
+    }
+
+    return parsePaletteGroupsText(text, path);
+}
+
+std::vector<ParsedCPaletteGroup> ResourceManager::parsePalettesFromCText(const std::string& text, const std::string& sourceLabel)
+{
+    return parsePaletteGroupsText(text, sourceLabel);
+}
+
 SDL_Texture* ResourceManager::loadTexture(SDL_Renderer* renderer, const std::string& path)
 {
     // ask shaffy why he used a game engine to make a GUI application
@@ -284,38 +576,80 @@ SDL_Texture* ResourceManager::loadTexture(SDL_Renderer* renderer, const std::str
 
 std::vector<AnimationCel> ResourceManager::loadAnimationCels(const std::string& path)
 {
-    std::ifstream file(path);
-
-    if (!file.is_open()) {
+    std::string text;
+    if (!readTextFile(path, text)) {
         SDL_Log("Failed to open animation cels file: %s", path.c_str());
         return {};
     }
 
-    return parseAnimationCelsStream(file, path);
+    return parseAnimationCelsText(text, path);
 }
 
 std::vector<AnimationCel> ResourceManager::loadAnimationCelsFromText(const std::string& text, const std::string& sourceLabel)
 {
-    std::istringstream input(text);
-    return parseAnimationCelsStream(input, sourceLabel);
+    return parseAnimationCelsText(text, sourceLabel);
 }
 
-std::vector<Animation> ResourceManager::loadAnimations(const std::string& path)
+// a block runs from the line that opens a cel up to the next one (or the end of the file).
+// the parser never carries anything across that boundary, so parsing blocks one at a time
+// gives the same cels as parsing the whole thing
+std::vector<CelSourceBlock> ResourceManager::indexAnimationCelBlocks(std::string_view text)
 {
-    std::ifstream file(path);
+    std::vector<CelSourceBlock> blocks;
+    LineScanner lines(text);
+    std::string_view line;
+
+    while (lines.next(line)) {
+        bool opensCel = false;
+        std::string_view name;
+        if (line.empty() || !matchCelDeclaration(line, opensCel, name) || !opensCel) {
+            continue;
+        }
 
-    if (!file.is_open()) {
+        const size_t offset = static_cast<size_t>(line.data() - text.data());
+        if (!blocks.empty()) {
+            blocks.back().length = offset - blocks.back().offset;
+        }
+
+        CelSourceBlock block;
+        block.name.assign(name);
+        block.offset = offset;
+        block.line = lines.getLineNumber();
+        blocks.push_back(std::move(block));
+    }
+
+    if (!blocks.empty()) {
+        blocks.back().length = text.size() - blocks.back().offset;
+    }
+    for (auto& block : blocks) {
+        block.hash = hashBytes(reinterpret_cast<const uint8_t*>(text.data() + block.offset), block.length);
+    }
+    return blocks;
+}
+
+std::vector<AnimationCel> ResourceManager::parseAnimationCelBlock(std::string_view text, const CelSourceBlock& block, const std::string& sourceLabel)
+{
+    std::vector<AnimationCel> cels;
+    if (block.offset + block.length <= text.size()) {
+        parseAnimationCelLines(text.substr(block.offset, block.length), sourceLabel, block.line, cels);
+    }
+    return cels;
+}
+
+std::vector<Animation> ResourceManager::loadAnimations(const std::string& path)
+{
+    std::string text;
+    if (!readTextFile(path, text)) {
         SDL_Log("Failed to open animations file: %s", path.c_str());
         return {};
     }
 
-    return parseAnimationsStream(file, path);
+    return parseAnimationsText(text, path);
 }
 
 std::vector<Animation> ResourceManager::loadAnimationsFromText(const std::string& text, const std::string& sourceLabel)
 {
-    std::istringstream input(text);
-    return parseAnimationsStream(input, sourceLabel);
+    return parseAnimationsText(text, sourceLabel);
 }
 
 std::vector<Palette> ResourceManager::loadPalettes(const std::string& path)
@@ -354,314 +688,224 @@ std::vector<Palette> ResourceManager::loadPalettes(const std::string& path)
 
 Tiles ResourceManager::loadTiles(const std::string& path)
 {
-    Tiles tiles;
-    std::ifstream file(path, std::ios::binary);
-
-    if (!file.is_open()) {
-        SDL_Log("Failed to open tiles file: %s", path.c_str());
+    MappedFile file;
+    std::string error;
+    if (!file.open(path, error)) {
+        SDL_Log("Failed to open tiles file: %s (%s)", path.c_str(), error.c_str());
+        return Tiles();
+    }
+
+    std::string ext = path.substr(path.find_last_of('.') + 1);
+    std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+
+    const ByteView view = file.view();
+    if (ext == "lz") {
+        size_t consumed = 0;
+        Tiles tiles = loadCompressedTiles(view.getData(), view.getSize(), error, &consumed);
+        if (tiles.getSize() == 0) {
+            SDL_Log("Failed to decompress tiles file %s: %s", path.c_str(), error.c_str());
+        }
+        else {
+            SDL_Log("Loaded %d tiles from %s (%zu compressed bytes)", tiles.getSize(), path.c_str(), consumed);
+        }
         return tiles;
-	}
+    }
 
-    while(true) {
-        std::array<uint8_t, 32> data;
-        file.read(reinterpret_cast<char*>(data.data()), data.size());
-        std::streamsize bytesRead = file.gcount();
-        if (bytesRead == 0) break;
-        // complete tile with zero to avoid a super crystaltile2 reference 
-        if (bytesRead < 32) {
-            for (size_t i = static_cast<size_t>(bytesRead); i < 32; i++) {
-                data[i] = 0;
-			}
+    // .bin is whatever the build spat out, raw or compressed. only take it as compressed when the
+    // stream decodes and ends exactly at the (word aligned) end of the file, raw 4bpp data that
+    // happens to start with 0x10 almost never lines up like that
+    uint8_t type = 0;
+    size_t decompressedSize = 0;
+    if (Compression::readHeader(view.getData(), view.getSize(), type, decompressedSize)) {
+        size_t consumed = 0;
+        Tiles tiles = loadCompressedTiles(view.getData(), view.getSize(), error, &consumed);
+        if (tiles.getSize() > 0 && ((consumed + 3) & ~static_cast<size_t>(3)) == view.getSize()) {
+            SDL_Log("Loaded %d tiles from %s (%s compressed)", tiles.getSize(), path.c_str(), Compression::getTypeName(type));
+            return tiles;
         }
-		tiles.addTile(data);
     }
 
-    file.close();
+    Tiles tiles = loadTilesFromBytes(view.getData(), view.getSize());
     SDL_Log("Loaded %d tiles from %s", tiles.getSize(), path.c_str());
-	return tiles;
+    return tiles;
 }
 
-Tiles ResourceManager::loadTilesFromImageAndPalette(const std::string& path, std::vector<Palette>& palettes, int currentPalette)
+Tiles ResourceManager::loadTilesFromBytes(const uint8_t* data, size_t size)
 {
     Tiles tiles;
+    for (size_t pos = 0; pos < size; pos += 32) {
+        // complete tile with zero to avoid a super crystaltile2 reference
+        std::array<uint8_t, 32> tile = {};
+        memcpy(tile.data(), data + pos, std::min<size_t>(32, size - pos));
+        tiles.addTile(tile);
+    }
+    return tiles;
+}
 
-    SDL_Surface* originalSurface = IMG_Load(path.c_str());
-    if (!originalSurface) {
-        SDL_Log("Failed to load image %s! SDL_image Error: %s", path.c_str(), SDL_GetError());
-        return tiles;
+Tiles ResourceManager::loadCompressedTiles(const uint8_t* data, size_t size, std::string& error, size_t* consumed)
+{
+    uint8_t type = 0;
+    size_t decompressedSize = 0;
+    if (!Compression::readHeader(data, size, type, decompressedSize)) {
+        error = "not a compressed stream";
+        return Tiles();
+    }
+    // a full 1024 tile sheet is only 32 KB, a header asking for more than this is garbage
+    if (decompressedSize == 0 || decompressedSize > kMaxCompressedTilesSize) {
+        error = "decompressed size " + std::to_string(decompressedSize) + " is out of range";
+        return Tiles();
     }
 
-    SDL_Surface* surface = originalSurface;
-    bool needCleanup = false;
+    std::vector<uint8_t> raw;
+    if (!Compression::decompress(data, size, raw, consumed)) {
+        error = std::string("the ") + Compression::getTypeName(type) + " stream is corrupt or cut off";
+        return Tiles();
+    }
 
-    if (originalSurface->w != 256 || originalSurface->h != 256) {
-        SDL_Log("Resizing image from %dx%d to 256x256", originalSurface->w, originalSurface->h);
-        surface = SDL_CreateSurface(256, 256, SDL_PIXELFORMAT_RGBA32);
-        if (!surface) {
-            SDL_Log("Failed to create scaled surface! SDL Error: %s", SDL_GetError());
-            SDL_DestroySurface(originalSurface);
-            return tiles;
-        }
+    return loadTilesFromBytes(raw.data(), raw.size());
+}
 
-        SDL_Rect srcRect = { 0, 0, originalSurface->w, originalSurface->h };
-        SDL_Rect dstRect = { 0, 0, 256, 256 };
-        SDL_BlitSurfaceScaled(originalSurface, &srcRect, surface, &dstRect, SDL_SCALEMODE_NEAREST);
-        needCleanup = true;
-    }
+Tiles ResourceManager::loadTilesFromImageAndPalette(const std::string& path, std::vector<Palette>& palettes, int currentPalette, int* outTilesPerRow)
+{
+    Tiles tiles;
 
-    SDL_Surface* rgbaSurface = SDL_ConvertSurface(surface, SDL_PIXELFORMAT_RGBA32);
+    SDL_Surface* rgbaSurface = loadImageRGBA(path);
     if (!rgbaSurface) {
-        SDL_Log("Failed to convert surface to RGBA! SDL Error: %s", SDL_GetError());
-        if (needCleanup) SDL_DestroySurface(surface);
-        SDL_DestroySurface(originalSurface);
         return tiles;
     }
 
-    std::vector<SDL_Color> allColors;
-    std::unordered_map<uint32_t, int> colorToIndex;
-
+    // current palette first so it wins ties, then the rest in order
+    std::vector<int> paletteOrder;
     if (currentPalette >= 0 && currentPalette < static_cast<int>(palettes.size())) {
-        const auto& palette = palettes[currentPalette];
-        for (int i = 0; i < 16; ++i) {
-            SDL_Color color = palette.colors[i];
-            uint32_t colorKey = (color.r << 16) | (color.g << 8) | color.b;
-
-            if (colorToIndex.find(colorKey) == colorToIndex.end()) {
-                colorToIndex[colorKey] = static_cast<int>(allColors.size());
-                allColors.push_back(color);
-            }
-        }
+        paletteOrder.push_back(currentPalette);
     }
-
-    for (size_t paletteIdx = 0; paletteIdx < palettes.size(); ++paletteIdx) {
-        if (static_cast<int>(paletteIdx) == currentPalette) continue;
-
-        const auto& palette = palettes[paletteIdx];
-        for (int i = 0; i < 16; ++i) {
-            SDL_Color color = palette.colors[i];
-            uint32_t colorKey = (color.r << 16) | (color.g << 8) | color.b;
-
-            if (colorToIndex.find(colorKey) == colorToIndex.end()) {
-                colorToIndex[colorKey] = static_cast<int>(allColors.size());
-                allColors.push_back(color);
-            }
-        }
+    for (int paletteIdx = 0; paletteIdx < static_cast<int>(palettes.size()); ++paletteIdx) {
+        if (paletteIdx != currentPalette) paletteOrder.push_back(paletteIdx);
     }
 
-    // lam*bad*s
-    auto findClosestColor = [&](uint8_t r, uint8_t g, uint8_t b) -> int {
-        int bestIndex = 0;
-        int bestDistance = INT_MAX;
-
-        for (size_t i = 0; i < allColors.size(); ++i) {
-            const SDL_Color& paletteColor = allColors[i];
-            int dr = r - paletteColor.r;
-            int dg = g - paletteColor.g;
-            int db = b - paletteColor.b;
-            int distance = dr * dr + dg * dg + db * db;
+    PaletteQuantizer quantizer(palettes, paletteOrder);
+    if (quantizer.empty()) {
+        SDL_Log("No palettes to quantize %s against", path.c_str());
+        SDL_DestroySurface(rgbaSurface);
+        return tiles;
+    }
 
-            if (distance < bestDistance) {
-                bestDistance = distance;
-                bestIndex = static_cast<int>(i);
-            }
-        }
-        return bestIndex;
-        };
+    // any size goes, a ragged right or bottom edge is padded out with color 0
+    const int width = rgbaSurface->w;
+    const int height = rgbaSurface->h;
+    const int tilesPerRow = (width + 7) / 8;
+    const int tileRows = (height + 7) / 8;
+    std::vector<TileData> tileData(static_cast<size_t>(tilesPerRow) * tileRows);
 
     // dithering in MY rhythm tengoku :yum:
-    std::vector<std::vector<SDL_Color>> quantizedImage(256, std::vector<SDL_Color>(256));
-    std::vector<std::vector<float>> errorR(256, std::vector<float>(256, 0.0f));
-    std::vector<std::vector<float>> errorG(256, std::vector<float>(256, 0.0f));
-    std::vector<std::vector<float>> errorB(256, std::vector<float>(256, 0.0f));
-
+    Uint64 startNS = SDL_GetTicksNS();
     SDL_LockSurface(rgbaSurface);
-    uint8_t* pixels = static_cast<uint8_t*>(rgbaSurface->pixels);
-    int pitch = rgbaSurface->pitch;
-
-    for (int y = 0; y < 256; ++y) {
-        for (int x = 0; x < 256; ++x) {
-            uint8_t* pixel = pixels + y * pitch + x * 4;
-
-            float r = pixel[0] + errorR[y][x];
-            float g = pixel[1] + errorG[y][x];
-            float b = pixel[2] + errorB[y][x];
-
-            r = std::max(0.0f, std::min(255.0f, r));
-            g = std::max(0.0f, std::min(255.0f, g));
-            b = std::max(0.0f, std::min(255.0f, b));
-
-            int closestIndex = findClosestColor(static_cast<uint8_t>(r),
-                static_cast<uint8_t>(g),
-                static_cast<uint8_t>(b));
-            SDL_Color closestColor = allColors[closestIndex];
-            quantizedImage[y][x] = closestColor;
-
-            float errR = r - closestColor.r;
-            float errG = g - closestColor.g;
-            float errB = b - closestColor.b;
-
-            // thank you chatgpt, apparently that's called a Floyd-Steinberg dithering, the more you know
-            if (x + 1 < 256) {
-                errorR[y][x + 1] += errR * 7.0f / 16.0f;
-                errorG[y][x + 1] += errG * 7.0f / 16.0f;
-                errorB[y][x + 1] += errB * 7.0f / 16.0f;
-            }
-            if (y + 1 < 256) {
-                if (x > 0) {
-                    errorR[y + 1][x - 1] += errR * 3.0f / 16.0f;
-                    errorG[y + 1][x - 1] += errG * 3.0f / 16.0f;
-                    errorB[y + 1][x - 1] += errB * 3.0f / 16.0f;
-                }
-                errorR[y + 1][x] += errR * 5.0f / 16.0f;
-                errorG[y + 1][x] += errG * 5.0f / 16.0f;
-                errorB[y + 1][x] += errB * 5.0f / 16.0f;
-                if (x + 1 < 256) {
-                    errorR[y + 1][x + 1] += errR * 1.0f / 16.0f;
-                    errorG[y + 1][x + 1] += errG * 1.0f / 16.0f;
-                    errorB[y + 1][x + 1] += errB * 1.0f / 16.0f;
-                }
-            }
-        }
-    }
-
+    ditherImageToTiles(static_cast<const uint8_t*>(rgbaSurface->pixels), width, height, rgbaSurface->pitch,
+        quantizer, tileData, tilesPerRow);
     SDL_UnlockSurface(rgbaSurface);
+    SDL_DestroySurface(rgbaSurface);
 
-    for (int tileY = 0; tileY < 32; ++tileY) {
-        for (int tileX = 0; tileX < 32;++tileX) {
-            TileData tileData;
-
-            for (int py = 0; py < 8; ++py) {
-                for (int px = 0; px < 8; ++px) {
-                    int imageX = tileX * 8 + px;
-                    int imageY = tileY * 8 + py;
-
-                    SDL_Color pixelColor = quantizedImage[imageY][imageX];
-
-                    uint8_t paletteIndex = 0;
-
-                    bool found = false;
-                    if (currentPalette >= 0 && currentPalette < static_cast<int>(palettes.size())) {
-                        const auto& palette = palettes[currentPalette];
-                        for (int colorIdx = 0; colorIdx < 16; ++colorIdx) {
-                            const SDL_Color& paletteColor = palette.colors[colorIdx];
-                            if (paletteColor.r == pixelColor.r &&
-                                paletteColor.g == pixelColor.g &&
-                                paletteColor.b == pixelColor.b) {
-                                paletteIndex = static_cast<uint8_t>(colorIdx);
-                                found = true;
-                                break;
-                            }
-                        }
-                    }
-
-                    if (!found) {
-                        for (size_t paletteIdx = 0; paletteIdx < palettes.size() && !found; ++paletteIdx) {
-                            for (int colorIdx = 0; colorIdx < 16; ++colorIdx) {
-                                const SDL_Color& paletteColor = palettes[paletteIdx].colors[colorIdx];
-                                if (paletteColor.r == pixelColor.r &&
-                                    paletteColor.g == pixelColor.g &&
-                                    paletteColor.b == pixelColor.b) {
-                                    paletteIndex = static_cast<uint8_t>(colorIdx);
-                                    found = true;
-                                    break;
-                                }
-                            }
-                        }
-                    }
-
-                    tileData.data[py][px] = paletteIndex;
-                }
-            }
-
-            std::array<uint8_t, 32> tileBytes;
-            for (int i = 0; i < 32; ++i) {
-                int py = i / 4;
-                int px = (i % 4) * 2;
-                uint8_t pixel1 = tileData.data[py][px] & 0x0F;
-                uint8_t pixel2 = tileData.data[py][px + 1] & 0x0F;
-                tileBytes[i] = pixel1 | (pixel2 << 4);
-            }
-
-            tiles.addTile(tileBytes);
-        }
+    tiles.resize(static_cast<int>(tileData.size()));
+    for (size_t i = 0; i < tileData.size(); ++i) {
+        tiles.setTile(static_cast<int>(i), tileData[i]);
     }
+    if (outTilesPerRow) *outTilesPerRow = tilesPerRow;
 
-    SDL_DestroySurface(rgbaSurface);
-    if (needCleanup) SDL_DestroySurface(surface);
-    SDL_DestroySurface(originalSurface);
-
-    SDL_Log("Successfully converted image to %d tiles with quantized colors using palette %d", tiles.getSize(), currentPalette);
+    SDL_Log("Successfully converted %dx%d image to %d tiles with quantized colors using palette %d (%.2f ms)",
+        width, height, tiles.getSize(), currentPalette, (SDL_GetTicksNS() - startNS) / 1e6);
     return tiles;
 }
 
 void ResourceManager::saveAnimationCels(const std::string& path, const std::vector<AnimationCel>& cels)
 {
-    std::ofstream file;
-    file.open(path, std::ios::out | std::ios::trunc);
-
-    if (!file.is_open()) {
-        SDL_Log("Failed to open animation cels file for writing: %s", path.c_str());
-        return;
+    TextWriter out;
+    size_t estimate = 96;
+    for (const auto& cel : cels) {
+        estimate += 48 + cel.name.size() + cel.oams.size() * 40;
     }
+    out.reserve(estimate);
 
     // Write file header
-    file << "// Generated by Sofanthiel [https://github.com/shaffyswitcher/sofanthiel]\n\n";
+    out.put("// Generated by Sofanthiel [https://github.com/shaffyswitcher/sofanthiel]\n\n");
 
     for (const auto& cel : cels) {
-        file << "AnimationCel " << cel.name << "[] = {\n";
+        out.put("AnimationCel ");
+        out.put(cel.name);
+        out.put("[] = {\n");
         // Write OAM count
-        file << "    /* Len */ " << cel.oams.size() << ",\n";
+        out.put("    /* Len */ ");
+        out.putDecimal(cel.oams.size());
+        out.put(",\n");
         // Write each OAM entry
         for (size_t i = 0; i < cel.oams.size(); ++i) {
-            const auto& oam = cel.oams[i];
-            file << "    /* " << std::setw(3) << std::setfill('0') << i << " */ ";
-            const uint16_t* raw = reinterpret_cast<const uint16_t*>(&oam);
-            file << "0x" << std::hex << std::setw(4) << std::setfill('0') << raw[0] << ", ";
-            file << "0x" << std::hex << std::setw(4) << std::setfill('0') << raw[1] << ", ";
-            file << "0x" << std::hex << std::setw(4) << std::setfill('0') << raw[2];
-            file << std::dec; // Reset to decimal
+            const uint16_t* raw = reinterpret_cast<const uint16_t*>(&cel.oams[i]);
+            out.put("    /* ");
+            out.putDecimal(i, 3);
+            out.put(" */ 0x");
+            out.putHex(raw[0], 4);
+            out.put(", 0x");
+            out.putHex(raw[1], 4);
+            out.put(", 0x");
+            out.putHex(raw[2], 4);
             if (i + 1 < cel.oams.size())
-                file << ",";
-            file << "\n";
+                out.put(',');
+            out.put('\n');
         }
-        file << "};\n\n";
+        out.put("};\n\n");
+    }
+
+    if (!writeOutputFile(path, out.text, true, "animation cels file")) {
+        return;
     }
 
-    file.close();
     SDL_Log("Saved %zu animation cels to %s", cels.size(), path.c_str());
 }
 
 void ResourceManager::saveAnimations(const std::string& path, const std::vector<Animation>& animations, const std::string& cel_filename)
 {
-    std::ofstream file;
-    file.open(path, std::ios::out | std::ios::trunc);
-
-    if (!file.is_open()) {
-        SDL_Log("Failed to open animation cels file for writing: %s", path.c_str());
-        return;
+    TextWriter out;
+    size_t estimate = 160 + cel_filename.size();
+    for (const auto& anim : animations) {
+        estimate += 64 + anim.name.size();
+        for (const auto& entry : anim.entries) {
+            estimate += 24 + entry.celName.size();
+        }
     }
+    out.reserve(estimate);
 
     // Write file header
-    file << "// Generated by Sofanthiel [https://github.com/shaffyswitcher/sofanthiel]\n\n";
-    file << "#include \"global.h\"\n";
-    file << "#include \"graphics.h\"\n\n";
-    file << "#include \"";
-    file << cel_filename;
-    file << "\"\n\n";
+    out.put("// Generated by Sofanthiel [https://github.com/shaffyswitcher/sofanthiel]\n\n");
+    out.put("#include \"global.h\"\n");
+    out.put("#include \"graphics.h\"\n\n");
+    out.put("#include \"");
+    out.put(cel_filename);
+    out.put("\"\n\n");
 
     for (const auto& anim : animations) {
-        file << "struct Animation " << anim.name << "[] = {\n";
+        out.put("struct Animation ");
+        out.put(anim.name);
+        out.put("[] = {\n");
         for (size_t i = 0; i < anim.entries.size(); ++i) {
             const auto& entry = anim.entries[i];
-            file << "    /* " << std::setw(3) << std::setfill('0') << i << " */ { "
-                << entry.celName << ", " << static_cast<int>(entry.duration) << " },\n";
+            out.put("    /* ");
+            out.putDecimal(i, 3);
+            out.put(" */ { ");
+            out.put(entry.celName);
+            out.put(", ");
+            out.putDecimal(static_cast<int>(entry.duration));
+            out.put(" },\n");
         }
         // Write END_ANIMATION marker
-        file << "    /* " << std::setw(3) << std::setfill('0') << anim.entries.size() << " */ END_ANIMATION,\n";
-        file << "};\n\n";
+        out.put("    /* ");
+        out.putDecimal(anim.entries.size(), 3);
+        out.put(" */ END_ANIMATION,\n");
+        out.put("};\n\n");
+    }
+
+    if (!writeOutputFile(path, out.text, true, "animations file")) {
+        return;
     }
 
-    file.close();
     SDL_Log("Saved %zu animations to %s", animations.size(), path.c_str());
 }
 
@@ -670,59 +914,48 @@ void ResourceManager::saveAnimations(const std::string& path, const std::vector<
 void ResourceManager::savePalettes(const std::string& path, const std::vector<Palette>& palettes)
 {
     if (path.substr(path.find_last_of(".") + 1) == "pal") {
-        std::ofstream file(path, std::ios::binary);
-        if (!file.is_open()) {
-            SDL_Log("Failed to open palettes file for writing: %s", path.c_str());
-            return;
-        }
-
         // Calculate color count
         int colorCount = static_cast<int>(palettes.size() * 16);
         int dataChunkSize = 4 + 2 + 2 + colorCount * 4;
         int riffFileSize = 4 + 4 + dataChunkSize;
 
+        ByteWriter out;
+        out.bytes.reserve(8 + riffFileSize);
+
         // RIFF header
-        file.write("RIFF", 4);
-        uint32_t fileLength = riffFileSize;
-        file.write(reinterpret_cast<const char*>(&fileLength), 4);
-        file.write("PAL ", 4);
+        out.putBytes("RIFF", 4);
+        out.putU32(static_cast<uint32_t>(riffFileSize));
+        out.putBytes("PAL ", 4);
 
         // Data chunk
-        file.write("data", 4);
-        uint32_t chunkSize = dataChunkSize - 8;
-        file.write(reinterpret_cast<const char*>(&chunkSize), 4);
+        out.putBytes("data", 4);
+        out.putU32(static_cast<uint32_t>(dataChunkSize - 8));
 
-        uint16_t version = 0x0300;
-        uint16_t numColors = static_cast<uint16_t>(colorCount);
-        file.write(reinterpret_cast<const char*>(&version), 2);
-        file.write(reinterpret_cast<const char*>(&numColors), 2);
+        out.putU16(0x0300);
+        out.putU16(static_cast<uint16_t>(colorCount));
 
         // Colors
         for (const auto& palette : palettes) {
             for (const auto& color : palette.colors) {
-                file.write(reinterpret_cast<const char*>(&color.r), 1);
-                file.write(reinterpret_cast<const char*>(&color.g), 1);
-                file.write(reinterpret_cast<const char*>(&color.b), 1);
-                uint8_t flag = 0;
-                file.write(reinterpret_cast<const char*>(&flag), 1);
+                out.putU8(color.r);
+                out.putU8(color.g);
+                out.putU8(color.b);
+                out.putU8(0);
             }
         }
 
-        file.close();
+        if (!writeOutputFile(path, std::string_view(reinterpret_cast<const char*>(out.bytes.data()), out.bytes.size()), false, "palettes file")) {
+            return;
+        }
         SDL_Log("Saved %zu palettes to %s", palettes.size(), path.c_str());
     }
     else {
-        std::ofstream file;
-        file.open(path, std::ios::out | std::ios::trunc);
-
-        if (!file.is_open()) {
-            SDL_Log("Failed to open palettes file for writing: %s", path.c_str());
-            return;
-        }
+        TextWriter out;
+        out.reserve(256 + palettes.size() * (32 + 16 * 40));
 
-        file << "// Generated by Sofanthiel [https://github.com/shaffyswitcher/sofanthiel]\n\n";
-        file << "#include \"global.h\"\n";
-        file << "#include \"graphics.h\"\n\n";
+        out.put("// Generated by Sofanthiel [https://github.com/shaffyswitcher/sofanthiel]\n\n");
+        out.put("#include \"global.h\"\n");
+        out.put("#include \"graphics.h\"\n\n");
 
         std::string filename = path.substr(path.find_last_of("/\\") + 1);
         std::string paletteName = filename.substr(0, filename.find_last_of("."));
@@ -730,12 +963,16 @@ void ResourceManager::savePalettes(const std::string& path, const std::vector<Pa
             paletteName = "palette";
         }
 
-        file << "Palette " << paletteName << "_pal[] = {\n";
+        out.put("Palette ");
+        out.put(paletteName);
+        out.put("_pal[] = {\n");
 
         for (size_t paletteIndex = 0; paletteIndex < palettes.size(); ++paletteIndex) {
             const auto& palette = palettes[paletteIndex];
 
-            file << "    /* PALETTE " << std::setw(2) << std::setfill('0') << paletteIndex << " */ {\n";
+            out.put("    /* PALETTE ");
+            out.putDecimal(paletteIndex, 2);
+            out.put(" */ {\n");
 
             for (size_t colorIndex = 0; colorIndex < 16; ++colorIndex) {
                 const auto& color = palette.colors[colorIndex];
@@ -744,56 +981,79 @@ void ResourceManager::savePalettes(const std::string& path, const std::vector<Pa
                     (static_cast<uint32_t>(color.g) << 8) |
                     static_cast<uint32_t>(color.b);
 
-                file << "        /* " << std::setw(2) << std::setfill('0') << colorIndex << " */ TO_RGB555(0x"
-                    << std::hex << std::setw(6) << std::setfill('0') << rgb24 << ")";
+                out.put("        /* ");
+                out.putDecimal(colorIndex, 2);
+                out.put(" */ TO_RGB555(0x");
+                out.putHex(rgb24, 6);
+                out.put(')');
 
                 if (colorIndex < 15) {
-                    file << ",";
+                    out.put(',');
                 }
 
-                file << std::dec << "\n";
+                out.put('\n');
             }
 
-            file << "    }";
+            out.put("    }");
             if (paletteIndex < palettes.size() - 1) {
-                file << ",";
+                out.put(',');
             }
-            file << "\n";
+            out.put('\n');
         }
 
-        file << "};\n";
+        out.put("};\n");
 
-        file.close();
+        if (!writeOutputFile(path, out.text, true, "palettes file")) {
+            return;
+        }
         SDL_Log("Saved %zu palettes to %s", palettes.size(), path.c_str());
     }
 }
 
-void ResourceManager::saveTiles(const std::string& path, Tiles& tiles)
+void ResourceManager::saveTiles(const std::string& path, Tiles& tiles, bool compress, Compression::LZ77Mode mode)
 {
-    std::ofstream file(path, std::ios::binary);
-
-    if (!file.is_open()) {
-        SDL_Log("Failed to open tiles file for writing: %s", path.c_str());
-        return;
-    }
+    std::string bytes(static_cast<size_t>(tiles.getSize()) * 32, '\0');
 
     for (int i = 0; i < tiles.getSize(); ++i) {
         TileData tileData = tiles.getTile(i);
+        char* tileBytes = &bytes[static_cast<size_t>(i) * 32];
 
-        std::array<uint8_t, 32> tileBytes;
         for (int byteIndex = 0; byteIndex < 32; ++byteIndex) {
             int py = byteIndex / 4;
             int px = (byteIndex % 4) * 2;
             uint8_t pixel1 = tileData.data[py][px] & 0x0F;
             uint8_t pixel2 = tileData.data[py][px + 1] & 0x0F;
-            tileBytes[byteIndex] = pixel1 | (pixel2 << 4);
+            tileBytes[byteIndex] = static_cast<char>(pixel1 | (pixel2 << 4));
+        }
+    }
+
+    std::string ext = path.substr(path.find_last_of('.') + 1);
+    std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+    if (!compress && ext != "lz") {
+        if (!writeOutputFile(path, bytes, false, "tiles file")) {
+            return;
         }
+        SDL_Log("Saved %d tiles to %s", tiles.getSize(), path.c_str());
+        return;
+    }
 
-        file.write(reinterpret_cast<const char*>(tileBytes.data()), 32);
+    // the game hands these straight to LZ77UnCompVram, so no distance 1 matches
+    Uint64 startNS = SDL_GetTicksNS();
+    std::vector<uint8_t> packed = Compression::compressLZ77(
+        reinterpret_cast<const uint8_t*>(bytes.data()), bytes.size(), mode, true);
+    Uint64 elapsedNS = SDL_GetTicksNS() - startNS;
+    if (packed.empty()) {
+        SDL_Log("Failed to compress tiles for %s: %zu bytes is over the 16 MB LZ77 limit", path.c_str(), bytes.size());
+        return;
     }
 
-    file.close();
-    SDL_Log("Saved %d tiles to %s", tiles.getSize(), path.c_str());
+    if (!writeOutputFile(path, std::string_view(reinterpret_cast<const char*>(packed.data()), packed.size()), false, "tiles file")) {
+        return;
+    }
+    SDL_Log("Saved %d tiles to %s (LZ77 %s, %zu -> %zu bytes, %.1f%%, %.2f ms)",
+        tiles.getSize(), path.c_str(), mode == Compression::LZ77Mode::Optimal ? "optimal" : "greedy",
+        bytes.size(), packed.size(), bytes.empty() ? 0.0 : 100.0 * static_cast<double>(packed.size()) / static_cast<double>(bytes.size()),
+        static_cast<double>(elapsedNS) / 1e6);
 }
 
 void ResourceManager::saveTilesToImage(const std::string& path, Tiles& tiles, const std::vector<Palette>& palettes)
@@ -855,26 +1115,41 @@ void ResourceManager::saveTilesToImage(const std::string& path, Tiles& tiles, co
     std::string extension = path.substr(path.find_last_of(".") + 1);
     std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
 
-    bool success = false;
-    if (extension == "bmp") {
-        success = SDL_SaveBMP(surface, path.c_str());
-    }
-    else if (extension == "png") {
-        success = IMG_SavePNG(surface, path.c_str());
-    }
-    else {
-        std::string bmpPath = path.substr(0, path.find_last_of(".")) + ".bmp";
-        success = SDL_SaveBMP(surface, bmpPath.c_str());
-        SDL_Log("Unknown image format, saved as BMP: %s", bmpPath.c_str());
+    // encode into memory so an unchanged image doesn't get rewritten either
+    std::string outPath = path;
+    SDL_IOStream* io = SDL_IOFromDynamicMem();
+    bool success = io != nullptr;
+    if (success) {
+        if (extension == "bmp") {
+            success = SDL_SaveBMP_IO(surface, io, false);
+        }
+        else if (extension == "png") {
+            success = IMG_SavePNG_IO(surface, io, false);
+        }
+        else {
+            outPath = path.substr(0, path.find_last_of(".")) + ".bmp";
+            success = SDL_SaveBMP_IO(surface, io, false);
+            SDL_Log("Unknown image format, saved as BMP: %s", outPath.c_str());
+        }
     }
 
     if (!success) {
         SDL_Log("Failed to save tiles image to %s! SDL Error: %s", path.c_str(), SDL_GetError());
     }
     else {
-        SDL_Log("Successfully saved %d tiles to image %s", tiles.getSize(), path.c_str());
+        const char* encoded = static_cast<const char*>(
+            SDL_GetPointerProperty(SDL_GetIOProperties(io), SDL_PROP_IOSTREAM_DYNAMIC_MEMORY_POINTER, nullptr));
+        Sint64 encodedSize = SDL_TellIO(io);
+
+        if (encoded != nullptr && encodedSize > 0 &&
+            writeOutputFile(outPath, std::string_view(encoded, static_cast<size_t>(encodedSize)), false, "tiles image")) {
+            SDL_Log("Successfully saved %d tiles to image %s", tiles.getSize(), outPath.c_str());
+        }
     }
 
+    if (io != nullptr) {
+        SDL_CloseIO(io);
+    }
     SDL_DestroySurface(surface);
 }
 
@@ -982,6 +1257,13 @@ bool ResourceManager::importImageAtPosition(const std::string& path, Tiles& tile
     int tileCountY = (imgH + 7) / 8;
 
     int safePalette = SDL_clamp(paletteIndex, 0, static_cast<int>(palettes.size()) - 1);
+    PaletteQuantizer quantizer(palettes, { safePalette });
+    if (quantizer.empty()) {
+        SDL_Log("No palette to import %s with", path.c_str());
+        SDL_DestroySurface(rgbaSurface);
+        SDL_DestroySurface(originalSurface);
+        return false;
+    }
 
     if (tilesPerRow <= 0) {
         tilesPerRow = TILES_PER_LINE;
@@ -994,8 +1276,6 @@ bool ResourceManager::importImageAtPosition(const std::string& path, Tiles& tile
     uint8_t* pixels = static_cast<uint8_t*>(rgbaSurface->pixels);
     int pitch = rgbaSurface->pitch;
 
-    const Palette& pal = palettes[safePalette];
-
     for (int ty = 0; ty < tileCountY; ++ty) {
         for (int tx = 0; tx < tileCountX; ++tx) {
             int tileIndex = (tileStartY + ty) * tilesPerRow + (tileStartX + tx);
@@ -1024,19 +1304,7 @@ bool ResourceManager::importImageAtPosition(const std::string& path, Tiles& tile
                         continue;
                     }
 
-                    int bestIdx = 0;
-                    int bestDist = INT_MAX;
-                    for (int ci = 0; ci < 16; ++ci) {
-                        int dr = r - pal.colors[ci].r;
-                        int dg = g - pal.colors[ci].g;
-                        int db = b - pal.colors[ci].b;
-                        int dist = dr * dr + dg * dg + db * db;
-                        if (dist < bestDist) {
-                            bestDist = dist;
-                            bestIdx = ci;
-                        }
-                    }
-                    tileData.data[py][px] = static_cast<uint8_t>(bestIdx);
+                    tileData.data[py][px] = quantizer.find(r, g, b).index;
                 }
             }
 
@@ -1053,81 +1321,30 @@ bool ResourceManager::importImageAtPosition(const std::string& path, Tiles& tile
 }
 
 bool ResourceManager::convertImageToSpritesheetAndPalette(const std::string& path,
-    Tiles& outTiles, std::vector<Palette>& outPalettes)
+    Tiles& outTiles, std::vector<Palette>& outPalettes, std::vector<uint8_t>& outTilePalettes, int* outTilesPerRow)
 {
-    SDL_Surface* originalSurface = IMG_Load(path.c_str());
-    if (!originalSurface) {
-        SDL_Log("Failed to load image %s! SDL Error: %s", path.c_str(), SDL_GetError());
-        return false;
-    }
-
-    SDL_Surface* surface = originalSurface;
-    bool needCleanup = false;
-    if (originalSurface->w != 256 || originalSurface->h != 256) {
-        SDL_Log("Resizing image from %dx%d to 256x256", originalSurface->w, originalSurface->h);
-        surface = SDL_CreateSurface(256, 256, SDL_PIXELFORMAT_RGBA32);
-        if (!surface) {
-            SDL_DestroySurface(originalSurface);
-            return false;
-        }
-        SDL_Rect srcRect = { 0, 0, originalSurface->w, originalSurface->h };
-        SDL_Rect dstRect = { 0, 0, 256, 256 };
-        SDL_BlitSurfaceScaled(originalSurface, &srcRect, surface, &dstRect, SDL_SCALEMODE_NEAREST);
-        needCleanup = true;
-    }
-
-    SDL_Surface* rgbaSurface = SDL_ConvertSurface(surface, SDL_PIXELFORMAT_RGBA32);
+    SDL_Surface* rgbaSurface = loadImageRGBA(path);
     if (!rgbaSurface) {
-        if (needCleanup) SDL_DestroySurface(surface);
-        SDL_DestroySurface(originalSurface);
         return false;
     }
 
     SDL_LockSurface(rgbaSurface);
-    uint8_t* pixels = static_cast<uint8_t*>(rgbaSurface->pixels);
-    int pitch = rgbaSurface->pitch;
-
-    struct ColorEntry { uint8_t r, g, b; };
-    std::unordered_map<uint32_t, int> colorCounts;
-
-    for (int y = 0; y < 256; ++y) {
-        for (int x = 0; x < 256; ++x) {
-            uint8_t* px = pixels + y * pitch + x * 4;
-            uint32_t key = (px[0] << 16) | (px[1] << 8) | px[2];
-            colorCounts[key]++;
-        }
-    }
-
-    std::vector<std::pair<uint32_t, int>> colorList(colorCounts.begin(), colorCounts.end());
-    std::sort(colorList.begin(), colorList.end(),
-        [](const auto& a, const auto& b) { return a.second > b.second; });
-
-    Palette extractedPalette;
-    memset(&extractedPalette, 0, sizeof(Palette));
-
-    int numColors = std::min(16, static_cast<int>(colorList.size()));
-
-    for (int i = 0; i < numColors; ++i) {
-        uint32_t key = colorList[i].first;
-        extractedPalette.colors[i].r = (key >> 16) & 0xFF;
-        extractedPalette.colors[i].g = (key >> 8) & 0xFF;
-        extractedPalette.colors[i].b = key & 0xFF;
-        extractedPalette.colors[i].a = 255;
-    }
-
-    outPalettes.clear();
-    outPalettes.push_back(extractedPalette);
-
+    TileQuantizeResult quantized = quantizeTiles(static_cast<const uint8_t*>(rgbaSurface->pixels),
+        rgbaSurface->w, rgbaSurface->h, rgbaSurface->pitch);
     SDL_UnlockSurface(rgbaSurface);
 
-    outTiles = loadTilesFromImageAndPalette(path, outPalettes, 0);
-
+    const int width = rgbaSurface->w;
+    const int height = rgbaSurface->h;
     SDL_DestroySurface(rgbaSurface);
-    if (needCleanup) SDL_DestroySurface(surface);
-    SDL_DestroySurface(originalSurface);
 
-    SDL_Log("Converted image to spritesheet (%d tiles) with extracted %d-color palette",
-        outTiles.getSize(), numColors + 1);
+    outTiles = std::move(quantized.tiles);
+    outPalettes = std::move(quantized.palettes);
+    outTilePalettes = std::move(quantized.tilePalettes);
+    if (outTilesPerRow) *outTilesPerRow = (width + 7) / 8;
+
+    SDL_Log("Converted %dx%d image to spritesheet (%d tiles, %d source colors) with %d extracted palettes in %llu ms",
+        width, height, outTiles.getSize(), quantized.sourceColors, static_cast<int>(outPalettes.size()),
+        static_cast<unsigned long long>(quantized.durationMs));
     return true;
 }
 
@@ -1235,9 +1452,10 @@ void blendPixel(std::vector<uint8_t>& frameBuffer, int pixelIndex, const SDL_Col
 bool ResourceManager::exportAnimationToGif(const std::string& path,
     const std::vector<Animation>& animations, int animIndex,
     const std::vector<AnimationCel>& cels,
-    Tiles& tiles, const std::vector<Palette>& palettes,
+    const Tiles& tiles, const std::vector<Palette>& palettes,
     float frameRate, int width, int height,
-    float offsetX, float offsetY, int scale)
+    float offsetX, float offsetY, int scale,
+    const std::function<bool(float)>& onProgress)
 {
     if (animIndex < 0 || animIndex >= static_cast<int>(animations.size())) {
         SDL_Log("Invalid animation index %d for GIF export", animIndex);
@@ -1358,6 +1576,7 @@ bool ResourceManager::exportAnimationToGif(const std::string& path,
 
     double idealTimeCentiseconds = 0.0;
     double actualTimeCentiseconds = 0.0;
+    int framesWritten = 0;
 
     for (const auto& entry : anim.entries) {
         if (entry.duration == 0) continue;
@@ -1453,6 +1672,14 @@ bool ResourceManager::exportAnimationToGif(const std::string& path,
         actualTimeCentiseconds += entryDelay;
 
         GifWriteLzwImage(writer.f, writer.oldImage, 0, 0, cropW, cropH, entryDelay, &gifPal, 2);
+
+        framesWritten += entry.duration;
+        if (onProgress && !onProgress(totalFrames > 0 ? static_cast<float>(framesWritten) / totalFrames : 1.0f)) {
+            GifEnd(&writer);
+            std::remove(path.c_str());
+            SDL_Log("GIF export of '%s' cancelled", anim.name.c_str());
+            return false;
+        }
     }
 
     GifEnd(&writer);
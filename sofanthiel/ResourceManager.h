@@ -1,6 +1,8 @@
 #pragma once
 
+#include <functional>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <iomanip>
 #include <array>
@@ -10,6 +12,7 @@
 #include <SDL3/SDL.h>
 #include <SDL3_image/SDL_image.h>
 #include "Graphics.h"
+#include "Compression.h"
 #include <unordered_map>
 #include <ranges>
 #include <algorithm>
@@ -29,6 +32,16 @@ struct ParsedCPaletteGroup {
 	std::vector<Palette> palettes;
 };
 
+// one `AnimationCel name[] = {...}` in a cels source, as a byte range of the text it was
+// indexed from. the hash covers the whole range, so any edit inside it changes it
+struct CelSourceBlock {
+	std::string name;
+	size_t offset = 0;
+	size_t length = 0;
+	int line = 0;
+	uint64_t hash = 0;
+};
+
 class ResourceManager
 {
 public:
@@ -36,17 +49,27 @@ public:
 
 	static std::vector<AnimationCel> loadAnimationCels(const std::string& path);
 	static std::vector<AnimationCel> loadAnimationCelsFromText(const std::string& text, const std::string& sourceLabel = "<memory>");
+	static std::vector<CelSourceBlock> indexAnimationCelBlocks(std::string_view text);
+	static std::vector<AnimationCel> parseAnimationCelBlock(std::string_view text, const CelSourceBlock& block, const std::string& sourceLabel = "<memory>");
 	static std::vector<Animation> loadAnimations(const std::string& path);
 	static std::vector<Animation> loadAnimationsFromText(const std::string& text, const std::string& sourceLabel = "<memory>");
 	static std::vector<Palette> loadPalettes(const std::string& path);
 	static std::vector<ParsedCPaletteGroup> parsePalettesFromCFile(const std::string& path);
+	static std::vector<ParsedCPaletteGroup> parsePalettesFromCText(const std::string& text, const std::string& sourceLabel = "<memory>");
 	static Tiles loadTiles(const std::string& path);
-	static Tiles loadTilesFromImageAndPalette(const std::string& path, std::vector<Palette>& palettes, int currentPalette);
+	static Tiles loadTilesFromBytes(const uint8_t* data, size_t size);
+	// BIOS compressed graphics (lz77/rle/huffman) starting at data, empty with `error` set if it doesn't decode
+	static Tiles loadCompressedTiles(const uint8_t* data, size_t size, std::string& error, size_t* consumed = nullptr);
+	// images of any size, tiles come out in sheet order. `outTilesPerRow` gets the image width in tiles
+	static Tiles loadTilesFromImageAndPalette(const std::string& path, std::vector<Palette>& palettes, int currentPalette,
+		int* outTilesPerRow = nullptr);
 
 	static void saveAnimationCels(const std::string& path, const std::vector<AnimationCel>& cels);
 	static void saveAnimations(const std::string& path, const std::vector<Animation>& animations, const std::string& cel_filename);
 	static void savePalettes(const std::string& path, const std::vector<Palette>& palettes);
-	static void saveTiles(const std::string& path, Tiles& tiles);
+	// .lz paths (or compress = true) are written as a VRAM safe LZ77 stream
+	static void saveTiles(const std::string& path, Tiles& tiles, bool compress = false,
+		Compression::LZ77Mode mode = Compression::LZ77Mode::Optimal);
 	static void saveTilesToImage(const std::string& path, Tiles& tiles, const std::vector<Palette>& palettes);
 
 	static bool exportSelectionToImage(const std::string& path, Tiles& tiles,
@@ -57,14 +80,20 @@ public:
 		std::vector<Palette>& palettes, int paletteIndex,
 		int tileStartX, int tileStartY, int tilesPerRow = TILES_PER_LINE);
 
+	// up to 16 palettes, tiles grouped by the colors they use. `outTilePalettes` has the
+	// palette of each tile
 	static bool convertImageToSpritesheetAndPalette(const std::string& path,
-		Tiles& outTiles, std::vector<Palette>& outPalettes);
+		Tiles& outTiles, std::vector<Palette>& outPalettes, std::vector<uint8_t>& outTilePalettes,
+		int* outTilesPerRow = nullptr);
 
+	// `onProgress` gets 0-1 after every frame written, returning false stops the export and
+	// removes the half written file
 	static bool exportAnimationToGif(const std::string& path,
 		const std::vector<Animation>& animations, int animIndex,
 		const std::vector<AnimationCel>& cels,
-		Tiles& tiles, const std::vector<Palette>& palettes,
+		const Tiles& tiles, const std::vector<Palette>& palettes,
 		float frameRate, int width, int height,
-		float offsetX, float offsetY, int scale = 1);
+		float offsetX, float offsetY, int scale = 1,
+		const std::function<bool(float)>& onProgress = nullptr);
 };
 
@@ -0,0 +1,490 @@
+#include "RomAnimation.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+#include <unordered_set>
+
+#include <SDL3/SDL.h>
+
+#include "JobSystem.h"
+
+std::string formatGbaPointer(uint32_t pointer)
+{
+	std::ostringstream oss;
+	oss << std::uppercase << std::hex << std::setw(8) << std::setfill('0') << pointer;
+	return oss.str();
+}
+
+std::string buildRomImportCelName(const std::string& celPrefix, int index)
+{
+	std::ostringstream oss;
+	oss << celPrefix << std::setw(3) << std::setfill('0') << index;
+	return oss.str();
+}
+
+bool tryConvertRomPointerToOffset(uint32_t pointer, size_t romSize, size_t& outOffset, std::string* outError)
+{
+	outOffset = 0;
+
+	if ((pointer & 0xFF000000) != GBA_ROM_BASE) {
+		if (outError != nullptr) {
+			*outError = "Pointers must be in the 0x08XXXXXX ROM address range.";
+		}
+		return false;
+	}
+
+	uint32_t rawOffset = pointer - GBA_ROM_BASE;
+	if (rawOffset >= romSize) {
+		if (outError != nullptr) {
+			std::ostringstream oss;
+			oss << "Pointer 0x" << formatGbaPointer(pointer) << " points outside the selected ROM.";
+			*outError = oss.str();
+		}
+		return false;
+	}
+
+	outOffset = static_cast<size_t>(rawOffset);
+	return true;
+}
+
+bool tryParseRomCel(const ByteView& rom, uint32_t celPointer, std::vector<TengokuOAM>& outOams, std::string& outError)
+{
+	constexpr uint16_t kMaxRomCelOams = 512;
+
+	size_t celOffset = 0;
+	if (!tryConvertRomPointerToOffset(celPointer, rom.getSize(), celOffset, &outError)) {
+		return false;
+	}
+
+	if ((celOffset % 2) != 0) {
+		outError = "Cel data must be aligned to 2 bytes.";
+		return false;
+	}
+
+	uint16_t oamCount = 0;
+	if (!rom.readU16(celOffset, oamCount)) {
+		outError = "Could not read the cel OAM count.";
+		return false;
+	}
+
+	if (oamCount > kMaxRomCelOams) {
+		std::ostringstream oss;
+		oss << "Cel at 0x" << formatGbaPointer(celPointer)
+			<< " declares " << oamCount << " OAMs, which is above the safety limit.";
+		outError = oss.str();
+		return false;
+	}
+
+	size_t requiredBytes = sizeof(uint16_t) + static_cast<size_t>(oamCount) * sizeof(TengokuOAM);
+	if (!rom.contains(celOffset, requiredBytes)) {
+		outError = "Cel data extends past the end of the ROM.";
+		return false;
+	}
+
+	outOams.clear();
+	outOams.reserve(oamCount);
+
+	size_t readOffset = celOffset + sizeof(uint16_t);
+	for (uint16_t i = 0; i < oamCount; ++i) {
+		uint16_t rawOam[3] = {};
+		if (!rom.readU16(readOffset, rawOam[0]) ||
+			!rom.readU16(readOffset + 2, rawOam[1]) ||
+			!rom.readU16(readOffset + 4, rawOam[2])) {
+			outError = "Could not read one of the OAM entries for the cel.";
+			return false;
+		}
+
+		TengokuOAM oam = {};
+		std::memcpy(&oam, rawOam, sizeof(TengokuOAM));
+		outOams.push_back(oam);
+		readOffset += sizeof(TengokuOAM);
+	}
+
+	return true;
+}
+
+RomAnimationImportParseResult parseRomAnimationData(const ByteView& rom, uint32_t animationPointer,
+	const std::string& animationName, const std::string& celPrefix, std::unordered_map<uint32_t, RomCelCacheEntry>& celCache)
+{
+	constexpr int kMaxRomAnimationEntries = 2048;
+
+	RomAnimationImportParseResult result;
+	result.animationPointer = animationPointer;
+
+	size_t animationOffset = 0;
+	if (!tryConvertRomPointerToOffset(animationPointer, rom.getSize(), animationOffset, &result.errorMessage)) {
+		return result;
+	}
+
+	if ((animationOffset % 4) != 0) {
+		result.warningMessage = "Animation data is not 4-byte aligned. Parsing anyway.";
+	}
+
+	result.animation.name = animationName;
+
+	std::unordered_map<uint32_t, int> celIndexByPointer;
+	int clampedDurationCount = 0;
+
+	for (int entryIndex = 0; entryIndex < kMaxRomAnimationEntries; ++entryIndex) {
+		size_t recordOffset = animationOffset + static_cast<size_t>(entryIndex) * 8;
+
+		uint32_t celPointer = 0;
+		uint32_t durationValue = 0;
+		if (!rom.readU32(recordOffset, celPointer) ||
+			!rom.readU32(recordOffset + 4, durationValue)) {
+			result.errorMessage = "Animation data ran off the end of the ROM before an end marker was found.";
+			result.animation.entries.clear();
+			result.cels.clear();
+			result.entryPointers.clear();
+			result.celPointers.clear();
+			return result;
+		}
+
+		if (celPointer == 0 && durationValue == 0) {
+			if (result.animation.entries.empty()) {
+				result.errorMessage = "The animation pointer immediately points to an end marker.";
+				return result;
+			}
+
+			if (clampedDurationCount > 0) {
+				std::ostringstream oss;
+				if (!result.warningMessage.empty()) {
+					oss << result.warningMessage << "\n";
+				}
+				oss << clampedDurationCount << " duration value(s) were clamped to 255 frames.";
+				result.warningMessage = oss.str();
+			}
+
+			result.success = true;
+			return result;
+		}
+
+		if (celPointer == 0) {
+			std::ostringstream oss;
+			oss << "Entry " << entryIndex << " has a null cel pointer.";
+			result.errorMessage = oss.str();
+			return result;
+		}
+
+		if (durationValue == 0) {
+			std::ostringstream oss;
+			oss << "Entry " << entryIndex << " has a duration of 0.";
+			result.errorMessage = oss.str();
+			return result;
+		}
+
+		int celIndex = -1;
+		auto existingCel = celIndexByPointer.find(celPointer);
+		if (existingCel == celIndexByPointer.end()) {
+			auto [cached, inserted] = celCache.try_emplace(celPointer);
+			RomCelCacheEntry& romCel = cached->second;
+			if (inserted) {
+				romCel.valid = tryParseRomCel(rom, celPointer, romCel.oams, romCel.error);
+			}
+
+			if (!romCel.valid) {
+				std::ostringstream oss;
+				oss << "Failed to parse cel at 0x" << formatGbaPointer(celPointer) << ": " << romCel.error;
+				result.errorMessage = oss.str();
+				return result;
+			}
+
+			AnimationCel cel;
+			cel.name = buildRomImportCelName(celPrefix, static_cast<int>(result.cels.size()));
+			cel.oams = romCel.oams;
+
+			celIndex = static_cast<int>(result.cels.size());
+			celIndexByPointer[celPointer] = celIndex;
+			result.cels.push_back(std::move(cel));
+			result.celPointers.push_back(celPointer);
+		}
+		else {
+			celIndex = existingCel->second;
+		}
+
+		AnimationEntry entry;
+		entry.celName = result.cels[static_cast<size_t>(celIndex)].name;
+		entry.duration = static_cast<uint8_t>(std::min<uint32_t>(durationValue, 255));
+		if (durationValue > 255) {
+			++clampedDurationCount;
+		}
+
+		result.animation.entries.push_back(entry);
+		result.entryPointers.push_back(celPointer);
+	}
+
+	result.errorMessage = "The animation did not hit an 8-byte zero terminator before the safety limit.";
+	result.animation.entries.clear();
+	result.cels.clear();
+	result.entryPointers.clear();
+	result.celPointers.clear();
+	return result;
+}
+
+std::vector<uint32_t> readRomPointerTable(const ByteView& rom, uint32_t tablePointer, int maxCount)
+{
+	std::vector<uint32_t> pointers;
+	size_t offset = 0;
+	if (!tryConvertRomPointerToOffset(tablePointer, rom.getSize(), offset)) {
+		return pointers;
+	}
+
+	uint32_t pointer = 0;
+	size_t unused = 0;
+	while ((maxCount <= 0 || static_cast<int>(pointers.size()) < maxCount) && rom.readU32(offset, pointer) &&
+		tryConvertRomPointerToOffset(pointer, rom.getSize(), unused)) {
+		pointers.push_back(pointer);
+		offset += 4;
+	}
+	return pointers;
+}
+
+RomBatchImportResult parseRomAnimationBatch(const ByteView& rom, const std::vector<uint32_t>& animationPointers,
+	const std::string& namePrefix, const std::vector<Animation>& existingAnimations, const std::vector<AnimationCel>& existingCels)
+{
+	auto startTime = std::chrono::steady_clock::now();
+	RomBatchImportResult batch;
+
+	std::vector<uint32_t> pointers;
+	std::unordered_set<uint32_t> seenPointers;
+	for (uint32_t pointer : animationPointers) {
+		if (seenPointers.insert(pointer).second) pointers.push_back(pointer);
+	}
+
+	// the parsing itself is independent per animation, each worker keeps its own cel cache
+	std::vector<RomAnimationImportParseResult> parsed(pointers.size());
+	std::atomic<size_t> nextPointer{ 0 };
+	auto parseWorker = [&]() {
+		std::unordered_map<uint32_t, RomCelCacheEntry> celCache;
+		for (size_t i = nextPointer++; i < pointers.size(); i = nextPointer++) {
+			parsed[i] = parseRomAnimationData(rom, pointers[i], namePrefix + "_" + formatGbaPointer(pointers[i]), "", celCache);
+		}
+	};
+
+	const size_t threadCount = std::min<size_t>(WorkerPool::shared().getThreadCount() + 1, pointers.size());
+	WorkerPool::shared().parallelFor(threadCount, [&](size_t) { parseWorker(); });
+
+	// stitching stays on one thread so cel names and order don't depend on scheduling
+	std::unordered_map<std::string, const AnimationCel*> existingCelsByName;
+	for (const auto& cel : existingCels) {
+		existingCelsByName.emplace(cel.name, &cel);
+	}
+	std::unordered_set<std::string> takenAnimationNames;
+	for (const auto& animation : existingAnimations) {
+		takenAnimationNames.insert(animation.name);
+	}
+
+	std::unordered_map<uint32_t, std::string> celNameByPointer;
+	std::unordered_map<uint32_t, int> animationsUsingCel;
+	for (size_t i = 0; i < pointers.size(); i++) {
+		RomAnimationImportParseResult& result = parsed[i];
+		const std::string pointerLabel = formatGbaPointer(pointers[i]);
+		if (!result.success) {
+			batch.errors.push_back("0x" + pointerLabel + ": " + result.errorMessage);
+			continue;
+		}
+		if (!takenAnimationNames.insert(result.animation.name).second) {
+			batch.errors.push_back("0x" + pointerLabel + ": " + result.animation.name + " is already in the project.");
+			continue;
+		}
+
+		// resolve every cel before adding any, a conflict skips the whole animation
+		std::string conflict;
+		std::vector<std::string> celNames(result.cels.size());
+		for (size_t celIndex = 0; celIndex < result.cels.size() && conflict.empty(); celIndex++) {
+			const uint32_t celPointer = result.celPointers[celIndex];
+			auto known = celNameByPointer.find(celPointer);
+			if (known != celNameByPointer.end()) {
+				celNames[celIndex] = known->second;
+				continue;
+			}
+
+			celNames[celIndex] = namePrefix + "_cel_" + formatGbaPointer(celPointer);
+			auto existing = existingCelsByName.find(celNames[celIndex]);
+			if (existing != existingCelsByName.end() &&
+				(existing->second->oams.size() != result.cels[celIndex].oams.size() ||
+				 memcmp(existing->second->oams.data(), result.cels[celIndex].oams.data(), existing->second->oams.size() * sizeof(TengokuOAM)) != 0)) {
+				conflict = celNames[celIndex] + " is already in the project with different OAMs.";
+			}
+		}
+		if (!conflict.empty()) {
+			batch.errors.push_back("0x" + pointerLabel + ": " + conflict);
+			continue;
+		}
+
+		for (size_t celIndex = 0; celIndex < result.cels.size(); celIndex++) {
+			const uint32_t celPointer = result.celPointers[celIndex];
+			if (animationsUsingCel[celPointer]++ == 1) {
+				batch.sharedCels++;
+			}
+			if (!celNameByPointer.emplace(celPointer, celNames[celIndex]).second) {
+				continue;
+			}
+
+			if (existingCelsByName.count(celNames[celIndex])) {
+				batch.reusedCels++;
+				continue;
+			}
+			AnimationCel& cel = result.cels[celIndex];
+			cel.name = celNames[celIndex];
+			batch.cels.push_back(std::move(cel));
+			batch.celPointers.push_back(celPointer);
+		}
+
+		for (size_t entryIndex = 0; entryIndex < result.animation.entries.size(); entryIndex++) {
+			result.animation.entries[entryIndex].celName = celNameByPointer[result.entryPointers[entryIndex]];
+		}
+		batch.animations.push_back(std::move(result.animation));
+		batch.animationPointers.push_back(pointers[i]);
+	}
+
+	batch.durationMs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+		std::chrono::steady_clock::now() - startTime).count());
+	SDL_Log("Parsed %zu of %zu ROM animations in %llu ms on %zu threads: %zu new cels, %d reused, %d shared",
+		batch.animations.size(), pointers.size(), static_cast<unsigned long long>(batch.durationMs), threadCount,
+		batch.cels.size(), batch.reusedCels, batch.sharedCels);
+	return batch;
+}
+
+namespace {
+
+constexpr size_t kScanChunkBytes = 256 * 1024;
+constexpr int kMaxScanEntries = 2048;
+constexpr uint16_t kMaxScanCelOams = 512;
+
+// the cheap version of tryParseRomCel: in range, aligned, and the OAMs fit. real cels
+// always have at least one OAM, which also keeps runs of zeroes from passing as cels
+bool looksLikeCel(const ByteView& rom, uint32_t pointer)
+{
+	if ((pointer & 0xFF000001) != GBA_ROM_BASE) {
+		return false;
+	}
+
+	size_t offset = pointer - GBA_ROM_BASE;
+	uint16_t oamCount = 0;
+	return rom.readU16(offset, oamCount) && oamCount > 0 && oamCount <= kMaxScanCelOams &&
+		rom.contains(offset, sizeof(uint16_t) + static_cast<size_t>(oamCount) * sizeof(TengokuOAM));
+}
+
+// durations past 255 would get clamped on import, in practice they only show up in data
+// that isn't an animation at all
+bool looksLikeRecord(const ByteView& rom, size_t offset)
+{
+	uint32_t celPointer = 0;
+	uint32_t duration = 0;
+	return rom.readU32(offset, celPointer) && rom.readU32(offset + 4, duration) &&
+		duration != 0 && duration <= 255 && looksLikeCel(rom, celPointer);
+}
+
+int scoreCandidate(const RomAnimationCandidate& candidate, const RomAnimationImportParseResult& parsed)
+{
+	// more entries and more distinct cels make a coincidence less likely, and real cels
+	// live close to the tables that use them
+	int score = std::min(candidate.entryCount, 64) * 2 + std::min(candidate.celCount, 64) * 3;
+	bool celsNearby = std::all_of(parsed.celPointers.begin(), parsed.celPointers.end(), [&](uint32_t pointer) {
+		uint32_t distance = pointer > candidate.pointer ? pointer - candidate.pointer : candidate.pointer - pointer;
+		return distance < 0x100000;
+	});
+	if (celsNearby) score += 8;
+	if (candidate.entryCount == 1) score -= 4;
+	return score;
+}
+
+// the ROM is cut into chunks and every participant of the parallelFor pulls the next one
+struct ScanChunks {
+	ByteView view;
+	size_t chunkCount = 0;
+	std::atomic<size_t> nextChunk{ 0 };
+	std::atomic<size_t> chunksDone{ 0 };
+};
+
+void scanChunks(ScanChunks& chunks, JobToken& token, std::vector<RomAnimationCandidate>& found)
+{
+	const ByteView& view = chunks.view;
+	std::unordered_map<uint32_t, RomCelCacheEntry> celCache;
+
+	for (size_t chunk = chunks.nextChunk++; chunk < chunks.chunkCount && !token.isCancelled(); chunk = chunks.nextChunk++) {
+		const size_t begin = chunk * kScanChunkBytes;
+		const size_t end = std::min(begin + kScanChunkBytes, view.getSize());
+
+		for (size_t offset = begin; offset < end; offset += 4) {
+			// only the first record of a run starts a table, the rest are its tails.
+			// runs may spill into the next chunk, reading past `end` is fine
+			if (!looksLikeRecord(view, offset) || (offset >= 8 && looksLikeRecord(view, offset - 8))) {
+				continue;
+			}
+
+			size_t recordOffset = offset;
+			int entryCount = 0;
+			while (entryCount < kMaxScanEntries && looksLikeRecord(view, recordOffset)) {
+				recordOffset += 8;
+				entryCount++;
+			}
+
+			uint32_t terminator[2] = { 1, 1 };
+			if (!view.readU32(recordOffset, terminator[0]) || !view.readU32(recordOffset + 4, terminator[1]) ||
+				terminator[0] != 0 || terminator[1] != 0) {
+				continue;
+			}
+
+			RomAnimationCandidate candidate;
+			candidate.pointer = GBA_ROM_BASE + static_cast<uint32_t>(offset);
+			RomAnimationImportParseResult parsed = parseRomAnimationData(view, candidate.pointer, "", "cel", celCache);
+			if (!parsed.success) {
+				continue;
+			}
+
+			candidate.entryCount = static_cast<int>(parsed.animation.entries.size());
+			candidate.celCount = static_cast<int>(parsed.cels.size());
+			for (const auto& entry : parsed.animation.entries) {
+				candidate.totalFrames += entry.duration;
+			}
+			for (const auto& cel : parsed.cels) {
+				candidate.oamCount += static_cast<int>(cel.oams.size());
+			}
+			candidate.score = scoreCandidate(candidate, parsed);
+			found.push_back(candidate);
+		}
+
+		token.setProgress(static_cast<float>(++chunks.chunksDone) / static_cast<float>(chunks.chunkCount));
+	}
+}
+
+}
+
+RomScanResult scanRomForAnimations(const ByteView& rom, JobToken& token)
+{
+	auto startTime = std::chrono::steady_clock::now();
+
+	RomScanResult result;
+	ScanChunks chunks;
+	chunks.view = rom;
+	chunks.chunkCount = (rom.getSize() + kScanChunkBytes - 1) / kScanChunkBytes;
+	result.threadCount = WorkerPool::shared().getThreadCount() + 1;
+	token.setProgress(0.0f);
+
+	// one bucket per participant so nothing has to be locked while scanning
+	std::vector<std::vector<RomAnimationCandidate>> found(result.threadCount);
+	WorkerPool::shared().parallelFor(result.threadCount, [&](size_t i) { scanChunks(chunks, token, found[i]); });
+
+	if (token.isCancelled()) {
+		return result;
+	}
+
+	for (auto& part : found) {
+		result.candidates.insert(result.candidates.end(), part.begin(), part.end());
+	}
+	std::sort(result.candidates.begin(), result.candidates.end(), [](const RomAnimationCandidate& a, const RomAnimationCandidate& b) {
+		return a.score != b.score ? a.score > b.score : a.pointer < b.pointer;
+	});
+
+	result.durationMs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+		std::chrono::steady_clock::now() - startTime).count());
+	SDL_Log("Scanned %zu bytes of ROM in %llu ms on %u threads, %zu candidate animations",
+		rom.getSize(), static_cast<unsigned long long>(result.durationMs), result.threadCount, result.candidates.size());
+	return result;
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Graphics.h"
+#include "MappedFile.h"
+
+class JobToken;
+
+// reading Tengoku animation tables straight out of a GBA ROM. a table is a run of
+// {u32 cel pointer, u32 duration} records closed by 8 zero bytes, a cel is a u16 OAM
+// count followed by that many 6-byte OAMs
+
+constexpr uint32_t GBA_ROM_BASE = 0x08000000;
+
+// a cel as it sits in the ROM, errors included so a bad pointer isn't retried every refresh
+struct RomCelCacheEntry {
+	bool valid = false;
+	std::vector<TengokuOAM> oams;
+	std::string error;
+};
+
+struct RomAnimationImportParseResult {
+	bool success = false;
+	uint32_t animationPointer = 0;
+	Animation animation;
+	std::vector<AnimationCel> cels;
+	std::vector<uint32_t> entryPointers;
+	std::vector<uint32_t> celPointers;
+	std::string errorMessage;
+	std::string warningMessage;
+};
+
+std::string formatGbaPointer(uint32_t pointer);
+std::string buildRomImportCelName(const std::string& celPrefix, int index);
+bool tryConvertRomPointerToOffset(uint32_t pointer, size_t romSize, size_t& outOffset, std::string* outError = nullptr);
+bool tryParseRomCel(const ByteView& rom, uint32_t celPointer, std::vector<TengokuOAM>& outOams, std::string& outError);
+
+// cels are looked up in `celCache` first, animations tend to share most of their cels and
+// retyping the offset shouldn't read them all over again
+RomAnimationImportParseResult parseRomAnimationData(const ByteView& rom, uint32_t animationPointer,
+	const std::string& animationName, const std::string& celPrefix, std::unordered_map<uint32_t, RomCelCacheEntry>& celCache);
+
+// reads a table of animation pointers (u32 each) until it hits something that isn't a ROM
+// pointer, or `maxCount` of them if that's above 0
+std::vector<uint32_t> readRomPointerTable(const ByteView& rom, uint32_t tablePointer, int maxCount);
+
+struct RomBatchImportResult {
+	std::vector<Animation> animations; // the ones that parsed, in the order they were asked for
+	std::vector<uint32_t> animationPointers;
+	std::vector<AnimationCel> cels; // new to the project, one per cel pointer
+	std::vector<uint32_t> celPointers;
+	int reusedCels = 0; // already in the project from an earlier import
+	int sharedCels = 0; // used by more than one animation of this batch
+	std::vector<std::string> errors; // one line per animation that got skipped
+	uint64_t durationMs = 0;
+};
+
+// parses all of `animationPointers` across every core. cels are named after their pointer
+// (`<namePrefix>_cel_<pointer>`), so a cel several animations share comes in once, and one
+// an earlier batch already brought into `existingCels` is reused instead of duplicated
+RomBatchImportResult parseRomAnimationBatch(const ByteView& rom, const std::vector<uint32_t>& animationPointers,
+	const std::string& namePrefix, const std::vector<Animation>& existingAnimations, const std::vector<AnimationCel>& existingCels);
+
+struct RomAnimationCandidate {
+	uint32_t pointer = 0;
+	int entryCount = 0;
+	int celCount = 0;
+	int totalFrames = 0;
+	int oamCount = 0; // over the unique cels
+	int score = 0;
+};
+
+struct RomScanResult {
+	std::vector<RomAnimationCandidate> candidates; // best first
+	unsigned threadCount = 1;
+	uint64_t durationMs = 0;
+};
+
+// sweeps every 4-byte aligned offset of a ROM for animation tables. the ROM is cut into
+// chunks that all cores pull from, each hit is confirmed with parseRomAnimationData and the
+// survivors come back ranked best first. meant to run as a job: chunks stop being handed
+// out once `token` is cancelled, and progress goes through it
+RomScanResult scanRomForAnimations(const ByteView& rom, JobToken& token);
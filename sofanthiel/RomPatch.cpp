@@ -0,0 +1,543 @@
+#include "RomPatch.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <unordered_set>
+
+#include "Compression.h"
+#include "RomAnimation.h"
+
+namespace {
+
+// 0xFF is what linkers pad with, runs of it are almost always free. zero runs are only
+// trusted when they're long, shorter ones tend to be real tables that happen to be empty
+constexpr size_t kMinFreeRunFF = 256;
+constexpr size_t kMinFreeRunZero = 4096;
+// left alone at the start of every run, the data before it may end in the same byte
+constexpr size_t kFreeRunGuard = 16;
+// 0x08000000-0x08FFFFFF. the cartridge goes on at 0x09000000 but nothing here (or in the
+// importer) treats those as ROM pointers, so new data stays below 16 MB
+constexpr size_t kMaxPatchOffset = 16 * 1024 * 1024;
+constexpr int kMaxAnimationEntries = 2048;
+
+// IPS records cost 5 bytes of header, so gaps shorter than this are cheaper to resend
+constexpr size_t kIpsMergeGap = 6;
+constexpr size_t kIpsMaxRecord = 0xFFFE;
+constexpr size_t kIpsEofOffset = 0x454F46; // "EOF", a record can't start here
+
+size_t alignUp(size_t value, size_t alignment)
+{
+	return (value + alignment - 1) & ~(alignment - 1);
+}
+
+// first fit over the free runs of the original ROM, then past its end
+class FreeSpace {
+public:
+	explicit FreeSpace(const ByteView& rom) : growEnd(rom.getSize())
+	{
+		const uint8_t* data = rom.getData();
+		const size_t size = std::min(rom.getSize(), kMaxPatchOffset);
+		size_t pos = 0;
+		while (pos < size) {
+			const uint8_t value = data[pos];
+			if (value != 0xFF && value != 0x00) {
+				pos++;
+				continue;
+			}
+
+			size_t end = pos + 1;
+			while (end < size && data[end] == value) end++;
+
+			const size_t minRun = value == 0xFF ? kMinFreeRunFF : kMinFreeRunZero;
+			const size_t start = alignUp(pos + kFreeRunGuard, 4);
+			if (end - pos >= minRun && start < end) {
+				ranges.push_back({ start, end });
+			}
+			pos = end;
+		}
+	}
+
+	// keeps data that's still in use (original cels and tables) out of the free list
+	void reserve(size_t start, size_t length)
+	{
+		const size_t end = start + length;
+		std::vector<Range> kept;
+		kept.reserve(ranges.size() + 1);
+		for (const Range& range : ranges) {
+			if (range.end <= start || range.start >= end) {
+				kept.push_back(range);
+				continue;
+			}
+			if (range.start < start) kept.push_back({ range.start, start });
+			if (range.end > end) kept.push_back({ alignUp(end, 4), range.end });
+		}
+		ranges = std::move(kept);
+	}
+
+	bool allocate(size_t size, size_t& outOffset)
+	{
+		for (Range& range : ranges) {
+			if (range.end > range.start && range.end - range.start >= size) {
+				outOffset = range.start;
+				range.start = alignUp(range.start + size, 4);
+				range.start = std::min(range.start, range.end);
+				return true;
+			}
+		}
+
+		const size_t offset = alignUp(growEnd, 4);
+		if (offset + size > kMaxPatchOffset) {
+			return false;
+		}
+		outOffset = offset;
+		growEnd = offset + size;
+		return true;
+	}
+
+private:
+	struct Range {
+		size_t start;
+		size_t end;
+	};
+
+	std::vector<Range> ranges;
+	size_t growEnd;
+};
+
+std::vector<uint8_t> serializeCel(const AnimationCel& cel)
+{
+	ByteWriter writer;
+	writer.putU16(static_cast<uint16_t>(cel.oams.size()));
+	for (const TengokuOAM& oam : cel.oams) {
+		uint16_t rawOam[3] = {};
+		std::memcpy(rawOam, &oam, sizeof(TengokuOAM));
+		writer.putU16(rawOam[0]);
+		writer.putU16(rawOam[1]);
+		writer.putU16(rawOam[2]);
+	}
+	return writer.bytes;
+}
+
+// byte length of the table at `offset` counting its end marker, 0 if it isn't a table
+size_t measureAnimationTable(const ByteView& rom, size_t offset)
+{
+	for (int entry = 0; entry < kMaxAnimationEntries; entry++) {
+		uint32_t celPointer = 0;
+		uint32_t duration = 0;
+		if (!rom.readU32(offset + entry * 8, celPointer) || !rom.readU32(offset + entry * 8 + 4, duration)) {
+			return 0;
+		}
+		if (celPointer == 0 && duration == 0) {
+			return entry == 0 ? 0 : static_cast<size_t>(entry + 1) * 8;
+		}
+		if ((celPointer & 0xFF000000) != GBA_ROM_BASE || duration == 0) {
+			return 0;
+		}
+	}
+	return 0;
+}
+
+bool findOrigin(const std::unordered_map<std::string, uint32_t>& known, const std::string& name, uint32_t& outPointer)
+{
+	auto it = known.find(name);
+	if (it != known.end()) {
+		outPointer = it->second;
+		return true;
+	}
+	return tryParseRomPointerSuffix(name, outPointer);
+}
+
+// where a cel or table sits in the original ROM, and how much room it has there
+struct Origin {
+	bool known = false;
+	uint32_t pointer = 0;
+	size_t offset = 0;
+	size_t size = 0;
+};
+
+void writeBytes(std::vector<uint8_t>& rom, size_t offset, const std::vector<uint8_t>& bytes)
+{
+	if (offset + bytes.size() > rom.size()) {
+		rom.resize(offset + bytes.size(), 0xFF);
+	}
+	std::memcpy(rom.data() + offset, bytes.data(), bytes.size());
+}
+
+// how many leading bytes two buffers share, a word at a time
+size_t countEqual(const uint8_t* a, const uint8_t* b, size_t size)
+{
+	size_t pos = 0;
+	while (pos + 8 <= size) {
+		uint64_t wordA = 0;
+		uint64_t wordB = 0;
+		std::memcpy(&wordA, a + pos, 8);
+		std::memcpy(&wordB, b + pos, 8);
+		if (wordA != wordB) break;
+		pos += 8;
+	}
+	while (pos < size && a[pos] == b[pos]) pos++;
+	return pos;
+}
+
+void putBpsNumber(std::vector<uint8_t>& out, uint64_t value)
+{
+	for (;;) {
+		uint8_t low = value & 0x7F;
+		value >>= 7;
+		if (value == 0) {
+			out.push_back(0x80 | low);
+			return;
+		}
+		out.push_back(low);
+		value--;
+	}
+}
+
+void putLittleU32(std::vector<uint8_t>& out, uint32_t value)
+{
+	for (int i = 0; i < 4; i++) {
+		out.push_back(static_cast<uint8_t>((value >> (i * 8)) & 0xFF));
+	}
+}
+
+}
+
+bool tryParseRomPointerSuffix(const std::string& name, uint32_t& outPointer)
+{
+	if (name.size() < 9 || name[name.size() - 9] != '_') {
+		return false;
+	}
+
+	uint32_t value = 0;
+	for (size_t i = name.size() - 8; i < name.size(); i++) {
+		const char c = name[i];
+		uint32_t digit = 0;
+		if (c >= '0' && c <= '9') digit = c - '0';
+		else if (c >= 'A' && c <= 'F') digit = c - 'A' + 10;
+		else if (c >= 'a' && c <= 'f') digit = c - 'a' + 10;
+		else return false;
+		value = (value << 4) | digit;
+	}
+
+	if ((value & 0xFF000000) != GBA_ROM_BASE) {
+		return false;
+	}
+	outPointer = value;
+	return true;
+}
+
+RomPatchResult buildRomPatch(const ByteView& rom, const std::vector<AnimationCel>& cels,
+	const std::vector<Animation>& animations, const RomOrigins& origins)
+{
+	auto startTime = std::chrono::steady_clock::now();
+
+	RomPatchResult result;
+	result.rom.assign(rom.getData(), rom.getData() + rom.getSize());
+	FreeSpace freeSpace(rom);
+
+	std::unordered_map<std::string, size_t> celIndexByName;
+	for (size_t i = 0; i < cels.size(); i++) {
+		celIndexByName.try_emplace(cels[i].name, i);
+	}
+
+	// work out where everything came from before anything gets allocated, so new data never
+	// lands on top of an original that's still in use
+	std::vector<Origin> celOrigins(cels.size());
+	for (size_t i = 0; i < cels.size(); i++) {
+		// a name used twice only gets written once, by its first cel
+		if (celIndexByName[cels[i].name] != i) continue;
+
+		Origin& origin = celOrigins[i];
+		std::vector<TengokuOAM> oams;
+		std::string error;
+		if (!findOrigin(origins.celPointers, cels[i].name, origin.pointer) ||
+			!tryParseRomCel(rom, origin.pointer, oams, error)) {
+			continue;
+		}
+		origin.known = true;
+		origin.offset = origin.pointer - GBA_ROM_BASE;
+		origin.size = sizeof(uint16_t) + oams.size() * sizeof(TengokuOAM);
+		freeSpace.reserve(origin.offset, origin.size);
+	}
+
+	std::vector<size_t> patchedAnimations;
+	std::vector<Origin> animationOrigins(animations.size());
+	for (size_t i = 0; i < animations.size(); i++) {
+		const Animation& animation = animations[i];
+		Origin& origin = animationOrigins[i];
+		if (!findOrigin(origins.animationPointers, animation.name, origin.pointer)) {
+			result.warnings.push_back(animation.name + ": not imported from a ROM, nothing points at it");
+			continue;
+		}
+
+		size_t offset = 0;
+		if (!tryConvertRomPointerToOffset(origin.pointer, rom.getSize(), offset) ||
+			(origin.size = measureAnimationTable(rom, offset)) == 0) {
+			result.warnings.push_back(animation.name + ": no animation table at 0x" + formatGbaPointer(origin.pointer));
+			continue;
+		}
+
+		bool missingCel = false;
+		for (const AnimationEntry& entry : animation.entries) {
+			if (celIndexByName.count(entry.celName) == 0) {
+				result.warnings.push_back(animation.name + ": uses missing cel " + entry.celName);
+				missingCel = true;
+				break;
+			}
+		}
+		if (missingCel || animation.entries.empty()) {
+			if (!missingCel) result.warnings.push_back(animation.name + ": has no entries");
+			continue;
+		}
+
+		origin.known = true;
+		origin.offset = offset;
+		freeSpace.reserve(origin.offset, origin.size);
+		patchedAnimations.push_back(i);
+	}
+
+	// cels the patched animations use, plus every cel that came out of the ROM
+	std::vector<bool> celNeeded(cels.size(), false);
+	for (size_t i = 0; i < cels.size(); i++) {
+		celNeeded[i] = celOrigins[i].known;
+	}
+	for (size_t animationIndex : patchedAnimations) {
+		for (const AnimationEntry& entry : animations[animationIndex].entries) {
+			celNeeded[celIndexByName[entry.celName]] = true;
+		}
+	}
+
+	// the same data can come in twice under different names, so several cels (or animations) can
+	// share one origin. it only gets rewritten or repointed when every copy still agrees, otherwise
+	// the edited copies go to new space and the ROM keeps pointing at the original
+	std::unordered_set<uint32_t> splitOrigins;
+	auto findSplitOrigins = [&](const std::vector<Origin>& itemOrigins, const std::vector<std::vector<uint8_t>>& itemBytes,
+		const std::vector<size_t>& items) {
+		std::unordered_map<uint32_t, size_t> firstByOrigin;
+		for (size_t i : items) {
+			if (!itemOrigins[i].known) continue;
+			auto first = firstByOrigin.try_emplace(itemOrigins[i].pointer, i).first;
+			if (itemBytes[first->second] != itemBytes[i]) {
+				splitOrigins.insert(itemOrigins[i].pointer);
+			}
+		}
+	};
+
+	std::unordered_map<uint32_t, uint32_t> repoints;
+	std::unordered_map<uint32_t, uint32_t> placedOrigins; // origin pointer -> where its copies ended up
+	auto place = [&](const std::string& name, const Origin& origin, const std::vector<uint8_t>& bytes, int& unchanged,
+		int& inPlace, int& relocated, int& added, uint32_t& outPointer) -> bool {
+		const bool split = origin.known && splitOrigins.count(origin.pointer) != 0;
+		if (origin.known && !split) {
+			auto placed = placedOrigins.find(origin.pointer);
+			if (placed != placedOrigins.end()) {
+				outPointer = placed->second;
+				return true;
+			}
+		}
+
+		if (origin.known) {
+			if (bytes.size() == origin.size && std::memcmp(rom.getData() + origin.offset, bytes.data(), bytes.size()) == 0) {
+				unchanged++;
+				outPointer = origin.pointer;
+				if (!split) placedOrigins[origin.pointer] = outPointer;
+				return true;
+			}
+			if (!split && bytes.size() <= origin.size) {
+				writeBytes(result.rom, origin.offset, bytes);
+				inPlace++;
+				outPointer = origin.pointer;
+				placedOrigins[origin.pointer] = outPointer;
+				return true;
+			}
+		}
+
+		size_t offset = 0;
+		if (!freeSpace.allocate(bytes.size(), offset)) {
+			return false;
+		}
+		writeBytes(result.rom, offset, bytes);
+		result.bytesAllocated += bytes.size();
+		outPointer = GBA_ROM_BASE + static_cast<uint32_t>(offset);
+		if (split) {
+			added++;
+			result.warnings.push_back(name + ": differs from other copies of 0x" + formatGbaPointer(origin.pointer) +
+				", written to new space without repointing");
+		}
+		else if (origin.known) {
+			relocated++;
+			repoints[origin.pointer] = outPointer;
+			placedOrigins[origin.pointer] = outPointer;
+		}
+		else {
+			added++;
+		}
+		return true;
+	};
+
+	std::vector<size_t> celsToWrite;
+	std::vector<std::vector<uint8_t>> celBytes(cels.size());
+	for (size_t i = 0; i < cels.size(); i++) {
+		if (!celNeeded[i] || celIndexByName[cels[i].name] != i) continue;
+		celsToWrite.push_back(i);
+		celBytes[i] = serializeCel(cels[i]);
+	}
+	findSplitOrigins(celOrigins, celBytes, celsToWrite);
+
+	std::vector<uint32_t> celPointers(cels.size(), 0);
+	for (size_t i : celsToWrite) {
+		if (!place(cels[i].name, celOrigins[i], celBytes[i], result.celsUnchanged, result.celsInPlace,
+			result.celsRelocated, result.celsAdded, celPointers[i])) {
+			result.errorMessage = "Ran out of free space in the ROM while placing cel " + cels[i].name + ".";
+			return result;
+		}
+	}
+
+	// tables go after the cels, they hold the cels' final pointers
+	std::vector<std::vector<uint8_t>> animationBytes(animations.size());
+	for (size_t animationIndex : patchedAnimations) {
+		ByteWriter writer;
+		for (const AnimationEntry& entry : animations[animationIndex].entries) {
+			writer.putU32(celPointers[celIndexByName[entry.celName]]);
+			writer.putU32(entry.duration);
+		}
+		writer.putU32(0);
+		writer.putU32(0);
+		animationBytes[animationIndex] = std::move(writer.bytes);
+	}
+	findSplitOrigins(animationOrigins, animationBytes, patchedAnimations);
+
+	for (size_t animationIndex : patchedAnimations) {
+		const Animation& animation = animations[animationIndex];
+		uint32_t pointer = 0;
+		int notAdded = 0; // only copies that disagree with another one end up here
+		if (!place(animation.name, animationOrigins[animationIndex], animationBytes[animationIndex],
+			result.animationsUnchanged, result.animationsInPlace, result.animationsRelocated, notAdded, pointer)) {
+			result.errorMessage = "Ran out of free space in the ROM while placing animation " + animation.name + ".";
+			return result;
+		}
+	}
+
+	// anything that moved: every aligned word in the original ROM still pointing at the old spot
+	// (other animation tables, pointer tables, literal pools) follows it. new data only ever holds
+	// final pointers, so the part past the old end doesn't need looking at
+	if (!repoints.empty()) {
+		uint8_t* data = result.rom.data();
+		for (size_t offset = 0; offset + 4 <= rom.getSize(); offset += 4) {
+			if (data[offset + 3] != (GBA_ROM_BASE >> 24)) continue;
+
+			uint32_t word = 0;
+			std::memcpy(&word, data + offset, sizeof(word));
+			auto it = repoints.find(word);
+			if (it == repoints.end()) continue;
+
+			std::memcpy(data + offset, &it->second, sizeof(uint32_t));
+			result.pointersRepointed++;
+		}
+	}
+
+	result.success = true;
+	result.durationMs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+		std::chrono::steady_clock::now() - startTime).count());
+	return result;
+}
+
+std::vector<uint8_t> buildIpsPatch(const ByteView& source, const ByteView& target, std::string& error)
+{
+	const uint8_t* src = source.getData();
+	const uint8_t* dst = target.getData();
+	auto differs = [&](size_t pos) { return pos >= source.getSize() || src[pos] != dst[pos]; };
+
+	std::vector<uint8_t> out = { 'P', 'A', 'T', 'C', 'H' };
+	const size_t commonSize = std::min(source.getSize(), target.getSize());
+	size_t pos = 0;
+	while (pos < target.getSize()) {
+		if (pos < commonSize) {
+			pos += countEqual(src + pos, dst + pos, commonSize - pos);
+			if (pos >= target.getSize()) break;
+		}
+
+		size_t start = pos;
+		if (start == kIpsEofOffset) start--;
+
+		size_t end = pos + 1;
+		for (size_t next = pos + 1; next < target.getSize() && next - start < kIpsMaxRecord; next++) {
+			if (differs(next)) end = next + 1;
+			else if (next - end >= kIpsMergeGap) break;
+		}
+
+		if (start > 0xFFFFFF) {
+			error = "IPS patches can't reach past 16 MB, use the BPS patch instead.";
+			return {};
+		}
+
+		out.push_back(static_cast<uint8_t>(start >> 16));
+		out.push_back(static_cast<uint8_t>(start >> 8));
+		out.push_back(static_cast<uint8_t>(start));
+
+		const size_t length = end - start;
+		const bool isRun = length >= 8 && std::all_of(dst + start, dst + end, [&](uint8_t b) { return b == dst[start]; });
+		if (isRun) {
+			out.insert(out.end(), { 0, 0, static_cast<uint8_t>(length >> 8), static_cast<uint8_t>(length), dst[start] });
+		}
+		else {
+			out.push_back(static_cast<uint8_t>(length >> 8));
+			out.push_back(static_cast<uint8_t>(length));
+			out.insert(out.end(), dst + start, dst + end);
+		}
+		pos = end;
+	}
+
+	out.insert(out.end(), { 'E', 'O', 'F' });
+	return out;
+}
+
+std::vector<uint8_t> buildBpsPatch(const ByteView& source, const ByteView& target)
+{
+	// only SourceRead (0) and TargetRead (1): the edits are small and in place, the
+	// copy actions wouldn't buy much
+	const uint8_t* src = source.getData();
+	const uint8_t* dst = target.getData();
+	const size_t sourceSize = source.getSize();
+	const size_t targetSize = target.getSize();
+	auto same = [&](size_t pos) { return pos < sourceSize && src[pos] == dst[pos]; };
+
+	std::vector<uint8_t> out = { 'B', 'P', 'S', '1' };
+	putBpsNumber(out, sourceSize);
+	putBpsNumber(out, targetSize);
+	putBpsNumber(out, 0);
+
+	const size_t commonSize = std::min(sourceSize, targetSize);
+	size_t pos = 0;
+	while (pos < targetSize) {
+		size_t end = pos < commonSize ? pos + countEqual(src + pos, dst + pos, commonSize - pos) : pos;
+		if (end > pos) {
+			putBpsNumber(out, ((end - pos - 1) << 2) | 0);
+			pos = end;
+			continue;
+		}
+
+		// changed bytes, through any equal stretch too short to be worth its own action
+		end = pos + 1;
+		while (end < targetSize) {
+			if (!same(end)) {
+				end++;
+				continue;
+			}
+			size_t equalEnd = end;
+			while (equalEnd < targetSize && same(equalEnd) && equalEnd - end < 4) equalEnd++;
+			if (equalEnd - end >= 4 || equalEnd == targetSize) break;
+			end = equalEnd;
+		}
+
+		putBpsNumber(out, ((end - pos - 1) << 2) | 1);
+		out.insert(out.end(), dst + pos, dst + end);
+		pos = end;
+	}
+
+	putLittleU32(out, Compression::crc32(src, sourceSize));
+	putLittleU32(out, Compression::crc32(dst, targetSize));
+	putLittleU32(out, Compression::crc32(out.data(), out.size()));
+	return out;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "ByteStream.h"
+#include "Graphics.h"
+
+// writing edited cels and animation tables back into a copy of the ROM they were imported
+// from, for trying things in an emulator without rebuilding the decomp. data that still fits
+// goes back where it was, anything that grew is moved into free space and every aligned
+// pointer to its old spot gets repointed
+
+// where imported cels and animations came from, by name. filled in by the ROM importers
+struct RomOrigins {
+	std::string romPath;
+	std::unordered_map<std::string, uint32_t> celPointers;
+	std::unordered_map<std::string, uint32_t> animationPointers;
+
+	void clear()
+	{
+		romPath.clear();
+		celPointers.clear();
+		animationPointers.clear();
+	}
+};
+
+// batch imports (and the single import's default animation name) end in `_<8 digit pointer>`,
+// which lets a saved and reopened project still find its way back into the ROM
+bool tryParseRomPointerSuffix(const std::string& name, uint32_t& outPointer);
+
+struct RomPatchResult {
+	bool success = false;
+	std::vector<uint8_t> rom; // the patched copy, can be longer than the original
+	int celsUnchanged = 0;
+	int celsInPlace = 0;
+	int celsRelocated = 0;
+	int celsAdded = 0; // new in the project and used by a patched animation, or an edited copy of a shared origin
+	int animationsUnchanged = 0;
+	int animationsInPlace = 0;
+	int animationsRelocated = 0;
+	int pointersRepointed = 0;
+	size_t bytesAllocated = 0;
+	std::vector<std::string> warnings; // one line per thing that got skipped
+	std::string errorMessage;
+	uint64_t durationMs = 0;
+};
+
+// only animations with a known origin get written (nothing in the game points at the others),
+// along with every cel they use and every cel that came from the ROM
+RomPatchResult buildRomPatch(const ByteView& rom, const std::vector<AnimationCel>& cels,
+	const std::vector<Animation>& animations, const RomOrigins& origins);
+
+// classic IPS, offsets stop at 16 MB. empty with `error` set when the changes go past that
+std::vector<uint8_t> buildIpsPatch(const ByteView& source, const ByteView& target, std::string& error);
+std::vector<uint8_t> buildBpsPatch(const ByteView& source, const ByteView& target);
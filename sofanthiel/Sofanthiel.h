@@ -13,6 +13,16 @@
 #include "ResourceManager.h"
 #include "UndoRedo.h"
 #include "InputManager.h"
+#include "UsageIndex.h"
+#include "ProjectFile.h"
+#include "ProjectSaver.h"
+#include "EditJournal.h"
+#include "FileWatcher.h"
+#include "RomAnimation.h"
+#include "RomPatch.h"
+#include "FileImport.h"
+#include "JobSystem.h"
+#include "PlaybackClock.h"
 
 //-----------------------------------------------------------------------------
 
@@ -40,6 +50,8 @@ struct TimelineResizeState {
     float resizeStartPos = 0.0f;
     int originalDuration = 0;
     int frameStartOffset = 0;
+    bool hasEntriesBefore = false;
+    std::vector<AnimationEntry> entriesBefore;
 };
 
 struct TimelineDragState {
@@ -57,7 +69,8 @@ struct RomAnimationImportState {
     bool popupPendingOpen = false;
     bool previewValid = false;
     std::string romPath;
-    std::vector<uint8_t> romData;
+    std::shared_ptr<const MappedFile> rom; // shared with the scan and parse jobs while they run
+    std::unordered_map<uint32_t, RomCelCacheEntry> celCache; // by cel pointer, outlives offset edits
     char offsetBuffer[32] = "";
     char animationNameBuffer[256] = "";
     char celPrefixBuffer[256] = "";
@@ -72,7 +85,75 @@ struct RomAnimationImportState {
     std::vector<uint32_t> previewCelPointers;
     int previewCurrentFrame = 0;
     int previewTotalFrames = 0;
-    Uint64 previewLastTickMs = 0;
+    PlaybackClock previewClock;
+    JobHandle scanJob; // empty when no scan is running
+    bool scanFinished = false;
+    uint64_t scanDurationMs = 0;
+    std::vector<RomAnimationCandidate> scanResults;
+    int scanMinEntries = 2;
+    char scanFilterBuffer[32] = "";
+    bool batchMode = false;
+    char batchPointerBuffer[8192] = "";
+    char batchTableBuffer[32] = "";
+    int batchTableCount = 0;
+    bool batchPreviewValid = false;
+    uint64_t batchPreviewJob = 0; // the parse whose result the preview is waiting for, 0 when none
+    RomBatchImportResult batchPreview;
+    std::string batchMessage;
+};
+
+struct RomGraphicsImportState {
+    bool showPopup = false;
+    bool popupPendingOpen = false;
+    bool previewValid = false;
+    std::string romPath;
+    std::shared_ptr<const MappedFile> rom;
+    char offsetBuffer[32] = "";
+    size_t offset = 0;
+    Tiles previewTiles;
+    uint8_t type = 0;
+    size_t compressedSize = 0;
+    double decodeMs = 0.0;
+    std::string message;
+};
+
+struct RomPatchExportState {
+    bool showPopup = false;
+    bool popupPendingOpen = false;
+    std::string baseRomPath;
+    std::string outputPath;
+    bool writeIps = true;
+    bool writeBps = true;
+    bool hasResult = false;
+    RomPatchResult result; // rom bytes are dropped once written
+    std::vector<std::string> writtenFiles;
+};
+
+struct FileImportState {
+    JobHandle batchJob; // the batch decoding right now, empty when none
+    std::vector<std::string> droppedPaths; // collected until the drop completes
+    bool dropInProgress = false;
+    std::vector<std::string> queuedPaths; // came in while a batch was still decoding
+    bool hasResult = false;
+    size_t importedCount = 0;
+    std::vector<std::string> errors;
+    uint64_t durationMs = 0;
+    Uint64 finishedTick = 0;
+};
+
+// files the document was imported from, edits made to them outside get merged back in
+enum class WatchedSourceKind {
+    Tiles,
+    Palettes,
+    AnimationCels,
+    Animations,
+    Count
+};
+
+struct WatchedSource {
+    std::string path;
+    std::vector<std::string> names; // what the file held last time, so we know what it dropped
+    std::vector<CelSourceBlock> celBlocks; // cels only, so a reload can skip the blocks that didn't change
 };
 
 //-----------------------------------------------------------------------------
@@ -93,9 +174,34 @@ private:
     float getAutomaticDisplayScale() const;
     float getCurrentDisplayScale() const;
     void applyDisplayScale(float displayScale);
-    void handleDroppedFile(const std::string& path);
+    void importFiles(const std::vector<std::string>& paths);
+    void startQueuedFileImport();
+    void commitImportedFiles(std::vector<ImportedFile>& files);
+    void drawImportStatus();
     void saveProject(const std::string& path);
     void loadProject(const std::string& path);
+    void cancelProjectLoad();
+    void pollProjectSave();
+    void drawSaveStatus();
+    void drawJobStatus();
+    ProjectMetadata buildProjectMetadata() const;
+    std::shared_ptr<const DocumentSnapshot> captureDocument();
+    void applyProjectData(ProjectData& project);
+    void journalDocument();
+    void resetJournal(const std::string& basePath);
+    void handleRecoveryPopup();
+    void recoverJournal();
+
+    // hot reload
+    void watchImportedFile(const std::string& path, WatchedSourceKind kind);
+    void stopWatchingSource(WatchedSourceKind kind);
+    void clearWatchedSources();
+    void pollWatchedFiles();
+    void reloadWatchedSource(WatchedSourceKind kind);
+    void reloadAnimationCels(WatchedSource& source);
+    void reloadAnimations(WatchedSource& source);
+    void reloadTiles(WatchedSource& source);
+    void reloadPalettes(WatchedSource& source);
 
     // ui handlers (main)
     void handleMenuBar();
@@ -105,6 +211,7 @@ private:
     void handlePalette();
     void handleAnimCels();
     void handleAnims();
+    void handleRemoveCelPopup();
 
     // ui handlers (cel editor)
     void handleCelInfobar();
@@ -139,6 +246,7 @@ private:
     // preview
     void drawBackgroundTexture(ImDrawList* drawList, ImVec2 origin, ImVec2 scaledSize);
     void updateAnimationPlayback();
+    double getPlaybackFrameRate() const;
     void drawAnimationFramePreview(ImDrawList* drawList, ImVec2 origin, float zoom,
         const Animation& anim, const std::vector<AnimationCel>& cels,
         int frame, ImVec2 animationOffset);
@@ -157,6 +265,9 @@ private:
     void drawSpritesheetSelection(ImDrawList* drawList, const ImVec2& origin);
     void drawSpritesheetImportOverlay(ImDrawList* drawList, const ImVec2& origin);
     void handleSpritesheetContextMenu(const ImVec2& origin);
+    void drawUnusedTilesOverlay(ImDrawList* drawList, const ImVec2& origin);
+    void requestTileDelete(const std::vector<int>& affectedTiles, std::function<void()> deleteAction);
+    void handleTileDeleteWarningPopup();
 
     // palette
     void drawPaletteContent(const ImVec2& origin);
@@ -167,12 +278,25 @@ private:
     void handlePaletteRowSelection(const ImVec2& origin);
     void handlePaletteContextMenu();
 	void initializeDefaultPalettes();
+    static std::vector<Palette> makeDefaultPalettes();
     void beginPaletteImport(const std::vector<ParsedCPaletteGroup>& groups);
     void handlePaletteImportPopup();
     void beginRomAnimationImport(const std::string& romPath);
     void clearRomAnimationImportState();
+    void startRomAnimationScan();
     void refreshRomAnimationImportPreview();
     void handleRomAnimationImportPopup();
+    void refreshRomBatchImportPreview();
+    void startImageConversion(const std::string& path);
+    void startGifExport(const std::string& path);
+    bool handleRomBatchImport();
+    void beginRomGraphicsImport(const std::string& romPath);
+    void refreshRomGraphicsImportPreview();
+    void handleRomGraphicsImportPopup();
+    void rememberRomOrigins(const std::string& romPath);
+    void beginRomPatchExport();
+    void runRomPatchExport();
+    void handleRomPatchExportPopup();
 
     // oam preview
     void drawCelPreviewInfoPanel(ViewManager& view, ImVec2 mousePosInWindow, ImVec2 contentSize, const ImVec2& origin);
@@ -184,7 +308,7 @@ private:
 
     void renderOAM(ImDrawList* drawList, ImVec2 origin, float zoom,
         const TengokuOAM& oam, float offsetX, float offsetY, float alpha);
-    void getOAMDimensions(int objShape, int objSize, int& width, int& height);
+    static void getOAMDimensions(int objShape, int objSize, int& width, int& height);
     void renderTile(ImDrawList* drawList, float xPos, float yPos, float zoom,
         const TengokuOAM& oam, int tileIdx, int tx, int ty, float alpha);
 
@@ -192,12 +316,17 @@ private:
     void drawBackground(ImDrawList* drawList, ImVec2 origin, ImVec2 size, float* color);
     ImVec2 calculateContentCenter();
     void recalculateTotalFrames();
-    bool buildOptimizedSpritesheetState(Tiles& outTiles, std::vector<AnimationCel>& outAnimationCels);
+    void startSpritesheetOptimization();
+    static bool buildOptimizedSpritesheetState(const Tiles& tiles, const std::vector<AnimationCel>& animationCels,
+        const std::vector<Animation>& animations, Tiles& outTiles, std::vector<AnimationCel>& outAnimationCels);
     bool isCelNameUnique(const std::string& name, int excludeIndex = -1) const;
+    void removeAnimationCels(const std::vector<int>& celIndices, bool removeReferencingEntries);
+    void selectUnusedCels();
     bool isAnimationNameUnique(const std::string& name, int excludeIndex = -1) const;
     void applyTheme();
     void updateWindowTitle();
     void handleAboutDialog();
+    void handleUndoHistory();
     std::string buildWindowTitle() const;
     std::string getProjectDisplayName() const;
     
@@ -221,6 +350,7 @@ private:
     std::vector<ImVec2> selectedOAMStartPositions;
     bool showExitConfirmation = false;
     bool showAboutDialog = false;
+    bool showUndoHistory = false;
 
     bool showGrid = true;
     bool showSelectionBorder = true;
@@ -240,6 +370,8 @@ private:
     bool isPlaying = false;
     bool loopAnimation = true;
     float frameRate = 60.0f;
+    bool lockToGbaRefreshRate = false; // plays at PlaybackClock::GBA_REFRESH_RATE, ignoring frameRate
+    PlaybackClock playbackClock;
     float syncScroll = 0.0f;
     float timelineHorizontalZoom = 1.0f;
 
@@ -263,6 +395,9 @@ private:
 
     bool usePaletteBGColor = false;
     int currentPalette = 0;
+    // palette of each tile, only filled by Convert Image to Spritesheet + Palette
+    std::vector<uint8_t> tilePalettes;
+    bool useTilePalettes = false;
     int spritesheetTilesPerRow = TILES_PER_LINE;
     ViewManager spritesheetView;
 
@@ -279,6 +414,13 @@ private:
     int ssImportImageH = 0;
     ImVec2 ssImportTilePos = ImVec2(0, 0); // tile coords where overlay is placed
 
+    bool showUnusedTiles = false;
+    bool ssTileDeletePopupPendingOpen = false;
+    int ssTileDeleteUsedTiles = 0;
+    int ssTileDeleteOAMRefs = 0;
+    int ssTileDeleteCelCount = 0;
+    std::function<void()> ssPendingTileDelete;
+
     std::vector<TileData> ssTileClipboard;
     int ssTileClipboardWidth = 0;
     int ssTileClipboardHeight = 0;
@@ -306,6 +448,10 @@ private:
     bool showNewAnimationPopup = false;
     char newAnimationNameBuffer[256] = "";
 
+    std::vector<int> selectedCelIndices;
+    bool showRemoveCelPopup = false;
+    std::vector<int> removingCelIndices;
+
     bool showRenameCelPopup = false;
     int renamingCelIndex = -1;
     char renameCelNameBuffer[128] = "";
@@ -321,10 +467,32 @@ private:
     int paletteImportPreviewGroupIndex = 0;
     int paletteImportPreviewPaletteIndex = 0;
     RomAnimationImportState romAnimationImport;
+    RomGraphicsImportState romGraphicsImport;
+    RomOrigins romOrigins;
+    RomPatchExportState romPatchExport;
+    FileImportState fileImport;
+    JobSystem jobs;
+    JobHandle projectLoad; // files dropped with a project wait for it to land
 
     int gifExportScale = 1;
 
     std::string currentProjectPath;
+    bool compressProjectFile = true;
+    bool optimalTileCompression = true;
+    ProjectSaver projectSaver;
+    // where the newest save of this document is headed, the document only moves there once it lands
+    std::string pendingSavePath;
+    ProjectSaveResult lastSaveResult;
+    bool hasSaveResult = false;
+    Uint64 lastSaveFinishedTick = 0;
+    EditJournal journal;
+    std::shared_ptr<const DocumentSnapshot> lastSnapshot;
+    Uint64 lastJournalTick = 0;
+    bool recoveryPending = false;
+    std::string recoveryBasePath;
+    std::vector<std::vector<uint8_t>> recoveryRecords;
+    FileWatcher fileWatcher;
+    std::array<WatchedSource, static_cast<size_t>(WatchedSourceKind::Count)> watchedSources;
     std::string lastWindowTitle;
     std::string imguiSettingsPath;
 
@@ -333,6 +501,8 @@ private:
     bool useManualDPIScale = false;
 
     UndoRedoManager undoManager;
+    TileUsageIndex tileUsage;
+    CelUsageIndex celUsage;
     Palette paletteUndoSnapshot;
     int paletteUndoSnapshotIndex = -1;
 };
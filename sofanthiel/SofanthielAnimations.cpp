@@ -85,13 +85,13 @@ void Sofanthiel::handleAnimCels()
                 std::string oldName = animationCels[renamingCelIndex].name;
                 std::string newName = renameCelNameBuffer;
 
+                celUsage.sync(animations);
                 animationCels[renamingCelIndex].name = newName;
 
-                for (auto& anim : animations) {
-                    for (auto& entry : anim.entries) {
-                        if (entry.celName == oldName) {
-                            entry.celName = newName;
-                        }
+                for (const auto& ref : celUsage.getReferences(oldName)) {
+                    if (ref.animationIndex < static_cast<int>(animations.size()) &&
+                        ref.entryIndex < static_cast<int>(animations[ref.animationIndex].entries.size())) {
+                        animations[ref.animationIndex].entries[ref.entryIndex].celName = newName;
                     }
                 }
 
@@ -115,6 +115,8 @@ void Sofanthiel::handleAnimCels()
         ImGui::EndPopup();
     }
 
+    handleRemoveCelPopup();
+
     ImGui::BeginChild("AnimationCelsList", ImVec2(0, 0), ImGuiChildFlags_None);
 
     if (animationCels.empty()) {
@@ -139,19 +141,37 @@ void Sofanthiel::handleAnimCels()
         ImGui::PushID(i);
 
         bool isEditing = (editingCelIndex == i && celEditingMode);
+        auto selectedIt = std::find(selectedCelIndices.begin(), selectedCelIndices.end(), i);
+        bool isSelected = selectedIt != selectedCelIndices.end();
+        int useCount = celUsage.getUseCount(cel.name);
+
         char label[256];
-        snprintf(label, sizeof(label), ICON_FA_IMAGE " %s  (%d OAMs)", cel.name.c_str(), static_cast<int>(cel.oams.size()));
+        snprintf(label, sizeof(label), ICON_FA_IMAGE " %s  (%d OAMs, %d uses)", cel.name.c_str(), static_cast<int>(cel.oams.size()), useCount);
 
-        if (ImGui::Selectable(label, isEditing, ImGuiSelectableFlags_AllowDoubleClick, ImVec2(availWidth, 0))) {
+        if (useCount == 0) {
+            ImGui::PushStyleColor(ImGuiCol_Text, ImGui::GetStyleColorVec4(ImGuiCol_TextDisabled));
+        }
+        if (ImGui::Selectable(label, isEditing || isSelected, ImGuiSelectableFlags_AllowDoubleClick, ImVec2(availWidth, 0))) {
             if (ImGui::IsMouseDoubleClicked(ImGuiMouseButton_Left)) {
                 this->celEditingMode = true;
                 this->editingCelIndex = i;
                 this->selectedOAMIndices.clear();
             }
+            else if (ImGui::GetIO().KeyCtrl) {
+                if (isSelected) selectedCelIndices.erase(selectedIt);
+                else selectedCelIndices.push_back(i);
+            }
+            else {
+                selectedCelIndices.clear();
+            }
+        }
+        if (useCount == 0) {
+            ImGui::PopStyleColor();
         }
 
         if (ImGui::IsItemHovered()) {
-            ImGui::SetTooltip("Double-click to edit '%s'", cel.name.c_str());
+            ImGui::SetTooltip("Double-click to edit '%s'\nUsed %d time(s) in %d animation(s)",
+                cel.name.c_str(), useCount, celUsage.getAnimationCount(cel.name));
         }
 
         if (ImGui::BeginPopupContextItem("##cel_context")) {
@@ -190,11 +210,21 @@ void Sofanthiel::handleAnimCels()
 
             ImGui::Separator();
 
+            if (ImGui::MenuItem(ICON_FA_MAGNIFYING_GLASS " Select Unused Cels")) {
+                selectUnusedCels();
+            }
+
             if (ImGui::MenuItem(ICON_FA_TRASH " Remove")) {
-                animationCels.erase(animationCels.begin() + i);
-                if (editingCelIndex >= static_cast<int>(animationCels.size())) {
-                    editingCelIndex = -1;
-                    celEditingMode = false;
+                removingCelIndices = { i };
+                showRemoveCelPopup = true;
+            }
+
+            if (selectedCelIndices.size() > 1) {
+                char removeSelectedLabel[64];
+                snprintf(removeSelectedLabel, sizeof(removeSelectedLabel), ICON_FA_TRASH " Remove Selected (%d)", static_cast<int>(selectedCelIndices.size()));
+                if (ImGui::MenuItem(removeSelectedLabel)) {
+                    removingCelIndices = selectedCelIndices;
+                    showRemoveCelPopup = true;
                 }
             }
 
@@ -245,6 +275,68 @@ void Sofanthiel::handleAnimCels()
     ImGui::End();
 }
 
+void Sofanthiel::handleRemoveCelPopup()
+{
+    if (!showRemoveCelPopup) {
+        return;
+    }
+
+    int referenceCount = 0;
+    for (int idx : removingCelIndices) {
+        if (idx >= 0 && idx < static_cast<int>(animationCels.size())) {
+            referenceCount += celUsage.getUseCount(animationCels[idx].name);
+        }
+    }
+
+    // nothing points at these, no point bugging the user about it
+    if (referenceCount == 0) {
+        removeAnimationCels(removingCelIndices, false);
+        removingCelIndices.clear();
+        showRemoveCelPopup = false;
+        return;
+    }
+
+    ImGui::OpenPopup("Remove Animation Cel");
+    ImVec2 center = ImGui::GetMainViewport()->GetCenter();
+    ImGui::SetNextWindowPos(center, ImGuiCond_Appearing, ImVec2(0.5f, 0.5f));
+
+    if (ImGui::BeginPopupModal("Remove Animation Cel", &showRemoveCelPopup, ImGuiWindowFlags_AlwaysAutoResize)) {
+        if (removingCelIndices.size() == 1 && removingCelIndices[0] >= 0 && removingCelIndices[0] < static_cast<int>(animationCels.size())) {
+            const std::string& celName = animationCels[removingCelIndices[0]].name;
+            ImGui::Text(ICON_FA_TRIANGLE_EXCLAMATION " '%s' is used by %d entr%s in %d animation(s).",
+                celName.c_str(), referenceCount, referenceCount == 1 ? "y" : "ies", celUsage.getAnimationCount(celName));
+        }
+        else {
+            ImGui::Text(ICON_FA_TRIANGLE_EXCLAMATION " %d selected cels are used by %d animation entries.",
+                static_cast<int>(removingCelIndices.size()), referenceCount);
+        }
+        ImGui::TextColored(ImVec4(0.7f, 0.7f, 0.75f, 1.0f), "Keeping the entries leaves them pointing at a missing cel.");
+        ImGui::Separator();
+
+        if (ImGui::Button("Remove + Entries", getScaledButtonSize(140, 0))) {
+            removeAnimationCels(removingCelIndices, true);
+            removingCelIndices.clear();
+            showRemoveCelPopup = false;
+            ImGui::CloseCurrentPopup();
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Keep Entries", getScaledButtonSize(140, 0))) {
+            removeAnimationCels(removingCelIndices, false);
+            removingCelIndices.clear();
+            showRemoveCelPopup = false;
+            ImGui::CloseCurrentPopup();
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Cancel", getScaledButtonSize(120, 0)) || ImGui::IsKeyPressed(ImGuiKey_Escape)) {
+            removingCelIndices.clear();
+            showRemoveCelPopup = false;
+            ImGui::CloseCurrentPopup();
+        }
+
+        ImGui::EndPopup();
+    }
+}
+
 void Sofanthiel::handleAnims()
 {
     ImGui::Begin("Animations", nullptr, ImGuiWindowFlags_NoCollapse);
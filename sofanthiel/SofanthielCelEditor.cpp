@@ -100,12 +100,7 @@ void Sofanthiel::handleCelPreview() {
         }
 
         if (moved) {
-            std::vector<std::pair<int, ImVec2>> beforePositions;
-            for (int idx : selectedOAMIndices) {
-                if (idx >= 0 && idx < cel.oams.size()) {
-                    beforePositions.push_back({ idx, ImVec2((float)cel.oams[idx].xPosition, (float)cel.oams[idx].yPosition) });
-                }
-            }
+            auto oamsBefore = cel.oams;
 
             for (int idx : selectedOAMIndices) {
                 if (idx >= 0 && idx < cel.oams.size()) {
@@ -120,41 +115,19 @@ void Sofanthiel::handleCelPreview() {
                 }
             }
 
-            std::vector<std::pair<int, ImVec2>> afterPositions;
-            for (int idx : selectedOAMIndices) {
-                if (idx >= 0 && idx < cel.oams.size()) {
-                    afterPositions.push_back({ idx, ImVec2((float)cel.oams[idx].xPosition, (float)cel.oams[idx].yPosition) });
-                }
-            }
-
+            // holding an arrow key shouldn't leave a hundred 1px entries in the history
             int celIdx = editingCelIndex;
-            undoManager.execute(std::make_unique<LambdaAction>(
+            undoManager.execute(std::make_unique<OAMModifyAction>(
                 "Move OAM(s)",
-                [this, celIdx, afterPositions]() {
-                    if (celIdx >= 0 && celIdx < animationCels.size()) {
-                        for (size_t i = 0; i < afterPositions.size(); ++i) {
-                            int oamIdx = afterPositions[i].first;
-                            ImVec2 pos = afterPositions[i].second;
-                            if (oamIdx >= 0 && oamIdx < (int)animationCels[celIdx].oams.size()) {
-                                animationCels[celIdx].oams[oamIdx].xPosition = (int)pos.x;
-                                animationCels[celIdx].oams[oamIdx].yPosition = (int)pos.y;
-                            }
-                        }
+                [this, celIdx]() -> std::vector<TengokuOAM>* {
+                    if (celIdx >= 0 && celIdx < static_cast<int>(animationCels.size())) {
+                        return &animationCels[celIdx].oams;
                     }
+                    return nullptr;
                 },
-                [this, celIdx, beforePositions]() {
-                    if (celIdx >= 0 && celIdx < animationCels.size()) {
-                        for (size_t i = 0; i < beforePositions.size(); ++i) {
-                            int oamIdx = beforePositions[i].first;
-                            ImVec2 pos = beforePositions[i].second;
-                            if (oamIdx >= 0 && oamIdx < (int)animationCels[celIdx].oams.size()) {
-                                animationCels[celIdx].oams[oamIdx].xPosition = (int)pos.x;
-                                animationCels[celIdx].oams[oamIdx].yPosition = (int)pos.y;
-                            }
-                        }
-                    }
-                }
-            ));
+                oamsBefore,
+                cel.oams
+            ), "move-oams:" + std::to_string(celIdx));
         }
     }
 
@@ -319,54 +292,31 @@ void Sofanthiel::handleOAMDragging(const ImVec2& origin, float offsetX, float of
             }
             else {
                 int celIdx = editingCelIndex;
-                std::vector<std::pair<int, ImVec2>> beforePositions;
-                std::vector<std::pair<int, ImVec2>> afterPositions;
+                auto oamsBefore = cel.oams;
 
+                bool changed = false;
                 for (size_t i = 0; i < selectedOAMIndices.size(); i++) {
                     int idx = selectedOAMIndices[i];
                     if (idx >= 0 && idx < cel.oams.size() && i < selectedOAMStartPositions.size()) {
-                        beforePositions.push_back({ idx, selectedOAMStartPositions[i] });
-                        afterPositions.push_back({ idx, ImVec2((float)cel.oams[idx].xPosition, (float)cel.oams[idx].yPosition) });
-                    }
-                }
-
-                bool changed = false;
-                for (size_t i = 0; i < beforePositions.size(); i++) {
-                    if (beforePositions[i].second.x != afterPositions[i].second.x ||
-                        beforePositions[i].second.y != afterPositions[i].second.y) {
-                        changed = true;
-                        break;
+                        oamsBefore[idx].xPosition = static_cast<int>(selectedOAMStartPositions[i].x);
+                        oamsBefore[idx].yPosition = static_cast<int>(selectedOAMStartPositions[i].y);
+                        changed |= oamsBefore[idx].xPosition != cel.oams[idx].xPosition ||
+                            oamsBefore[idx].yPosition != cel.oams[idx].yPosition;
                     }
                 }
 
                 if (changed) {
-                    undoManager.execute(std::make_unique<LambdaAction>(
+                    undoManager.execute(std::make_unique<OAMModifyAction>(
                         "Drag OAM(s)",
-                        [this, celIdx, afterPositions]() {
-                            if (celIdx >= 0 && celIdx < animationCels.size()) {
-                                for (size_t i = 0; i < afterPositions.size(); ++i) {
-                                    int oamIdx = afterPositions[i].first;
-                                    ImVec2 pos = afterPositions[i].second;
-                                    if (oamIdx >= 0 && oamIdx < (int)animationCels[celIdx].oams.size()) {
-                                        animationCels[celIdx].oams[oamIdx].xPosition = (int)pos.x;
-                                        animationCels[celIdx].oams[oamIdx].yPosition = (int)pos.y;
-                                    }
-                                }
+                        [this, celIdx]() -> std::vector<TengokuOAM>* {
+                            if (celIdx >= 0 && celIdx < static_cast<int>(animationCels.size())) {
+                                return &animationCels[celIdx].oams;
                             }
+                            return nullptr;
                         },
-                        [this, celIdx, beforePositions]() {
-                            if (celIdx >= 0 && celIdx < animationCels.size()) {
-                                for (size_t i = 0; i < beforePositions.size(); ++i) {
-                                    int oamIdx = beforePositions[i].first;
-                                    ImVec2 pos = beforePositions[i].second;
-                                    if (oamIdx >= 0 && oamIdx < (int)animationCels[celIdx].oams.size()) {
-                                        animationCels[celIdx].oams[oamIdx].xPosition = (int)pos.x;
-                                        animationCels[celIdx].oams[oamIdx].yPosition = (int)pos.y;
-                                    }
-                                }
-                            }
-                        }
-                    ));
+                        oamsBefore,
+                        cel.oams
+                    ), "drag-oams:" + std::to_string(celIdx));
                 }
 
                 isOAMDragging = false;
@@ -1046,7 +996,8 @@ void Sofanthiel::drawCelSpritesheetTiles(ImDrawList* drawList, const ImVec2& ori
         return;
     }
 
-    std::vector<int> usedTileIndices;
+    // one flag per tile so the lookup below doesn't scan anything
+    std::vector<uint8_t> selectedTileMask(static_cast<size_t>(tiles.getSize()), 0);
     if (editingCelIndex >= 0 && editingCelIndex < animationCels.size() && !selectedOAMIndices.empty()) {
         const AnimationCel& cel = animationCels[editingCelIndex];
 
@@ -1060,7 +1011,9 @@ void Sofanthiel::drawCelSpritesheetTiles(ImDrawList* drawList, const ImVec2& ori
                 for (int ty = 0; ty < height / 8; ty++) {
                     for (int tx = 0; tx < width / 8; tx++) {
                         int tileIdx = getTileIndexForOffset(oam, tx, ty);
-                        usedTileIndices.push_back(tileIdx);
+                        if (tileIdx >= 0 && tileIdx < tiles.getSize()) {
+                            selectedTileMask[tileIdx] = 1;
+                        }
                     }
                 }
             }
@@ -1076,7 +1029,7 @@ void Sofanthiel::drawCelSpritesheetTiles(ImDrawList* drawList, const ImVec2& ori
         float xPos = origin.x + tileX * tileSize;
         float yPos = origin.y + tileY * tileSize;
 
-        bool isUsedTile = std::find(usedTileIndices.begin(), usedTileIndices.end(), i) != usedTileIndices.end();
+        bool isUsedTile = selectedTileMask[i] != 0;
 
         if (isUsedTile) {
             drawList->AddRect(
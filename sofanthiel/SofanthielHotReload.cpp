@@ -0,0 +1,371 @@
+#include "Sofanthiel.h"
+#include "FileUtils.h"
+#include "UndoRedo.h"
+#include <unordered_map>
+#include <unordered_set>
+
+namespace {
+template <typename T>
+std::vector<std::string> collectNames(const std::vector<T>& items)
+{
+    std::vector<std::string> names;
+    names.reserve(items.size());
+    for (const auto& item : items) {
+        names.push_back(item.name);
+    }
+    return names;
+}
+
+// merge `parsed` into `items` by name, in place: matching items get the new contents, new
+// ones go at the end and whatever is named in `removedNames` is dropped. items nobody
+// mentions aren't touched, and only the span between the first and last edit gets copied
+// for `delta`. `remap` maps old indices to new ones, -1 for removed
+template <typename T, typename Assign>
+bool mergeByName(std::vector<T>& items, std::vector<T>& parsed, const std::vector<std::string>& removedNames,
+    SpliceDelta<T>& delta, std::vector<int>& remap, int& changed, int& added, int& removed, Assign assign)
+{
+    const size_t oldSize = items.size();
+    std::unordered_map<std::string, size_t> indexByName;
+    for (size_t i = 0; i < oldSize; i++) {
+        indexByName.emplace(items[i].name, i);
+    }
+
+    size_t first = oldSize;
+    size_t last = 0;
+    std::unordered_map<size_t, T*> updates;
+    std::vector<T> appended;
+    for (auto& item : parsed) {
+        auto found = indexByName.find(item.name);
+        if (found == indexByName.end()) {
+            indexByName.emplace(item.name, oldSize + appended.size());
+            appended.push_back(std::move(item));
+            added++;
+        }
+        else if (found->second >= oldSize) {
+            assign(appended[found->second - oldSize], item);
+        }
+        else if (auto pending = updates.find(found->second);
+            !undoElementsEqual(pending != updates.end() ? *pending->second : items[found->second], item)) {
+            // the same name twice in one file, the last one wins
+            updates[found->second] = &item;
+            first = std::min(first, found->second);
+            last = std::max(last, found->second + 1);
+            changed++;
+        }
+    }
+
+    std::vector<bool> keep(oldSize, true);
+    for (const auto& name : removedNames) {
+        auto found = indexByName.find(name);
+        if (found != indexByName.end() && found->second < oldSize && keep[found->second]) {
+            keep[found->second] = false;
+            first = std::min(first, found->second);
+            last = std::max(last, found->second + 1);
+            removed++;
+        }
+    }
+
+    if (changed == 0 && added == 0 && removed == 0) {
+        return false;
+    }
+    if (added > 0) {
+        last = oldSize;
+    }
+
+    std::vector<T> oldSpan(items.begin() + first, items.begin() + last);
+    for (auto& [index, from] : updates) {
+        assign(items[index], *from);
+    }
+
+    remap.resize(oldSize);
+    size_t write = first;
+    for (size_t i = 0; i < oldSize; i++) {
+        if (i < first) {
+            remap[i] = static_cast<int>(i);
+            continue;
+        }
+        remap[i] = keep[i] ? static_cast<int>(write) : -1;
+        if (keep[i]) {
+            if (write != i) items[write] = std::move(items[i]);
+            write++;
+        }
+    }
+    items.erase(items.begin() + write, items.end());
+    for (auto& item : appended) {
+        items.push_back(std::move(item));
+    }
+
+    const size_t newLast = added > 0 ? items.size() : last - removed;
+    std::vector<T> newSpan(items.begin() + first, items.begin() + newLast);
+    delta = SpliceDelta<T>::build(oldSpan, newSpan, first, items.size());
+    return true;
+}
+
+int remapIndex(const std::vector<int>& remap, int index)
+{
+    return (index >= 0 && index < static_cast<int>(remap.size())) ? remap[index] : -1;
+}
+}
+
+void Sofanthiel::watchImportedFile(const std::string& path, WatchedSourceKind kind)
+{
+    stopWatchingSource(kind);
+
+    WatchedSource& source = watchedSources[static_cast<size_t>(kind)];
+    source.path = path;
+    if (kind == WatchedSourceKind::AnimationCels) {
+        std::string text;
+        if (readTextFile(path, text)) {
+            source.celBlocks = ResourceManager::indexAnimationCelBlocks(text);
+        }
+    }
+    else if (kind == WatchedSourceKind::Animations) {
+        source.names = collectNames(animations);
+    }
+
+    fileWatcher.watch(path);
+}
+
+void Sofanthiel::stopWatchingSource(WatchedSourceKind kind)
+{
+    WatchedSource& source = watchedSources[static_cast<size_t>(kind)];
+    if (source.path.empty()) {
+        return;
+    }
+
+    bool sharedPath = false;
+    for (const auto& other : watchedSources) {
+        if (&other != &source && other.path == source.path) {
+            sharedPath = true;
+        }
+    }
+    if (!sharedPath) {
+        fileWatcher.unwatch(source.path);
+    }
+
+    source = WatchedSource();
+}
+
+void Sofanthiel::clearWatchedSources()
+{
+    fileWatcher.clear();
+    for (auto& source : watchedSources) {
+        source = WatchedSource();
+    }
+}
+
+void Sofanthiel::pollWatchedFiles()
+{
+    for (const std::string& path : fileWatcher.poll()) {
+        for (size_t kind = 0; kind < watchedSources.size(); kind++) {
+            if (watchedSources[kind].path == path) {
+                reloadWatchedSource(static_cast<WatchedSourceKind>(kind));
+            }
+        }
+    }
+}
+
+void Sofanthiel::reloadWatchedSource(WatchedSourceKind kind)
+{
+    WatchedSource& source = watchedSources[static_cast<size_t>(kind)];
+    switch (kind) {
+    case WatchedSourceKind::AnimationCels: reloadAnimationCels(source); break;
+    case WatchedSourceKind::Animations: reloadAnimations(source); break;
+    case WatchedSourceKind::Tiles: reloadTiles(source); break;
+    case WatchedSourceKind::Palettes: reloadPalettes(source); break;
+    default: break;
+    }
+}
+
+void Sofanthiel::reloadAnimationCels(WatchedSource& source)
+{
+    std::string text;
+    if (!readTextFile(source.path, text)) {
+        SDL_Log("Couldn't reload %s, leaving the cels alone", source.path.c_str());
+        return;
+    }
+
+    std::vector<CelSourceBlock> blocks = ResourceManager::indexAnimationCelBlocks(text);
+    if (blocks.empty()) {
+        // most likely caught halfway through a write, the next change will bring it back
+        SDL_Log("No cels in %s anymore, not touching anything", source.path.c_str());
+        return;
+    }
+
+    // only blocks whose bytes moved get parsed again, the rest keep whatever the editor has
+    std::unordered_map<std::string, uint64_t> previousHashes;
+    for (const auto& block : source.celBlocks) {
+        previousHashes.emplace(block.name, block.hash);
+    }
+
+    std::vector<AnimationCel> parsed;
+    std::unordered_set<std::string> presentNames;
+    size_t reparsedBlocks = 0;
+    for (const auto& block : blocks) {
+        auto previous = previousHashes.find(block.name);
+        if (previous != previousHashes.end() && previous->second == block.hash) {
+            presentNames.insert(block.name);
+            continue;
+        }
+
+        for (auto& cel : ResourceManager::parseAnimationCelBlock(text, block, source.path)) {
+            presentNames.insert(cel.name);
+            parsed.push_back(std::move(cel));
+        }
+        reparsedBlocks++;
+    }
+
+    std::vector<std::string> removedNames;
+    for (const auto& [name, hash] : previousHashes) {
+        if (!presentNames.count(name)) removedNames.push_back(name);
+    }
+    source.celBlocks = std::move(blocks);
+
+    SpliceDelta<AnimationCel> delta;
+    std::vector<int> remap;
+    int changed = 0, added = 0, removed = 0;
+    bool anyChange = mergeByName(animationCels, parsed, removedNames, delta, remap, changed, added, removed,
+        [](AnimationCel& target, AnimationCel& from) { target.oams = std::move(from.oams); });
+
+    if (!anyChange) {
+        SDL_Log("%s changed on disk but its cels didn't (%zu of %zu blocks re-parsed)",
+            source.path.c_str(), reparsedBlocks, source.celBlocks.size());
+        return;
+    }
+
+    undoManager.execute(std::make_unique<AnimationCelsAction>(
+        "Reload " + getFileName(source.path), &animationCels, std::move(delta)));
+
+    // keep pointing at the same cels, only the ones that went away lose their selection
+    int oldEditingCelIndex = editingCelIndex;
+    editingCelIndex = remapIndex(remap, editingCelIndex);
+    if (editingCelIndex < 0) {
+        if (oldEditingCelIndex >= 0) {
+            celEditingMode = false;
+        }
+        selectedOAMIndices.clear();
+    }
+    else {
+        int oamCount = static_cast<int>(animationCels[editingCelIndex].oams.size());
+        selectedOAMIndices.erase(std::remove_if(selectedOAMIndices.begin(), selectedOAMIndices.end(),
+            [oamCount](int idx) { return idx >= oamCount; }), selectedOAMIndices.end());
+    }
+
+    currentAnimationCel = remapIndex(remap, currentAnimationCel);
+
+    std::vector<int> newSelection;
+    for (int idx : selectedCelIndices) {
+        int mapped = remapIndex(remap, idx);
+        if (mapped >= 0) newSelection.push_back(mapped);
+    }
+    selectedCelIndices = std::move(newSelection);
+
+    SDL_Log("Reloaded cels from %s: %d changed, %d added, %d removed (%zu of %zu blocks re-parsed)",
+        source.path.c_str(), changed, added, removed, reparsedBlocks, source.celBlocks.size());
+}
+
+void Sofanthiel::reloadAnimations(WatchedSource& source)
+{
+    std::string text;
+    if (!readTextFile(source.path, text)) {
+        SDL_Log("Couldn't reload %s, leaving the animations alone", source.path.c_str());
+        return;
+    }
+
+    std::vector<Animation> parsed = ResourceManager::loadAnimationsFromText(text, source.path);
+    if (parsed.empty()) {
+        SDL_Log("No animations in %s anymore, not touching anything", source.path.c_str());
+        return;
+    }
+    std::vector<std::string> parsedNames = collectNames(parsed);
+    std::unordered_set<std::string> parsedNameSet(parsedNames.begin(), parsedNames.end());
+    std::vector<std::string> removedNames;
+    for (const auto& name : source.names) {
+        if (!parsedNameSet.count(name)) removedNames.push_back(name);
+    }
+    source.names = std::move(parsedNames);
+
+    // remember what the current animation looked like, the merge edits in place
+    const bool hadCurrent = currentAnimation >= 0 && currentAnimation < static_cast<int>(animations.size());
+    Animation previousCurrent = hadCurrent ? animations[currentAnimation] : Animation();
+
+    SpliceDelta<Animation> delta;
+    std::vector<int> remap;
+    int changed = 0, added = 0, removed = 0;
+    bool anyChange = mergeByName(animations, parsed, removedNames, delta, remap, changed, added, removed,
+        [](Animation& target, Animation& from) { target.entries = std::move(from.entries); });
+
+    if (!anyChange) {
+        SDL_Log("%s changed on disk but its animations didn't", source.path.c_str());
+        return;
+    }
+
+    const bool currentTouched = !hadCurrent || remapIndex(remap, currentAnimation) < 0 ||
+        !undoElementsEqual(previousCurrent, animations[remapIndex(remap, currentAnimation)]);
+
+    undoManager.execute(std::make_unique<AnimationsAction>(
+        "Reload " + getFileName(source.path), &animations, std::move(delta)));
+
+    currentAnimation = remapIndex(remap, currentAnimation);
+    if (currentAnimation < 0 && !animations.empty()) {
+        currentAnimation = 0;
+    }
+
+    if (currentTouched) {
+        timelineSelectedEntryIndices.clear();
+        timelineResizeState = TimelineResizeState();
+        timelineDragState = TimelineDragState();
+        recalculateTotalFrames();
+        currentFrame = totalFrames > 0 ? SDL_clamp(currentFrame, 0, totalFrames - 1) : 0;
+    }
+
+    SDL_Log("Reloaded animations from %s: %d changed, %d added, %d removed", source.path.c_str(), changed, added, removed);
+}
+
+void Sofanthiel::reloadTiles(WatchedSource& source)
+{
+    Tiles loaded = ResourceManager::loadTiles(source.path);
+    if (loaded.getSize() == 0) {
+        SDL_Log("No tiles in %s anymore, not touching anything", source.path.c_str());
+        return;
+    }
+    if (sameTiles(tiles, loaded)) {
+        return;
+    }
+
+    // per tile diff, so the history only keeps what actually moved
+    Tiles before = tiles;
+    tiles = std::move(loaded);
+    undoManager.execute(std::make_unique<TilesModifyAction>("Reload " + getFileName(source.path), &tiles, before, tiles));
+    SDL_Log("Reloaded %d tiles from %s", tiles.getSize(), source.path.c_str());
+}
+
+void Sofanthiel::reloadPalettes(WatchedSource& source)
+{
+    std::vector<Palette> loaded = ResourceManager::loadPalettes(source.path);
+    if (loaded.empty()) {
+        SDL_Log("No palettes in %s anymore, not touching anything", source.path.c_str());
+        return;
+    }
+    if (loaded.size() == palettes.size() && memcmp(loaded.data(), palettes.data(), loaded.size() * sizeof(Palette)) == 0) {
+        return;
+    }
+
+    std::vector<Palette> oldPalettes = palettes;
+    palettes = loaded;
+    currentPalette = SDL_clamp(currentPalette, 0, static_cast<int>(palettes.size()) - 1);
+    undoManager.execute(std::make_unique<LambdaAction>(
+        "Reload " + getFileName(source.path),
+        [this, loaded]() {
+            this->palettes = loaded;
+            this->currentPalette = SDL_clamp(this->currentPalette, 0, static_cast<int>(this->palettes.size()) - 1);
+        },
+        [this, oldPalettes]() {
+            this->palettes = oldPalettes;
+            if (!this->palettes.empty()) {
+                this->currentPalette = SDL_clamp(this->currentPalette, 0, static_cast<int>(this->palettes.size()) - 1);
+            }
+        },
+        approximateMemoryUsage(loaded) + approximateMemoryUsage(oldPalettes)));
+    SDL_Log("Reloaded %zu palettes from %s", palettes.size(), source.path.c_str());
+}
@@ -169,7 +169,8 @@ void Sofanthiel::handleColorPicker(int editPaletteIdx, int editColorIdx, float e
                 undoManager.execute(std::make_unique<LambdaAction>(
                     "Change Palette Color",
                     [this, idx, newState]() { if (idx < palettes.size()) palettes[idx] = newState; },
-                    [this, idx, oldState]() { if (idx < palettes.size()) palettes[idx] = oldState; }
+                    [this, idx, oldState]() { if (idx < palettes.size()) palettes[idx] = oldState; },
+                    sizeof(newState) + sizeof(oldState)
                 ));
             }
             paletteUndoSnapshotIndex = -1;
@@ -177,7 +178,7 @@ void Sofanthiel::handleColorPicker(int editPaletteIdx, int editColorIdx, float e
     }
 }
 
-void Sofanthiel::initializeDefaultPalettes()
+std::vector<Palette> Sofanthiel::makeDefaultPalettes()
 {
     Palette defaultPalette;
 
@@ -198,8 +199,12 @@ void Sofanthiel::initializeDefaultPalettes()
     defaultPalette.colors[14] = { 128, 0, 128, 255 };
     defaultPalette.colors[15] = { 0, 128, 128, 255 };
 
-    this->palettes.clear();
-    this->palettes.push_back(defaultPalette);
+    return { defaultPalette };
+}
+
+void Sofanthiel::initializeDefaultPalettes()
+{
+    this->palettes = makeDefaultPalettes();
 }
 
 void Sofanthiel::drawPaletteGrid(ImDrawList* drawList, ImVec2 origin, ImVec2 scaledSize)
@@ -282,7 +287,8 @@ void Sofanthiel::handlePaletteRowSelection(const ImVec2& origin)
             undoManager.execute(std::make_unique<LambdaAction>(
                 "Paste Palette Row",
                 [this, newPalettes]() { this->palettes = newPalettes; },
-                [this, oldPalettes]() { this->palettes = oldPalettes; }
+                [this, oldPalettes]() { this->palettes = oldPalettes; },
+                approximateMemoryUsage(newPalettes) + approximateMemoryUsage(oldPalettes)
             ));
         }
 
@@ -313,7 +319,8 @@ void Sofanthiel::handlePaletteRowSelection(const ImVec2& origin)
                         this->palettes = oldPalettes;
                         this->currentPalette = oldCurrentPalette;
                         this->selectedPaletteRow = oldSelectedRow;
-                    }
+                    },
+                    approximateMemoryUsage(newPalettes) + approximateMemoryUsage(oldPalettes)
                 ));
             }
         }
@@ -364,7 +371,8 @@ void Sofanthiel::handlePaletteContextMenu()
             undoManager.execute(std::make_unique<LambdaAction>(
                 "Paste Palette Row",
                 [this, newPalettes]() { this->palettes = newPalettes; },
-                [this, oldPalettes]() { this->palettes = oldPalettes; }
+                [this, oldPalettes]() { this->palettes = oldPalettes; },
+                approximateMemoryUsage(newPalettes) + approximateMemoryUsage(oldPalettes)
             ));
         }
 
@@ -392,7 +400,8 @@ void Sofanthiel::handlePaletteContextMenu()
                     this->palettes = oldPalettes;
                     this->currentPalette = oldCurrentPalette;
                     this->selectedPaletteRow = oldSelectedRow;
-                }
+                },
+                approximateMemoryUsage(newPalettes) + approximateMemoryUsage(oldPalettes)
             ));
         }
 
@@ -418,7 +427,8 @@ void Sofanthiel::handlePaletteContextMenu()
                 [this, oldPalettes, oldSelectedRow]() {
                     this->palettes = oldPalettes;
                     this->selectedPaletteRow = oldSelectedRow;
-                }
+                },
+                approximateMemoryUsage(newPalettes) + approximateMemoryUsage(oldPalettes)
             ));
         }
 
@@ -441,7 +451,8 @@ void Sofanthiel::handlePaletteContextMenu()
                 [this, oldPalettes, oldSelectedRow]() {
                     this->palettes = oldPalettes;
                     this->selectedPaletteRow = oldSelectedRow;
-                }
+                },
+                approximateMemoryUsage(newPalettes) + approximateMemoryUsage(oldPalettes)
             ));
         }
 
@@ -473,7 +484,8 @@ void Sofanthiel::handlePaletteContextMenu()
                     this->palettes = oldPalettes;
                     this->currentPalette = oldCurrentPalette;
                     this->selectedPaletteRow = oldSelectedRow;
-                }
+                },
+                approximateMemoryUsage(newPalettes) + approximateMemoryUsage(oldPalettes)
             ));
         }
 
@@ -88,7 +88,7 @@ void Sofanthiel::handlePreview()
 {
     ImGui::Begin("Preview", nullptr, ImGuiWindowFlags_NoCollapse);
 
-    float infoBarHeight = ImGui::GetFrameHeightWithSpacing() * 2 + ImGui::GetStyle().ItemSpacing.y;
+    float infoBarHeight = ImGui::GetFrameHeightWithSpacing() * 3 + ImGui::GetStyle().ItemSpacing.y;
     float contentHeight = ImMax(ImGui::GetContentRegionAvail().y - infoBarHeight, 50.0f);
 
     ImGui::BeginChild("PreviewContent", ImVec2(0, contentHeight), ImGuiChildFlags_None);
@@ -188,6 +188,29 @@ void Sofanthiel::drawPreviewInfoPanel(ViewManager& view, ImVec2 mousePosInWindow
     ImGui::SameLine();
     ImGui::SetNextItemWidth(getScaledSize(80));
     ImGui::DragFloat2("##AnimOffset", (float*)&previewAnimationOffset, 1.0f, -256.0f, 255.0f, "%.0f");
+
+    ImGui::Checkbox("GBA Refresh", &lockToGbaRefreshRate);
+    if (ImGui::IsItemHovered()) ImGui::SetTooltip("Play at the GBA's %.2f Hz instead of the timeline FPS", PlaybackClock::GBA_REFRESH_RATE);
+
+    ImGui::SameLine();
+    ImGui::SeparatorEx(ImGuiSeparatorFlags_Vertical);
+    ImGui::SameLine();
+
+    if (isPlaying && playbackClock.isRunning()) {
+        ImGui::Text("Target: %.2f fps  Measured: %.2f fps", getPlaybackFrameRate(), playbackClock.getMeasuredRate());
+        ImGui::SameLine();
+        if (playbackClock.getDroppedFrames() > 0) {
+            ImGui::TextColored(ImVec4(1.0f, 0.70f, 0.35f, 1.0f), "Dropped: %llu",
+                static_cast<unsigned long long>(playbackClock.getDroppedFrames()));
+        }
+        else {
+            ImGui::TextDisabled("Dropped: 0");
+        }
+        if (ImGui::IsItemHovered()) ImGui::SetTooltip("Frames skipped since playback started because the editor couldn't draw them in time");
+    }
+    else {
+        ImGui::TextDisabled("Target: %.2f fps", getPlaybackFrameRate());
+    }
 }
 
 void Sofanthiel::drawBackgroundTexture(ImDrawList* drawList, ImVec2 origin, ImVec2 scaledSize) {
@@ -224,23 +247,37 @@ void Sofanthiel::drawBackgroundTexture(ImDrawList* drawList, ImVec2 origin, ImVe
 }
 
 void Sofanthiel::updateAnimationPlayback() {
-    static float lastTime = (float)SDL_GetTicks() / 1000.0f;
-    float currentTime = (float)SDL_GetTicks() / 1000.0f;
-    float deltaTime = currentTime - lastTime;
-
-    if (isPlaying && deltaTime >= (1.0f / frameRate) && totalFrames != 0) {
-        currentFrame++;
-        if (currentFrame >= totalFrames) {
-            if (loopAnimation) {
-                currentFrame = 0;
-            }
-            else {
-                currentFrame = totalFrames - 1;
-                isPlaying = false;
-            }
-        }
-        lastTime = currentTime;
+    const Uint64 now = SDL_GetTicksNS();
+    if (!isPlaying || totalFrames <= 0) {
+        playbackClock.stop();
+        return;
+    }
+    if (!playbackClock.isRunning()) {
+        playbackClock.start(now);
+        return;
+    }
+
+    // after a hitch this skips ahead by however many frames should have played meanwhile
+    const uint64_t due = playbackClock.advance(now, getPlaybackFrameRate());
+    if (due == 0) {
+        return;
     }
+
+    const uint64_t nextFrame = static_cast<uint64_t>(std::max(currentFrame, 0)) + due;
+    if (nextFrame < static_cast<uint64_t>(totalFrames)) {
+        currentFrame = static_cast<int>(nextFrame);
+    }
+    else if (loopAnimation) {
+        currentFrame = static_cast<int>(nextFrame % static_cast<uint64_t>(totalFrames));
+    }
+    else {
+        currentFrame = totalFrames - 1;
+        isPlaying = false;
+    }
+}
+
+double Sofanthiel::getPlaybackFrameRate() const {
+    return lockToGbaRefreshRate ? PlaybackClock::GBA_REFRESH_RATE : static_cast<double>(frameRate);
 }
 
 void Sofanthiel::drawCurrentAnimationFrame(ImDrawList* drawList, ImVec2 origin, float zoom) {
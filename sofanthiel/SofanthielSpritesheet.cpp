@@ -51,6 +51,9 @@ void Sofanthiel::handleSpritesheet()
     drawSpritesheetInfoPanel(spritesheetView, mousePosInWindow, baseSize, origin);
 
     ImGui::EndChild();
+
+    handleTileDeleteWarningPopup();
+
     ImGui::End();
 }
 
@@ -68,6 +71,10 @@ void Sofanthiel::drawSpritesheetContent(const ImVec2& origin)
 
     drawSpritesheetTiles(drawList, origin);
 
+    if (showUnusedTiles) {
+        drawUnusedTilesOverlay(drawList, origin);
+    }
+
     drawList->AddRect(
         origin,
         ImVec2(origin.x + scaledSize.x, origin.y + scaledSize.y),
@@ -112,6 +119,9 @@ void Sofanthiel::drawSingleTile(ImDrawList* drawList, float xPos, float yPos, in
     float pixelSize = spritesheetView.zoom;
 
     int safePalette = SDL_clamp(currentPalette, 0, static_cast<int>(palettes.size()) - 1);
+    if (useTilePalettes && tileIndex < static_cast<int>(tilePalettes.size()) && tilePalettes[tileIndex] < palettes.size()) {
+        safePalette = tilePalettes[tileIndex];
+    }
 
     for (int y = 0; y < 8; y++) {
         for (int x = 0; x < 8; x++) {
@@ -130,6 +140,90 @@ void Sofanthiel::drawSingleTile(ImDrawList* drawList, float xPos, float yPos, in
     }
 }
 
+void Sofanthiel::drawUnusedTilesOverlay(ImDrawList* drawList, const ImVec2& origin)
+{
+    if (tiles.getSize() <= 0 || palettes.empty()) return;
+
+    const int tilesPerRow = SDL_max(1, spritesheetTilesPerRow);
+    const float tileSize = 8.0f * spritesheetView.zoom;
+
+    for (int i = 0; i < tiles.getSize(); i++) {
+        if (tileUsage.isUsed(i)) continue;
+
+        ImVec2 p0(origin.x + (i % tilesPerRow) * tileSize, origin.y + (i / tilesPerRow) * tileSize);
+        ImVec2 p1(p0.x + tileSize, p0.y + tileSize);
+
+        drawList->AddRectFilled(p0, p1, IM_COL32(255, 60, 60, 70));
+        drawList->AddLine(p0, p1, IM_COL32(255, 60, 60, 120));
+    }
+}
+
+void Sofanthiel::requestTileDelete(const std::vector<int>& affectedTiles, std::function<void()> deleteAction)
+{
+    int usedTiles = 0;
+    int oamRefs = 0;
+    std::vector<bool> seenCels(animationCels.size(), false);
+    int celCount = 0;
+
+    for (int tileIdx : affectedTiles) {
+        const auto& refs = tileUsage.getReferences(tileIdx);
+        if (refs.empty()) continue;
+
+        usedTiles++;
+        oamRefs += static_cast<int>(refs.size());
+        for (const auto& ref : refs) {
+            if (ref.celIndex >= 0 && ref.celIndex < static_cast<int>(seenCels.size()) && !seenCels[ref.celIndex]) {
+                seenCels[ref.celIndex] = true;
+                celCount++;
+            }
+        }
+    }
+
+    if (usedTiles == 0) {
+        deleteAction();
+        return;
+    }
+
+    ssTileDeleteUsedTiles = usedTiles;
+    ssTileDeleteOAMRefs = oamRefs;
+    ssTileDeleteCelCount = celCount;
+    ssPendingTileDelete = std::move(deleteAction);
+    ssTileDeletePopupPendingOpen = true;
+}
+
+void Sofanthiel::handleTileDeleteWarningPopup()
+{
+    if (ssTileDeletePopupPendingOpen) {
+        ImGui::OpenPopup("Delete Used Tiles?");
+        ssTileDeletePopupPendingOpen = false;
+    }
+
+    ImVec2 center = ImGui::GetMainViewport()->GetCenter();
+    ImGui::SetNextWindowPos(center, ImGuiCond_Appearing, ImVec2(0.5f, 0.5f));
+
+    if (ImGui::BeginPopupModal("Delete Used Tiles?", nullptr, ImGuiWindowFlags_AlwaysAutoResize)) {
+        ImGui::Text(ICON_FA_TRIANGLE_EXCLAMATION " %d tile(s) are still used by %d OAM(s) across %d cel(s).",
+            ssTileDeleteUsedTiles, ssTileDeleteOAMRefs, ssTileDeleteCelCount);
+        ImGui::TextColored(ImVec4(0.7f, 0.7f, 0.75f, 1.0f), "Those OAMs will end up pointing at blank or missing tiles.");
+        ImGui::Separator();
+
+        if (ImGui::Button("Delete Anyway", getScaledButtonSize(140, 0))) {
+            if (ssPendingTileDelete) {
+                ssPendingTileDelete();
+            }
+            ssPendingTileDelete = nullptr;
+            ImGui::CloseCurrentPopup();
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Cancel", getScaledButtonSize(140, 0)) || ImGui::IsKeyPressed(ImGuiKey_Escape)) {
+            ssPendingTileDelete = nullptr;
+            ImGui::CloseCurrentPopup();
+        }
+
+        ImGui::EndPopup();
+    }
+}
+
 void Sofanthiel::drawSpritesheetInfoPanel(ViewManager& view, ImVec2 mousePosInWindow, ImVec2 contentSize, const ImVec2& origin)
 {
     const int tilesPerRow = SDL_max(1, spritesheetTilesPerRow);
@@ -141,6 +235,14 @@ void Sofanthiel::drawSpritesheetInfoPanel(ViewManager& view, ImVec2 mousePosInWi
     ImGui::Checkbox("Pal BG", &usePaletteBGColor);
     if (ImGui::IsItemHovered()) ImGui::SetTooltip("Use first palette color as background");
     ImGui::SameLine();
+    ImGui::Checkbox("Unused", &showUnusedTiles);
+    if (ImGui::IsItemHovered()) ImGui::SetTooltip("Highlight tiles no cel is using (%d unused)", tileUsage.getUnusedTileCount());
+    if (!tilePalettes.empty()) {
+        ImGui::SameLine();
+        ImGui::Checkbox("Tile Pal", &useTilePalettes);
+        if (ImGui::IsItemHovered()) ImGui::SetTooltip("Draw each tile with the palette it was converted with");
+    }
+    ImGui::SameLine();
     ImGui::Text("Pal:");
     ImGui::SameLine();
     ImGui::SetNextItemWidth(getScaledSize(55));
@@ -158,7 +260,7 @@ void Sofanthiel::drawSpritesheetInfoPanel(ViewManager& view, ImVec2 mousePosInWi
     ImGui::SameLine();
     ImGui::SetNextItemWidth(getScaledSize(80));
     if (ImGui::InputInt("##SpritesheetTilesPerRow", &spritesheetTilesPerRow, 1, 8)) {
-        spritesheetTilesPerRow = SDL_clamp(spritesheetTilesPerRow, 1, 256);
+        spritesheetTilesPerRow = SDL_max(1, spritesheetTilesPerRow);
         if (ssHasSelection || ssIsSelecting) {
             ssHasSelection = false;
             ssIsSelecting = false;
@@ -180,38 +282,28 @@ void Sofanthiel::drawSpritesheetInfoPanel(ViewManager& view, ImVec2 mousePosInWi
         Tiles oldTiles = tiles;
         int oldSize = tiles.getSize();
         tiles.ensureSize(oldSize + tilesPerRow);
-        Tiles newTiles = tiles;
-
-        undoManager.execute(std::make_unique<LambdaAction>(
-            "Add Spritesheet Row",
-            [this, newTiles]() {
-                this->tiles = newTiles;
-            },
-            [this, oldTiles]() {
-                this->tiles = oldTiles;
-            }
-        ));
+
+        undoManager.execute(std::make_unique<TilesModifyAction>("Add Spritesheet Row", &tiles, oldTiles, tiles));
     }
 
     ImGui::SameLine();
     bool canRemoveRow = tiles.getSize() > 0;
     if (!canRemoveRow) ImGui::BeginDisabled();
     if (ImGui::Button(ICON_FA_MINUS " Row")) {
-        Tiles oldTiles = tiles;
         int oldSize = tiles.getSize();
         int newSize = SDL_max(0, oldSize - tilesPerRow);
-        tiles.resize(newSize);
-        Tiles newTiles = tiles;
-
-        undoManager.execute(std::make_unique<LambdaAction>(
-            "Remove Spritesheet Row",
-            [this, newTiles]() {
-                this->tiles = newTiles;
-            },
-            [this, oldTiles]() {
-                this->tiles = oldTiles;
-            }
-        ));
+
+        std::vector<int> removedTiles;
+        for (int i = newSize; i < oldSize; i++) {
+            removedTiles.push_back(i);
+        }
+
+        requestTileDelete(removedTiles, [this, newSize]() {
+            Tiles oldTiles = tiles;
+            tiles.resize(newSize);
+
+            undoManager.execute(std::make_unique<TilesModifyAction>("Remove Spritesheet Row", &tiles, oldTiles, tiles));
+        });
     }
     if (!canRemoveRow) ImGui::EndDisabled();
 
@@ -231,8 +323,9 @@ void Sofanthiel::drawSpritesheetInfoPanel(ViewManager& view, ImVec2 mousePosInWi
     int tileIndex = tileY * tilesPerRow + tileX;
     if (tileIndex >= 0 && tileIndex < tiles.getSize()) {
         int byteOffset = tileIndex * 32;
-        char tileInfo[128];
-        snprintf(tileInfo, sizeof(tileInfo), " Tile: %d (0x%X)  4bpp offset: 0x%X", tileIndex, tileIndex, byteOffset);
+        char tileInfo[160];
+        snprintf(tileInfo, sizeof(tileInfo), " Tile: %d (0x%X)  4bpp offset: 0x%X  Used by: %d OAM(s)",
+            tileIndex, tileIndex, byteOffset, tileUsage.getUseCount(tileIndex));
         ImGui::SameLine();
         ImGui::TextUnformatted(tileInfo);
     }
@@ -329,28 +422,25 @@ void Sofanthiel::handleSpritesheetSelection(const ImVec2& origin)
     }
 
     if (InputManager::isPressed(InputManager::Delete)) {
-        Tiles oldTiles = tiles;
-
-        TileData emptyTile = {};
+        std::vector<int> clearedTiles;
         for (int y = ssSelTileY0; y <= ssSelTileY1; ++y) {
             for (int x = ssSelTileX0; x <= ssSelTileX1; ++x) {
-                int tileIndex = y * tilesPerRow + x;
+                clearedTiles.push_back(y * tilesPerRow + x);
+            }
+        }
+
+        requestTileDelete(clearedTiles, [this, clearedTiles]() {
+            Tiles oldTiles = tiles;
+
+            TileData emptyTile = {};
+            for (int tileIndex : clearedTiles) {
                 if (tileIndex >= 0 && tileIndex < tiles.getSize()) {
                     tiles.setTile(tileIndex, emptyTile);
                 }
             }
-        }
 
-        Tiles newTiles = tiles;
-        undoManager.execute(std::make_unique<LambdaAction>(
-            "Clear Tile Selection",
-            [this, newTiles]() {
-                this->tiles = newTiles;
-            },
-            [this, oldTiles]() {
-                this->tiles = oldTiles;
-            }
-        ));
+            undoManager.execute(std::make_unique<TilesModifyAction>("Clear Tile Selection", &tiles, oldTiles, tiles));
+        });
     }
 
     if (InputManager::isPressed(InputManager::Copy)) {
@@ -410,16 +500,7 @@ void Sofanthiel::handleSpritesheetSelection(const ImVec2& origin)
             }
         }
 
-        Tiles newTiles = tiles;
-        undoManager.execute(std::make_unique<LambdaAction>(
-            "Paste Tile Selection",
-            [this, newTiles]() {
-                this->tiles = newTiles;
-            },
-            [this, oldTiles]() {
-                this->tiles = oldTiles;
-            }
-        ));
+        undoManager.execute(std::make_unique<TilesModifyAction>("Paste Tile Selection", &tiles, oldTiles, tiles));
     }
 }
 
@@ -525,28 +606,25 @@ void Sofanthiel::handleSpritesheetContextMenu(const ImVec2& origin)
     };
 
     auto clearSelectionTiles = [this, tilesPerRow]() {
-        Tiles oldTiles = tiles;
-
-        TileData emptyTile = {};
+        std::vector<int> clearedTiles;
         for (int y = ssSelTileY0; y <= ssSelTileY1; ++y) {
             for (int x = ssSelTileX0; x <= ssSelTileX1; ++x) {
-                int tileIndex = y * tilesPerRow + x;
+                clearedTiles.push_back(y * tilesPerRow + x);
+            }
+        }
+
+        requestTileDelete(clearedTiles, [this, clearedTiles]() {
+            Tiles oldTiles = tiles;
+
+            TileData emptyTile = {};
+            for (int tileIndex : clearedTiles) {
                 if (tileIndex >= 0 && tileIndex < tiles.getSize()) {
                     tiles.setTile(tileIndex, emptyTile);
                 }
             }
-        }
 
-        Tiles newTiles = tiles;
-        undoManager.execute(std::make_unique<LambdaAction>(
-            "Clear Tile Selection",
-            [this, newTiles]() {
-                this->tiles = newTiles;
-            },
-            [this, oldTiles]() {
-                this->tiles = oldTiles;
-            }
-        ));
+            undoManager.execute(std::make_unique<TilesModifyAction>("Clear Tile Selection", &tiles, oldTiles, tiles));
+        });
     };
 
     auto pasteClipboardToSelection = [this, tilesPerRow]() {
@@ -579,16 +657,7 @@ void Sofanthiel::handleSpritesheetContextMenu(const ImVec2& origin)
             }
         }
 
-        Tiles newTiles = tiles;
-        undoManager.execute(std::make_unique<LambdaAction>(
-            "Paste Tile Selection",
-            [this, newTiles]() {
-                this->tiles = newTiles;
-            },
-            [this, oldTiles]() {
-                this->tiles = oldTiles;
-            }
-        ));
+        undoManager.execute(std::make_unique<TilesModifyAction>("Paste Tile Selection", &tiles, oldTiles, tiles));
     };
 
     if (ImGui::IsWindowHovered() && ImGui::IsMouseClicked(ImGuiMouseButton_Right)) {
@@ -383,7 +383,16 @@ void Sofanthiel::drawTimelineControls()
 
     ImGui::SameLine(ImGui::GetWindowWidth() - rightWidth - ImGui::GetStyle().WindowPadding.x);
     ImGui::SetNextItemWidth(sliderWidth);
-    ImGui::SliderFloat("FPS", &frameRate, 1.0f, 120.0f, "%.0f");
+    if (lockToGbaRefreshRate) {
+        // the slider keeps the project's own rate, it just isn't the one playing
+        float gbaRate = static_cast<float>(PlaybackClock::GBA_REFRESH_RATE);
+        ImGui::BeginDisabled();
+        ImGui::SliderFloat("FPS", &gbaRate, 1.0f, 120.0f, "%.2f");
+        ImGui::EndDisabled();
+    }
+    else {
+        ImGui::SliderFloat("FPS", &frameRate, 1.0f, 120.0f, "%.0f");
+    }
     ImGui::SameLine();
     ImGui::Checkbox("Loop", &loopAnimation);
 
@@ -580,15 +589,17 @@ void Sofanthiel::drawTimelineContent(Animation& anim, float timelineStartX, floa
                 }
             }
 
-            undoManager.execute(std::make_unique<LambdaAction>(
+            int animIdx = currentAnimation;
+            undoManager.execute(std::make_unique<AnimationEntriesAction>(
                 "Delete Timeline Entries",
-                []{},
-                [this, oldEntries, animIdx = currentAnimation](){
-                    if (animIdx >= 0 && animIdx < animations.size())
-                        animations[animIdx].entries = oldEntries;
-                    recalculateTotalFrames();
-                }
-            ));
+                [this, animIdx]() -> std::vector<AnimationEntry>* {
+                    if (animIdx >= 0 && animIdx < static_cast<int>(animations.size())) {
+                        return &animations[animIdx].entries;
+                    }
+                    return nullptr;
+                },
+                oldEntries,
+                anim.entries));
 
             timelineSelectedEntryIndices.clear();
 
@@ -895,6 +906,7 @@ void Sofanthiel::handleTimelineEntryEdges(ImDrawList* drawList, const ImVec2& wi
 
         if (ImGui::IsMouseClicked(ImGuiMouseButton_Left) && !resizeState.isResizing) {
             resizeState.isResizing = true;
+            resizeState.hasEntriesBefore = false;
             resizeState.resizingEntryIdx = entryIdx;
             resizeState.resizingRight = isHoveringRightEdge;
             resizeState.resizeStartPos = mousePos.x;
@@ -997,6 +1009,11 @@ void Sofanthiel::handleTimelineResizing(Animation& anim, TimelineResizeState& re
 
         ImGui::SetMouseCursor(ImGuiMouseCursor_ResizeEW);
 
+        if (!resizeState.hasEntriesBefore) {
+            resizeState.entriesBefore = anim.entries;
+            resizeState.hasEntriesBefore = true;
+        }
+
         if (ImGui::IsMouseDown(ImGuiMouseButton_Left)) {
             AnimationEntry& entry = anim.entries[resizeState.resizingEntryIdx];
             float dragDelta = ImGui::GetMousePos().x - resizeState.resizeStartPos;
@@ -1023,8 +1040,31 @@ void Sofanthiel::handleTimelineResizing(Animation& anim, TimelineResizeState& re
             recalculateTotalFrames();
         }
         else {
+            bool changed = !std::equal(anim.entries.begin(), anim.entries.end(),
+                resizeState.entriesBefore.begin(), resizeState.entriesBefore.end(),
+                [](const AnimationEntry& lhs, const AnimationEntry& rhs) { return undoElementsEqual(lhs, rhs); });
+
+            if (changed) {
+                // a few quick tweaks of the same edge end up as one history entry
+                int animIdx = currentAnimation;
+                char mergeKey[64];
+                snprintf(mergeKey, sizeof(mergeKey), "resize-entry:%d:%d:%d", animIdx, resizeState.resizingEntryIdx, resizeState.resizingRight ? 1 : 0);
+                undoManager.execute(std::make_unique<AnimationEntriesAction>(
+                    "Resize Timeline Entry",
+                    [this, animIdx]() -> std::vector<AnimationEntry>* {
+                        if (animIdx >= 0 && animIdx < static_cast<int>(animations.size())) {
+                            return &animations[animIdx].entries;
+                        }
+                        return nullptr;
+                    },
+                    resizeState.entriesBefore,
+                    anim.entries), mergeKey);
+            }
+
             resizeState.isResizing = false;
             resizeState.resizingEntryIdx = -1;
+            resizeState.hasEntriesBefore = false;
+            resizeState.entriesBefore.clear();
         }
     }
 }
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <charconv>
+#include <cstddef>
+#include <string_view>
+
+// tiny helpers for the hand written C-ish parsers. everything works on string_views into
+// one buffer, nothing here allocates
+
+// hands out one line at a time (without the '\n', a '\r' stays like std::getline leaves it)
+class LineScanner {
+public:
+	// firstLine is the line number `text` starts at, for scanning a slice of a bigger file
+	explicit LineScanner(std::string_view text, int firstLine = 1) : text(text), lineNumber(firstLine - 1) {}
+
+	bool next(std::string_view& line)
+	{
+		if (pos >= text.size()) {
+			return false;
+		}
+
+		size_t end = text.find('\n', pos);
+		if (end == std::string_view::npos) {
+			end = text.size();
+		}
+
+		line = text.substr(pos, end - pos);
+		pos = end + 1;
+		lineNumber++;
+		return true;
+	}
+
+	// 1 based, for diagnostics
+	int getLineNumber() const { return lineNumber; }
+
+private:
+	std::string_view text;
+	size_t pos = 0;
+	int lineNumber = 0;
+};
+
+inline bool isTextSpace(char c)
+{
+	// same set as isspace() in the C locale
+	return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r';
+}
+
+inline bool isHexDigit(char c)
+{
+	return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+}
+
+inline bool containsText(std::string_view haystack, std::string_view needle)
+{
+	return haystack.find(needle) != std::string_view::npos;
+}
+
+inline std::string_view trimText(std::string_view text, std::string_view chars = " \t")
+{
+	size_t start = text.find_first_not_of(chars);
+	if (start == std::string_view::npos) {
+		return {};
+	}
+	size_t end = text.find_last_not_of(chars);
+	return text.substr(start, end - start + 1);
+}
+
+// whitespace separated tokens, like `iss >> token`
+class TokenScanner {
+public:
+	explicit TokenScanner(std::string_view text) : text(text) {}
+
+	bool next(std::string_view& token)
+	{
+		while (pos < text.size() && isTextSpace(text[pos])) pos++;
+		if (pos >= text.size()) {
+			return false;
+		}
+
+		size_t start = pos;
+		while (pos < text.size() && !isTextSpace(text[pos])) pos++;
+		token = text.substr(start, pos - start);
+		tokenOffset = start;
+		return true;
+	}
+
+	size_t getTokenOffset() const { return tokenOffset; }
+
+private:
+	std::string_view text;
+	size_t pos = 0;
+	size_t tokenOffset = 0;
+};
+
+// strtoul(token, 16) rules: optional 0x prefix, stops at the first non hex char, a bare
+// "0x" reads as the leading 0. false where stoul would throw (no digits, overflow)
+template <typename T>
+inline bool parseHexPrefix(std::string_view token, T& out)
+{
+	size_t pos = 0;
+	if (token.size() >= 3 && token[0] == '0' && (token[1] == 'x' || token[1] == 'X') && isHexDigit(token[2])) {
+		pos = 2;
+	}
+
+	auto result = std::from_chars(token.data() + pos, token.data() + token.size(), out, 16);
+	return result.ec == std::errc();
+}
+
+// stoi rules: leading whitespace, optional sign, then at least one digit
+inline bool parseDecimalPrefix(std::string_view text, int& out)
+{
+	size_t pos = 0;
+	while (pos < text.size() && isTextSpace(text[pos])) pos++;
+	if (pos < text.size() && text[pos] == '+') {
+		pos++;
+		if (pos >= text.size() || text[pos] < '0' || text[pos] > '9') return false;
+	}
+
+	auto result = std::from_chars(text.data() + pos, text.data() + text.size(), out, 10);
+	return result.ec == std::errc();
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+// append-only text builder for the exporters. numbers go through to_chars and a hex pair
+// table instead of stream manipulators, output matches what `<< std::setw(n) << std::setfill('0')`
+// (plus std::hex, lowercase) used to produce
+
+class TextWriter {
+public:
+	std::string text;
+
+	void reserve(size_t bytes) { text.reserve(bytes); }
+
+	void put(std::string_view str) { text.append(str.data(), str.size()); }
+	void put(char c) { text.push_back(c); }
+
+	// decimal, zero padded up to minWidth
+	template <typename T>
+	void putDecimal(T value, int minWidth = 0)
+	{
+		static_assert(std::is_integral_v<T>, "putDecimal wants an integer");
+		char buffer[24];
+		auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+		putPadded(buffer, result.ptr, minWidth);
+	}
+
+	// lowercase hex without 0x, zero padded up to minDigits
+	void putHex(uint32_t value, int minDigits = 0)
+	{
+		char buffer[8];
+		char* end = buffer + sizeof(buffer);
+		char* start = end;
+		do {
+			const char* pair = hexPairs() + (value & 0xFF) * 2;
+			*--start = pair[1];
+			*--start = pair[0];
+			value >>= 8;
+		} while (value != 0);
+
+		// the pair table always hands out two digits, drop the leading zero of an odd count
+		if (*start == '0' && end - start > 1) start++;
+		putPadded(start, end, minDigits);
+	}
+
+	// same digits as a default-formatted ostream (%g, 6 significant digits)
+	void putFloat(float value)
+	{
+		char buffer[32];
+		auto result = std::to_chars(buffer, buffer + sizeof(buffer), value, std::chars_format::general, 6);
+		text.append(buffer, result.ptr);
+	}
+
+private:
+	void putPadded(const char* start, const char* end, int minWidth)
+	{
+		const int length = static_cast<int>(end - start);
+		if (length < minWidth) {
+			text.append(static_cast<size_t>(minWidth - length), '0');
+		}
+		text.append(start, end);
+	}
+
+	static const char* hexPairs()
+	{
+		static const struct Table {
+			char chars[512];
+			Table()
+			{
+				const char* digits = "0123456789abcdef";
+				for (int i = 0; i < 256; i++) {
+					chars[i * 2] = digits[i >> 4];
+					chars[i * 2 + 1] = digits[i & 0x0F];
+				}
+			}
+		} table;
+		return table.chars;
+	}
+};
@@ -0,0 +1,355 @@
+#include "TileQuantizer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+
+#include "JobSystem.h"
+
+namespace {
+
+constexpr int kColorsPerPalette = 15; // slot 0 is transparency
+constexpr int kMaxIterations = 8;
+constexpr uint16_t kTransparent = 0x8000;
+
+struct WeightedColor {
+	uint16_t color; // gba BGR555
+	uint32_t count;
+};
+
+struct TileColors {
+	uint16_t pixels[64]; // BGR555, or kTransparent
+	std::vector<WeightedColor> colors; // distinct opaque ones
+};
+
+struct ClusterPalette {
+	int count = 0;
+	uint16_t colors[kColorsPerPalette] = {};
+};
+
+inline int channel(uint16_t color, int shift)
+{
+	return (color >> shift) & 0x1F;
+}
+
+inline int colorDistance(uint16_t a, uint16_t b)
+{
+	const int dr = channel(a, 0) - channel(b, 0);
+	const int dg = channel(a, 5) - channel(b, 5);
+	const int db = channel(a, 10) - channel(b, 10);
+	return dr * dr + dg * dg + db * db;
+}
+
+inline int nearestIndex(const ClusterPalette& palette, uint16_t color)
+{
+	int bestIndex = 0;
+	int bestDistance = INT_MAX;
+	for (int i = 0; i < palette.count; i++) {
+		const int distance = colorDistance(color, palette.colors[i]);
+		if (distance < bestDistance) {
+			bestDistance = distance;
+			bestIndex = i;
+		}
+	}
+	return bestIndex;
+}
+
+// squared error of drawing a tile with a palette. gives up once it passes `bound`, the
+// caller only cares whether it beats what it already has
+uint64_t tileCost(const TileColors& tile, const ClusterPalette& palette, uint64_t bound = UINT64_MAX)
+{
+	uint64_t cost = 0;
+	for (const WeightedColor& entry : tile.colors) {
+		int bestDistance = INT_MAX;
+		for (int i = 0; i < palette.count && bestDistance > 0; i++) {
+			bestDistance = std::min(bestDistance, colorDistance(entry.color, palette.colors[i]));
+		}
+		cost += static_cast<uint64_t>(bestDistance) * entry.count;
+		if (cost >= bound) break;
+	}
+	return cost;
+}
+
+// median cut down to `maxColors`. the box with the most weighted variance is split at the
+// weighted median of its widest channel, each box ends up as its weighted mean
+ClusterPalette medianCut(std::vector<WeightedColor> colors, int maxColors)
+{
+	ClusterPalette palette;
+	if (static_cast<int>(colors.size()) <= maxColors) {
+		for (const WeightedColor& entry : colors) {
+			palette.colors[palette.count++] = entry.color;
+		}
+		return palette;
+	}
+
+	struct Box {
+		size_t begin, end;
+		int splitShift;
+		double score; // weighted variance along splitShift, 0 when it can't split
+	};
+
+	auto measure = [&](size_t begin, size_t end) {
+		Box box = { begin, end, 0, 0.0 };
+		if (end - begin < 2) return box;
+
+		for (int shift = 0; shift <= 10; shift += 5) {
+			double weight = 0.0, sum = 0.0, sumSquares = 0.0;
+			for (size_t i = begin; i < end; i++) {
+				const double value = channel(colors[i].color, shift);
+				weight += colors[i].count;
+				sum += value * colors[i].count;
+				sumSquares += value * value * colors[i].count;
+			}
+			const double variance = sumSquares - sum * sum / weight;
+			if (variance > box.score) {
+				box.score = variance;
+				box.splitShift = shift;
+			}
+		}
+		return box;
+	};
+
+	std::vector<Box> boxes = { measure(0, colors.size()) };
+	while (static_cast<int>(boxes.size()) < maxColors) {
+		auto widest = std::max_element(boxes.begin(), boxes.end(),
+			[](const Box& a, const Box& b) { return a.score < b.score; });
+		if (widest->score <= 0.0) break;
+
+		const Box box = *widest;
+		std::sort(colors.begin() + box.begin, colors.begin() + box.end,
+			[shift = box.splitShift](const WeightedColor& a, const WeightedColor& b) {
+				return channel(a.color, shift) < channel(b.color, shift);
+			});
+
+		uint64_t total = 0;
+		for (size_t i = box.begin; i < box.end; i++) total += colors[i].count;
+
+		size_t split = box.begin + 1;
+		uint64_t running = colors[box.begin].count;
+		while (split < box.end - 1 && running * 2 < total) {
+			running += colors[split++].count;
+		}
+
+		*widest = measure(box.begin, split);
+		boxes.push_back(measure(split, box.end));
+	}
+
+	for (const Box& box : boxes) {
+		uint64_t weight = 0, r = 0, g = 0, b = 0;
+		for (size_t i = box.begin; i < box.end; i++) {
+			weight += colors[i].count;
+			r += static_cast<uint64_t>(channel(colors[i].color, 0)) * colors[i].count;
+			g += static_cast<uint64_t>(channel(colors[i].color, 5)) * colors[i].count;
+			b += static_cast<uint64_t>(channel(colors[i].color, 10)) * colors[i].count;
+		}
+		auto average = [weight](uint64_t sum) { return static_cast<uint16_t>((sum + weight / 2) / weight); };
+		palette.colors[palette.count++] = static_cast<uint16_t>(average(r) | (average(g) << 5) | (average(b) << 10));
+	}
+	return palette;
+}
+
+// every color the tiles in `members` use, weighted by pixel count
+std::vector<WeightedColor> gatherColors(const std::vector<TileColors>& tiles, const std::vector<int>& members)
+{
+	std::vector<uint32_t> counts(32768, 0);
+	for (int tileIdx : members) {
+		for (const WeightedColor& entry : tiles[tileIdx].colors) {
+			counts[entry.color] += entry.count;
+		}
+	}
+
+	std::vector<WeightedColor> colors;
+	for (uint32_t color = 0; color < counts.size(); color++) {
+		if (counts[color] != 0) colors.push_back({ static_cast<uint16_t>(color), counts[color] });
+	}
+	return colors;
+}
+
+}
+
+TileQuantizeResult quantizeTiles(const uint8_t* rgba, int width, int height, int pitch, int maxPalettes)
+{
+	auto startTime = std::chrono::steady_clock::now();
+	TileQuantizeResult result;
+
+	const int tilesPerRow = (width + 7) / 8;
+	const int tileCount = tilesPerRow * ((height + 7) / 8);
+	maxPalettes = std::clamp(maxPalettes, 1, 16);
+	if (tileCount <= 0) return result;
+
+	auto toColor = [](const uint8_t* pixel) {
+		return static_cast<uint16_t>((pixel[0] >> 3) | ((pixel[1] >> 3) << 5) | ((pixel[2] >> 3) << 10));
+	};
+
+	bool hasAlpha = false;
+	for (int y = 0; y < height && !hasAlpha; y++) {
+		const uint8_t* row = rgba + static_cast<size_t>(y) * pitch;
+		for (int x = 0; x < width; x++) {
+			if (row[x * 4 + 3] < 128) {
+				hasAlpha = true;
+				break;
+			}
+		}
+	}
+	const uint16_t backgroundColor = hasAlpha ? 0 : toColor(rgba);
+
+	std::vector<TileColors> tiles(tileCount);
+	WorkerPool::shared().parallelFor(tiles.size(), [&](size_t tileIdx) {
+		TileColors& tile = tiles[tileIdx];
+		const int originX = static_cast<int>(tileIdx % tilesPerRow) * 8;
+		const int originY = static_cast<int>(tileIdx / tilesPerRow) * 8;
+
+		uint16_t opaque[64];
+		int opaqueCount = 0;
+		const int tileWidth = std::min(8, width - originX);
+		const int tileHeight = std::min(8, height - originY);
+		std::fill(std::begin(tile.pixels), std::end(tile.pixels), kTransparent);
+		for (int y = 0; y < tileHeight; y++) {
+			const uint8_t* row = rgba + static_cast<size_t>(originY + y) * pitch + originX * 4;
+			for (int x = 0; x < tileWidth; x++) {
+				const uint8_t* pixel = row + x * 4;
+				const uint16_t color = toColor(pixel);
+				const bool transparent = hasAlpha ? pixel[3] < 128 : color == backgroundColor;
+				tile.pixels[y * 8 + x] = transparent ? kTransparent : color;
+				if (!transparent) opaque[opaqueCount++] = color;
+			}
+		}
+
+		std::sort(opaque, opaque + opaqueCount);
+		for (int i = 0; i < opaqueCount; i++) {
+			if (tile.colors.empty() || tile.colors.back().color != opaque[i]) {
+				tile.colors.push_back({ opaque[i], 0 });
+			}
+			tile.colors.back().count++;
+		}
+	});
+
+	std::vector<int> activeTiles;
+	for (int i = 0; i < tileCount; i++) {
+		if (!tiles[i].colors.empty()) activeTiles.push_back(i);
+	}
+
+	const std::vector<WeightedColor> imageColors = gatherColors(tiles, activeTiles);
+	result.sourceColors = static_cast<int>(imageColors.size());
+
+	// seeding: start from the most colorful tile, then keep adding a palette made from
+	// whichever tile the palettes so far draw worst, until none is off or we run out
+	std::vector<ClusterPalette> palettes;
+	std::vector<int> assignment(tileCount, 0);
+	if (static_cast<int>(imageColors.size()) <= kColorsPerPalette) {
+		palettes.push_back(medianCut(imageColors, kColorsPerPalette));
+	} else {
+		int seed = activeTiles.front();
+		for (int tileIdx : activeTiles) {
+			if (tiles[tileIdx].colors.size() > tiles[seed].colors.size()) seed = tileIdx;
+		}
+
+		std::vector<uint64_t> bestCost(tileCount, UINT64_MAX);
+		while (true) {
+			const int paletteIdx = static_cast<int>(palettes.size());
+			palettes.push_back(medianCut(tiles[seed].colors, kColorsPerPalette));
+
+			WorkerPool::shared().parallelFor(activeTiles.size(), [&](size_t i) {
+				const int tileIdx = activeTiles[i];
+				const uint64_t cost = tileCost(tiles[tileIdx], palettes.back(), bestCost[tileIdx]);
+				if (cost < bestCost[tileIdx]) {
+					bestCost[tileIdx] = cost;
+					assignment[tileIdx] = paletteIdx;
+				}
+			});
+
+			if (static_cast<int>(palettes.size()) >= maxPalettes) break;
+
+			seed = activeTiles.front();
+			for (int tileIdx : activeTiles) {
+				if (bestCost[tileIdx] > bestCost[seed]) seed = tileIdx;
+			}
+			if (bestCost[seed] == 0) break;
+		}
+
+		// k-means: remake each palette from the tiles that picked it, let the tiles pick again
+		for (int iteration = 0; iteration < kMaxIterations; iteration++) {
+			std::vector<std::vector<int>> members(palettes.size());
+			for (int tileIdx : activeTiles) {
+				members[assignment[tileIdx]].push_back(tileIdx);
+			}
+
+			WorkerPool::shared().parallelFor(palettes.size(), [&](size_t paletteIdx) {
+				if (!members[paletteIdx].empty()) {
+					palettes[paletteIdx] = medianCut(gatherColors(tiles, members[paletteIdx]), kColorsPerPalette);
+				}
+			});
+
+			std::atomic<int> moved{ 0 };
+			WorkerPool::shared().parallelFor(activeTiles.size(), [&](size_t i) {
+				const int tileIdx = activeTiles[i];
+				const int current = assignment[tileIdx];
+				int bestPalette = current;
+				uint64_t best = tileCost(tiles[tileIdx], palettes[current]);
+				for (int paletteIdx = 0; paletteIdx < static_cast<int>(palettes.size()) && best > 0; paletteIdx++) {
+					if (paletteIdx == current) continue;
+					const uint64_t cost = tileCost(tiles[tileIdx], palettes[paletteIdx], best);
+					if (cost < best) {
+						best = cost;
+						bestPalette = paletteIdx;
+					}
+				}
+				if (bestPalette != current) {
+					assignment[tileIdx] = bestPalette;
+					moved++;
+				}
+			});
+			if (moved == 0) break;
+		}
+	}
+
+	// palettes nobody ended up using are dropped, the rest numbered in order of first use
+	std::vector<int> remap(palettes.size(), -1);
+	std::vector<int> order;
+	for (int tileIdx : activeTiles) {
+		int& slot = remap[assignment[tileIdx]];
+		if (slot < 0) {
+			slot = static_cast<int>(order.size());
+			order.push_back(assignment[tileIdx]);
+		}
+	}
+	if (order.empty()) order.push_back(0);
+
+	for (int clusterIdx : order) {
+		Palette palette = {};
+		palette.colors[0] = colorFromRGB555(backgroundColor);
+		const ClusterPalette& cluster = palettes[clusterIdx];
+		for (int i = 0; i < cluster.count; i++) {
+			palette.colors[i + 1] = colorFromRGB555(cluster.colors[i]);
+		}
+		result.palettes.push_back(palette);
+	}
+
+	std::vector<TileData> tileData(tileCount);
+	result.tilePalettes.assign(tileCount, 0);
+	WorkerPool::shared().parallelFor(tiles.size(), [&](size_t tileIdx) {
+		const TileColors& tile = tiles[tileIdx];
+		TileData& out = tileData[tileIdx];
+		if (tile.colors.empty()) {
+			out = {};
+			return;
+		}
+
+		const ClusterPalette& palette = palettes[assignment[tileIdx]];
+		result.tilePalettes[tileIdx] = static_cast<uint8_t>(remap[assignment[tileIdx]]);
+		for (int i = 0; i < 64; i++) {
+			const uint16_t color = tile.pixels[i];
+			out.data[i / 8][i % 8] = color == kTransparent ? 0 : static_cast<uint8_t>(nearestIndex(palette, color) + 1);
+		}
+	});
+
+	result.tiles.ensureSize(tileCount);
+	for (int i = 0; i < tileCount; i++) {
+		result.tiles.setTile(i, tileData[i]);
+	}
+
+	result.durationMs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+		std::chrono::steady_clock::now() - startTime).count());
+	return result;
+}
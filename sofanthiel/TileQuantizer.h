@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "Graphics.h"
+
+// turning a full color image into 4bpp tiles plus a set of 16 color palettes. tiles are
+// grouped by the colors they use (k-means, with each group's palette made by median cut
+// over its tiles' colors), so a sheet with a lot of different parts keeps its colors instead
+// of squeezing everything through one palette
+struct TileQuantizeResult {
+	Tiles tiles;
+	std::vector<Palette> palettes; // color 0 of each is the transparent color
+	std::vector<uint8_t> tilePalettes; // palette of each tile, same order as `tiles`
+	int sourceColors = 0; // distinct RGB555 colors in the image, not counting transparency
+	uint64_t durationMs = 0;
+};
+
+// `rgba` is `width` x `height` RGBA32 pixels with rows `pitch` bytes apart. tiles come out
+// row by row, `(width + 7) / 8` to a row, and a ragged edge is padded with transparency.
+// pixels with alpha under 128 are transparent; when there are none, the top left pixel's
+// color is taken as the background instead
+TileQuantizeResult quantizeTiles(const uint8_t* rgba, int width, int height, int pitch, int maxPalettes = 16);
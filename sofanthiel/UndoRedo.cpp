@@ -1,36 +1,74 @@
 #include "UndoRedo.h"
 
-void UndoRedoManager::execute(std::unique_ptr<UndoableAction> action)
+void UndoRedoManager::execute(std::unique_ptr<UndoableAction> action, const std::string& mergeKey)
 {
     action->execute();
-    undoStack.push_back(std::move(action));
-    redoStack.clear();
+    clearRedo();
+
+    Uint64 now = SDL_GetTicks();
+    bool canMerge = !mergeKey.empty() && mergeKey == lastMergeKey &&
+        !undoStack.empty() && now - lastMergeTick <= MERGE_WINDOW_MS;
 
-    if (static_cast<int>(undoStack.size()) > MAX_UNDO_HISTORY) {
-        undoStack.erase(undoStack.begin());
+    if (canMerge && undoStack.back().action->mergeWith(*action)) {
+        HistoryEntry& top = undoStack.back();
+        undoBytes -= top.bytes;
+        top.bytes = top.action->memoryUsage();
+        undoBytes += top.bytes;
+        top.mergedEdits++;
+    }
+    else {
+        HistoryEntry entry;
+        entry.bytes = action->memoryUsage();
+        entry.action = std::move(action);
+        undoBytes += entry.bytes;
+        undoStack.push_back(std::move(entry));
     }
+
+    lastMergeKey = mergeKey;
+    lastMergeTick = now;
+
+    trimToBudget();
+
+    if (onChange) onChange();
 }
 
 void UndoRedoManager::undo()
 {
     if (undoStack.empty()) return;
 
-    auto action = std::move(undoStack.back());
+    HistoryEntry entry = std::move(undoStack.back());
     undoStack.pop_back();
+    undoBytes -= entry.bytes;
 
-    action->undo();
-    redoStack.push_back(std::move(action));
+    entry.action->undo();
+    redoBytes += entry.bytes;
+    redoStack.push_back(std::move(entry));
+    lastMergeKey.clear();
+
+    if (onChange) onChange();
 }
 
 void UndoRedoManager::redo()
 {
     if (redoStack.empty()) return;
 
-    auto action = std::move(redoStack.back());
+    HistoryEntry entry = std::move(redoStack.back());
     redoStack.pop_back();
+    redoBytes -= entry.bytes;
+
+    entry.action->redo();
+    undoBytes += entry.bytes;
+    undoStack.push_back(std::move(entry));
+    lastMergeKey.clear();
 
-    action->redo();
-    undoStack.push_back(std::move(action));
+    if (onChange) onChange();
+}
+
+void UndoRedoManager::jumpTo(int count)
+{
+    count = SDL_clamp(count, 0, undoCount() + redoCount());
+    while (undoCount() > count) undo();
+    while (undoCount() < count) redo();
 }
 
 bool UndoRedoManager::canUndo() const
@@ -46,17 +84,41 @@ bool UndoRedoManager::canRedo() const
 std::string UndoRedoManager::undoDescription() const
 {
     if (undoStack.empty()) return "";
-    return undoStack.back()->description();
+    return undoStack.back().action->description();
 }
 
 std::string UndoRedoManager::redoDescription() const
 {
     if (redoStack.empty()) return "";
-    return redoStack.back()->description();
+    return redoStack.back().action->description();
 }
 
 void UndoRedoManager::clear()
 {
     undoStack.clear();
     redoStack.clear();
+    undoBytes = 0;
+    redoBytes = 0;
+    lastMergeKey.clear();
+}
+
+void UndoRedoManager::setMemoryBudget(size_t bytes)
+{
+    memoryBudget = bytes;
+    trimToBudget();
+}
+
+void UndoRedoManager::trimToBudget()
+{
+    // oldest edits go first, the newest one always stays even if it's huge on its own
+    while (undoBytes + redoBytes > memoryBudget && undoStack.size() > 1) {
+        undoBytes -= undoStack.front().bytes;
+        undoStack.pop_front();
+    }
+}
+
+void UndoRedoManager::clearRedo()
+{
+    redoStack.clear();
+    redoBytes = 0;
 }
@@ -1,9 +1,14 @@
 #pragma once
 
+#include <algorithm>
 #include <string>
 #include <vector>
+#include <deque>
 #include <memory>
 #include <functional>
+#include <cstring>
+
+#include "Graphics.h"
 
 class UndoableAction
 {
@@ -14,15 +19,35 @@ public:
     virtual void undo() = 0;
     virtual void redo() { execute(); }
     virtual std::string description() const = 0;
+
+    // rough footprint of what this entry keeps alive, drives the history byte budget
+    virtual size_t memoryUsage() const { return sizeof(*this); }
+
+    // fold an already executed follow-up edit into this one, false keeps them separate
+    virtual bool mergeWith(UndoableAction& next) { (void)next; return false; }
 };
 
 class UndoRedoManager
 {
 public:
-    void execute(std::unique_ptr<UndoableAction> action);
+    static constexpr size_t DEFAULT_MEMORY_BUDGET = 16 * 1024 * 1024;
+    static constexpr Uint64 MERGE_WINDOW_MS = 1000;
+
+    struct HistoryEntry {
+        std::unique_ptr<UndoableAction> action;
+        size_t bytes = 0;
+        int mergedEdits = 1;
+    };
+
+    // edits sharing a non-empty merge key that land within MERGE_WINDOW_MS of each other
+    // collapse into one history entry (oam nudges, drags, duration resizes...)
+    void execute(std::unique_ptr<UndoableAction> action, const std::string& mergeKey = "");
     void undo();
     void redo();
 
+    // undo/redo until exactly `count` entries are applied
+    void jumpTo(int count);
+
     bool canUndo() const;
     bool canRedo() const;
 
@@ -34,120 +59,324 @@ public:
     int undoCount() const { return static_cast<int>(undoStack.size()); }
     int redoCount() const { return static_cast<int>(redoStack.size()); }
 
+    // 0 = oldest applied edit / 0 = the next one redo would bring back
+    const HistoryEntry& undoEntry(int index) const { return undoStack[index]; }
+    const HistoryEntry& redoEntry(int index) const { return redoStack[redoStack.size() - 1 - index]; }
+
+    size_t memoryUsage() const { return undoBytes + redoBytes; }
+    size_t getMemoryBudget() const { return memoryBudget; }
+    void setMemoryBudget(size_t bytes);
+
+    // fired after anything touched the document through here (execute/undo/redo)
+    void setChangeCallback(std::function<void()> callback) { onChange = std::move(callback); }
+
 private:
-    static constexpr int MAX_UNDO_HISTORY = 100;
+    void trimToBudget();
+    void clearRedo();
+
+    // deque so dropping the oldest entry off the front is O(1)
+    std::deque<HistoryEntry> undoStack;
+    std::deque<HistoryEntry> redoStack;
+    size_t undoBytes = 0;
+    size_t redoBytes = 0;
+    size_t memoryBudget = DEFAULT_MEMORY_BUDGET;
 
-    std::vector<std::unique_ptr<UndoableAction>> undoStack;
-    std::vector<std::unique_ptr<UndoableAction>> redoStack;
+    std::string lastMergeKey;
+    Uint64 lastMergeTick = 0;
+
+    std::function<void()> onChange;
 };
 
 class LambdaAction : public UndoableAction
 {
 public:
+    // payloadBytes = whatever the lambdas captured, they're opaque so the caller has to say.
+    // no default on purpose, a forgotten size would quietly slip past the history budget
     LambdaAction(std::string desc,
                  std::function<void()> doFunc,
-                 std::function<void()> undoFunc)
+                 std::function<void()> undoFunc,
+                 size_t payloadBytes)
         : desc(std::move(desc))
         , doFunc(std::move(doFunc))
         , undoFunc(std::move(undoFunc))
+        , payloadBytes(payloadBytes)
     {}
 
     void execute() override { doFunc(); }
     void undo() override { undoFunc(); }
     std::string description() const override { return desc; }
+    size_t memoryUsage() const override { return sizeof(*this) + desc.capacity() + payloadBytes; }
 
 private:
     std::string desc;
     std::function<void()> doFunc;
     std::function<void()> undoFunc;
+    size_t payloadBytes;
 };
 
-#include "Graphics.h"
+inline bool undoElementsEqual(const TengokuOAM& lhs, const TengokuOAM& rhs)
+{
+    return memcmp(&lhs, &rhs, sizeof(TengokuOAM)) == 0;
+}
+
+inline bool undoElementsEqual(const AnimationEntry& lhs, const AnimationEntry& rhs)
+{
+    return lhs.duration == rhs.duration && lhs.celName == rhs.celName;
+}
+
+inline bool undoElementsEqual(const AnimationCel& lhs, const AnimationCel& rhs)
+{
+    return lhs.name == rhs.name && lhs.oams.size() == rhs.oams.size() &&
+        (lhs.oams.empty() || memcmp(lhs.oams.data(), rhs.oams.data(), lhs.oams.size() * sizeof(TengokuOAM)) == 0);
+}
+
+inline bool undoElementsEqual(const Animation& lhs, const Animation& rhs)
+{
+    return lhs.name == rhs.name && std::equal(lhs.entries.begin(), lhs.entries.end(), rhs.entries.begin(), rhs.entries.end(),
+        [](const AnimationEntry& a, const AnimationEntry& b) { return undoElementsEqual(a, b); });
+}
+
+inline size_t undoElementBytes(const TengokuOAM&) { return sizeof(TengokuOAM); }
+inline size_t undoElementBytes(const AnimationEntry& entry) { return sizeof(AnimationEntry) + entry.celName.capacity(); }
+inline size_t undoElementBytes(const AnimationCel& cel) { return sizeof(AnimationCel) + cel.name.capacity() + cel.oams.capacity() * sizeof(TengokuOAM); }
+
+inline size_t undoElementBytes(const Animation& anim)
+{
+    size_t bytes = sizeof(Animation) + anim.name.capacity();
+    for (const auto& entry : anim.entries) {
+        bytes += undoElementBytes(entry);
+    }
+    return bytes;
+}
+
+inline size_t approximateMemoryUsage(const Tiles& tiles)
+{
+    return sizeof(Tiles) + static_cast<size_t>(tiles.getSize()) * sizeof(TileData);
+}
+
+inline size_t approximateMemoryUsage(const std::vector<Palette>& palettes)
+{
+    return palettes.capacity() * sizeof(Palette);
+}
+
+inline size_t approximateMemoryUsage(const std::vector<AnimationCel>& cels)
+{
+    size_t bytes = cels.capacity() * sizeof(AnimationCel);
+    for (const auto& cel : cels) {
+        bytes += cel.name.capacity() + cel.oams.capacity() * sizeof(TengokuOAM);
+    }
+    return bytes;
+}
+
+inline size_t approximateMemoryUsage(const std::vector<Animation>& animations)
+{
+    size_t bytes = animations.capacity() * sizeof(Animation);
+    for (const auto& anim : animations) {
+        bytes += anim.name.capacity();
+        for (const auto& entry : anim.entries) {
+            bytes += undoElementBytes(entry);
+        }
+    }
+    return bytes;
+}
+
+// old -> new as a single replaced span, common prefix/suffix get dropped.
+// tweaking, inserting, erasing or appending elements all end up a few elements big
+template <typename T>
+struct SpliceDelta
+{
+    size_t start = 0;
+    size_t resultSize = 0;
+    std::vector<T> before;
+    std::vector<T> after;
+
+    static SpliceDelta build(const std::vector<T>& oldState, const std::vector<T>& newState)
+    {
+        return build(oldState, newState, 0, newState.size());
+    }
+
+    // same thing for callers that edited in place and only kept the span they touched:
+    // the spans sit at `offset`, and the whole vector ends up `resultSize` long
+    static SpliceDelta build(const std::vector<T>& oldState, const std::vector<T>& newState, size_t offset, size_t resultSize)
+    {
+        size_t prefix = 0;
+        size_t common = std::min(oldState.size(), newState.size());
+        while (prefix < common && undoElementsEqual(oldState[prefix], newState[prefix])) {
+            prefix++;
+        }
 
-class OAMModifyAction : public UndoableAction
+        size_t suffix = 0;
+        while (suffix < common - prefix &&
+            undoElementsEqual(oldState[oldState.size() - 1 - suffix], newState[newState.size() - 1 - suffix])) {
+            suffix++;
+        }
+
+        SpliceDelta delta;
+        delta.start = offset + prefix;
+        delta.resultSize = resultSize;
+        delta.before.assign(oldState.begin() + prefix, oldState.end() - suffix);
+        delta.after.assign(newState.begin() + prefix, newState.end() - suffix);
+        return delta;
+    }
+
+    // call sites usually edit first and then hand the action over, so applying on top of the
+    // new state has to be a no-op. before/after always differ at both ends, so this can't
+    // mistake the old state for the new one
+    bool isApplied(const std::vector<T>& target) const
+    {
+        if (target.size() != resultSize || start + after.size() > target.size()) {
+            return false;
+        }
+        for (size_t i = 0; i < after.size(); i++) {
+            if (!undoElementsEqual(target[start + i], after[i])) return false;
+        }
+        return true;
+    }
+
+    void apply(std::vector<T>& target) const
+    {
+        if (!isApplied(target)) replace(target, before.size(), after);
+    }
+    void revert(std::vector<T>& target) const { replace(target, after.size(), before); }
+
+    size_t memoryUsage() const
+    {
+        size_t bytes = 0;
+        for (const auto& value : before) bytes += undoElementBytes(value);
+        for (const auto& value : after) bytes += undoElementBytes(value);
+        return bytes;
+    }
+
+private:
+    void replace(std::vector<T>& target, size_t removeCount, const std::vector<T>& values) const
+    {
+        size_t from = std::min(start, target.size());
+        size_t to = std::min(from + removeCount, target.size());
+        target.erase(target.begin() + from, target.begin() + to);
+        target.insert(target.begin() + from, values.begin(), values.end());
+    }
+};
+
+template <typename T>
+class VectorModifyAction : public UndoableAction
 {
 public:
-    OAMModifyAction(std::string desc,
-                    std::function<std::vector<TengokuOAM>*()> targetResolver,
-                    std::vector<TengokuOAM> oldState,
-                    std::vector<TengokuOAM> newState)
+    VectorModifyAction(std::string desc,
+                       std::function<std::vector<T>*()> targetResolver,
+                       const std::vector<T>& oldState,
+                       const std::vector<T>& newState)
         : desc(std::move(desc))
         , targetResolver(std::move(targetResolver))
-        , oldState(std::move(oldState))
-        , newState(std::move(newState))
+        , delta(SpliceDelta<T>::build(oldState, newState))
     {}
 
-    OAMModifyAction(std::string desc,
-                    std::vector<TengokuOAM>* target,
-                    std::vector<TengokuOAM> oldState,
-                    std::vector<TengokuOAM> newState)
-        : OAMModifyAction(
+    VectorModifyAction(std::string desc,
+                       std::vector<T>* target,
+                       const std::vector<T>& oldState,
+                       const std::vector<T>& newState)
+        : VectorModifyAction(
             std::move(desc),
             [target]() { return target; },
-            std::move(oldState),
-            std::move(newState))
+            oldState,
+            newState)
+    {}
+
+    VectorModifyAction(std::string desc,
+                       std::vector<T>* target,
+                       SpliceDelta<T> delta)
+        : desc(std::move(desc))
+        , targetResolver([target]() { return target; })
+        , delta(std::move(delta))
     {}
 
     void execute() override {
         if (auto* target = targetResolver()) {
-            *target = newState;
+            delta.apply(*target);
         }
     }
     void undo() override {
         if (auto* target = targetResolver()) {
-            *target = oldState;
+            delta.revert(*target);
         }
     }
     std::string description() const override { return desc; }
+    size_t memoryUsage() const override { return sizeof(*this) + desc.capacity() + delta.memoryUsage(); }
+
+    bool mergeWith(UndoableAction& next) override {
+        auto* other = dynamic_cast<VectorModifyAction<T>*>(&next);
+        auto* target = targetResolver();
+        if (other == nullptr || target == nullptr || other->targetResolver() != target) {
+            return false;
+        }
+
+        // walk the live state back past both edits, then re-diff start -> now
+        std::vector<T> original = *target;
+        other->delta.revert(original);
+        delta.revert(original);
+        delta = SpliceDelta<T>::build(original, *target);
+        return true;
+    }
 
 private:
     std::string desc;
-    std::function<std::vector<TengokuOAM>*()> targetResolver;
-    std::vector<TengokuOAM> oldState;
-    std::vector<TengokuOAM> newState;
+    std::function<std::vector<T>*()> targetResolver;
+    SpliceDelta<T> delta;
 };
 
-class AnimationEntriesAction : public UndoableAction
+using OAMModifyAction = VectorModifyAction<TengokuOAM>;
+using AnimationEntriesAction = VectorModifyAction<AnimationEntry>;
+using AnimationCelsAction = VectorModifyAction<AnimationCel>;
+using AnimationsAction = VectorModifyAction<Animation>;
+
+// sparse per tile diff, tile edits tend to be scattered rects so a splice would drag
+// along everything in between. tiles past the shorter size count as blank
+class TilesModifyAction : public UndoableAction
 {
 public:
-    AnimationEntriesAction(std::string desc,
-                           std::function<std::vector<AnimationEntry>*()> targetResolver,
-                           std::vector<AnimationEntry> oldState,
-                           std::vector<AnimationEntry> newState)
+    TilesModifyAction(std::string desc, Tiles* target, const Tiles& oldState, const Tiles& newState)
         : desc(std::move(desc))
-        , targetResolver(std::move(targetResolver))
-        , oldState(std::move(oldState))
-        , newState(std::move(newState))
-    {}
-
-    AnimationEntriesAction(std::string desc,
-                           std::vector<AnimationEntry>* target,
-                           std::vector<AnimationEntry> oldState,
-                           std::vector<AnimationEntry> newState)
-        : AnimationEntriesAction(
-            std::move(desc),
-            [target]() { return target; },
-            std::move(oldState),
-            std::move(newState))
-    {}
+        , target(target)
+        , oldSize(oldState.getSize())
+        , newSize(newState.getSize())
+    {
+        const TileData blank = {};
+        const int count = std::max(oldSize, newSize);
+        for (int i = 0; i < count; i++) {
+            TileData before = i < oldSize ? oldState.getTile(i) : blank;
+            TileData after = i < newSize ? newState.getTile(i) : blank;
+            if (memcmp(&before, &after, sizeof(TileData)) != 0) {
+                changes.push_back({ i, before, after });
+            }
+        }
+    }
 
     void execute() override {
-        if (auto* target = targetResolver()) {
-            *target = newState;
+        target->resize(newSize);
+        for (const auto& change : changes) {
+            if (change.index < newSize) target->setTile(change.index, change.after);
         }
     }
     void undo() override {
-        if (auto* target = targetResolver()) {
-            *target = oldState;
+        target->resize(oldSize);
+        for (const auto& change : changes) {
+            if (change.index < oldSize) target->setTile(change.index, change.before);
         }
     }
     std::string description() const override { return desc; }
+    size_t memoryUsage() const override { return sizeof(*this) + desc.capacity() + changes.capacity() * sizeof(TileChange); }
 
 private:
+    struct TileChange {
+        int index;
+        TileData before;
+        TileData after;
+    };
+
     std::string desc;
-    std::function<std::vector<AnimationEntry>*()> targetResolver;
-    std::vector<AnimationEntry> oldState;
-    std::vector<AnimationEntry> newState;
+    Tiles* target;
+    int oldSize;
+    int newSize;
+    std::vector<TileChange> changes;
 };
 
 class PaletteChangeAction : public UndoableAction
@@ -185,6 +414,7 @@ public:
         }
     }
     std::string description() const override { return desc; }
+    size_t memoryUsage() const override { return sizeof(*this) + desc.capacity(); }
 
 private:
     std::string desc;
@@ -0,0 +1,256 @@
+#include "UsageIndex.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+const std::vector<TileReference> kNoTileReferences;
+const std::vector<CelReference> kNoCelReferences;
+
+bool sameOAMs(const std::vector<TengokuOAM>& lhs, const std::vector<TengokuOAM>& rhs)
+{
+	// oams are 3 fully packed u16s, no padding to trip over
+	return lhs.size() == rhs.size() &&
+		(lhs.empty() || memcmp(lhs.data(), rhs.data(), lhs.size() * sizeof(TengokuOAM)) == 0);
+}
+
+bool sameEntryNames(const std::vector<AnimationEntry>& entries, const std::vector<std::string>& names)
+{
+	if (entries.size() != names.size()) {
+		return false;
+	}
+
+	for (size_t i = 0; i < entries.size(); i++) {
+		if (entries[i].celName != names[i]) {
+			return false;
+		}
+	}
+	return true;
+}
+
+std::vector<std::string> collectEntryNames(const Animation& animation)
+{
+	std::vector<std::string> names;
+	names.reserve(animation.entries.size());
+	for (const auto& entry : animation.entries) {
+		names.push_back(entry.celName);
+	}
+	return names;
+}
+
+template <typename Fn>
+void forEachOAMTile(const TengokuOAM& oam, Fn&& fn)
+{
+	const int tilesWide = getOAMTilesWide(oam);
+	const int tilesHigh = getOAMTilesHigh(oam);
+	for (int ty = 0; ty < tilesHigh; ty++) {
+		for (int tx = 0; tx < tilesWide; tx++) {
+			fn(getTileIndexForOffset(oam, tx, ty));
+		}
+	}
+}
+
+}
+
+void TileUsageIndex::sync(const std::vector<AnimationCel>& cels, int tileCount)
+{
+	// cels got added/removed/reordered or the sheet was resized, indices shifted so start over
+	if (cels.size() != indexedOams.size() || tileCount != static_cast<int>(referencesByTile.size())) {
+		rebuild(cels, tileCount);
+		return;
+	}
+
+	for (int i = 0; i < static_cast<int>(cels.size()); i++) {
+		if (sameOAMs(cels[i].oams, indexedOams[i])) {
+			continue;
+		}
+
+		removeCel(i, indexedOams[i]);
+		addCel(i, cels[i].oams);
+		indexedOams[i] = cels[i].oams;
+	}
+}
+
+void TileUsageIndex::rebuild(const std::vector<AnimationCel>& cels, int tileCount)
+{
+	referencesByTile.assign(static_cast<size_t>(SDL_max(0, tileCount)), {});
+	indexedOams.clear();
+	indexedOams.reserve(cels.size());
+	usedTileCount = 0;
+
+	for (int i = 0; i < static_cast<int>(cels.size()); i++) {
+		addCel(i, cels[i].oams);
+		indexedOams.push_back(cels[i].oams);
+	}
+}
+
+void TileUsageIndex::addCel(int celIndex, const std::vector<TengokuOAM>& oams)
+{
+	const int tileCount = static_cast<int>(referencesByTile.size());
+	for (int oamIdx = 0; oamIdx < static_cast<int>(oams.size()); oamIdx++) {
+		forEachOAMTile(oams[oamIdx], [&](int tileIdx) {
+			if (tileIdx < 0 || tileIdx >= tileCount) {
+				return;
+			}
+
+			auto& refs = referencesByTile[tileIdx];
+			if (refs.empty()) {
+				usedTileCount++;
+			}
+			refs.push_back({ celIndex, oamIdx });
+		});
+	}
+}
+
+void TileUsageIndex::removeCel(int celIndex, const std::vector<TengokuOAM>& oams)
+{
+	const int tileCount = static_cast<int>(referencesByTile.size());
+	for (const auto& oam : oams) {
+		forEachOAMTile(oam, [&](int tileIdx) {
+			if (tileIdx < 0 || tileIdx >= tileCount) {
+				return;
+			}
+
+			auto& refs = referencesByTile[tileIdx];
+			if (refs.empty()) {
+				return;
+			}
+
+			refs.erase(std::remove_if(refs.begin(), refs.end(), [celIndex](const TileReference& ref) {
+				return ref.celIndex == celIndex;
+			}), refs.end());
+
+			if (refs.empty()) {
+				usedTileCount--;
+			}
+		});
+	}
+}
+
+bool TileUsageIndex::isUsed(int tileIndex) const
+{
+	return tileIndex >= 0 && tileIndex < static_cast<int>(referencesByTile.size()) &&
+		!referencesByTile[tileIndex].empty();
+}
+
+int TileUsageIndex::getUseCount(int tileIndex) const
+{
+	return static_cast<int>(getReferences(tileIndex).size());
+}
+
+const std::vector<TileReference>& TileUsageIndex::getReferences(int tileIndex) const
+{
+	if (tileIndex < 0 || tileIndex >= static_cast<int>(referencesByTile.size())) {
+		return kNoTileReferences;
+	}
+	return referencesByTile[tileIndex];
+}
+
+int TileUsageIndex::getUnusedTileCount() const
+{
+	return static_cast<int>(referencesByTile.size()) - usedTileCount;
+}
+
+void CelUsageIndex::sync(const std::vector<Animation>& animations)
+{
+	if (animations.size() != indexedEntryNames.size()) {
+		rebuild(animations);
+		return;
+	}
+
+	for (int i = 0; i < static_cast<int>(animations.size()); i++) {
+		if (sameEntryNames(animations[i].entries, indexedEntryNames[i])) {
+			continue;
+		}
+
+		removeAnimation(i, indexedEntryNames[i]);
+		indexedEntryNames[i] = collectEntryNames(animations[i]);
+		addAnimation(i, indexedEntryNames[i]);
+	}
+}
+
+void CelUsageIndex::rebuild(const std::vector<Animation>& animations)
+{
+	referencesByCel.clear();
+	indexedEntryNames.clear();
+	indexedEntryNames.reserve(animations.size());
+
+	for (int i = 0; i < static_cast<int>(animations.size()); i++) {
+		indexedEntryNames.push_back(collectEntryNames(animations[i]));
+		addAnimation(i, indexedEntryNames.back());
+	}
+}
+
+void CelUsageIndex::addAnimation(int animationIndex, const std::vector<std::string>& entryNames)
+{
+	for (int entryIdx = 0; entryIdx < static_cast<int>(entryNames.size()); entryIdx++) {
+		if (entryNames[entryIdx].empty()) {
+			continue;
+		}
+		referencesByCel[entryNames[entryIdx]].push_back({ animationIndex, entryIdx });
+	}
+}
+
+void CelUsageIndex::removeAnimation(int animationIndex, const std::vector<std::string>& entryNames)
+{
+	for (const auto& name : entryNames) {
+		auto found = referencesByCel.find(name);
+		if (found == referencesByCel.end()) {
+			continue;
+		}
+
+		auto& refs = found->second;
+		refs.erase(std::remove_if(refs.begin(), refs.end(), [animationIndex](const CelReference& ref) {
+			return ref.animationIndex == animationIndex;
+		}), refs.end());
+
+		if (refs.empty()) {
+			referencesByCel.erase(found);
+		}
+	}
+}
+
+bool CelUsageIndex::isUsed(const std::string& celName) const
+{
+	return referencesByCel.find(celName) != referencesByCel.end();
+}
+
+int CelUsageIndex::getUseCount(const std::string& celName) const
+{
+	return static_cast<int>(getReferences(celName).size());
+}
+
+int CelUsageIndex::getAnimationCount(const std::string& celName) const
+{
+	// refs are grouped per animation since they're added one animation at a time
+	int count = 0;
+	int lastAnimation = -1;
+	for (const auto& ref : getReferences(celName)) {
+		if (ref.animationIndex != lastAnimation) {
+			count++;
+			lastAnimation = ref.animationIndex;
+		}
+	}
+	return count;
+}
+
+const std::vector<CelReference>& CelUsageIndex::getReferences(const std::string& celName) const
+{
+	auto found = referencesByCel.find(celName);
+	if (found == referencesByCel.end()) {
+		return kNoCelReferences;
+	}
+	return found->second;
+}
+
+int CelUsageIndex::countUnusedCels(const std::vector<AnimationCel>& cels) const
+{
+	int count = 0;
+	for (const auto& cel : cels) {
+		if (!isUsed(cel.name)) {
+			count++;
+		}
+	}
+	return count;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Graphics.h"
+
+struct TileReference {
+	int celIndex = -1;
+	int oamIndex = -1;
+};
+
+// reverse lookup from a spritesheet tile to every (cel, oam) drawing it.
+// sync() diffs the cels against what it saw last time and only re-indexes
+// the ones whose oams actually changed, so calling it every frame is cheap
+class TileUsageIndex {
+public:
+	void sync(const std::vector<AnimationCel>& cels, int tileCount);
+	void rebuild(const std::vector<AnimationCel>& cels, int tileCount);
+
+	bool isUsed(int tileIndex) const;
+	int getUseCount(int tileIndex) const;
+	const std::vector<TileReference>& getReferences(int tileIndex) const;
+
+	int getUnusedTileCount() const;
+
+private:
+	void addCel(int celIndex, const std::vector<TengokuOAM>& oams);
+	void removeCel(int celIndex, const std::vector<TengokuOAM>& oams);
+
+	std::vector<std::vector<TileReference>> referencesByTile;
+	std::vector<std::vector<TengokuOAM>> indexedOams;
+	int usedTileCount = 0;
+};
+
+struct CelReference {
+	int animationIndex = -1;
+	int entryIndex = -1;
+};
+
+// same idea for cels: cel name -> every (animation, entry) that shows it.
+// animations whose entry names didn't move since last sync are skipped
+class CelUsageIndex {
+public:
+	void sync(const std::vector<Animation>& animations);
+	void rebuild(const std::vector<Animation>& animations);
+
+	bool isUsed(const std::string& celName) const;
+	int getUseCount(const std::string& celName) const;
+	int getAnimationCount(const std::string& celName) const;
+	const std::vector<CelReference>& getReferences(const std::string& celName) const;
+
+	int countUnusedCels(const std::vector<AnimationCel>& cels) const;
+
+private:
+	void addAnimation(int animationIndex, const std::vector<std::string>& entryNames);
+	void removeAnimation(int animationIndex, const std::vector<std::string>& entryNames);
+
+	std::unordered_map<std::string, std::vector<CelReference>> referencesByCel;
+	std::vector<std::vector<std::string>> indexedEntryNames;
+};
@@ -3,6 +3,10 @@
 #include "IconsFontAwesome6.h"
 #include "InputManager.h"
 #include "UndoRedo.h"
+#include "RomAnimation.h"
+#include "Compression.h"
+#include "FileUtils.h"
+#include <cfloat>
 #include <cmath>
 #include <cstdlib>
 #include <unordered_map>
@@ -10,6 +14,21 @@
 
 namespace {
 
+std::string formatByteSize(size_t bytes)
+{
+    char buffer[32];
+    if (bytes >= 1024 * 1024) {
+        snprintf(buffer, sizeof(buffer), "%.1f MB", bytes / (1024.0 * 1024.0));
+    }
+    else if (bytes >= 1024) {
+        snprintf(buffer, sizeof(buffer), "%.1f KB", bytes / 1024.0);
+    }
+    else {
+        snprintf(buffer, sizeof(buffer), "%zu B", bytes);
+    }
+    return buffer;
+}
+
 void* loadFileToHeapBuffer(const char* path, size_t& outSize)
 {
     outSize = 0;
@@ -40,17 +59,6 @@ void* loadFileToHeapBuffer(const char* path, size_t& outSize)
     return buffer;
 }
 
-struct RomAnimationImportParseResult {
-    bool success = false;
-    uint32_t animationPointer = 0;
-    Animation animation;
-    std::vector<AnimationCel> cels;
-    std::vector<uint32_t> entryPointers;
-    std::vector<uint32_t> celPointers;
-    std::string errorMessage;
-    std::string warningMessage;
-};
-
 std::string trimString(const std::string& value)
 {
     size_t start = value.find_first_not_of(" \t\r\n");
@@ -115,13 +123,6 @@ std::string sanitizeRomImportName(const std::string& value)
     return sanitized;
 }
 
-std::string formatGbaPointer(uint32_t pointer)
-{
-    std::ostringstream oss;
-    oss << std::uppercase << std::hex << std::setw(8) << std::setfill('0') << pointer;
-    return oss.str();
-}
-
 std::string buildRomImportSuggestedAnimationName(const std::string& romPath, uint32_t animationPointer)
 {
     return sanitizeRomImportName(getFileStem(romPath)) + "_" + formatGbaPointer(animationPointer);
@@ -132,13 +133,6 @@ std::string buildRomImportSuggestedCelPrefix(const std::string& romPath, uint32_
     return buildRomImportSuggestedAnimationName(romPath, animationPointer) + "_cel";
 }
 
-std::string buildRomImportCelName(const std::string& celPrefix, int index)
-{
-    std::ostringstream oss;
-    oss << celPrefix << std::setw(3) << std::setfill('0') << index;
-    return oss.str();
-}
-
 int calculateAnimationTotalFrames(const Animation& anim)
 {
     int totalFrames = 0;
@@ -154,75 +148,6 @@ bool shouldUpdateSuggestedBuffer(const char* currentValue, const std::string& pr
     return current.empty() || current == previousSuggestedValue;
 }
 
-bool loadBinaryFile(const std::string& path, std::vector<uint8_t>& outData)
-{
-    outData.clear();
-
-    std::ifstream file(path, std::ios::binary | std::ios::ate);
-    if (!file.is_open()) {
-        return false;
-    }
-
-    std::streamsize fileSize = file.tellg();
-    if (fileSize <= 0) {
-        return false;
-    }
-
-    file.seekg(0, std::ios::beg);
-    outData.resize(static_cast<size_t>(fileSize));
-    return file.read(reinterpret_cast<char*>(outData.data()), fileSize).good();
-}
-
-bool tryReadLittleU16(const std::vector<uint8_t>& data, size_t offset, uint16_t& outValue)
-{
-    if (offset + sizeof(uint16_t) > data.size()) {
-        return false;
-    }
-
-    outValue = static_cast<uint16_t>(data[offset]) |
-        (static_cast<uint16_t>(data[offset + 1]) << 8);
-    return true;
-}
-
-bool tryReadLittleU32(const std::vector<uint8_t>& data, size_t offset, uint32_t& outValue)
-{
-    if (offset + sizeof(uint32_t) > data.size()) {
-        return false;
-    }
-
-    outValue = static_cast<uint32_t>(data[offset]) |
-        (static_cast<uint32_t>(data[offset + 1]) << 8) |
-        (static_cast<uint32_t>(data[offset + 2]) << 16) |
-        (static_cast<uint32_t>(data[offset + 3]) << 24);
-    return true;
-}
-
-bool tryConvertRomPointerToOffset(uint32_t pointer, size_t romSize, size_t& outOffset, std::string* outError = nullptr)
-{
-    constexpr uint32_t kGbaRomBase = 0x08000000;
-    outOffset = 0;
-
-    if ((pointer & 0xFF000000) != kGbaRomBase) {
-        if (outError != nullptr) {
-            *outError = "Pointers must be in the 0x08XXXXXX ROM address range.";
-        }
-        return false;
-    }
-
-    uint32_t rawOffset = pointer - kGbaRomBase;
-    if (rawOffset >= romSize) {
-        if (outError != nullptr) {
-            std::ostringstream oss;
-            oss << "Pointer 0x" << formatGbaPointer(pointer) << " points outside the selected ROM.";
-            *outError = oss.str();
-        }
-        return false;
-    }
-
-    outOffset = static_cast<size_t>(rawOffset);
-    return true;
-}
-
 bool tryParseRomAnimationPointerInput(const std::string& input, size_t romSize,
     uint32_t& outPointer, std::string& outError)
 {
@@ -290,173 +215,81 @@ bool tryParseRomAnimationPointerInput(const std::string& input, size_t romSize,
     return true;
 }
 
-bool tryParseRomCel(const std::vector<uint8_t>& romData, uint32_t celPointer,
-    const std::string& celName, AnimationCel& outCel, std::string& outError)
+// scan results that pass the pointer filter and the minimum entry count, as indices
+std::vector<int> filterRomScanResults(const RomAnimationImportState& state)
 {
-    constexpr uint16_t kMaxRomCelOams = 512;
-
-    size_t celOffset = 0;
-    if (!tryConvertRomPointerToOffset(celPointer, romData.size(), celOffset, &outError)) {
-        return false;
-    }
-
-    if ((celOffset % 2) != 0) {
-        outError = "Cel data must be aligned to 2 bytes.";
-        return false;
-    }
-
-    uint16_t oamCount = 0;
-    if (!tryReadLittleU16(romData, celOffset, oamCount)) {
-        outError = "Could not read the cel OAM count.";
-        return false;
-    }
-
-    if (oamCount > kMaxRomCelOams) {
-        std::ostringstream oss;
-        oss << "Cel at 0x" << formatGbaPointer(celPointer)
-            << " declares " << oamCount << " OAMs, which is above the safety limit.";
-        outError = oss.str();
-        return false;
+    std::string filter = trimString(state.scanFilterBuffer);
+    std::transform(filter.begin(), filter.end(), filter.begin(), [](unsigned char ch) { return static_cast<char>(std::toupper(ch)); });
+    if (filter.rfind("0X", 0) == 0) {
+        filter.erase(0, 2);
     }
 
-    size_t requiredBytes = sizeof(uint16_t) + static_cast<size_t>(oamCount) * sizeof(TengokuOAM);
-    if (celOffset + requiredBytes > romData.size()) {
-        outError = "Cel data extends past the end of the ROM.";
-        return false;
+    std::vector<int> visible;
+    for (int i = 0; i < static_cast<int>(state.scanResults.size()); i++) {
+        const RomAnimationCandidate& candidate = state.scanResults[i];
+        if (candidate.entryCount < state.scanMinEntries) continue;
+        if (!filter.empty() && formatGbaPointer(candidate.pointer).find(filter) == std::string::npos) continue;
+        visible.push_back(i);
     }
+    return visible;
+}
 
-    outCel = AnimationCel();
-    outCel.name = celName;
-    outCel.oams.reserve(oamCount);
-
-    size_t readOffset = celOffset + sizeof(uint16_t);
-    for (uint16_t i = 0; i < oamCount; ++i) {
-        uint16_t rawOam[3] = {};
-        if (!tryReadLittleU16(romData, readOffset, rawOam[0]) ||
-            !tryReadLittleU16(romData, readOffset + 2, rawOam[1]) ||
-            !tryReadLittleU16(romData, readOffset + 4, rawOam[2])) {
-            outError = "Could not read one of the OAM entries for the cel.";
-            return false;
+// first word aligned offset at or after `from` holding a compressed stream that decodes to whole tiles.
+// the bios only takes aligned sources, and junk almost always fails the header or the first few tokens
+bool findNextCompressedTiles(const ByteView& rom, size_t from, size_t& outOffset)
+{
+    std::vector<uint8_t> scratch;
+    for (size_t offset = (from + 3) & ~static_cast<size_t>(3); offset + 4 <= rom.getSize(); offset += 4) {
+        uint8_t type = 0;
+        size_t decompressedSize = 0;
+        if (!Compression::readHeader(rom.getData() + offset, rom.getSize() - offset, type, decompressedSize)) continue;
+        if (decompressedSize == 0 || decompressedSize % 32 != 0 || decompressedSize > 1024 * 1024) continue;
+
+        if (Compression::decompress(rom.getData() + offset, rom.getSize() - offset, scratch)) {
+            outOffset = offset;
+            return true;
         }
-
-        TengokuOAM oam = {};
-        std::memcpy(&oam, rawOam, sizeof(TengokuOAM));
-        outCel.oams.push_back(oam);
-        readOffset += sizeof(TengokuOAM);
     }
-
-    return true;
+    return false;
 }
 
-RomAnimationImportParseResult parseRomAnimationData(const std::vector<uint8_t>& romData, uint32_t animationPointer,
-    const std::string& animationName, const std::string& celPrefix)
+// whitespace/comma separated list, each one in any form the single offset field takes
+std::vector<uint32_t> parseRomPointerList(const std::string& text, size_t romSize, std::vector<std::string>& outErrors)
 {
-    constexpr int kMaxRomAnimationEntries = 2048;
-
-    RomAnimationImportParseResult result;
-    result.animationPointer = animationPointer;
-
-    size_t animationOffset = 0;
-    if (!tryConvertRomPointerToOffset(animationPointer, romData.size(), animationOffset, &result.errorMessage)) {
-        return result;
-    }
-
-    if ((animationOffset % 4) != 0) {
-        result.warningMessage = "Animation data is not 4-byte aligned. Parsing anyway.";
-    }
-
-    result.animation.name = animationName;
-
-    std::unordered_map<uint32_t, int> celIndexByPointer;
-    int clampedDurationCount = 0;
-
-    for (int entryIndex = 0; entryIndex < kMaxRomAnimationEntries; ++entryIndex) {
-        size_t recordOffset = animationOffset + static_cast<size_t>(entryIndex) * 8;
-
-        uint32_t celPointer = 0;
-        uint32_t durationValue = 0;
-        if (!tryReadLittleU32(romData, recordOffset, celPointer) ||
-            !tryReadLittleU32(romData, recordOffset + 4, durationValue)) {
-            result.errorMessage = "Animation data ran off the end of the ROM before an end marker was found.";
-            result.animation.entries.clear();
-            result.cels.clear();
-            result.entryPointers.clear();
-            result.celPointers.clear();
-            return result;
-        }
-
-        if (celPointer == 0 && durationValue == 0) {
-            if (result.animation.entries.empty()) {
-                result.errorMessage = "The animation pointer immediately points to an end marker.";
-                return result;
-            }
-
-            if (clampedDurationCount > 0) {
-                std::ostringstream oss;
-                if (!result.warningMessage.empty()) {
-                    oss << result.warningMessage << "\n";
-                }
-                oss << clampedDurationCount << " duration value(s) were clamped to 255 frames.";
-                result.warningMessage = oss.str();
-            }
-
-            result.success = true;
-            return result;
-        }
-
-        if (celPointer == 0) {
-            std::ostringstream oss;
-            oss << "Entry " << entryIndex << " has a null cel pointer.";
-            result.errorMessage = oss.str();
-            return result;
+    std::vector<uint32_t> pointers;
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t start = text.find_first_not_of(" \t\r\n,;", pos);
+        if (start == std::string::npos) {
+            break;
         }
-
-        if (durationValue == 0) {
-            std::ostringstream oss;
-            oss << "Entry " << entryIndex << " has a duration of 0.";
-            result.errorMessage = oss.str();
-            return result;
+        size_t end = text.find_first_of(" \t\r\n,;", start);
+        if (end == std::string::npos) {
+            end = text.size();
         }
 
-        int celIndex = -1;
-        auto existingCel = celIndexByPointer.find(celPointer);
-        if (existingCel == celIndexByPointer.end()) {
-            AnimationCel cel;
-            std::string celError;
-            std::string celName = buildRomImportCelName(celPrefix, static_cast<int>(result.cels.size()));
-            if (!tryParseRomCel(romData, celPointer, celName, cel, celError)) {
-                std::ostringstream oss;
-                oss << "Failed to parse cel at 0x" << formatGbaPointer(celPointer) << ": " << celError;
-                result.errorMessage = oss.str();
-                return result;
-            }
-
-            celIndex = static_cast<int>(result.cels.size());
-            celIndexByPointer[celPointer] = celIndex;
-            result.cels.push_back(cel);
-            result.celPointers.push_back(celPointer);
+        std::string token = text.substr(start, end - start);
+        uint32_t pointer = 0;
+        std::string error;
+        if (tryParseRomAnimationPointerInput(token, romSize, pointer, error)) {
+            pointers.push_back(pointer);
         }
         else {
-            celIndex = existingCel->second;
-        }
-
-        AnimationEntry entry;
-        entry.celName = result.cels[static_cast<size_t>(celIndex)].name;
-        entry.duration = static_cast<uint8_t>(std::min<uint32_t>(durationValue, 255));
-        if (durationValue > 255) {
-            ++clampedDurationCount;
+            outErrors.push_back(token + ": " + error);
         }
-
-        result.animation.entries.push_back(entry);
-        result.entryPointers.push_back(celPointer);
+        pos = end;
     }
+    return pointers;
+}
 
-    result.errorMessage = "The animation did not hit an 8-byte zero terminator before the safety limit.";
-    result.animation.entries.clear();
-    result.cels.clear();
-    result.entryPointers.clear();
-    result.celPointers.clear();
-    return result;
+void appendRomPointerToList(char* buffer, size_t bufferSize, uint32_t pointer)
+{
+    std::string text = buffer;
+    if (!text.empty() && text.back() != '\n') {
+        text.push_back('\n');
+    }
+    text += formatGbaPointer(pointer);
+    copyStringToBuffer(buffer, bufferSize, text);
 }
 
 }
@@ -525,9 +358,37 @@ bool Sofanthiel::init()
 
     if (char* prefPath = SDL_GetPrefPath("ShaffySwitcher", "Sofanthiel")) {
         this->imguiSettingsPath = std::string(prefPath) + "imgui.ini";
+        this->journal.claimSlot(prefPath);
         SDL_free(prefPath);
     }
 
+    // leftover journal = last session didn't make it to close()
+    if (this->journal.readRecovery(this->recoveryBasePath, this->recoveryRecords)) {
+        this->recoveryPending = true;
+
+        // a new project that never got past the default document isn't worth asking about
+        if (this->recoveryBasePath.empty()) {
+            ProjectData replayed;
+            replayed.palettes = makeDefaultPalettes();
+            for (const auto& record : this->recoveryRecords) {
+                if (!EditJournal::applyRecord(record, replayed)) break;
+            }
+
+            const std::vector<Palette> defaultPalettes = makeDefaultPalettes();
+            const bool defaultDocument = replayed.tiles.getSize() == 0 && replayed.tilePalettes.empty() &&
+                replayed.animationCels.empty() && replayed.animations.empty() && replayed.palettes.size() == defaultPalettes.size() &&
+                memcmp(replayed.palettes.data(), defaultPalettes.data(), defaultPalettes.size() * sizeof(Palette)) == 0;
+            if (defaultDocument) {
+                this->recoveryPending = false;
+                this->recoveryRecords.clear();
+            }
+        }
+    }
+    if (!this->recoveryPending) {
+        this->resetJournal("");
+    }
+    this->undoManager.setChangeCallback([this]() { this->journalDocument(); });
+
     if (!this->imguiSettingsPath.empty()) {
         ImGui::LoadIniSettingsFromDisk(this->imguiSettingsPath.c_str());
     }
@@ -549,6 +410,9 @@ void Sofanthiel::close()
 {
     SDL_Log("bye bye!");
 
+    this->jobs.cancelAll();
+    this->journal.discard();
+
     if (this->backgroundTexture != nullptr) {
         SDL_DestroyTexture(this->backgroundTexture);
         this->backgroundTexture = nullptr;
@@ -590,71 +454,172 @@ void Sofanthiel::processEvents()
         if(event.type == SDL_EVENT_QUIT) {
             showExitConfirmation = true;
         }
+        else if(event.type == SDL_EVENT_DROP_BEGIN) {
+            fileImport.dropInProgress = true;
+        }
         else if(event.type == SDL_EVENT_DROP_FILE) {
             const char* droppedFile = event.drop.data;
             if (droppedFile) {
-                handleDroppedFile(std::string(droppedFile));
+                fileImport.droppedPaths.push_back(droppedFile);
             }
         }
+        else if(event.type == SDL_EVENT_DROP_COMPLETE) {
+            fileImport.dropInProgress = false;
+        }
 	}
 
+    // everything dropped together goes in as one batch
+    if (!fileImport.dropInProgress && !fileImport.droppedPaths.empty()) {
+        std::vector<std::string> paths = std::move(fileImport.droppedPaths);
+        fileImport.droppedPaths.clear();
+        importFiles(paths);
+    }
+
     if (InputManager::isPressed(InputManager::PlayPause) && !ImGui::GetIO().WantCaptureKeyboard && !this->celEditingMode) {
         isPlaying = !isPlaying;
     }
 }
 
-void Sofanthiel::handleDroppedFile(const std::string& path)
+void Sofanthiel::importFiles(const std::vector<std::string>& paths)
+{
+    // a project replaces everything anyway, so it opens right away and the rest lands on top
+    std::vector<std::string> batchPaths;
+    bool openedProject = false;
+    for (const std::string& path : paths) {
+        SDL_Log("Importing file: %s", path.c_str());
+        if (classifyImportPath(path) != ImportFileKind::Project) {
+            batchPaths.push_back(path);
+        }
+        else if (!openedProject) {
+            loadProject(path);
+            openedProject = true;
+        }
+        else {
+            SDL_Log("Skipped %s, only one project can be opened at a time", path.c_str());
+        }
+    }
+
+    fileImport.queuedPaths.insert(fileImport.queuedPaths.end(), batchPaths.begin(), batchPaths.end());
+    startQueuedFileImport();
+}
+
+void Sofanthiel::startQueuedFileImport()
 {
-    size_t dotPos = path.find_last_of('.');
-    if (dotPos == std::string::npos) {
-        SDL_Log("Dropped file has no extension: %s", path.c_str());
+    // one batch at a time so they land in order (a finished one counts until it's applied),
+    // and files dropped with a project wait for the project
+    const bool batchRunning = fileImport.batchJob.token && !fileImport.batchJob.token->isCancelled();
+    const bool projectLoading = projectLoad.token && !projectLoad.token->isCancelled();
+    if (batchRunning || projectLoading || fileImport.queuedPaths.empty()) {
         return;
     }
 
-    std::string ext = path.substr(dotPos + 1);
-    std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+    std::vector<std::string> paths = std::move(fileImport.queuedPaths);
+    fileImport.queuedPaths.clear();
+
+    std::string name = paths.size() == 1
+        ? "Importing " + getFileName(paths.front())
+        : "Importing " + std::to_string(paths.size()) + " files";
+    fileImport.batchJob = jobs.submit<ImportBatchResult>(name,
+        [paths, currentPalettes = this->palettes, paletteIndex = this->currentPalette](JobToken& token) {
+            return decodeImportBatch(paths, currentPalettes, paletteIndex, token);
+        },
+        [this](ImportBatchResult& result) {
+            fileImport.batchJob = JobHandle();
+            commitImportedFiles(result.files);
+            fileImport.durationMs = result.durationMs;
+            fileImport.finishedTick = SDL_GetTicks();
+        });
+}
 
-    SDL_Log("Dropped file: %s (ext: %s)", path.c_str(), ext.c_str());
+void Sofanthiel::commitImportedFiles(std::vector<ImportedFile>& files)
+{
+    fileImport.hasResult = true;
+    fileImport.importedCount = 0;
+    fileImport.errors.clear();
+
+    // palettes and tiles first, then cels, then the animations that use them. with several
+    // files of one kind the last one wins, same as dropping them one after another
+    const ImportFileKind commitOrder[] = {
+        ImportFileKind::Palettes,
+        ImportFileKind::Tiles,
+        ImportFileKind::ImageTiles,
+        ImportFileKind::CPalettes,
+        ImportFileKind::AnimationCels,
+        ImportFileKind::Animations
+    };
 
-    if (ext == "inv") {
-        loadProject(path);
-    }
-    else if (ext == "4bpp" || ext == "bin") {
-        this->tiles = ResourceManager::loadTiles(path);
-    }
-    else if (ext == "png" || ext == "bmp" || ext == "jpg" || ext == "jpeg") {
-        this->tiles = ResourceManager::loadTilesFromImageAndPalette(path, this->palettes, this->currentPalette);
+    for (ImportFileKind kind : commitOrder) {
+        for (ImportedFile& file : files) {
+            if (file.kind != kind || !file.success) continue;
+            fileImport.importedCount++;
+
+            switch (kind) {
+            case ImportFileKind::Palettes:
+                this->palettes = std::move(file.palettes);
+                this->currentPalette = SDL_clamp(this->currentPalette, 0,
+                    static_cast<int>(this->palettes.size()) - 1);
+                this->watchImportedFile(file.path, WatchedSourceKind::Palettes);
+                break;
+            case ImportFileKind::Tiles:
+                this->tiles = std::move(file.tiles);
+                this->tilePalettes.clear();
+                this->watchImportedFile(file.path, WatchedSourceKind::Tiles);
+                break;
+            case ImportFileKind::ImageTiles:
+                this->tiles = std::move(file.tiles);
+                this->spritesheetTilesPerRow = SDL_max(1, file.tilesPerRow);
+                this->tilePalettes.clear();
+                this->stopWatchingSource(WatchedSourceKind::Tiles);
+                break;
+            case ImportFileKind::CPalettes:
+                beginPaletteImport(file.paletteGroups);
+                break;
+            case ImportFileKind::AnimationCels:
+                this->animationCels = std::move(file.cels);
+                this->selectedCelIndices.clear();
+                this->animationCelFilename = getFileName(file.path);
+                this->watchImportedFile(file.path, WatchedSourceKind::AnimationCels);
+                break;
+            case ImportFileKind::Animations:
+                this->animations = std::move(file.animations);
+                this->watchImportedFile(file.path, WatchedSourceKind::Animations);
+                break;
+            default:
+                break;
+            }
+        }
     }
-    else if (ext == "pal") {
-        this->palettes = ResourceManager::loadPalettes(path);
-        this->currentPalette = SDL_clamp(this->currentPalette, 0,
-            static_cast<int>(this->palettes.size()) - 1);
+
+    for (const ImportedFile& file : files) {
+        if (!file.success) {
+            SDL_Log("Failed to import %s: %s", file.path.c_str(), file.errorMessage.c_str());
+            fileImport.errors.push_back(getFileName(file.path) + ": " + file.errorMessage);
+        }
     }
-    else if (ext == "c") {
-        std::ifstream file(path);
-        if (!file.is_open()) return;
+}
 
-        std::string content((std::istreambuf_iterator<char>(file)),
-                             std::istreambuf_iterator<char>());
-        file.close();
+void Sofanthiel::drawImportStatus()
+{
+    // progress is under Jobs, this only sums up the last batch for a bit
+    constexpr Uint64 kImportedLabelMs = 3000;
 
-        if (content.find("TO_RGB555") != std::string::npos && content.find("Palette") != std::string::npos) {
-            beginPaletteImport(ResourceManager::parsePalettesFromCFile(path));
-        }
-        else if (content.find("AnimationCel") != std::string::npos) {
-            this->animationCels = ResourceManager::loadAnimationCels(path);
-            std::string filename = path.substr(path.find_last_of("/\\") + 1);
-            this->animationCelFilename = filename;
-        }
-        else if (content.find("struct Animation") != std::string::npos || content.find("END_ANIMATION") != std::string::npos) {
-            this->animations = ResourceManager::loadAnimations(path);
-        }
-        else {
-            SDL_Log("Unrecognized .c file format: %s", path.c_str());
-        }
+    if (!fileImport.hasResult || SDL_GetTicks() - fileImport.finishedTick >= kImportedLabelMs) {
+        return;
+    }
+
+    if (!fileImport.errors.empty()) {
+        ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.35f, 1.0f), ICON_FA_TRIANGLE_EXCLAMATION " Imported %zu, %zu failed",
+            fileImport.importedCount, fileImport.errors.size());
     }
     else {
-        SDL_Log("Unsupported file dropped: %s", path.c_str());
+        ImGui::TextColored(ImVec4(0.5f, 0.85f, 0.5f, 1.0f), ICON_FA_CHECK " Imported %zu files", fileImport.importedCount);
+    }
+    if (ImGui::IsItemHovered()) {
+        std::string tooltip = "Decoded in " + std::to_string(fileImport.durationMs) + " ms";
+        for (const std::string& error : fileImport.errors) {
+            tooltip += "\n" + error;
+        }
+        ImGui::SetTooltip("%s", tooltip.c_str());
     }
 }
 
@@ -1076,9 +1041,12 @@ void Sofanthiel::handlePaletteImportPopup()
                     this->palettes = oldPalettes;
                     this->currentPalette = oldCurrentPalette;
                     this->selectedPaletteRow = oldSelectedPaletteRow;
-                }
+                },
+                approximateMemoryUsage(newPalettes) + approximateMemoryUsage(oldPalettes)
             ));
 
+            // the palettes no longer mirror a .pal, don't let a reload of it stomp on these
+            stopWatchingSource(WatchedSourceKind::Palettes);
             clearPaletteImportState();
             ImGui::CloseCurrentPopup();
         };
@@ -1142,20 +1110,45 @@ void Sofanthiel::handlePaletteImportPopup()
 
 void Sofanthiel::clearRomAnimationImportState()
 {
+    if (romAnimationImport.batchPreviewJob != 0) {
+        jobs.cancel(romAnimationImport.batchPreviewJob);
+    }
+    if (romAnimationImport.scanJob.token) {
+        jobs.cancel(romAnimationImport.scanJob.id);
+    }
     romAnimationImport = RomAnimationImportState();
 }
 
+void Sofanthiel::startRomAnimationScan()
+{
+    romAnimationImport.scanFinished = false;
+    romAnimationImport.scanResults.clear();
+
+    std::shared_ptr<const MappedFile> rom = romAnimationImport.rom;
+    romAnimationImport.scanJob = jobs.submit<RomScanResult>("Scanning " + getFileName(romAnimationImport.romPath),
+        [rom](JobToken& token) {
+            return scanRomForAnimations(rom->view(), token);
+        },
+        [this](RomScanResult& result) {
+            romAnimationImport.scanJob = JobHandle();
+            romAnimationImport.scanResults = std::move(result.candidates);
+            romAnimationImport.scanDurationMs = result.durationMs;
+            romAnimationImport.scanFinished = true;
+        });
+}
+
 void Sofanthiel::beginRomAnimationImport(const std::string& romPath)
 {
-    std::vector<uint8_t> romData;
-    if (!loadBinaryFile(romPath, romData)) {
-        SDL_Log("Failed to open ROM file for import: %s", romPath.c_str());
+    auto rom = std::make_shared<MappedFile>();
+    std::string error;
+    if (!rom->open(romPath, error)) {
+        SDL_Log("Failed to open ROM file for import: %s (%s)", romPath.c_str(), error.c_str());
         return;
     }
 
     clearRomAnimationImportState();
     romAnimationImport.romPath = romPath;
-    romAnimationImport.romData = std::move(romData);
+    romAnimationImport.rom = std::move(rom);
     romAnimationImport.showPopup = true;
     romAnimationImport.popupPendingOpen = true;
     romAnimationImport.errorMessage = "Enter a ROM offset such as 0x123456 or 08123456.";
@@ -1171,10 +1164,10 @@ void Sofanthiel::refreshRomAnimationImportPreview()
     romAnimationImport.previewCelPointers.clear();
     romAnimationImport.previewCurrentFrame = 0;
     romAnimationImport.previewTotalFrames = 0;
-    romAnimationImport.previewLastTickMs = 0;
+    romAnimationImport.previewClock.stop();
     romAnimationImport.warningMessage.clear();
 
-    if (romAnimationImport.romData.empty()) {
+    if (!romAnimationImport.rom) {
         romAnimationImport.errorMessage = "Choose a ROM file first.";
         return;
     }
@@ -1183,7 +1176,7 @@ void Sofanthiel::refreshRomAnimationImportPreview()
     uint32_t animationPointer = 0;
     if (!tryParseRomAnimationPointerInput(
         romAnimationImport.offsetBuffer,
-        romAnimationImport.romData.size(),
+        romAnimationImport.rom->size(),
         animationPointer,
         pointerError)) {
         romAnimationImport.errorMessage = pointerError;
@@ -1233,10 +1226,11 @@ void Sofanthiel::refreshRomAnimationImportPreview()
     }
 
     RomAnimationImportParseResult parseResult = parseRomAnimationData(
-        romAnimationImport.romData,
+        romAnimationImport.rom->view(),
         animationPointer,
         animationName,
-        celPrefix);
+        celPrefix,
+        romAnimationImport.celCache);
 
     romAnimationImport.errorMessage = parseResult.errorMessage;
     romAnimationImport.warningMessage = parseResult.warningMessage;
@@ -1251,7 +1245,7 @@ void Sofanthiel::refreshRomAnimationImportPreview()
     romAnimationImport.previewEntryPointers = std::move(parseResult.entryPointers);
     romAnimationImport.previewCelPointers = std::move(parseResult.celPointers);
     romAnimationImport.previewTotalFrames = calculateAnimationTotalFrames(romAnimationImport.previewAnimation);
-    romAnimationImport.previewLastTickMs = SDL_GetTicks();
+    romAnimationImport.previewClock.start(SDL_GetTicksNS());
 }
 
 void Sofanthiel::handleRomAnimationImportPopup()
@@ -1279,7 +1273,7 @@ void Sofanthiel::handleRomAnimationImportPopup()
     ImGui::SetNextWindowSizeConstraints(minWindowSize, maxWindowSize);
 
     if (romAnimationImport.showPopup &&
-        (romAnimationImport.romPath.empty() || romAnimationImport.romData.empty())) {
+        (romAnimationImport.romPath.empty() || !romAnimationImport.rom)) {
         clearRomAnimationImportState();
         return;
     }
@@ -1293,6 +1287,23 @@ void Sofanthiel::handleRomAnimationImportPopup()
         ImGui::TextWrapped("Selected ROM: %s", romAnimationImport.romPath.c_str());
         ImGui::Spacing();
 
+        if (ImGui::RadioButton("Single Animation", !romAnimationImport.batchMode)) {
+            romAnimationImport.batchMode = false;
+        }
+        ImGui::SameLine();
+        if (ImGui::RadioButton("Batch", romAnimationImport.batchMode)) {
+            romAnimationImport.batchMode = true;
+        }
+        ImGui::Spacing();
+
+        if (romAnimationImport.batchMode) {
+            if (handleRomBatchImport()) {
+                closePopup();
+            }
+            ImGui::EndPopup();
+            return;
+        }
+
         ImGui::SetNextItemWidth(getScaledSize(220.0f));
         if (ImGui::InputText("ROM Offset", romAnimationImport.offsetBuffer, sizeof(romAnimationImport.offsetBuffer))) {
             refreshPreview = true;
@@ -1311,6 +1322,66 @@ void Sofanthiel::handleRomAnimationImportPopup()
             ImGui::TextDisabled("Resolved: 0x%s", formatGbaPointer(romAnimationImport.resolvedAnimationPointer).c_str());
         }
 
+        // progress shows up under Jobs with everything else
+        const JobHandle& scanJob = romAnimationImport.scanJob;
+        if (scanJob.token && !scanJob.token->isCancelled()) {
+            ImGui::TextDisabled("Scanning...");
+            ImGui::SameLine();
+            if (ImGui::Button(ICON_FA_STOP " Stop Scan")) {
+                jobs.cancel(scanJob.id);
+                romAnimationImport.scanJob = JobHandle();
+            }
+        }
+        else {
+            if (ImGui::Button(ICON_FA_MAGNIFYING_GLASS " Scan ROM for Animations")) {
+                startRomAnimationScan();
+            }
+            if (ImGui::IsItemHovered()) {
+                ImGui::SetTooltip("Looks through the whole ROM for animation tables, best matches first.");
+            }
+        }
+
+        if (romAnimationImport.scanFinished) {
+            ImGui::SameLine();
+            ImGui::TextDisabled("%d found in %llu ms",
+                static_cast<int>(romAnimationImport.scanResults.size()),
+                static_cast<unsigned long long>(romAnimationImport.scanDurationMs));
+
+            ImGui::SetNextItemWidth(getScaledSize(160.0f));
+            ImGui::InputTextWithHint("##RomScanFilter", "Filter pointers", romAnimationImport.scanFilterBuffer,
+                sizeof(romAnimationImport.scanFilterBuffer));
+            ImGui::SameLine();
+            ImGui::SetNextItemWidth(getScaledSize(110.0f));
+            if (ImGui::InputInt("Min Entries", &romAnimationImport.scanMinEntries)) {
+                romAnimationImport.scanMinEntries = std::max(1, romAnimationImport.scanMinEntries);
+            }
+
+            std::vector<int> visibleResults = filterRomScanResults(romAnimationImport);
+
+            ImGui::BeginChild("RomImportScanResults", ImVec2(0, getScaledSize(140.0f)), ImGuiChildFlags_Borders);
+            ImGuiListClipper clipper;
+            clipper.Begin(static_cast<int>(visibleResults.size()));
+            while (clipper.Step()) {
+                for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; row++) {
+                    const RomAnimationCandidate& candidate = romAnimationImport.scanResults[visibleResults[row]];
+                    std::string pointerLabel = formatGbaPointer(candidate.pointer);
+                    char label[128];
+                    snprintf(label, sizeof(label), "0x%s  %4d entries  %3d cels  %5d frames  %4d OAM##scan%d",
+                        pointerLabel.c_str(), candidate.entryCount, candidate.celCount, candidate.totalFrames,
+                        candidate.oamCount, row);
+
+                    if (ImGui::Selectable(label, romAnimationImport.resolvedAnimationPointer == candidate.pointer)) {
+                        copyStringToBuffer(romAnimationImport.offsetBuffer, sizeof(romAnimationImport.offsetBuffer), pointerLabel);
+                        refreshPreview = true;
+                    }
+                }
+            }
+            if (visibleResults.empty()) {
+                ImGui::TextDisabled("Nothing matches the filter.");
+            }
+            ImGui::EndChild();
+        }
+
         ImGui::SetNextItemWidth(getScaledSize(320.0f));
         if (ImGui::InputText(
             "Animation Name",
@@ -1459,16 +1530,13 @@ void Sofanthiel::handleRomAnimationImportPopup()
         ImGui::BeginChild("RomImportPreviewPane", ImVec2(0, contentHeight), ImGuiChildFlags_Borders);
         ImDrawList* drawList = ImGui::GetWindowDrawList();
         if (romAnimationImport.previewValid && romAnimationImport.previewTotalFrames > 0) {
-            double msPerFrame = 1000.0 / std::max(1.0f, frameRate);
-            Uint64 now = SDL_GetTicks();
-            if (romAnimationImport.previewLastTickMs == 0) {
-                romAnimationImport.previewLastTickMs = now;
-            }
-            while (now > romAnimationImport.previewLastTickMs + static_cast<Uint64>(msPerFrame)) {
-                romAnimationImport.previewCurrentFrame =
-                    (romAnimationImport.previewCurrentFrame + 1) % romAnimationImport.previewTotalFrames;
-                romAnimationImport.previewLastTickMs += static_cast<Uint64>(msPerFrame);
+            Uint64 now = SDL_GetTicksNS();
+            if (!romAnimationImport.previewClock.isRunning()) {
+                romAnimationImport.previewClock.start(now);
             }
+            const uint64_t due = romAnimationImport.previewClock.advance(now, std::max(1.0, getPlaybackFrameRate()));
+            romAnimationImport.previewCurrentFrame = static_cast<int>(
+                (static_cast<uint64_t>(romAnimationImport.previewCurrentFrame) + due) % romAnimationImport.previewTotalFrames);
         }
 
         if (romAnimationImport.previewValid) {
@@ -1539,8 +1607,9 @@ void Sofanthiel::handleRomAnimationImportPopup()
             ImGui::BeginDisabled();
         }
         if (ImGui::Button(ICON_FA_FILE_IMPORT " Import", getScaledButtonSize(120, 0))) {
-            std::vector<Animation> oldAnimations = animations;
-            std::vector<AnimationCel> oldAnimationCels = animationCels;
+            // the old state shares its elements with the live snapshot instead of being a deep copy
+            auto before = captureDocument();
+            size_t beforeBytes = approximateMemoryUsage(animations) + approximateMemoryUsage(animationCels);
             int oldCurrentAnimation = currentAnimation;
             int oldCurrentFrame = currentFrame;
 
@@ -1562,16 +1631,25 @@ void Sofanthiel::handleRomAnimationImportPopup()
                     currentAnimation = newCurrentAnimation;
                     currentFrame = 0;
                     timelineSelectedEntryIndices.clear();
+                    selectedCelIndices.clear();
                     recalculateTotalFrames();
                 },
-                [this, oldAnimations, oldAnimationCels, oldCurrentAnimation, oldCurrentFrame]() {
-                    animations = oldAnimations;
-                    animationCels = oldAnimationCels;
+                [this, before, oldCurrentAnimation, oldCurrentFrame]() {
+                    animations = before->copyAnimations();
+                    animationCels = before->copyAnimationCels();
                     currentAnimation = oldCurrentAnimation;
                     currentFrame = oldCurrentFrame;
                     timelineSelectedEntryIndices.clear();
+                    selectedCelIndices.clear();
                     recalculateTotalFrames();
-                }));
+                },
+                approximateMemoryUsage(newAnimations) + approximateMemoryUsage(newAnimationCels) + beforeBytes));
+
+            rememberRomOrigins(romAnimationImport.romPath);
+            romOrigins.animationPointers[romAnimationImport.previewAnimation.name] = romAnimationImport.resolvedAnimationPointer;
+            for (size_t i = 0; i < romAnimationImport.previewCels.size() && i < romAnimationImport.previewCelPointers.size(); i++) {
+                romOrigins.celPointers[romAnimationImport.previewCels[i].name] = romAnimationImport.previewCelPointers[i];
+            }
 
             closePopup();
         }
@@ -1603,53 +1681,661 @@ void Sofanthiel::handleRomAnimationImportPopup()
     }
 }
 
-void Sofanthiel::update()
+void Sofanthiel::refreshRomBatchImportPreview()
 {
-    float currentDisplayScale = this->getCurrentDisplayScale();
-    this->applyDisplayScale(currentDisplayScale);
+    romAnimationImport.batchPreviewValid = false;
+    romAnimationImport.batchPreview = RomBatchImportResult();
+    romAnimationImport.batchMessage.clear();
+    if (romAnimationImport.batchPreviewJob != 0) {
+        jobs.cancel(romAnimationImport.batchPreviewJob);
+        romAnimationImport.batchPreviewJob = 0;
+    }
+
+    std::vector<std::string> inputErrors;
+    std::vector<uint32_t> pointers = parseRomPointerList(
+        romAnimationImport.batchPointerBuffer,
+        romAnimationImport.rom->size(),
+        inputErrors);
+    if (pointers.empty()) {
+        romAnimationImport.batchMessage = inputErrors.empty()
+            ? "Add animation pointers, one per line, or read them from a pointer table."
+            : inputErrors.front();
+        return;
+    }
 
-    ImGui_ImplSDLRenderer3_NewFrame();
-    ImGui_ImplSDL3_NewFrame();
-    syncImGuiDisplayMetrics(this->window);
+    // a long pointer list takes a while, the popup keeps going meanwhile. a newer parse or
+    // closing the popup cancels this one, so whatever gets applied is always the latest
+    std::shared_ptr<const MappedFile> rom = romAnimationImport.rom;
+    auto document = captureDocument();
+    std::string namePrefix = sanitizeRomImportName(getFileStem(romAnimationImport.romPath));
+    romAnimationImport.batchPreviewJob = jobs.submit<RomBatchImportResult>("Parsing ROM animations",
+        [rom, document, pointers, namePrefix](JobToken&) {
+            return parseRomAnimationBatch(rom->view(), pointers, namePrefix,
+                document->copyAnimations(), document->copyAnimationCels());
+        },
+        [this, inputErrors](RomBatchImportResult& result) {
+            romAnimationImport.batchPreviewJob = 0;
+            romAnimationImport.batchPreview = std::move(result);
+            romAnimationImport.batchPreview.errors.insert(
+                romAnimationImport.batchPreview.errors.begin(), inputErrors.begin(), inputErrors.end());
+            romAnimationImport.batchPreviewValid = !romAnimationImport.batchPreview.animations.empty();
+            if (!romAnimationImport.batchPreviewValid) {
+                romAnimationImport.batchMessage = "None of the pointers parsed into an animation.";
+            }
+        }).id;
+}
 
-    ImGui::NewFrame();
+bool Sofanthiel::handleRomBatchImport()
+{
+    bool refreshPreview = false;
+
+    ImGui::TextDisabled("Animation pointers, one per line (0xXXXXXX offsets or 08XXXXXX pointers):");
+    ImGui::InputTextMultiline(
+        "##RomBatchPointers",
+        romAnimationImport.batchPointerBuffer,
+        sizeof(romAnimationImport.batchPointerBuffer),
+        ImVec2(getScaledSize(260.0f), getScaledSize(160.0f)));
+
+    ImGui::SameLine();
+    ImGui::BeginGroup();
+    ImGui::SetNextItemWidth(getScaledSize(160.0f));
+    ImGui::InputText("Pointer Table", romAnimationImport.batchTableBuffer, sizeof(romAnimationImport.batchTableBuffer));
+    ImGui::SetNextItemWidth(getScaledSize(160.0f));
+    if (ImGui::InputInt("Count", &romAnimationImport.batchTableCount)) {
+        romAnimationImport.batchTableCount = std::max(0, romAnimationImport.batchTableCount);
+    }
+    if (ImGui::IsItemHovered()) {
+        ImGui::SetTooltip("0 reads until the first entry that isn't a ROM pointer.");
+    }
+    if (ImGui::Button("Read Table")) {
+        uint32_t tablePointer = 0;
+        std::string error;
+        if (tryParseRomAnimationPointerInput(romAnimationImport.batchTableBuffer, romAnimationImport.rom->size(), tablePointer, error)) {
+            for (uint32_t pointer : readRomPointerTable(romAnimationImport.rom->view(), tablePointer, romAnimationImport.batchTableCount)) {
+                appendRomPointerToList(romAnimationImport.batchPointerBuffer, sizeof(romAnimationImport.batchPointerBuffer), pointer);
+            }
+            refreshPreview = true;
+        }
+        else {
+            romAnimationImport.batchMessage = error;
+        }
+    }
 
-    ImGui::DockSpaceOverViewport(ImGui::GetID("Sofanthiel"), ImGui::GetMainViewport(), ImGuiDockNodeFlags_PassthruCentralNode);
-    
-    if (!isDockingLayoutSetup) {
-        this->setupDockingLayout();
-        isDockingLayoutSetup = true;
+    if (romAnimationImport.scanFinished) {
+        std::vector<int> visibleResults = filterRomScanResults(romAnimationImport);
+        char label[64];
+        snprintf(label, sizeof(label), "Add %d Scan Results", static_cast<int>(visibleResults.size()));
+        if (ImGui::Button(label)) {
+            for (int index : visibleResults) {
+                appendRomPointerToList(romAnimationImport.batchPointerBuffer, sizeof(romAnimationImport.batchPointerBuffer),
+                    romAnimationImport.scanResults[index].pointer);
+            }
+            refreshPreview = true;
+        }
     }
 
-    this->updateWindowTitle();
+    if (ImGui::Button("Parse Batch")) {
+        refreshPreview = true;
+    }
+    ImGui::EndGroup();
+
+    if (refreshPreview) {
+        refreshRomBatchImportPreview();
+    }
+
+    const RomBatchImportResult& batch = romAnimationImport.batchPreview;
+    if (romAnimationImport.batchPreviewValid) {
+        ImGui::TextColored(
+            ImVec4(0.60f, 0.82f, 0.62f, 1.0f),
+            "%d animations, %d new cels (%d shared between them, %d already in the project) in %llu ms.",
+            static_cast<int>(batch.animations.size()),
+            static_cast<int>(batch.cels.size()),
+            batch.sharedCels,
+            batch.reusedCels,
+            static_cast<unsigned long long>(batch.durationMs));
+    }
+    else if (romAnimationImport.batchPreviewJob != 0) {
+        ImGui::TextDisabled("Parsing...");
+    }
+    else if (!romAnimationImport.batchMessage.empty()) {
+        ImGui::TextDisabled("%s", romAnimationImport.batchMessage.c_str());
+    }
+
+    ImGui::Spacing();
+    ImGui::Separator();
+    ImGui::Spacing();
+
+    float footerHeight = ImGui::GetFrameHeightWithSpacing() * 2.0f + getScaledSize(20.0f);
+    ImGui::BeginChild("RomBatchImportList", ImVec2(0, ImMax(getScaledSize(160.0f), ImGui::GetContentRegionAvail().y - footerHeight)), ImGuiChildFlags_Borders);
+    for (size_t i = 0; i < batch.animations.size(); i++) {
+        const Animation& animation = batch.animations[i];
+        ImGui::Text("0x%s  %4d entries  %s",
+            formatGbaPointer(batch.animationPointers[i]).c_str(),
+            static_cast<int>(animation.entries.size()),
+            animation.name.c_str());
+    }
+    for (const auto& error : batch.errors) {
+        ImGui::TextColored(ImVec4(1.0f, 0.70f, 0.35f, 1.0f), "%s", error.c_str());
+    }
+    ImGui::EndChild();
+
+    ImGui::Spacing();
+    ImGui::Separator();
+    ImGui::Spacing();
+
+    bool importClicked = false;
+    if (!romAnimationImport.batchPreviewValid) {
+        ImGui::BeginDisabled();
+    }
+    if (ImGui::Button(ICON_FA_FILE_IMPORT " Import All", getScaledButtonSize(140, 0))) {
+        // one undo step for the whole batch, same shape as the single import
+        auto before = captureDocument();
+        size_t beforeBytes = approximateMemoryUsage(animations) + approximateMemoryUsage(animationCels);
+        int oldCurrentAnimation = currentAnimation;
+        int oldCurrentFrame = currentFrame;
+
+        std::vector<Animation> newAnimations = animations;
+        std::vector<AnimationCel> newAnimationCels = animationCels;
+        int newCurrentAnimation = static_cast<int>(newAnimations.size());
+        newAnimations.insert(newAnimations.end(), batch.animations.begin(), batch.animations.end());
+        newAnimationCels.insert(newAnimationCels.end(), batch.cels.begin(), batch.cels.end());
+
+        char description[64];
+        snprintf(description, sizeof(description), "Import %d Animations From ROM", static_cast<int>(batch.animations.size()));
+        undoManager.execute(std::make_unique<LambdaAction>(
+            description,
+            [this, newAnimations, newAnimationCels, newCurrentAnimation]() {
+                animations = newAnimations;
+                animationCels = newAnimationCels;
+                currentAnimation = newCurrentAnimation;
+                currentFrame = 0;
+                timelineSelectedEntryIndices.clear();
+                selectedCelIndices.clear();
+                recalculateTotalFrames();
+            },
+            [this, before, oldCurrentAnimation, oldCurrentFrame]() {
+                animations = before->copyAnimations();
+                animationCels = before->copyAnimationCels();
+                currentAnimation = oldCurrentAnimation;
+                currentFrame = oldCurrentFrame;
+                timelineSelectedEntryIndices.clear();
+                selectedCelIndices.clear();
+                recalculateTotalFrames();
+            },
+            approximateMemoryUsage(newAnimations) + approximateMemoryUsage(newAnimationCels) + beforeBytes));
+
+        rememberRomOrigins(romAnimationImport.romPath);
+        for (size_t i = 0; i < batch.animations.size(); i++) {
+            romOrigins.animationPointers[batch.animations[i].name] = batch.animationPointers[i];
+        }
+        for (size_t i = 0; i < batch.cels.size(); i++) {
+            romOrigins.celPointers[batch.cels[i].name] = batch.celPointers[i];
+        }
 
-    handleMenuBar();
+        importClicked = true;
+    }
+    if (!romAnimationImport.batchPreviewValid) {
+        ImGui::EndDisabled();
+    }
 
-    if (showExitConfirmation) {
-        showAboutDialog = false;
-        if (ImGui::IsPopupOpen("About Sofanthiel")) {
-            ImGui::ClosePopupToLevel(0, true);
-        }
-    } else {
-        handleAboutDialog();
+    ImGui::SameLine();
+    if (ImGui::Button(ICON_FA_XMARK " Cancel", getScaledButtonSize(110, 0)) || ImGui::IsKeyPressed(ImGuiKey_Escape)) {
+        return true;
     }
+    return importClicked;
+}
 
-    if (showExitConfirmation) {
-        ImGui::OpenPopup("Confirm Exit");
-        ImVec2 center = ImGui::GetMainViewport()->GetCenter();
-        ImGui::SetNextWindowPos(center, ImGuiCond_Appearing, ImVec2(0.5f, 0.5f));
+void Sofanthiel::rememberRomOrigins(const std::string& romPath)
+{
+    // pointers only mean something in the ROM they came from
+    if (romOrigins.romPath != romPath) {
+        romOrigins.clear();
+        romOrigins.romPath = romPath;
+    }
+}
 
-        if (ImGui::BeginPopupModal("Confirm Exit", NULL, ImGuiWindowFlags_AlwaysAutoResize)) {
-            ImGui::Text("Are you sure you want to exit Sofanthiel?");
-            ImGui::Separator();
+void Sofanthiel::beginRomPatchExport()
+{
+    romPatchExport = RomPatchExportState();
+    romPatchExport.baseRomPath = romOrigins.romPath;
+    if (!romOrigins.romPath.empty()) {
+        size_t dot = romOrigins.romPath.find_last_of('.');
+        size_t slash = romOrigins.romPath.find_last_of("/\\");
+        std::string base = (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+            ? romOrigins.romPath
+            : romOrigins.romPath.substr(0, dot);
+        romPatchExport.outputPath = base + "_patched.gba";
+    }
+    romPatchExport.showPopup = true;
+    romPatchExport.popupPendingOpen = true;
+}
 
-            if (ImGui::Button("Yes", getScaledButtonSize(120, 0))) {
-                this->isRunning = false;
-                ImGui::CloseCurrentPopup();
-                showExitConfirmation = false;
-            }
+void Sofanthiel::runRomPatchExport()
+{
+    romPatchExport.hasResult = true;
+    romPatchExport.writtenFiles.clear();
+    romPatchExport.result = RomPatchResult();
+    RomPatchResult& result = romPatchExport.result;
+
+    MappedFile rom;
+    std::string error;
+    if (!rom.open(romPatchExport.baseRomPath, error)) {
+        result.errorMessage = "Couldn't open the base ROM: " + error;
+        return;
+    }
 
-            ImGui::SameLine();
+    Uint64 startNS = SDL_GetTicksNS();
+    result = buildRomPatch(rom.view(), animationCels, animations, romOrigins);
+    if (!result.success) {
+        return;
+    }
+
+    const ByteView patched(result.rom.data(), result.rom.size());
+    if (!writeFileAtomically(romPatchExport.outputPath, result.rom, error)) {
+        result.success = false;
+        result.errorMessage = "Couldn't write " + romPatchExport.outputPath + ": " + error;
+        return;
+    }
+    romPatchExport.writtenFiles.push_back(romPatchExport.outputPath);
+
+    // the patches sit next to the patched ROM, named after it
+    std::string patchBase = romPatchExport.outputPath;
+    size_t dot = patchBase.find_last_of('.');
+    if (dot != std::string::npos && dot > patchBase.find_last_of("/\\") + 1) {
+        patchBase.erase(dot);
+    }
+
+    if (romPatchExport.writeIps) {
+        std::vector<uint8_t> ips = buildIpsPatch(rom.view(), patched, error);
+        if (ips.empty()) {
+            result.warnings.push_back(error);
+        }
+        else if (writeFileAtomically(patchBase + ".ips", ips, error)) {
+            romPatchExport.writtenFiles.push_back(patchBase + ".ips");
+        }
+        else {
+            result.warnings.push_back("Couldn't write " + patchBase + ".ips: " + error);
+        }
+    }
+    if (romPatchExport.writeBps) {
+        if (writeFileAtomically(patchBase + ".bps", buildBpsPatch(rom.view(), patched), error)) {
+            romPatchExport.writtenFiles.push_back(patchBase + ".bps");
+        }
+        else {
+            result.warnings.push_back("Couldn't write " + patchBase + ".bps: " + error);
+        }
+    }
+
+    result.durationMs = (SDL_GetTicksNS() - startNS) / 1000000;
+    SDL_Log("Patched %s into %s in %llu ms: %d/%d/%d cels unchanged/in place/moved (%d new), %d/%d/%d animations, %d pointers repointed",
+        romPatchExport.baseRomPath.c_str(), romPatchExport.outputPath.c_str(), static_cast<unsigned long long>(result.durationMs),
+        result.celsUnchanged, result.celsInPlace, result.celsRelocated, result.celsAdded,
+        result.animationsUnchanged, result.animationsInPlace, result.animationsRelocated, result.pointersRepointed);
+
+    // no reason to hold on to a whole ROM just for the summary
+    result.rom.clear();
+    result.rom.shrink_to_fit();
+}
+
+void Sofanthiel::handleRomPatchExportPopup()
+{
+    ImGuiViewport* viewport = ImGui::GetMainViewport();
+
+    if (romPatchExport.popupPendingOpen) {
+        ImGui::OpenPopup("Patch ROM");
+        ImGui::SetNextWindowPos(viewport->GetCenter(), ImGuiCond_Appearing, ImVec2(0.5f, 0.5f));
+        ImGui::SetNextWindowSize(ImVec2(getScaledSize(620.0f), getScaledSize(440.0f)), ImGuiCond_Appearing);
+        romPatchExport.popupPendingOpen = false;
+    }
+
+    bool keepOpen = romPatchExport.showPopup;
+    if (ImGui::BeginPopupModal("Patch ROM", &keepOpen, ImGuiWindowFlags_NoSavedSettings)) {
+        romPatchExport.showPopup = keepOpen;
+
+        ImGui::TextWrapped("Writes the animations imported from a ROM, and the cels they use, back into a copy of it. "
+            "Data that still fits stays where it was, anything that grew moves into free space and gets repointed.");
+        ImGui::Spacing();
+
+        nfdchar_t* outPath = nullptr;
+        ImGui::TextWrapped("Base ROM: %s", romPatchExport.baseRomPath.empty() ? "(none)" : romPatchExport.baseRomPath.c_str());
+        ImGui::SameLine();
+        if (ImGui::Button("Browse##PatchBase")) {
+            if (NFD_OpenDialog("gba,bin", nullptr, &outPath) == NFD_OKAY) {
+                romPatchExport.baseRomPath = outPath;
+                free(outPath);
+            }
+        }
+        ImGui::TextWrapped("Output: %s", romPatchExport.outputPath.empty() ? "(none)" : romPatchExport.outputPath.c_str());
+        ImGui::SameLine();
+        if (ImGui::Button("Browse##PatchOutput")) {
+            if (NFD_SaveDialog("gba", nullptr, &outPath) == NFD_OKAY) {
+                romPatchExport.outputPath = outPath;
+                free(outPath);
+            }
+        }
+
+        ImGui::Checkbox("Also write an .ips patch", &romPatchExport.writeIps);
+        ImGui::SameLine();
+        ImGui::Checkbox("Also write a .bps patch", &romPatchExport.writeBps);
+
+        if (!romOrigins.romPath.empty() && romPatchExport.baseRomPath != romOrigins.romPath) {
+            ImGui::TextColored(ImVec4(0.95f, 0.75f, 0.35f, 1.0f), "The animations were imported from %s.", romOrigins.romPath.c_str());
+        }
+
+        ImGui::Spacing();
+        ImGui::Separator();
+        ImGui::Spacing();
+
+        float footerHeight = ImGui::GetFrameHeightWithSpacing() + ImGui::GetStyle().ItemSpacing.y;
+        ImGui::BeginChild("RomPatchResult", ImVec2(0, -footerHeight), ImGuiChildFlags_Borders);
+        if (romPatchExport.hasResult) {
+            const RomPatchResult& result = romPatchExport.result;
+            if (!result.success) {
+                ImGui::TextColored(ImVec4(0.95f, 0.45f, 0.45f, 1.0f), "%s", result.errorMessage.c_str());
+            }
+            else {
+                ImGui::Text("Done in %llu ms.", static_cast<unsigned long long>(result.durationMs));
+                ImGui::Text("Cels: %d unchanged, %d in place, %d moved, %d new",
+                    result.celsUnchanged, result.celsInPlace, result.celsRelocated, result.celsAdded);
+                ImGui::Text("Animations: %d unchanged, %d in place, %d moved",
+                    result.animationsUnchanged, result.animationsInPlace, result.animationsRelocated);
+                ImGui::Text("%d pointers repointed, %zu bytes of free space used", result.pointersRepointed, result.bytesAllocated);
+                for (const std::string& file : romPatchExport.writtenFiles) {
+                    ImGui::TextDisabled("Wrote %s", file.c_str());
+                }
+            }
+            for (const std::string& warning : result.warnings) {
+                ImGui::TextColored(ImVec4(0.95f, 0.75f, 0.35f, 1.0f), "%s", warning.c_str());
+            }
+        }
+        ImGui::EndChild();
+
+        bool canPatch = !romPatchExport.baseRomPath.empty() && !romPatchExport.outputPath.empty() &&
+            romPatchExport.outputPath != romPatchExport.baseRomPath;
+        if (!canPatch) {
+            ImGui::BeginDisabled();
+        }
+        if (ImGui::Button(ICON_FA_FLOPPY_DISK " Patch", getScaledButtonSize(110, 0))) {
+            runRomPatchExport();
+        }
+        if (!canPatch) {
+            ImGui::EndDisabled();
+        }
+
+        ImGui::SameLine();
+        if (ImGui::Button(ICON_FA_XMARK " Close", getScaledButtonSize(110, 0)) || ImGui::IsKeyPressed(ImGuiKey_Escape)) {
+            romPatchExport = RomPatchExportState();
+            ImGui::CloseCurrentPopup();
+        }
+
+        ImGui::EndPopup();
+    }
+    else if (!keepOpen) {
+        romPatchExport = RomPatchExportState();
+    }
+}
+
+void Sofanthiel::beginRomGraphicsImport(const std::string& romPath)
+{
+    auto rom = std::make_shared<MappedFile>();
+    std::string error;
+    if (!rom->open(romPath, error)) {
+        SDL_Log("Failed to open ROM file for graphics import: %s (%s)", romPath.c_str(), error.c_str());
+        return;
+    }
+
+    romGraphicsImport = RomGraphicsImportState();
+    romGraphicsImport.romPath = romPath;
+    romGraphicsImport.rom = std::move(rom);
+    romGraphicsImport.showPopup = true;
+    romGraphicsImport.popupPendingOpen = true;
+    romGraphicsImport.message = "Enter the ROM offset of LZ77, RLE or Huffman compressed graphics.";
+}
+
+void Sofanthiel::refreshRomGraphicsImportPreview()
+{
+    romGraphicsImport.previewValid = false;
+    romGraphicsImport.offset = 0;
+    romGraphicsImport.previewTiles.clear();
+    romGraphicsImport.type = 0;
+    romGraphicsImport.compressedSize = 0;
+    romGraphicsImport.decodeMs = 0.0;
+
+    uint32_t pointer = 0;
+    std::string error;
+    if (!tryParseRomAnimationPointerInput(romGraphicsImport.offsetBuffer, romGraphicsImport.rom->size(), pointer, error) ||
+        !tryConvertRomPointerToOffset(pointer, romGraphicsImport.rom->size(), romGraphicsImport.offset, &error)) {
+        romGraphicsImport.message = error;
+        return;
+    }
+
+    const ByteView view = romGraphicsImport.rom->view();
+    const uint8_t* data = view.getData() + romGraphicsImport.offset;
+    const size_t available = view.getSize() - romGraphicsImport.offset;
+
+    uint8_t type = 0;
+    size_t decompressedSize = 0;
+    Compression::readHeader(data, available, type, decompressedSize);
+
+    Uint64 startNS = SDL_GetTicksNS();
+    romGraphicsImport.previewTiles = ResourceManager::loadCompressedTiles(data, available, error, &romGraphicsImport.compressedSize);
+    romGraphicsImport.decodeMs = static_cast<double>(SDL_GetTicksNS() - startNS) / 1e6;
+
+    if (romGraphicsImport.previewTiles.getSize() == 0) {
+        romGraphicsImport.message = error;
+        return;
+    }
+
+    romGraphicsImport.type = type;
+    romGraphicsImport.previewValid = true;
+    romGraphicsImport.message.clear();
+}
+
+void Sofanthiel::handleRomGraphicsImportPopup()
+{
+    auto closePopup = [this]() {
+        romGraphicsImport = RomGraphicsImportState();
+        ImGui::CloseCurrentPopup();
+    };
+
+    ImGuiViewport* viewport = ImGui::GetMainViewport();
+    ImVec2 minWindowSize(getScaledSize(560.0f), getScaledSize(420.0f));
+    ImVec2 maxWindowSize(viewport->WorkSize.x * 0.96f, viewport->WorkSize.y * 0.92f);
+
+    if (romGraphicsImport.popupPendingOpen) {
+        ImGui::OpenPopup("Import Graphics From ROM");
+        ImGui::SetNextWindowPos(viewport->GetCenter(), ImGuiCond_Appearing, ImVec2(0.5f, 0.5f));
+        ImGui::SetNextWindowSize(ImVec2(getScaledSize(640.0f), getScaledSize(560.0f)), ImGuiCond_Appearing);
+        romGraphicsImport.popupPendingOpen = false;
+    }
+
+    ImGui::SetNextWindowSizeConstraints(minWindowSize, maxWindowSize);
+
+    if (romGraphicsImport.showPopup && !romGraphicsImport.rom) {
+        romGraphicsImport = RomGraphicsImportState();
+        return;
+    }
+
+    bool keepOpen = romGraphicsImport.showPopup;
+    if (ImGui::BeginPopupModal("Import Graphics From ROM", &keepOpen, ImGuiWindowFlags_NoSavedSettings)) {
+        romGraphicsImport.showPopup = keepOpen;
+
+        ImGui::TextWrapped("Selected ROM: %s", romGraphicsImport.romPath.c_str());
+        ImGui::Spacing();
+
+        ImGui::SetNextItemWidth(getScaledSize(220.0f));
+        if (ImGui::InputText("ROM Offset", romGraphicsImport.offsetBuffer, sizeof(romGraphicsImport.offsetBuffer))) {
+            refreshRomGraphicsImportPreview();
+        }
+        if (ImGui::IsItemHovered()) {
+            ImGui::SetTooltip("Accepts either 0xXXXXXX ROM offsets or 08XXXXXX GBA ROM pointers.");
+        }
+
+        ImGui::SameLine();
+        if (ImGui::Button(ICON_FA_FORWARD " Find Next")) {
+            // step past the stream being shown, otherwise search from wherever the typed offset points
+            size_t from = romGraphicsImport.previewValid ? romGraphicsImport.offset + 1 : romGraphicsImport.offset;
+            size_t next = 0;
+            if (findNextCompressedTiles(romGraphicsImport.rom->view(), from, next)) {
+                snprintf(romGraphicsImport.offsetBuffer, sizeof(romGraphicsImport.offsetBuffer), "0x%06zX", next);
+                refreshRomGraphicsImportPreview();
+            }
+            else {
+                romGraphicsImport.message = "No more compressed graphics past this offset.";
+            }
+        }
+        if (ImGui::IsItemHovered()) {
+            ImGui::SetTooltip("Jumps to the next word aligned offset that decompresses into whole tiles.");
+        }
+
+        if (romGraphicsImport.previewValid) {
+            ImGui::TextDisabled("%s, %zu -> %d bytes (%d tiles), decoded in %.3f ms",
+                Compression::getTypeName(romGraphicsImport.type),
+                romGraphicsImport.compressedSize,
+                romGraphicsImport.previewTiles.getSize() * 32,
+                romGraphicsImport.previewTiles.getSize(),
+                romGraphicsImport.decodeMs);
+        }
+        else {
+            ImGui::TextColored(ImVec4(0.95f, 0.45f, 0.45f, 1.0f), "%s", romGraphicsImport.message.c_str());
+        }
+
+        ImGui::Spacing();
+
+        float footerHeight = ImGui::GetFrameHeightWithSpacing() + ImGui::GetStyle().ItemSpacing.y;
+        ImGui::BeginChild("RomGraphicsPreview", ImVec2(0, -footerHeight), ImGuiChildFlags_Borders);
+        if (romGraphicsImport.previewValid) {
+            const Tiles& preview = romGraphicsImport.previewTiles;
+            const int tilesPerRow = TILES_PER_LINE;
+            const float pixelSize = ImMax(1.0f, std::floor(ImGui::GetContentRegionAvail().x / (tilesPerRow * 8.0f)));
+            const float tileSize = 8.0f * pixelSize;
+            const int rows = (preview.getSize() + tilesPerRow - 1) / tilesPerRow;
+
+            // greyscale ramp until there's a palette to look at it through
+            int safePalette = palettes.empty() ? -1 : SDL_clamp(currentPalette, 0, static_cast<int>(palettes.size()) - 1);
+
+            ImDrawList* drawList = ImGui::GetWindowDrawList();
+            ImGuiListClipper clipper;
+            clipper.Begin(rows, tileSize);
+            while (clipper.Step()) {
+                for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; row++) {
+                    ImVec2 rowOrigin = ImGui::GetCursorScreenPos();
+                    for (int col = 0; col < tilesPerRow; col++) {
+                        int tileIndex = row * tilesPerRow + col;
+                        if (tileIndex >= preview.getSize()) break;
+
+                        TileData tile = preview.getTile(tileIndex);
+                        float xPos = rowOrigin.x + col * tileSize;
+                        for (int y = 0; y < 8; y++) {
+                            for (int x = 0; x < 8; x++) {
+                                uint8_t colorIdx = tile.data[y][x];
+                                ImU32 color = IM_COL32(colorIdx * 17, colorIdx * 17, colorIdx * 17, 255);
+                                if (safePalette >= 0) {
+                                    SDL_Color paletteColor = palettes[safePalette].colors[colorIdx];
+                                    color = IM_COL32(paletteColor.r, paletteColor.g, paletteColor.b, 255);
+                                }
+
+                                drawList->AddRectFilled(
+                                    ImVec2(xPos + x * pixelSize, rowOrigin.y + y * pixelSize),
+                                    ImVec2(xPos + (x + 1) * pixelSize, rowOrigin.y + (y + 1) * pixelSize),
+                                    color);
+                            }
+                        }
+                    }
+                    ImGui::Dummy(ImVec2(tilesPerRow * tileSize, tileSize));
+                }
+            }
+            clipper.End();
+        }
+        ImGui::EndChild();
+
+        if (!romGraphicsImport.previewValid) {
+            ImGui::BeginDisabled();
+        }
+        if (ImGui::Button(ICON_FA_FILE_IMPORT " Import", getScaledButtonSize(110, 0))) {
+            this->tiles = romGraphicsImport.previewTiles;
+            this->tilePalettes.clear();
+            this->stopWatchingSource(WatchedSourceKind::Tiles);
+            SDL_Log("Imported %d tiles from %s at 0x%06zX", this->tiles.getSize(),
+                romGraphicsImport.romPath.c_str(), romGraphicsImport.offset);
+            closePopup();
+        }
+        if (!romGraphicsImport.previewValid) {
+            ImGui::EndDisabled();
+        }
+
+        ImGui::SameLine();
+        if (ImGui::Button(ICON_FA_XMARK " Cancel", getScaledButtonSize(110, 0)) || ImGui::IsKeyPressed(ImGuiKey_Escape)) {
+            closePopup();
+        }
+
+        ImGui::EndPopup();
+    }
+    else if (!keepOpen) {
+        romGraphicsImport = RomGraphicsImportState();
+    }
+}
+
+void Sofanthiel::update()
+{
+    float currentDisplayScale = this->getCurrentDisplayScale();
+    this->applyDisplayScale(currentDisplayScale);
+
+    ImGui_ImplSDLRenderer3_NewFrame();
+    ImGui_ImplSDL3_NewFrame();
+    syncImGuiDisplayMetrics(this->window);
+
+    ImGui::NewFrame();
+
+    ImGui::DockSpaceOverViewport(ImGui::GetID("Sofanthiel"), ImGui::GetMainViewport(), ImGuiDockNodeFlags_PassthruCentralNode);
+    
+    if (!isDockingLayoutSetup) {
+        this->setupDockingLayout();
+        isDockingLayoutSetup = true;
+    }
+
+    this->updateWindowTitle();
+
+    pollProjectSave();
+    jobs.applyFinished();
+    startQueuedFileImport();
+    pollWatchedFiles();
+    tileUsage.sync(animationCels, tiles.getSize());
+    celUsage.sync(animations);
+
+    // undo/redo already journal on every change, this catches imports and other direct edits
+    constexpr Uint64 kJournalIntervalMs = 2000;
+    if (SDL_GetTicks() - lastJournalTick >= kJournalIntervalMs) {
+        journalDocument();
+    }
+
+    handleMenuBar();
+
+    if (showExitConfirmation) {
+        showAboutDialog = false;
+        if (ImGui::IsPopupOpen("About Sofanthiel")) {
+            ImGui::ClosePopupToLevel(0, true);
+        }
+    } else {
+        handleAboutDialog();
+    }
+
+    if (showExitConfirmation) {
+        ImGui::OpenPopup("Confirm Exit");
+        ImVec2 center = ImGui::GetMainViewport()->GetCenter();
+        ImGui::SetNextWindowPos(center, ImGuiCond_Appearing, ImVec2(0.5f, 0.5f));
+
+        if (ImGui::BeginPopupModal("Confirm Exit", NULL, ImGuiWindowFlags_AlwaysAutoResize)) {
+            ImGui::Text("Are you sure you want to exit Sofanthiel?");
+            ImGui::Separator();
+
+            if (ImGui::Button("Yes", getScaledButtonSize(120, 0))) {
+                this->isRunning = false;
+                ImGui::CloseCurrentPopup();
+                showExitConfirmation = false;
+            }
+
+            ImGui::SameLine();
             if (ImGui::Button("No", getScaledButtonSize(120, 0)) || ImGui::IsKeyPressed(ImGuiKey_Escape)) {
                 ImGui::CloseCurrentPopup();
                 showExitConfirmation = false;
@@ -1659,8 +2345,12 @@ void Sofanthiel::update()
         }
     }
 
+    handleRecoveryPopup();
+    handleUndoHistory();
     handlePaletteImportPopup();
     handleRomAnimationImportPopup();
+    handleRomGraphicsImportPopup();
+    handleRomPatchExportPopup();
 
     if (!this->celEditingMode) {
         handleTimeline();
@@ -1726,19 +2416,28 @@ void Sofanthiel::handleMenuBar()
     if (ImGui::BeginMainMenuBar()) {
         if (ImGui::BeginMenu("File")) {
             if (ImGui::MenuItem(ICON_FA_FILE " New", "Ctrl+N")) {
+                // a project still being read would land on top of the new one
+                this->cancelProjectLoad();
                 this->animationCels.clear();
                 this->animations.clear();
                 this->palettes.clear();
                 this->tiles = Tiles();
+                this->tilePalettes.clear();
+                this->useTilePalettes = false;
                 this->celEditingMode = false;
                 this->editingCelIndex = -1;
 				this->selectedOAMIndices.clear();
+                this->selectedCelIndices.clear();
                 this->undoManager.clear();
                 this->currentProjectPath.clear();
+                this->pendingSavePath.clear();
+                this->clearWatchedSources();
+                this->romOrigins.clear();
 
                 this->initializeDefaultPalettes();
                 this->currentPalette = 0;
                 this->updateWindowTitle();
+                this->resetJournal("");
             }
             if (ImGui::MenuItem(ICON_FA_FOLDER_OPEN " Open", "Ctrl+O", nullptr, true)) {
                 nfdresult_t result = NFD_OpenDialog("inv", nullptr, &outPath);
@@ -1775,17 +2474,42 @@ void Sofanthiel::handleMenuBar()
                     saveProject(savePath);
                 }
             }
+            ImGui::MenuItem("Compress Project Sections", nullptr, &compressProjectFile);
+            if (ImGui::IsItemHovered()) {
+                ImGui::SetTooltip("LZ77 compress project sections when saving (smaller files, a bit slower to save)");
+            }
             ImGui::Separator();
             if (ImGui::BeginMenu(ICON_FA_FILE_IMPORT " Import")) {
-                if (ImGui::MenuItem(ICON_FA_IMAGE " Spritesheet (.4bpp, .bin, .image)")) {
-					nfdresult_t result = NFD_OpenDialog("4bpp,bin,png,bmp", nullptr, &outPath);
+                if (ImGui::MenuItem(ICON_FA_FOLDER_OPEN " Files...")) {
+                    nfdpathset_t pathSet;
+                    if (NFD_OpenDialogMultiple("4bpp,bin,lz,png,bmp,jpg,jpeg,pal,c", nullptr, &pathSet) == NFD_OKAY) {
+                        std::vector<std::string> paths;
+                        for (size_t i = 0; i < NFD_PathSet_GetCount(&pathSet); i++) {
+                            paths.push_back(NFD_PathSet_GetPath(&pathSet, i));
+                        }
+                        NFD_PathSet_Free(&pathSet);
+                        importFiles(paths);
+                    }
+                }
+                if (ImGui::IsItemHovered()) {
+                    ImGui::SetTooltip("Pick several files at once, they're decoded in parallel and added together");
+                }
+                if (ImGui::MenuItem(ICON_FA_IMAGE " Spritesheet (.4bpp, .bin, .lz, .image)")) {
+					nfdresult_t result = NFD_OpenDialog("4bpp,bin,lz,png,bmp", nullptr, &outPath);
 
                     if (result == NFD_OKAY) {
 						std::string outPathStr(outPath);
-                        if (outPathStr.substr(outPathStr.find_last_of(".") + 1) == "4bpp" || outPathStr.substr(outPathStr.find_last_of(".") + 1) == "bin") {
+                        std::string ext = outPathStr.substr(outPathStr.find_last_of(".") + 1);
+                        if (ext == "4bpp" || ext == "bin" || ext == "lz") {
                             this->tiles = ResourceManager::loadTiles(outPath);
+                            this->tilePalettes.clear();
+                            this->watchImportedFile(outPathStr, WatchedSourceKind::Tiles);
                         } else {
-                            this->tiles = ResourceManager::loadTilesFromImageAndPalette(outPath, this->palettes, this->currentPalette);
+                            int tilesPerRow = this->spritesheetTilesPerRow;
+                            this->tiles = ResourceManager::loadTilesFromImageAndPalette(outPath, this->palettes, this->currentPalette, &tilesPerRow);
+                            this->spritesheetTilesPerRow = SDL_max(1, tilesPerRow);
+                            this->tilePalettes.clear();
+                            this->stopWatchingSource(WatchedSourceKind::Tiles);
 						}
                         free(outPath);
                     }
@@ -1797,6 +2521,7 @@ void Sofanthiel::handleMenuBar()
                         std::string outPathStr(outPath);
                         if(outPathStr.substr(outPathStr.find_last_of(".") + 1) == "pal") {
                             this->palettes = ResourceManager::loadPalettes(outPath);
+                            this->watchImportedFile(outPathStr, WatchedSourceKind::Palettes);
                         } else {
                             beginPaletteImport(ResourceManager::parsePalettesFromCFile(outPath));
                         }
@@ -1808,12 +2533,14 @@ void Sofanthiel::handleMenuBar()
 
                     if (result == NFD_OKAY) {
                         this->animationCels = ResourceManager::loadAnimationCels(outPath);
+                        this->selectedCelIndices.clear();
                         std::string fullPath(outPath);
                         size_t lastSlash = fullPath.find_last_of("/\\");
                         if (lastSlash != std::string::npos)
                             this->animationCelFilename = fullPath.substr(lastSlash + 1);
                         else
                             this->animationCelFilename = fullPath;
+                        this->watchImportedFile(fullPath, WatchedSourceKind::AnimationCels);
                         free(outPath);
                     }
                 }
@@ -1822,6 +2549,7 @@ void Sofanthiel::handleMenuBar()
 
                     if (result == NFD_OKAY) {
                         this->animations = ResourceManager::loadAnimations(outPath);
+                        this->watchImportedFile(std::string(outPath), WatchedSourceKind::Animations);
                         free(outPath);
                     }
                 }
@@ -1833,22 +2561,24 @@ void Sofanthiel::handleMenuBar()
                         free(outPath);
                     }
                 }
+                if (ImGui::MenuItem("Graphics from ROM...")) {
+                    nfdresult_t result = NFD_OpenDialog("gba,bin", nullptr, &outPath);
+
+                    if (result == NFD_OKAY) {
+                        beginRomGraphicsImport(std::string(outPath));
+                        free(outPath);
+                    }
+                }
                 ImGui::Separator();
                 if (ImGui::MenuItem(ICON_FA_WAND_MAGIC_SPARKLES " Convert Image to Spritesheet + Palette")) {
                     nfdresult_t result = NFD_OpenDialog("png,bmp,jpg,jpeg", nullptr, &outPath);
                     if (result == NFD_OKAY) {
-                        Tiles newTiles;
-                        std::vector<Palette> newPalettes;
-                        if (ResourceManager::convertImageToSpritesheetAndPalette(outPath, newTiles, newPalettes)) {
-                            this->tiles = newTiles;
-                            this->palettes = newPalettes;
-                            this->currentPalette = 0;
-                        }
+                        startImageConversion(std::string(outPath));
                         free(outPath);
                     }
                 }
                 if (ImGui::IsItemHovered()) {
-                    ImGui::SetTooltip("Load an image and auto-extract a 16-color palette + spritesheet");
+                    ImGui::SetTooltip("Load an image and auto-extract up to 16 palettes + spritesheet, tiles grouped by the colors they use");
                 }
                 ImGui::EndMenu();
             }
@@ -1867,12 +2597,14 @@ void Sofanthiel::handleMenuBar()
                         free(outPath);
                     }
                 }
-                if (ImGui::MenuItem(ICON_FA_IMAGE " Spritesheet (.4bpp, .bin, .image)")) {
-                    nfdresult_t result = NFD_SaveDialog("4bpp,bin,png,bmp", nullptr, &outPath);
+                if (ImGui::MenuItem(ICON_FA_IMAGE " Spritesheet (.4bpp, .bin, .lz, .image)")) {
+                    nfdresult_t result = NFD_SaveDialog("4bpp,bin,lz,png,bmp", nullptr, &outPath);
                     if (result == NFD_OKAY) {
                         std::string outPathStr(outPath);
-                        if (outPathStr.substr(outPathStr.find_last_of(".") + 1) == "4bpp" || outPathStr.substr(outPathStr.find_last_of(".") + 1) == "bin") {
-                            ResourceManager::saveTiles(outPath, this->tiles);
+                        std::string ext = outPathStr.substr(outPathStr.find_last_of(".") + 1);
+                        if (ext == "4bpp" || ext == "bin" || ext == "lz") {
+                            ResourceManager::saveTiles(outPath, this->tiles, false,
+                                optimalTileCompression ? Compression::LZ77Mode::Optimal : Compression::LZ77Mode::Greedy);
                         }
                         else {
                             ResourceManager::saveTilesToImage(outPath, this->tiles, this->palettes);
@@ -1880,6 +2612,10 @@ void Sofanthiel::handleMenuBar()
                         free(outPath);
                     }
 				}
+                ImGui::MenuItem("Optimal LZ77 for .lz", nullptr, &optimalTileCompression);
+                if (ImGui::IsItemHovered()) {
+                    ImGui::SetTooltip("Smallest possible .lz spritesheets (a few times slower), off for a quick greedy pass");
+                }
                 if (ImGui::MenuItem(ICON_FA_PALETTE " Palettes (.pal, .c)")) {
 					nfdresult_t result = NFD_SaveDialog("pal,c", nullptr, &outPath);
                     if (result == NFD_OKAY) {
@@ -1887,6 +2623,9 @@ void Sofanthiel::handleMenuBar()
                         free(outPath);
                     }
 				}
+                if (ImGui::MenuItem("Patch ROM (.gba, .ips, .bps)...")) {
+                    beginRomPatchExport();
+                }
                 ImGui::Separator();
                 bool canExportGif = currentAnimation >= 0 &&
                     currentAnimation < static_cast<int>(animations.size()) &&
@@ -1909,15 +2648,7 @@ void Sofanthiel::handleMenuBar()
                             savePath.substr(savePath.find_last_of('.')) != ".gif") {
                             savePath += ".gif";
                         }
-                        float offX = previewSize.x / 2.0f + previewAnimationOffset.x;
-                        float offY = previewSize.y / 2.0f + previewAnimationOffset.y;
-                        ResourceManager::exportAnimationToGif(savePath,
-                            this->animations, this->currentAnimation,
-                            this->animationCels, this->tiles, this->palettes,
-                            this->frameRate,
-                            static_cast<int>(previewSize.x),
-                            static_cast<int>(previewSize.y),
-                            offX, offY, gifExportScale);
+                        startGifExport(savePath);
                     }
                 }
                 if (!canExportGif) ImGui::EndDisabled();
@@ -1942,6 +2673,7 @@ void Sofanthiel::handleMenuBar()
             if (ImGui::MenuItem(ICON_FA_ROTATE_RIGHT " Redo", "Ctrl+Y", false, undoManager.canRedo())) {
                 undoManager.redo();
             }
+            ImGui::MenuItem(ICON_FA_CLOCK_ROTATE_LEFT " History", nullptr, &showUndoHistory);
             ImGui::Separator();
 
             bool inCelEditor = this->celEditingMode;
@@ -1982,53 +2714,10 @@ void Sofanthiel::handleMenuBar()
         if (ImGui::BeginMenu("Tools")) {
             bool canOptimizeSpritesheet = tiles.getSize() > 0 && !animationCels.empty() && !animations.empty();
 
-            std::unordered_set<std::string> referencedCelNames;
-            for (const auto& animation : animations) {
-                for (const auto& entry : animation.entries) {
-                    if (!entry.celName.empty()) {
-                        referencedCelNames.insert(entry.celName);
-                    }
-                }
-            }
-            int unusedCelCount = 0;
-            for (const auto& cel : animationCels) {
-                if (referencedCelNames.find(cel.name) == referencedCelNames.end()) {
-                    unusedCelCount++;
-                }
-            }
+            int unusedCelCount = celUsage.countUnusedCels(animationCels);
 
             if (ImGui::MenuItem("Optimize Spritesheet", nullptr, false, canOptimizeSpritesheet)) {
-                Tiles optimizedTiles;
-                std::vector<AnimationCel> optimizedAnimationCels;
-
-                if (buildOptimizedSpritesheetState(optimizedTiles, optimizedAnimationCels)) {
-                    Tiles oldTiles = this->tiles;
-                    std::vector<AnimationCel> oldAnimationCels = this->animationCels;
-                    bool oldCelEditingMode = this->celEditingMode;
-                    int oldEditingCelIndex = this->editingCelIndex;
-                    std::vector<int> oldSelectedOAMIndices = this->selectedOAMIndices;
-
-                    undoManager.execute(std::make_unique<LambdaAction>(
-                        "Optimize Spritesheet",
-                        [this, optimizedTiles, optimizedAnimationCels]() {
-                            this->tiles = optimizedTiles;
-                            this->animationCels = optimizedAnimationCels;
-
-                            if (this->editingCelIndex < 0 || this->editingCelIndex >= static_cast<int>(this->animationCels.size())) {
-                                this->celEditingMode = false;
-                                this->editingCelIndex = -1;
-                                this->selectedOAMIndices.clear();
-                            }
-                        },
-                        [this, oldTiles, oldAnimationCels, oldCelEditingMode, oldEditingCelIndex, oldSelectedOAMIndices]() {
-                            this->tiles = oldTiles;
-                            this->animationCels = oldAnimationCels;
-                            this->celEditingMode = oldCelEditingMode;
-                            this->editingCelIndex = oldEditingCelIndex;
-                            this->selectedOAMIndices = oldSelectedOAMIndices;
-                        }
-                    ));
-                }
+                startSpritesheetOptimization();
             }
             if (ImGui::IsItemHovered(ImGuiHoveredFlags_AllowWhenDisabled)) {
                 if (!canOptimizeSpritesheet) {
@@ -2038,6 +2727,15 @@ void Sofanthiel::handleMenuBar()
                     ImGui::SetTooltip("Rebuilds spritesheet to only include used tiles.");
                 }
             }
+
+            char selectUnusedLabel[64];
+            snprintf(selectUnusedLabel, sizeof(selectUnusedLabel), "Select Unused Cels (%d)", unusedCelCount);
+            if (ImGui::MenuItem(selectUnusedLabel, nullptr, false, unusedCelCount > 0)) {
+                selectUnusedCels();
+            }
+            if (ImGui::IsItemHovered(ImGuiHoveredFlags_AllowWhenDisabled)) {
+                ImGui::SetTooltip("Selects every cel no animation entry points at.");
+            }
             ImGui::EndMenu();
         }
         if (ImGui::BeginMenu("View")) {
@@ -2127,6 +2825,10 @@ void Sofanthiel::handleMenuBar()
             ImGui::EndMenu();
         }
 
+        drawSaveStatus();
+        drawImportStatus();
+        drawJobStatus();
+
         std::string buildLabel = BuildInfo::displayVersion();
         ImGui::SetCursorPosX(calculateRightAlignedPosition(buildLabel.c_str(), 0.0f));
         ImGui::TextDisabled("%s", buildLabel.c_str());
@@ -2260,33 +2962,163 @@ void Sofanthiel::handleAboutDialog()
     showAboutDialog = keepOpen;
 }
 
-bool Sofanthiel::buildOptimizedSpritesheetState(Tiles& outTiles, std::vector<AnimationCel>& outAnimationCels)
+void Sofanthiel::handleUndoHistory()
 {
-    outTiles = this->tiles;
-    outAnimationCels = this->animationCels;
+    if (!showUndoHistory) {
+        return;
+    }
 
-    const int originalTileCount = this->tiles.getSize();
-    if (originalTileCount <= 0 || this->animationCels.empty() || this->animations.empty()) {
-        return false;
+    ImGui::SetNextWindowSize(ImVec2(getScaledSize(320), getScaledSize(400)), ImGuiCond_FirstUseEver);
+    if (!ImGui::Begin(ICON_FA_CLOCK_ROTATE_LEFT " History", &showUndoHistory)) {
+        ImGui::End();
+        return;
+    }
+
+    const size_t used = undoManager.memoryUsage();
+    const size_t budget = undoManager.getMemoryBudget();
+    std::string usage = formatByteSize(used) + " / " + formatByteSize(budget);
+    ImGui::ProgressBar(budget > 0 ? static_cast<float>(used) / budget : 0.0f, ImVec2(-FLT_MIN, 0), usage.c_str());
+
+    int budgetMB = static_cast<int>(budget / (1024 * 1024));
+    if (ImGui::SliderInt("Budget", &budgetMB, 1, 256, "%d MB")) {
+        undoManager.setMemoryBudget(static_cast<size_t>(budgetMB) * 1024 * 1024);
     }
+    ImGui::Separator();
 
-    std::unordered_set<std::string> referencedCelNames;
-    for (const auto& animation : this->animations) {
-        for (const auto& entry : animation.entries) {
-            if (!entry.celName.empty()) {
-                referencedCelNames.insert(entry.celName);
+    const int applied = undoManager.undoCount();
+    const int total = applied + undoManager.redoCount();
+    int jumpTarget = -1;
+
+    ImGui::BeginChild("HistoryList");
+
+    // row 0 is the oldest state still reachable, row n = after n edits
+    ImGuiListClipper clipper;
+    clipper.Begin(total + 1);
+    while (clipper.Step()) {
+        for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; row++) {
+            ImGui::PushID(row);
+
+            std::string label;
+            size_t bytes = 0;
+            if (row == 0) {
+                label = "(start)";
+            }
+            else {
+                const auto& entry = row <= applied ? undoManager.undoEntry(row - 1) : undoManager.redoEntry(row - 1 - applied);
+                label = entry.action->description();
+                if (entry.mergedEdits > 1) {
+                    label += " x" + std::to_string(entry.mergedEdits);
+                }
+                bytes = entry.bytes;
+            }
+
+            // undone entries are greyed out, they're only around until the next edit
+            bool undone = row > applied;
+            if (undone) ImGui::PushStyleColor(ImGuiCol_Text, ImGui::GetStyle().Colors[ImGuiCol_TextDisabled]);
+
+            if (ImGui::Selectable(label.c_str(), row == applied)) {
+                jumpTarget = row;
             }
+            if (row > 0) {
+                std::string size = formatByteSize(bytes);
+                ImGui::SameLine(calculateRightAlignedPosition(size.c_str()));
+                ImGui::TextDisabled("%s", size.c_str());
+            }
+
+            if (undone) ImGui::PopStyleColor();
+            ImGui::PopID();
         }
     }
 
-    if (referencedCelNames.empty()) {
+    ImGui::EndChild();
+    ImGui::End();
+
+    if (jumpTarget >= 0 && jumpTarget != applied) {
+        undoManager.jumpTo(jumpTarget);
+    }
+}
+
+void Sofanthiel::startSpritesheetOptimization()
+{
+    struct OptimizedSpritesheet {
+        bool success = false;
+        Tiles tiles;
+        std::vector<AnimationCel> animationCels;
+    };
+
+    auto before = captureDocument();
+    jobs.submit<OptimizedSpritesheet>("Optimizing spritesheet",
+        [before](JobToken&) {
+            OptimizedSpritesheet optimized;
+            optimized.success = buildOptimizedSpritesheetState(*before->tiles, before->copyAnimationCels(),
+                before->copyAnimations(), optimized.tiles, optimized.animationCels);
+            return optimized;
+        },
+        [this, before](OptimizedSpritesheet& optimized) {
+            if (!optimized.success) {
+                return;
+            }
+
+            // packed against the document as it was when the job started, anything edited since would get lost
+            auto current = captureDocument();
+            if (current->tiles != before->tiles || current->animationCels != before->animationCels ||
+                current->animations != before->animations) {
+                SDL_Log("Spritesheet changed while it was being optimized, not applying the result");
+                return;
+            }
+
+            size_t beforeBytes = approximateMemoryUsage(tiles) + approximateMemoryUsage(animationCels);
+            bool oldCelEditingMode = this->celEditingMode;
+            int oldEditingCelIndex = this->editingCelIndex;
+            std::vector<int> oldSelectedOAMIndices = this->selectedOAMIndices;
+            size_t afterBytes = approximateMemoryUsage(optimized.tiles) + approximateMemoryUsage(optimized.animationCels);
+
+            undoManager.execute(std::make_unique<LambdaAction>(
+                "Optimize Spritesheet",
+                [this, optimizedTiles = std::move(optimized.tiles), optimizedAnimationCels = std::move(optimized.animationCels)]() {
+                    this->tiles = optimizedTiles;
+                    this->animationCels = optimizedAnimationCels;
+                    // unused cels are gone, so the indices after them moved
+                    this->selectedCelIndices.clear();
+
+                    if (this->editingCelIndex < 0 || this->editingCelIndex >= static_cast<int>(this->animationCels.size())) {
+                        this->celEditingMode = false;
+                        this->editingCelIndex = -1;
+                        this->selectedOAMIndices.clear();
+                    }
+                },
+                [this, current, oldCelEditingMode, oldEditingCelIndex, oldSelectedOAMIndices]() {
+                    this->tiles = *current->tiles;
+                    this->animationCels = current->copyAnimationCels();
+                    this->selectedCelIndices.clear();
+                    this->celEditingMode = oldCelEditingMode;
+                    this->editingCelIndex = oldEditingCelIndex;
+                    this->selectedOAMIndices = oldSelectedOAMIndices;
+                },
+                afterBytes + beforeBytes
+            ));
+        });
+}
+
+bool Sofanthiel::buildOptimizedSpritesheetState(const Tiles& tiles, const std::vector<AnimationCel>& animationCels,
+    const std::vector<Animation>& animations, Tiles& outTiles, std::vector<AnimationCel>& outAnimationCels)
+{
+    outTiles = tiles;
+    outAnimationCels = animationCels;
+
+    const int originalTileCount = tiles.getSize();
+    if (originalTileCount <= 0 || animationCels.empty() || animations.empty()) {
         return false;
     }
 
+    // runs on a worker, so its own index rather than the editor's
+    CelUsageIndex celUsage;
+    celUsage.rebuild(animations);
+
     std::vector<AnimationCel> usedAnimationCels;
-    usedAnimationCels.reserve(this->animationCels.size());
-    for (const auto& cel : this->animationCels) {
-        if (referencedCelNames.find(cel.name) != referencedCelNames.end()) {
+    usedAnimationCels.reserve(animationCels.size());
+    for (const auto& cel : animationCels) {
+        if (celUsage.isUsed(cel.name)) {
             usedAnimationCels.push_back(cel);
         }
     }
@@ -2375,7 +3207,7 @@ bool Sofanthiel::buildOptimizedSpritesheetState(Tiles& outTiles, std::vector<Ani
                     int srcTileIndex = getTileIndexForOffset(oam, tx, ty);
                     TileData tileData = {};
                     if (srcTileIndex >= 0 && srcTileIndex < originalTileCount) {
-                        tileData = this->tiles.getTile(srcTileIndex);
+                        tileData = tiles.getTile(srcTileIndex);
                     }
                     desiredTileIndices[static_cast<size_t>(ty * widthTiles + tx)] = getUniqueTileIndex(tileData);
                 }
@@ -2508,6 +3340,113 @@ bool Sofanthiel::isCelNameUnique(const std::string& name, int excludeIndex) cons
     return true;
 }
 
+void Sofanthiel::removeAnimationCels(const std::vector<int>& celIndices, bool removeReferencingEntries)
+{
+    celUsage.sync(animations);
+
+    std::vector<bool> removeCel(animationCels.size(), false);
+    for (int idx : celIndices) {
+        if (idx >= 0 && idx < static_cast<int>(animationCels.size())) {
+            removeCel[idx] = true;
+        }
+    }
+
+    std::vector<AnimationCel> newAnimationCels;
+    newAnimationCels.reserve(animationCels.size());
+    std::vector<Animation> newAnimations = animations;
+    std::vector<std::vector<bool>> removeEntry;
+    if (removeReferencingEntries) {
+        removeEntry.resize(animations.size());
+        for (size_t i = 0; i < animations.size(); i++) {
+            removeEntry[i].assign(animations[i].entries.size(), false);
+        }
+    }
+
+    for (int i = 0; i < static_cast<int>(animationCels.size()); i++) {
+        if (!removeCel[i]) {
+            newAnimationCels.push_back(animationCels[i]);
+            continue;
+        }
+
+        if (!removeReferencingEntries) continue;
+
+        // only touch the entries that actually point at this cel
+        for (const auto& ref : celUsage.getReferences(animationCels[i].name)) {
+            if (ref.animationIndex >= 0 && ref.animationIndex < static_cast<int>(removeEntry.size()) &&
+                ref.entryIndex >= 0 && ref.entryIndex < static_cast<int>(removeEntry[ref.animationIndex].size())) {
+                removeEntry[ref.animationIndex][ref.entryIndex] = true;
+            }
+        }
+    }
+
+    if (removeReferencingEntries) {
+        for (size_t a = 0; a < newAnimations.size(); a++) {
+            auto& entries = newAnimations[a].entries;
+            size_t kept = 0;
+            for (size_t entryIdx = 0; entryIdx < entries.size(); entryIdx++) {
+                if (removeEntry[a][entryIdx]) continue;
+                if (kept != entryIdx) {
+                    entries[kept] = std::move(entries[entryIdx]);
+                }
+                kept++;
+            }
+            entries.resize(kept);
+        }
+    }
+
+    if (newAnimationCels.size() == animationCels.size()) {
+        return;
+    }
+
+    int newEditingCelIndex = -1;
+    if (editingCelIndex >= 0 && editingCelIndex < static_cast<int>(removeCel.size()) && !removeCel[editingCelIndex]) {
+        newEditingCelIndex = static_cast<int>(std::count(removeCel.begin(), removeCel.begin() + editingCelIndex, false));
+    }
+
+    auto before = captureDocument();
+    size_t beforeBytes = approximateMemoryUsage(animationCels) + approximateMemoryUsage(animations);
+    bool oldCelEditingMode = celEditingMode;
+    int oldEditingCelIndex = editingCelIndex;
+    std::vector<int> oldSelectedOAMIndices = selectedOAMIndices;
+
+    undoManager.execute(std::make_unique<LambdaAction>(
+        removeCel.size() - newAnimationCels.size() > 1 ? "Remove Cels" : "Remove Cel",
+        [this, newAnimationCels, newAnimations, newEditingCelIndex]() {
+            this->animationCels = newAnimationCels;
+            this->animations = newAnimations;
+            this->editingCelIndex = newEditingCelIndex;
+            if (newEditingCelIndex < 0) {
+                this->celEditingMode = false;
+                this->selectedOAMIndices.clear();
+            }
+            this->selectedCelIndices.clear();
+            this->recalculateTotalFrames();
+        },
+        [this, before, oldCelEditingMode, oldEditingCelIndex, oldSelectedOAMIndices]() {
+            this->animationCels = before->copyAnimationCels();
+            this->animations = before->copyAnimations();
+            this->celEditingMode = oldCelEditingMode;
+            this->editingCelIndex = oldEditingCelIndex;
+            this->selectedOAMIndices = oldSelectedOAMIndices;
+            this->selectedCelIndices.clear();
+            this->recalculateTotalFrames();
+        },
+        approximateMemoryUsage(newAnimationCels) + approximateMemoryUsage(newAnimations) + beforeBytes
+    ));
+}
+
+void Sofanthiel::selectUnusedCels()
+{
+    celUsage.sync(animations);
+
+    selectedCelIndices.clear();
+    for (int i = 0; i < static_cast<int>(animationCels.size()); i++) {
+        if (!celUsage.isUsed(animationCels[i].name)) {
+            selectedCelIndices.push_back(i);
+        }
+    }
+}
+
 bool Sofanthiel::isAnimationNameUnique(const std::string& name, int excludeIndex) const {
     for (size_t i = 0; i < animations.size(); i++) {
         if (static_cast<int>(i) != excludeIndex && animations[i].name == name) {
@@ -2821,284 +3760,418 @@ ImVec2 ViewManager::calculateOrigin(ImVec2 contentCenter, ImVec2 baseSize) {
     );
 }
 
-static void writeU32(std::ofstream& f, uint32_t val) {
-    f.write(reinterpret_cast<const char*>(&val), 4);
+ProjectMetadata Sofanthiel::buildProjectMetadata() const
+{
+    ProjectMetadata metadata;
+    metadata.celFilename = animationCelFilename;
+    metadata.currentPalette = currentPalette;
+    metadata.currentAnimation = currentAnimation;
+    metadata.frameRate = frameRate;
+    metadata.loopAnimation = loopAnimation;
+    metadata.useTilePalettes = useTilePalettes;
+    return metadata;
 }
 
-static uint32_t readU32(std::ifstream& f) {
-    uint32_t val = 0;
-    f.read(reinterpret_cast<char*>(&val), 4);
-    return val;
+std::shared_ptr<const DocumentSnapshot> Sofanthiel::captureDocument()
+{
+    // only what changed since the last capture gets copied, the rest is shared
+    lastSnapshot = DocumentSnapshot::capture(tiles, palettes, tilePalettes, animationCels, animations,
+        buildProjectMetadata(), lastSnapshot);
+    return lastSnapshot;
 }
 
 void Sofanthiel::saveProject(const std::string& path)
 {
-    std::ofstream file(path, std::ios::binary);
-    if (!file.is_open()) {
-        SDL_Log("Failed to save project to: %s", path.c_str());
+    // flush pending edits into the journal first, its mark is what the save covers
+    journalDocument();
+
+    // journaling just took a snapshot, serialize + write that on the saver thread so the editor keeps going
+    projectSaver.requestSave(lastSnapshot, path, compressProjectFile, journal.mark());
+    pendingSavePath = path;
+}
+
+void Sofanthiel::pollProjectSave()
+{
+    ProjectSaveResult result;
+    if (!projectSaver.pollResult(result)) {
         return;
     }
 
-    uint32_t sectionCount = 0;
-    if (tiles.getSize() > 0) sectionCount++;
-    if (!palettes.empty()) sectionCount++;
-    if (!animationCels.empty()) sectionCount++;
-    if (!animations.empty()) sectionCount++;
-    sectionCount++;
+    // everything up to the save is safe on disk now, no need to replay it after a crash
+    if (result.success) {
+        journal.compact(result.tag, result.path);
 
-    // Header
-    file.write("ENOT", 4); // ENOT RAIN WORLDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDD (this is the only thing keeping me sane at this point)
-    writeU32(file, 1);     // version
-    writeU32(file, sectionCount);
+        // an older save landing after a newer Save As, or after the document got replaced, doesn't count
+        if (result.path == pendingSavePath) {
+            this->currentProjectPath = result.path;
+            this->updateWindowTitle();
+        }
+    }
 
-    // raw 4bpp - section 1
-    if (tiles.getSize() > 0) {
-        writeU32(file, 1);
+    lastSaveResult = std::move(result);
+    hasSaveResult = true;
+    lastSaveFinishedTick = SDL_GetTicks();
+}
 
-        std::vector<uint8_t> tileBytes;
-        for (int i = 0; i < tiles.getSize(); ++i) {
-            TileData td = tiles.getTile(i);
-            for (int byteIndex = 0; byteIndex < 32; ++byteIndex) {
-                int py = byteIndex / 4;
-                int px = (byteIndex % 4) * 2;
-                uint8_t pixel1 = td.data[py][px] & 0x0F;
-                uint8_t pixel2 = td.data[py][px + 1] & 0x0F;
-                tileBytes.push_back(pixel1 | (pixel2 << 4));
-            }
-        }
+void Sofanthiel::drawSaveStatus()
+{
+    constexpr Uint64 kSavedLabelMs = 3000;
 
-        writeU32(file, static_cast<uint32_t>(tileBytes.size()));
-        file.write(reinterpret_cast<const char*>(tileBytes.data()), tileBytes.size());
+    if (projectSaver.isBusy()) {
+        ImGui::TextColored(ImVec4(0.9f, 0.8f, 0.4f, 1.0f), ICON_FA_FLOPPY_DISK " Saving...");
+        return;
     }
 
-    // raw palette data - section 2
-    if (!palettes.empty()) {
-        writeU32(file, 2);
+    if (!hasSaveResult) {
+        return;
+    }
 
-        // RGBA!!!!!!!!!!!!!!!!!
-        uint32_t dataSize = static_cast<uint32_t>(palettes.size() * 16 * 4);
-        writeU32(file, dataSize);
+    if (!lastSaveResult.success) {
+        // sticks around until the next save, this one you really want to see
+        ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.35f, 1.0f), ICON_FA_TRIANGLE_EXCLAMATION " Save failed");
+        if (ImGui::IsItemHovered()) {
+            ImGui::SetTooltip("%s", lastSaveResult.error.c_str());
+        }
+        return;
+    }
 
-        for (const auto& pal : palettes) {
-            for (int i = 0; i < 16; ++i) {
-                file.write(reinterpret_cast<const char*>(&pal.colors[i].r), 1);
-                file.write(reinterpret_cast<const char*>(&pal.colors[i].g), 1);
-                file.write(reinterpret_cast<const char*>(&pal.colors[i].b), 1);
-                file.write(reinterpret_cast<const char*>(&pal.colors[i].a), 1);
-            }
+    if (SDL_GetTicks() - lastSaveFinishedTick < kSavedLabelMs) {
+        ImGui::TextColored(ImVec4(0.5f, 0.85f, 0.5f, 1.0f), ICON_FA_CHECK " Saved");
+        if (ImGui::IsItemHovered()) {
+            ImGui::SetTooltip("%s\n%zu bytes in %llu ms", lastSaveResult.path.c_str(),
+                lastSaveResult.bytesWritten, static_cast<unsigned long long>(lastSaveResult.durationMs));
         }
     }
+}
+
+void Sofanthiel::drawJobStatus()
+{
+    std::vector<JobStatus> running = jobs.getJobs();
+    if (running.empty()) {
+        return;
+    }
 
-    // anim cels as text - section 3
-    if (!animationCels.empty()) {
-        writeU32(file, 3); // type
+    const JobStatus& first = running.front();
+    if (first.progress >= 0.0f) {
+        ImGui::ProgressBar(first.progress, ImVec2(getScaledSize(160.0f), 0), first.name.c_str());
+    }
+    else {
+        ImGui::TextColored(ImVec4(0.9f, 0.8f, 0.4f, 1.0f), ICON_FA_HOURGLASS_HALF " %s...", first.name.c_str());
+    }
 
-        std::ostringstream oss;
-        for (const auto& cel : animationCels) {
-            oss << "AnimationCel " << cel.name << "[] = {\n";
-            oss << "    /* Len */ " << cel.oams.size() << ",\n";
-            for (size_t i = 0; i < cel.oams.size(); ++i) {
-                const auto& oam = cel.oams[i];
-                const uint16_t* raw = reinterpret_cast<const uint16_t*>(&oam);
-                oss << "    /* " << std::setw(3) << std::setfill('0') << i << " */ ";
-                oss << "0x" << std::hex << std::setw(4) << std::setfill('0') << raw[0] << ", ";
-                oss << "0x" << std::hex << std::setw(4) << std::setfill('0') << raw[1] << ", ";
-                oss << "0x" << std::hex << std::setw(4) << std::setfill('0') << raw[2];
-                oss << std::dec;
-                if (i + 1 < cel.oams.size()) oss << ",";
-                oss << "\n";
+    char menuLabel[32];
+    snprintf(menuLabel, sizeof(menuLabel), "Jobs (%zu)", running.size());
+    if (ImGui::BeginMenu(menuLabel)) {
+        for (const JobStatus& job : running) {
+            ImGui::PushID(static_cast<int>(job.id));
+            if (job.cancelling) {
+                ImGui::TextDisabled("%s (cancelling)", job.name.c_str());
+            }
+            else if (!job.started) {
+                ImGui::TextDisabled("%s (waiting)", job.name.c_str());
+            }
+            else if (job.progress >= 0.0f) {
+                ImGui::Text("%s  %d%%", job.name.c_str(), static_cast<int>(job.progress * 100.0f));
+            }
+            else {
+                ImGui::Text("%s", job.name.c_str());
+            }
+            if (!job.cancelling) {
+                ImGui::SameLine();
+                if (ImGui::SmallButton(ICON_FA_XMARK " Cancel")) {
+                    jobs.cancel(job.id);
+                }
+            }
+            ImGui::PopID();
+        }
+        if (running.size() > 1) {
+            ImGui::Separator();
+            if (ImGui::MenuItem("Cancel All")) {
+                jobs.cancelAll();
             }
-            oss << "};\n\n";
         }
-        std::string text = oss.str();
-        writeU32(file, static_cast<uint32_t>(text.size()));
-        file.write(text.c_str(), text.size());
+        ImGui::EndMenu();
     }
-
-    // animations as text - section 4
-    if (!animations.empty()) {
-        writeU32(file, 4); // type
-
-        std::ostringstream oss;
-        oss << "#include \"global.h\"\n#include \"graphics.h\"\n\n";
-        oss << "#include \"" << animationCelFilename << "\"\n\n";
-        for (const auto& anim : animations) {
-            oss << "struct Animation " << anim.name << "[] = {\n";
-            for (size_t i = 0; i < anim.entries.size(); ++i) {
-                const auto& entry = anim.entries[i];
-                oss << "    /* " << std::setw(3) << std::setfill('0') << i << " */ { "
-                    << entry.celName << ", " << static_cast<int>(entry.duration) << " },\n";
-            }
-            oss << "    /* " << std::setw(3) << std::setfill('0') << anim.entries.size() << " */ END_ANIMATION,\n";
-            oss << "};\n\n";
-        }
-        std::string text = oss.str();
-        writeU32(file, static_cast<uint32_t>(text.size()));
-        file.write(text.c_str(), text.size());
-    }
-
-    // metadata - section 5
-    writeU32(file, 5); // type
-
-    std::ostringstream oss;
-    oss << "celFilename=" << animationCelFilename << "\n";
-    oss << "currentPalette=" << currentPalette << "\n";
-    oss << "currentAnimation=" << currentAnimation << "\n";
-    oss << "frameRate=" << frameRate << "\n";
-    oss << "loopAnimation=" << (loopAnimation ? 1 : 0) << "\n";
-
-    std::string text = oss.str();
-    writeU32(file, static_cast<uint32_t>(text.size()));
-    file.write(text.c_str(), text.size());
-
-    file.close();
-    this->currentProjectPath = path;
-    this->updateWindowTitle();
-    SDL_Log("Saved project to %s", path.c_str());
 }
 
-void Sofanthiel::loadProject(const std::string& path)
+void Sofanthiel::startImageConversion(const std::string& path)
 {
-    std::string celsText;
-    std::string animsText;
-    std::string metadataText;
+    struct ConvertedImage {
+        bool success = false;
+        Tiles tiles;
+        std::vector<Palette> palettes;
+        std::vector<uint8_t> tilePalettes;
+        int tilesPerRow = TILES_PER_LINE;
+    };
 
-    std::ifstream file(path, std::ios::binary);
-    if (!file.is_open()) {
-        SDL_Log("Failed to open project: %s", path.c_str());
-        return;
-    }
+    jobs.submit<ConvertedImage>("Converting " + getFileName(path),
+        [path](JobToken&) {
+            ConvertedImage converted;
+            converted.success = ResourceManager::convertImageToSpritesheetAndPalette(path,
+                converted.tiles, converted.palettes, converted.tilePalettes, &converted.tilesPerRow);
+            return converted;
+        },
+        [this, path](ConvertedImage& converted) {
+            if (!converted.success) {
+                return;
+            }
+
+            // the converted sheet is the newest document, a project still loading doesn't get to replace it
+            cancelProjectLoad();
+
+            // one undo step swapping the sheet, the palettes and the tile palette map together
+            auto before = captureDocument();
+            const int oldTilesPerRow = spritesheetTilesPerRow;
+            const int oldCurrentPalette = currentPalette;
+            const size_t payloadBytes = approximateMemoryUsage(tiles) + approximateMemoryUsage(palettes) + tilePalettes.size() +
+                approximateMemoryUsage(converted.tiles) + approximateMemoryUsage(converted.palettes) + converted.tilePalettes.size();
+            auto result = std::make_shared<const ConvertedImage>(std::move(converted));
 
-    char magic[4];
-    file.read(magic, 4);
-    if (memcmp(magic, "ENOT", 4) != 0) {
-        SDL_Log("Invalid project file (bad magic): %s", path.c_str());
-        file.close();
+            undoManager.execute(std::make_unique<LambdaAction>(
+                "Convert " + getFileName(path),
+                [this, result]() {
+                    spritesheetTilesPerRow = SDL_max(1, result->tilesPerRow);
+                    tiles = result->tiles;
+                    palettes = result->palettes;
+                    tilePalettes = result->tilePalettes;
+                    useTilePalettes = true;
+                    currentPalette = 0;
+                },
+                [this, before, oldTilesPerRow, oldCurrentPalette]() {
+                    spritesheetTilesPerRow = oldTilesPerRow;
+                    tiles = *before->tiles;
+                    palettes = *before->palettes;
+                    tilePalettes = *before->tilePalettes;
+                    useTilePalettes = before->metadata.useTilePalettes;
+                    currentPalette = oldCurrentPalette;
+                },
+                payloadBytes));
+
+            this->stopWatchingSource(WatchedSourceKind::Tiles);
+            this->stopWatchingSource(WatchedSourceKind::Palettes);
+        });
+}
+
+void Sofanthiel::startGifExport(const std::string& path)
+{
+    if (currentAnimation < 0 || currentAnimation >= static_cast<int>(animations.size())) {
         return;
     }
 
-    uint32_t version = readU32(file);
-    if (version != 1) {
-        SDL_Log("Unsupported project version %u in: %s", version, path.c_str());
-        file.close();
-        return;
+    // the exporter only gets the one animation, cels are looked up by name so those all go
+    auto document = captureDocument();
+    std::shared_ptr<const Animation> animation = document->animations[static_cast<size_t>(currentAnimation)];
+    const float exportFrameRate = static_cast<float>(getPlaybackFrameRate());
+    const int width = static_cast<int>(previewSize.x);
+    const int height = static_cast<int>(previewSize.y);
+    const float offX = previewSize.x / 2.0f + previewAnimationOffset.x;
+    const float offY = previewSize.y / 2.0f + previewAnimationOffset.y;
+    const int scale = gifExportScale;
+
+    jobs.submit<bool>("Exporting " + getFileName(path),
+        [path, document, animation, exportFrameRate, width, height, offX, offY, scale](JobToken& token) {
+            return ResourceManager::exportAnimationToGif(path,
+                std::vector<Animation>{ *animation }, 0,
+                document->copyAnimationCels(), *document->tiles, *document->palettes,
+                exportFrameRate, width, height, offX, offY, scale,
+                [&token](float progress) {
+                    token.setProgress(progress);
+                    return !token.isCancelled();
+                });
+        },
+        nullptr);
+}
+
+void Sofanthiel::cancelProjectLoad()
+{
+    if (projectLoad.token) {
+        jobs.cancel(projectLoad.id);
     }
+    projectLoad = JobHandle();
+}
+
+void Sofanthiel::loadProject(const std::string& path)
+{
+    struct LoadedProject {
+        bool opened = false;
+        uint32_t version = 0;
+        ProjectData project;
+    };
+
+    // opening another one before the last got here, the newer one wins
+    cancelProjectLoad();
+
+    // reading and decompressing happen on a worker, the document is only replaced once it's all in
+    projectLoad = jobs.submit<LoadedProject>("Opening " + getFileName(path),
+        [path](JobToken&) {
+            LoadedProject loaded;
+            ProjectReader reader;
+            if (!reader.open(path)) {
+                return loaded;
+            }
+
+            loaded.opened = true;
+            loaded.version = reader.getVersion();
+            if (!reader.readAll(loaded.project)) {
+                SDL_Log("Project %s has damaged sections, loading what survived", path.c_str());
+            }
+            return loaded;
+        },
+        [this, path](LoadedProject& loaded) {
+            projectLoad = JobHandle();
+            if (!loaded.opened) {
+                return;
+            }
 
-    uint32_t sectionCount = readU32(file);
+            this->applyProjectData(loaded.project);
+            this->currentProjectPath = path;
+            this->updateWindowTitle();
+            this->resetJournal(path);
+            SDL_Log("Loaded v%u project from %s (%d tiles, %zu palettes, %zu cels, %zu anims)",
+                loaded.version, path.c_str(), tiles.getSize(), palettes.size(),
+                animationCels.size(), animations.size());
+        });
+}
 
+void Sofanthiel::applyProjectData(ProjectData& project)
+{
     // reset everything
-    this->tiles = Tiles();
-    this->palettes.clear();
-    this->animationCels.clear();
-    this->animations.clear();
     this->celEditingMode = false;
     this->editingCelIndex = -1;
     this->selectedOAMIndices.clear();
-    this->currentAnimation = -1;
+    this->selectedCelIndices.clear();
     this->currentAnimationCel = -1;
     this->currentFrame = 0;
     this->isPlaying = false;
     this->undoManager.clear();
+    this->pendingSavePath.clear();
+    this->clearWatchedSources();
+    // origins aren't saved, a reopened project finds its way back through the _<pointer> names
+    this->romOrigins.clear();
+
+    this->tiles = std::move(project.tiles);
+    this->tilePalettes = std::move(project.tilePalettes);
+    this->palettes = std::move(project.palettes);
+    this->animationCels = std::move(project.animationCels);
+    this->animations = std::move(project.animations);
+    this->animationCelFilename = project.metadata.celFilename;
+    this->currentPalette = project.metadata.currentPalette;
+    this->currentAnimation = project.metadata.currentAnimation;
+    this->frameRate = project.metadata.frameRate;
+    this->loopAnimation = project.metadata.loopAnimation;
+    this->useTilePalettes = project.metadata.useTilePalettes;
 
-    for (uint32_t s = 0; s < sectionCount; ++s) {
-        if (!file.good()) break;
+    // clamp indices to valid ranges
+    if (!palettes.empty()) {
+        currentPalette = SDL_clamp(currentPalette, 0, static_cast<int>(palettes.size()) - 1);
+    }
+    if (!animations.empty()) {
+        currentAnimation = SDL_clamp(currentAnimation, 0, static_cast<int>(animations.size()) - 1);
+    }
 
-        uint32_t sectionType = readU32(file);
-        uint32_t dataLen = readU32(file);
+    this->recalculateTotalFrames();
+}
 
-        if (sectionType == 1) { // 4bpp
-            std::vector<uint8_t> tileData(dataLen);
-            file.read(reinterpret_cast<char*>(tileData.data()), dataLen);
+void Sofanthiel::journalDocument()
+{
+    lastJournalTick = SDL_GetTicks();
+    journal.record(captureDocument());
+}
 
-            this->tiles = Tiles();
-            for (size_t offset = 0; offset + 32 <= tileData.size(); offset += 32) {
-                std::array<uint8_t, 32> tile;
-                memcpy(tile.data(), tileData.data() + offset, 32);
-                this->tiles.addTile(tile);
-            }
-        }
-        else if (sectionType == 2) { // palette
-            std::vector<uint8_t> palData(dataLen);
-            file.read(reinterpret_cast<char*>(palData.data()), dataLen);
+void Sofanthiel::resetJournal(const std::string& basePath)
+{
+    // whatever gets decided in the recovery popup resets it anyway
+    if (recoveryPending) {
+        return;
+    }
 
-            this->palettes.clear();
-            size_t offset = 0;
-            while (offset + (16*4) <= palData.size()) {
-                Palette pal;
-                for (int i = 0; i < 16; ++i) {
-                    pal.colors[i].r = palData[offset++];
-                    pal.colors[i].g = palData[offset++];
-                    pal.colors[i].b = palData[offset++];
-                    pal.colors[i].a = palData[offset++];
-                }
-                this->palettes.push_back(pal);
-            }
-        }
-        else if (sectionType == 3) { // animation cels
-            celsText.resize(dataLen);
-            file.read(&celsText[0], dataLen);
-        }
-        else if (sectionType == 4) { // animations
-            animsText.resize(dataLen);
-            file.read(&animsText[0], dataLen);
-        }
-        else if (sectionType == 5) { // metadata
-            metadataText.resize(dataLen);
-            file.read(&metadataText[0], dataLen);
+    if (basePath.empty()) {
+        // nothing on disk to replay onto, a new project always starts out as the default
+        // document though, so recovery rebuilds that and only the edits get journaled
+        ProjectData defaults;
+        defaults.palettes = makeDefaultPalettes();
+        journal.reset("", DocumentSnapshot::capture(defaults));
+    }
+    else {
+        journal.reset(basePath, captureDocument());
+    }
+    journalDocument();
+}
+
+void Sofanthiel::recoverJournal()
+{
+    ProjectData project;
+    project.palettes = makeDefaultPalettes();
+    if (!recoveryBasePath.empty()) {
+        ProjectReader reader;
+        if (!reader.open(recoveryBasePath) || !reader.readAll(project)) {
+            SDL_Log("Can't recover, base project %s is gone or damaged", recoveryBasePath.c_str());
+            resetJournal(currentProjectPath);
+            return;
         }
-        else {
-            SDL_Log("unknown section????? type %u in project file: %s", sectionType, path.c_str());
-            file.seekg(dataLen, std::ios::cur);
+    }
+
+    auto base = DocumentSnapshot::capture(project);
+    size_t applied = 0;
+    for (const auto& record : recoveryRecords) {
+        if (!EditJournal::applyRecord(record, project)) {
+            SDL_Log("Journal record %zu didn't apply, stopping there", applied);
+            break;
         }
+        applied++;
     }
 
-    file.close();
+    cancelProjectLoad();
+    this->applyProjectData(project);
+    this->currentProjectPath = recoveryBasePath;
+    this->updateWindowTitle();
+
+    // still unsaved, so re-journal it against the same base
+    lastSnapshot = base;
+    journal.reset(recoveryBasePath, base);
+    journalDocument();
+    SDL_Log("Recovered %zu edit(s) on top of %s", applied,
+        recoveryBasePath.empty() ? "a new project" : recoveryBasePath.c_str());
+}
 
-    if (!celsText.empty()) {
-        this->animationCels = ResourceManager::loadAnimationCelsFromText(celsText, path + " [section:cels]");
+void Sofanthiel::handleRecoveryPopup()
+{
+    if (!recoveryPending) {
+        return;
     }
 
-    if (!animsText.empty()) {
-        this->animations = ResourceManager::loadAnimationsFromText(animsText, path + " [section:anims]");
+    if (!ImGui::IsPopupOpen("Recover Unsaved Work")) {
+        ImGui::OpenPopup("Recover Unsaved Work");
     }
+    ImVec2 center = ImGui::GetMainViewport()->GetCenter();
+    ImGui::SetNextWindowPos(center, ImGuiCond_Appearing, ImVec2(0.5f, 0.5f));
 
-    if (!metadataText.empty()) {
-        std::istringstream iss(metadataText);
-        std::string line;
-        while (std::getline(iss, line)) {
-            size_t eq = line.find('=');
-            if (eq == std::string::npos) continue;
-            std::string key = line.substr(0, eq);
-            std::string val = line.substr(eq + 1);
+    if (ImGui::BeginPopupModal("Recover Unsaved Work", NULL, ImGuiWindowFlags_AlwaysAutoResize)) {
+        ImGui::Text("Sofanthiel didn't close properly last time.");
+        ImGui::Text("%zu unsaved change(s) on %s", recoveryRecords.size(),
+            recoveryBasePath.empty() ? "a new project" : recoveryBasePath.c_str());
+        ImGui::Separator();
 
-            if (key == "celFilename") animationCelFilename = val;
-            else if (key == "currentPalette") {
-                try { currentPalette = std::stoi(val); } catch (...) {}
-            }
-            else if (key == "currentAnimation") {
-                try { currentAnimation = std::stoi(val); } catch (...) {}
-            }
-            else if (key == "frameRate") {
-                try { frameRate = std::stof(val); } catch (...) {}
-            }
-            else if (key == "loopAnimation") {
-                loopAnimation = (val == "1");
-            }
+        bool decided = false;
+        if (ImGui::Button("Recover", getScaledButtonSize(120, 0))) {
+            recoveryPending = false;
+            recoverJournal();
+            decided = true;
         }
-    }
 
-    // clamp indices to valid ranges
-    if (!palettes.empty()) {
-        currentPalette = SDL_clamp(currentPalette, 0, static_cast<int>(palettes.size()) - 1);
-    }
-    if (!animations.empty()) {
-        currentAnimation = SDL_clamp(currentAnimation, 0, static_cast<int>(animations.size()) - 1);
-    }
+        ImGui::SameLine();
+        if (ImGui::Button("Discard", getScaledButtonSize(120, 0))) {
+            recoveryPending = false;
+            resetJournal(currentProjectPath);
+            decided = true;
+        }
 
-    this->currentProjectPath = path;
-    this->recalculateTotalFrames();
-    this->updateWindowTitle();
-    SDL_Log("Loaded project from %s (%d tiles, %zu palettes, %zu cels, %zu anims)",
-        path.c_str(), tiles.getSize(), palettes.size(),
-        animationCels.size(), animations.size());
+        if (decided) {
+            recoveryRecords.clear();
+            recoveryBasePath.clear();
+            ImGui::CloseCurrentPopup();
+        }
+
+        ImGui::EndPopup();
+    }
 }
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdio>
+
+// bare bones checks, every test program is its own binary and exits non zero if one failed
+inline int& checkFailures()
+{
+	static int failures = 0;
+	return failures;
+}
+
+#define CHECK(cond) \
+	do { \
+		if (!(cond)) { \
+			std::printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+			checkFailures()++; \
+		} \
+	} while (0)
+
+inline int finishTests(const char* name)
+{
+	if (checkFailures() != 0) {
+		std::printf("%s: %d check(s) failed\n", name, checkFailures());
+		return 1;
+	}
+	std::printf("%s: ok\n", name);
+	return 0;
+}
@@ -0,0 +1,69 @@
+// EditJournal slots: a journal left behind by a crashed instance gets recovered by the next
+// one, while journals of instances that are still running are never touched
+#include "Check.h"
+#include "EditJournal.h"
+
+#include <filesystem>
+#include <memory>
+#include <vector>
+
+int main()
+{
+	namespace fs = std::filesystem;
+	const fs::path dir = fs::temp_directory_path() / "sofanthiel_edit_journal_test";
+	fs::remove_all(dir);
+	fs::create_directories(dir);
+	const std::string directory = dir.string() + "/";
+
+	ProjectData project;
+	project.palettes.resize(1);
+	auto base = DocumentSnapshot::capture(project);
+	project.palettes[0].colors[1] = { 255, 0, 0, 255 };
+	auto edited = DocumentSnapshot::capture(project, base);
+
+	// crashed: records hit the disk, then the instance goes away without discard()
+	{
+		EditJournal crashed;
+		CHECK(crashed.claimSlot(directory));
+		crashed.reset("", base);
+		CHECK(crashed.record(edited));
+	}
+
+	std::string basePath = "unset";
+	std::vector<std::vector<uint8_t>> records;
+
+	EditJournal next;
+	CHECK(next.claimSlot(directory));
+	CHECK(next.readRecovery(basePath, records));
+	CHECK(basePath.empty());
+	CHECK(records.size() == 1);
+
+	ProjectData replayed;
+	replayed.palettes.resize(1);
+	for (const auto& record : records) {
+		CHECK(EditJournal::applyRecord(record, replayed));
+	}
+	CHECK(replayed.palettes.size() == 1 && replayed.palettes[0].colors[1].r == 255);
+
+	// still running, so the second instance has to get a slot of its own
+	EditJournal second;
+	CHECK(second.claimSlot(directory));
+	CHECK(!second.readRecovery(basePath, records));
+
+	std::vector<std::unique_ptr<EditJournal>> others;
+	for (int i = 0; i < 6; i++) {
+		others.push_back(std::make_unique<EditJournal>());
+		CHECK(others.back()->claimSlot(directory));
+	}
+	EditJournal overflow;
+	CHECK(!overflow.claimSlot(directory));
+	CHECK(!overflow.isActive());
+
+	// a slot frees up again once its instance closes
+	others.pop_back();
+	CHECK(overflow.claimSlot(directory));
+
+	others.clear();
+	fs::remove_all(dir);
+	return finishTests("edit_journal");
+}
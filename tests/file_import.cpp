@@ -0,0 +1,193 @@
+// FileImport: one batch with a palette file, raw tiles, a cel .c and an animation .c (plus
+// a few files that should fail), written with the same ResourceManager savers the editor
+// uses and decoded through a job the way a drop is. images need SDL_image to decode, so
+// they're left to the app
+#include "Check.h"
+#include "FileImport.h"
+#include "JobSystem.h"
+
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace {
+
+constexpr auto kTimeout = std::chrono::seconds(30);
+
+std::vector<Palette> makePalettes()
+{
+	std::vector<Palette> palettes(2);
+	for (size_t p = 0; p < palettes.size(); p++) {
+		for (int i = 0; i < 16; i++) {
+			palettes[p].colors[i] = { static_cast<Uint8>(i * 16), static_cast<Uint8>(p * 100), static_cast<Uint8>(255 - i * 8), 255 };
+		}
+	}
+	return palettes;
+}
+
+Tiles makeTiles()
+{
+	Tiles tiles;
+	for (int t = 0; t < 3; t++) {
+		std::array<uint8_t, 32> packed;
+		for (size_t i = 0; i < packed.size(); i++) {
+			packed[i] = static_cast<uint8_t>((t * 37 + i * 11) & 0xFF);
+		}
+		tiles.addTile(packed);
+	}
+	return tiles;
+}
+
+TengokuOAM makeOam(int8_t x, int8_t y, uint16_t tileID, uint8_t palette)
+{
+	TengokuOAM oam = {};
+	oam.xPosition = x;
+	oam.yPosition = y;
+	oam.tileID = tileID;
+	oam.palette = palette;
+	return oam;
+}
+
+std::vector<AnimationCel> makeCels()
+{
+	std::vector<AnimationCel> cels(2);
+	cels[0].name = "test_cel0";
+	cels[0].oams = { makeOam(-8, -8, 0, 0), makeOam(0, -8, 1, 1) };
+	cels[1].name = "test_cel1";
+	cels[1].oams = { makeOam(4, 2, 2, 0) };
+	return cels;
+}
+
+std::vector<Animation> makeAnimations()
+{
+	Animation animation;
+	animation.name = "anim_test";
+	animation.entries = { { "test_cel0", 4 }, { "test_cel1", 6 }, { "test_cel0", 2 } };
+	return { animation };
+}
+
+const ImportedFile* findFile(const std::vector<ImportedFile>& files, const std::string& path)
+{
+	for (const ImportedFile& file : files) {
+		if (file.path == path) return &file;
+	}
+	return nullptr;
+}
+
+}
+
+int main()
+{
+	namespace fs = std::filesystem;
+	const fs::path dir = fs::temp_directory_path() / "sofanthiel_file_import_test";
+	fs::remove_all(dir);
+	fs::create_directories(dir);
+
+	const std::string palPath = (dir / "test.pal").string();
+	const std::string tilesPath = (dir / "test.4bpp").string();
+	const std::string celsPath = (dir / "test_cels.c").string();
+	const std::string animsPath = (dir / "test_anims.c").string();
+	const std::string textPath = (dir / "notes.txt").string();
+	const std::string missingPath = (dir / "gone.4bpp").string();
+	const std::string projectPath = (dir / "test.inv").string();
+
+	std::vector<Palette> palettes = makePalettes();
+	Tiles tiles = makeTiles();
+	std::vector<AnimationCel> cels = makeCels();
+	std::vector<Animation> animations = makeAnimations();
+	ResourceManager::savePalettes(palPath, palettes);
+	ResourceManager::saveTiles(tilesPath, tiles);
+	ResourceManager::saveAnimationCels(celsPath, cels);
+	ResourceManager::saveAnimations(animsPath, animations, "test_cels.c");
+	std::ofstream(textPath) << "not a sofanthiel file\n";
+
+	// same mixed order a drop would come in with, the batch has to hand them back in it
+	const std::vector<std::string> paths = { animsPath, textPath, tilesPath, celsPath, missingPath, palPath, projectPath };
+
+	JobSystem jobs;
+	std::vector<ImportedFile> files;
+	JobHandle handle = jobs.submit<ImportBatchResult>("import",
+		[paths](JobToken& token) { return decodeImportBatch(paths, {}, 0, token); },
+		[&files](ImportBatchResult& result) { files = std::move(result.files); });
+	CHECK(handle.finished.wait_for(kTimeout) == std::future_status::ready);
+	CHECK(handle.token->getProgress() == 1.0f);
+	jobs.applyFinished();
+
+	CHECK(files.size() == paths.size());
+	for (size_t i = 0; i < files.size() && i < paths.size(); i++) {
+		CHECK(files[i].path == paths[i]);
+	}
+
+	const ImportedFile* pal = findFile(files, palPath);
+	CHECK(pal != nullptr && pal->success && pal->kind == ImportFileKind::Palettes);
+	if (pal != nullptr) {
+		CHECK(pal->palettes.size() == palettes.size());
+		CHECK(pal->palettes.size() == palettes.size() &&
+			std::memcmp(pal->palettes.data(), palettes.data(), palettes.size() * sizeof(Palette)) == 0);
+	}
+
+	const ImportedFile* tileFile = findFile(files, tilesPath);
+	CHECK(tileFile != nullptr && tileFile->success && tileFile->kind == ImportFileKind::Tiles);
+	if (tileFile != nullptr) {
+		CHECK(tileFile->tiles.getSize() == tiles.getSize());
+		for (int i = 0; i < tiles.getSize() && i < tileFile->tiles.getSize(); i++) {
+			TileData expected = tiles.getTile(i);
+			TileData actual = tileFile->tiles.getTile(i);
+			CHECK(std::memcmp(&expected, &actual, sizeof(TileData)) == 0);
+		}
+	}
+
+	const ImportedFile* celFile = findFile(files, celsPath);
+	CHECK(celFile != nullptr && celFile->success && celFile->kind == ImportFileKind::AnimationCels);
+	if (celFile != nullptr) {
+		CHECK(celFile->cels.size() == cels.size());
+		for (size_t i = 0; i < cels.size() && i < celFile->cels.size(); i++) {
+			CHECK(celFile->cels[i].name == cels[i].name);
+			CHECK(celFile->cels[i].oams.size() == cels[i].oams.size());
+			for (size_t o = 0; o < cels[i].oams.size() && o < celFile->cels[i].oams.size(); o++) {
+				CHECK(std::memcmp(&celFile->cels[i].oams[o], &cels[i].oams[o], sizeof(TengokuOAM)) == 0);
+			}
+		}
+	}
+
+	// .c files come in as cels and get sorted out once they're read
+	const ImportedFile* animFile = findFile(files, animsPath);
+	CHECK(animFile != nullptr && animFile->success && animFile->kind == ImportFileKind::Animations);
+	if (animFile != nullptr) {
+		CHECK(animFile->animations.size() == 1);
+		if (animFile->animations.size() == 1) {
+			const Animation& anim = animFile->animations[0];
+			CHECK(anim.name == animations[0].name);
+			CHECK(anim.entries.size() == animations[0].entries.size());
+			for (size_t i = 0; i < anim.entries.size() && i < animations[0].entries.size(); i++) {
+				CHECK(anim.entries[i].celName == animations[0].entries[i].celName);
+				CHECK(anim.entries[i].duration == animations[0].entries[i].duration);
+			}
+		}
+	}
+
+	for (const std::string& path : { textPath, missingPath, projectPath }) {
+		const ImportedFile* file = findFile(files, path);
+		CHECK(file != nullptr && !file->success && !file->errorMessage.empty());
+	}
+
+	// cancelled before it gets going: nothing decodes and nothing gets applied
+	bool applied = false;
+	JobToken cancelled;
+	cancelled.cancel();
+	ImportBatchResult skipped = decodeImportBatch(paths, {}, 0, cancelled);
+	for (const ImportedFile& file : skipped.files) {
+		CHECK(!file.success);
+	}
+	JobHandle cancelledJob = jobs.submit<ImportBatchResult>("cancelled import",
+		[paths](JobToken& token) { return decodeImportBatch(paths, {}, 0, token); },
+		[&applied](ImportBatchResult&) { applied = true; });
+	jobs.cancel(cancelledJob.id);
+	CHECK(cancelledJob.finished.wait_for(kTimeout) == std::future_status::ready);
+	jobs.applyFinished();
+	CHECK(!applied);
+
+	fs::remove_all(dir);
+	return finishTests("file_import");
+}
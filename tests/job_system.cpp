@@ -0,0 +1,126 @@
+// WorkerPool and JobSystem: nested parallel loops, cancelling a job that hasn't started and
+// results being applied on the calling thread in submission order
+#include "Check.h"
+#include "JobSystem.h"
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr auto kTimeout = std::chrono::seconds(30);
+
+// parallelFor inside pool tasks, with more tasks than workers so every worker ends up in
+// one. a deadlock shows up as a timeout instead of a hung test run
+void testNestedParallelFor()
+{
+	WorkerPool& pool = WorkerPool::shared();
+	const size_t taskCount = pool.getThreadCount() + 2;
+	constexpr size_t kLoopSize = 1000;
+
+	std::vector<std::atomic<size_t>> sums(taskCount);
+	std::vector<std::future<void>> done;
+	for (size_t task = 0; task < taskCount; task++) {
+		auto promise = std::make_shared<std::promise<void>>();
+		done.push_back(promise->get_future());
+		pool.enqueue([&pool, &sums, task, promise]() {
+			pool.parallelFor(kLoopSize, [&](size_t i) {
+				// and one level deeper
+				pool.parallelFor(2, [&](size_t) { sums[task] += i; });
+			});
+			promise->set_value();
+		});
+	}
+
+	for (auto& future : done) {
+		CHECK(future.wait_for(kTimeout) == std::future_status::ready);
+	}
+	for (const auto& sum : sums) {
+		CHECK(sum == 2 * (kLoopSize * (kLoopSize - 1) / 2));
+	}
+}
+
+// every worker is held up, so the job is still queued when it gets cancelled: its work
+// never runs and applyFinished() drops it
+void testCancelBeforeStart()
+{
+	WorkerPool& pool = WorkerPool::shared();
+	std::promise<void> release;
+	std::shared_future<void> released = release.get_future().share();
+	std::atomic<unsigned> blocked{ 0 };
+	for (unsigned i = 0; i < pool.getThreadCount(); i++) {
+		pool.enqueue([&blocked, released]() {
+			blocked++;
+			released.wait();
+		});
+	}
+	while (blocked < pool.getThreadCount()) {
+		std::this_thread::yield();
+	}
+
+	JobSystem jobs;
+	bool workRan = false;
+	bool applied = false;
+	JobHandle handle = jobs.submit<int>("cancelled",
+		[&workRan](JobToken&) { workRan = true; return 1; },
+		[&applied](int&) { applied = true; });
+
+	jobs.cancel(handle.id);
+	CHECK(handle.token->isCancelled());
+	release.set_value();
+
+	CHECK(handle.finished.wait_for(kTimeout) == std::future_status::ready);
+	jobs.applyFinished();
+	CHECK(!workRan);
+	CHECK(!applied);
+	CHECK(!jobs.isBusy());
+}
+
+// the jobs finish back to front, apply still runs front to back and only from applyFinished()
+void testApplyOrder()
+{
+	constexpr int kJobCount = 6;
+	JobSystem jobs;
+	const std::thread::id mainThread = std::this_thread::get_id();
+
+	std::vector<int> applied;
+	std::vector<std::thread::id> applyThreads;
+	std::vector<JobHandle> handles;
+	for (int i = 0; i < kJobCount; i++) {
+		handles.push_back(jobs.submit<int>("job " + std::to_string(i),
+			[i](JobToken&) {
+				std::this_thread::sleep_for(std::chrono::milliseconds((kJobCount - i) * 5));
+				return i;
+			},
+			[&](int& value) {
+				applied.push_back(value);
+				applyThreads.push_back(std::this_thread::get_id());
+			}));
+	}
+
+	for (const JobHandle& handle : handles) {
+		CHECK(handle.finished.wait_for(kTimeout) == std::future_status::ready);
+	}
+	CHECK(applied.empty());
+
+	jobs.applyFinished();
+	CHECK(static_cast<int>(applied.size()) == kJobCount);
+	for (int i = 0; i < static_cast<int>(applied.size()); i++) {
+		CHECK(applied[i] == i);
+		CHECK(applyThreads[i] == mainThread);
+	}
+	CHECK(!jobs.isBusy());
+}
+
+}
+
+int main()
+{
+	testNestedParallelFor();
+	testCancelBeforeStart();
+	testApplyOrder();
+	return finishTests("job_system");
+}